@@ -0,0 +1,242 @@
+/*
+This file is part of libdbmanager
+(see the file COPYING in the root of the sources for a link to the
+homepage of libdbmanager)
+
+libdbmanager is a C++ library providing methods for reading/modifying a
+database using only C++ methods & objects and no SQL
+Copyright (C) 2016 Legrand SA
+
+libdbmanager is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License version 3
+(dated 29 June 2007) as published by the Free Software Foundation.
+
+libdbmanager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with libdbmanager (in the source code, it is enclosed in
+the file named "lgpl-3.0.txt" in the root of the sources).
+If not, see <http://www.gnu.org/licenses/>.
+*/
+/**
+ *
+ * \file awaitabledbmanager.hpp
+ *
+ * \brief C++20 coroutine interface to a DBManager.
+ *
+ * This header is only installed when libdbmanager is configured with --enable-coroutines. The library itself is still built as C++11, only code including this header needs C++20.
+ *
+ * */
+
+#ifndef _AWAITABLE_DBMANAGER_HPP_
+#define _AWAITABLE_DBMANAGER_HPP_
+
+#if __cplusplus < 202002L
+#error "awaitabledbmanager.hpp requires C++20 coroutines"
+#endif
+
+//STL includes
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+//Project includes
+#include "dbmanager.hpp"
+
+/**
+ * \brief An executor: a function that runs the function it is given, usually later and on another thread (for example by posting it to an event loop or a thread pool)
+ */
+typedef std::function<void(std::function<void()>)> DBManagerExecutor;
+
+/**
+ * \class DBManagerAwaitable
+ *
+ * \brief The result of a request made through AwaitableDBManager, to be co_awaited
+ *
+ * When co_awaited, the request is submitted to the manager with DBManager::post(), and the coroutine is suspended.
+ * It is resumed once the request completed: by the executor if one was given, otherwise directly on the worker thread that ran the request.
+ * Exceptions thrown by the request are rethrown by co_await.
+ */
+template<typename R>
+class DBManagerAwaitable {
+public:
+	/**
+	 * \brief Constructor
+	 *
+	 * \param manager The manager to submit the request to.
+	 * \param request The request, called with the isAtomic flag to pass to the methods of \p manager.
+	 * \param readOnly Set to true if \p request only reads the database.
+	 * \param executor The executor resuming the coroutine (may be empty).
+	 */
+	DBManagerAwaitable(DBManager& manager, std::function<R(bool)> request, bool readOnly, const DBManagerExecutor& executor) :
+				manager(manager),
+				request(std::move(request)),
+				readOnly(readOnly),
+				executor(executor),
+				result(),
+				exception() { }
+
+	bool await_ready() const noexcept {
+		return false;
+	}
+
+	void await_suspend(std::coroutine_handle<> handle) {
+		/* The coroutine may be resumed (and this object destroyed) before post() returns: nothing must be used after post() */
+		this->manager.post([this](bool isAtomic) {
+			try {
+				this->result.emplace(this->request(isAtomic));
+			}
+			catch (...) {
+				this->exception = std::current_exception();
+			}
+		}, [executor = this->executor, handle]() {	/* Once resumed, the coroutine may destroy this object: the completion must not use it */
+			if (executor)
+				executor([handle]() { handle.resume(); });
+			else
+				handle.resume();
+		}, this->readOnly);
+	}
+
+	R await_resume() {
+		if (this->exception)
+			std::rethrow_exception(this->exception);
+		return std::move(*(this->result));
+	}
+
+private:
+	DBManager& manager;	/*!< The manager the request is submitted to */
+	std::function<R(bool)> request;	/*!< The request */
+	bool readOnly;	/*!< Does the request only read the database? */
+	DBManagerExecutor executor;	/*!< The executor resuming the coroutine, or empty to resume it on the worker thread */
+	std::optional<R> result;	/*!< The result of the request, once it completed */
+	std::exception_ptr exception;	/*!< The exception thrown by the request, if any */
+};
+
+/**
+ * \class AwaitableDBManager
+ *
+ * \brief Wrapper around a DBManager whose methods can be co_awaited from a C++20 coroutine
+ *
+ * For example:
+ * \code
+ * AwaitableDBManager db(manager, executor);
+ * std::vector<std::map<std::string, std::string>> devices = co_await db.get("devices");
+ * \endcode
+ * The coroutine does not block any thread while the request is run by the worker threads of the manager (see DBManager::getAsync()).
+ * Without executor, the coroutine is resumed on the worker thread that ran the request, which is then blocked until the coroutine suspends again or returns: it must not wait for another request of the same manager there.
+ * The wrapped manager must outlive this object and its pending requests.
+ */
+class AwaitableDBManager {
+public:
+	/**
+	 * \brief Constructor
+	 *
+	 * \param manager The manager to run the requests.
+	 * \param executor The executor resuming the coroutines once their request completed. Leave empty to resume them on the worker threads of \p manager.
+	 */
+	explicit AwaitableDBManager(DBManager& manager, const DBManagerExecutor& executor = DBManagerExecutor()) :
+				manager(manager),
+				executor(executor) { }
+
+	/**
+	 * \brief Wrapped manager getter
+	 *
+	 * \return The manager running the requests.
+	 */
+	DBManager& getDBManager() const {
+		return this->manager;
+	}
+
+	/**
+	 * \brief Awaitable version of DBManager::get()
+	 */
+	DBManagerAwaitable<std::vector<std::map<std::string, std::string>>> get(const std::string& table, const std::vector<std::string>& columns = std::vector<std::string>(), const bool& distinct = false) const {
+		DBManager& manager = this->manager;
+		return DBManagerAwaitable<std::vector<std::map<std::string, std::string>>>(manager, [&manager, table, columns, distinct](bool isAtomic) { return manager.get(table, columns, distinct, isAtomic); }, true, this->executor);
+	}
+
+	/**
+	 * \brief Awaitable version of DBManager::insert()
+	 */
+	DBManagerAwaitable<bool> insert(const std::string& table, const std::map<std::string, std::string>& values) const {
+		return this->insert(table, std::vector<std::map<std::string, std::string>>({values}));
+	}
+
+	/**
+	 * \brief Awaitable version of DBManager::insert()
+	 */
+	DBManagerAwaitable<bool> insert(const std::string& table, const std::vector<std::map<std::string, std::string>>& values) const {
+		DBManager& manager = this->manager;
+		return DBManagerAwaitable<bool>(manager, [&manager, table, values](bool isAtomic) { return manager.insert(table, values, isAtomic); }, false, this->executor);
+	}
+
+	/**
+	 * \brief Awaitable version of DBManager::modify()
+	 */
+	DBManagerAwaitable<bool> modify(const std::string& table, const std::map<std::string, std::string>& refFields, const std::map<std::string, std::string>& values, const bool& insertIfNotExists = true) const {
+		DBManager& manager = this->manager;
+		return DBManagerAwaitable<bool>(manager, [&manager, table, refFields, values, insertIfNotExists](bool isAtomic) { return manager.modify(table, refFields, values, insertIfNotExists, isAtomic); }, false, this->executor);
+	}
+
+	/**
+	 * \brief Awaitable version of DBManager::remove()
+	 */
+	DBManagerAwaitable<bool> remove(const std::string& table, const std::map<std::string, std::string>& refFields) const {
+		DBManager& manager = this->manager;
+		return DBManagerAwaitable<bool>(manager, [&manager, table, refFields](bool isAtomic) { return manager.remove(table, refFields, isAtomic); }, false, this->executor);
+	}
+
+	/**
+	 * \brief Awaitable version of DBManager::linkRecords()
+	 */
+	DBManagerAwaitable<bool> linkRecords(const std::string& table1, const std::map<std::string, std::string>& record1, const std::string& table2, const std::map<std::string, std::string>& record2) const {
+		DBManager& manager = this->manager;
+		return DBManagerAwaitable<bool>(manager, [&manager, table1, record1, table2, record2](bool isAtomic) { return manager.linkRecords(table1, record1, table2, record2, isAtomic); }, false, this->executor);
+	}
+
+	/**
+	 * \brief Awaitable version of DBManager::linkRecords(), for a batch of pairs
+	 */
+	DBManagerAwaitable<bool> linkRecords(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs) const {
+		DBManager& manager = this->manager;
+		return DBManagerAwaitable<bool>(manager, [&manager, table1, table2, pairs](bool isAtomic) { return manager.linkRecords(table1, table2, pairs, isAtomic); }, false, this->executor);
+	}
+
+	/**
+	 * \brief Awaitable version of DBManager::unlinkRecords()
+	 */
+	DBManagerAwaitable<bool> unlinkRecords(const std::string& table1, const std::map<std::string, std::string>& record1, const std::string& table2, const std::map<std::string, std::string>& record2) const {
+		DBManager& manager = this->manager;
+		return DBManagerAwaitable<bool>(manager, [&manager, table1, record1, table2, record2](bool isAtomic) { return manager.unlinkRecords(table1, record1, table2, record2, isAtomic); }, false, this->executor);
+	}
+
+	/**
+	 * \brief Awaitable version of DBManager::unlinkRecords(), for a batch of pairs
+	 */
+	DBManagerAwaitable<bool> unlinkRecords(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs) const {
+		DBManager& manager = this->manager;
+		return DBManagerAwaitable<bool>(manager, [&manager, table1, table2, pairs](bool isAtomic) { return manager.unlinkRecords(table1, table2, pairs, isAtomic); }, false, this->executor);
+	}
+
+	/**
+	 * \brief Awaitable version of DBManager::getLinkedRecords()
+	 */
+	DBManagerAwaitable<std::map<std::string, std::vector<std::map<std::string, std::string>>>> getLinkedRecords(const std::string& table, const std::map<std::string, std::string>& record) const {
+		DBManager& manager = this->manager;
+		return DBManagerAwaitable<std::map<std::string, std::vector<std::map<std::string, std::string>>>>(manager, [&manager, table, record](bool isAtomic) { return manager.getLinkedRecords(table, record, isAtomic); }, true, this->executor);
+	}
+
+private:
+	DBManager& manager;	/*!< The manager running the requests */
+	DBManagerExecutor executor;	/*!< The executor resuming the coroutines, or empty to resume them on the worker threads */
+};
+
+#endif //_AWAITABLE_DBMANAGER_HPP_
@@ -22,23 +22,30 @@ the file named "lgpl-3.0.txt" in the root of the sources).
 If not, see <http://www.gnu.org/licenses/>.
 */
 #include <fstream>
+#include <algorithm>
+#include <thread>
+#include <chrono>
 
 #ifdef __unix__
 extern "C" {
 	#include <sys/file.h>
+	#include <sys/stat.h>
 }
 #endif
 
 #include "dbfactory.hpp"
 #include "sqlitedbmanager.hpp"
+#include "shardeddbmanager.hpp"
 
 #ifdef __unix__
 #define LOCK_FILE_PREFIX "/tmp/dbmanager"
+#define LOCK_FILE_DELETE_WAIT_MS 10	/* The maximum time to wait for a lock file held exclusively to be deleted (see DBManagerAllocationSlot::getLockOn()) */
 #endif
 
 using namespace std;
 
 #define SQLITE_URL_PROTO "sqlite"
+#define SQLITE_SHARDED_URL_PROTO "sqlite-sharded"
 
 /* Note: a copy operator is acceptable for this class, because even if we copy a pointer, we don't allocate it in this class, nor do we free it, we only store it */
 /* Allocation/deallocation is done outside by the code that uses us to store the result */
@@ -46,18 +53,19 @@ using namespace std;
 DBManagerAllocationSlot::DBManagerAllocationSlot(DBManager* managerPtr, const bool& exclusive) :
 		managerPtr(managerPtr), servedReferences(0), exclusive(exclusive)
 #ifdef __unix__
-		, lockFilename(""), lockFd(NULL)
+		, lockFilename(""), lockFd(NULL), lockExclusive(false)
 #endif
 		{
 }
 
 DBManagerAllocationSlot::DBManagerAllocationSlot(const DBManagerAllocationSlot& other) :
 		managerPtr(other.managerPtr),
-		servedReferences(other.servedReferences),
+		servedReferences(other.servedReferences.load()),
 		exclusive(other.exclusive)
 #ifdef __unix__
 		,lockFilename(other.lockFilename),
-		lockFd(other.lockFd)
+		lockFd(other.lockFd),
+		lockExclusive(other.lockExclusive)
 #endif
 		{
 	/* Note: we do not prevent copy construction even if exclusive is set, because we want to allow copy construction or assignment
@@ -65,33 +73,77 @@ DBManagerAllocationSlot::DBManagerAllocationSlot(const DBManagerAllocationSlot&
 	 */
 }
 
-void DBManagerAllocationSlot::getLockOn(const std::string& lockFilename) {
+#ifdef __unix__
+/**
+ * \brief Check that a path still names an open file
+ *
+ * \param fd The open file
+ * \param path The path \p fd was opened with
+ * \return false if the file was deleted, or replaced by another one, since \p fd was opened
+ */
+static bool pathNamesFile(FILE* fd, const std::string& path) {
+	struct stat fileStat, pathStat;
+	return (fstat(fileno(fd), &fileStat) == 0 && stat(path.c_str(), &pathStat) == 0
+	        && fileStat.st_dev == pathStat.st_dev && fileStat.st_ino == pathStat.st_ino);
+}
+#endif
+
+void DBManagerAllocationSlot::getLockOn(const std::string& lockFilename, const bool& exclusive) {
 
 #ifdef __unix__
 	if (this->lockFilename != "" && this->lockFilename != lockFilename && this->lockFd) {	/* We are already locking on a different file for this slot... raise an exception */
 		throw runtime_error("Lock already grabbed on file \"" + this->lockFilename + "\"");
 	}
-	if (this->lockFd) {
-		fclose(this->lockFd);
-		this->lockFd = NULL;
+	int operation = (exclusive ? LOCK_EX : LOCK_SH) | LOCK_NB;
+	if (this->lockFd) {	/* Convert the lock we already hold */
+		if (exclusive == this->lockExclusive)
+			return;
+		if (flock(fileno(this->lockFd), operation) == -1) {
+			/* The conversion is not atomic: the lock we held may have been released, try to get it back */
+			if (flock(fileno(this->lockFd), (this->lockExclusive ? LOCK_EX : LOCK_SH) | LOCK_NB) == -1) {
+				fclose(this->lockFd);
+				this->lockFd = NULL;
+				this->lockFilename = "";
+			}
+			throw runtime_error("Could not flock() on \"" + lockFilename + "\"");
+		}
+		this->lockExclusive = exclusive;
+		return;
 	}
 	this->lockFilename = "";
 
-	FILE *fd = fopen(lockFilename.c_str(), "w");
-	if (fd == NULL) {
-		throw runtime_error("Could not create lock file \"" + lockFilename + "\"");
-	}
-	if (flock(fileno(fd), LOCK_EX | LOCK_NB) == -1) {	/* Try to lock using flock */
-		fclose(fd);
-		throw runtime_error("Could not flock() on \"" + lockFilename + "\"");
+	FILE *fd = NULL;
+	while (fd == NULL) {
+		fd = fopen(lockFilename.c_str(), "a");	/* Don't truncate a file other processes hold a lock on */
+		if (fd == NULL) {
+			throw runtime_error("Could not create lock file \"" + lockFilename + "\"");
+		}
+		if (flock(fileno(fd), operation) == -1) {	/* Try to lock using flock */
+			/* The last process releasing its lock holds it exclusively only to delete the file (see releaseLock()): wait for the file to be deleted, and retry on a new file */
+			bool deleted = !pathNamesFile(fd, lockFilename);
+			for (unsigned int waited = 0; !deleted && waited < LOCK_FILE_DELETE_WAIT_MS; waited++) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				deleted = !pathNamesFile(fd, lockFilename);
+			}
+			fclose(fd);
+			if (!deleted)
+				throw runtime_error("Could not flock() on \"" + lockFilename + "\"");
+			fd = NULL;
+			continue;
+		}
+		/* The last process releasing its lock may have deleted the file between fopen() and flock() (see releaseLock()): retry on the new file */
+		if (!pathNamesFile(fd, lockFilename)) {
+			flock(fileno(fd), LOCK_UN);
+			fclose(fd);
+			fd = NULL;
+		}
 	}
-	else {
 #ifdef DEBUG
-		cout << "Grabbed lockfile \"" + lockFilename + "\"\n";
+	cout << "Grabbed " + string(exclusive ? "exclusive" : "shared") + " lockfile \"" + lockFilename + "\"\n";
 #endif
-		this->lockFilename = lockFilename;
-		this->lockFd = fd;	/* Store the handle for this lock */
-	}
+	this->lockFilename = lockFilename;
+	this->lockFd = fd;	/* Store the handle for this lock */
+	this->lockExclusive = exclusive;
 #endif	// __unix__
 }
 
@@ -102,14 +154,16 @@ void DBManagerAllocationSlot::releaseLock() {
 #endif
 
 	if (this->lockFd != NULL) {
+		/* Only delete the file if no other process holds a lock on it (they would keep locking a deleted file, that new processes would not see) */
+		if (this->lockFilename != "" && flock(fileno(this->lockFd), LOCK_EX | LOCK_NB) == 0) {
+			remove(this->lockFilename.c_str());	/* Delete the file in the fs */
+		}
 		flock(fileno(this->lockFd), LOCK_UN);
 		fclose(this->lockFd);
 		this->lockFd = NULL;
 	}
-	if (this->lockFilename != "") {
-		remove(this->lockFilename.c_str());	/* Delete the file in the fs */
-		this->lockFilename = "";
-	}
+	this->lockFilename = "";
+	this->lockExclusive = false;
 #endif	// __unix__
 }
 
@@ -121,11 +175,12 @@ void swap(DBManagerAllocationSlot& first, DBManagerAllocationSlot& second) noexc
 	using std::swap;	// Enable ADL
 
 	swap(first.managerPtr, second.managerPtr);
-	swap(first.servedReferences, second.servedReferences);
+	first.servedReferences = second.servedReferences.exchange(first.servedReferences);	/* std::atomic can't be swapped */
 	swap(first.exclusive, second.exclusive);
 #ifdef __unix__
 	swap(first.lockFilename, second.lockFilename);
 	swap(first.lockFd, second.lockFd);
+	swap(first.lockExclusive, second.lockExclusive);
 #endif
 	/* Once we have swapped the members of the two instances... the two instances have actually been swapped */
 }
@@ -140,7 +195,15 @@ DBManagerFactory& DBManagerFactory::getInstance() {
 	return instance;
 }
 
-DBManagerFactory::DBManagerFactory() : managersStore() {
+DBManagerFactory::DBManagerFactory() : managersStore(), maxOpenDatabases(0), sqliteManagersMut(), sqliteManagers() {
+}
+
+DBManagerStoreShard& DBManagerFactory::getShard(const string& location) {
+	return this->managersStore[std::hash<string>()(location) % DBMANAGER_FACTORY_SHARDS];
+}
+
+const DBManagerStoreShard& DBManagerFactory::getShard(const string& location) const {
+	return this->managersStore[std::hash<string>()(location) % DBMANAGER_FACTORY_SHARDS];
 }
 
 DBManagerFactory::~DBManagerFactory() {
@@ -148,10 +211,25 @@ DBManagerFactory::~DBManagerFactory() {
 }
 
 DBManager& DBManagerFactory::getDBManager(const string& location, const string& configurationDescriptionFile, const bool& exclusive) {
+	return *(this->getOrCreateDBManager(location, configurationDescriptionFile, NULL, exclusive).managerPtr);
+}
+
+DBManager& DBManagerFactory::getDBManager(const string& location, const DBSchemaDescriptor& schema, const bool& exclusive) {
+	return *(this->getOrCreateDBManager(location, "", &schema, exclusive).managerPtr);
+}
+
+DBManagerAllocationSlot& DBManagerFactory::getOrCreateDBManager(const string& location, const string& configurationDescriptionFile, const DBSchemaDescriptor* schema, const bool& exclusive) {
 	DBManager *manager = NULL;
+	DBManagerAllocationSlot *servedSlot = NULL;
 
+	DBManagerStoreShard& shard = this->getShard(location);
+	std::unique_lock<std::mutex> lock(shard.mut);	/* The manager of a location is looked up and served atomically. Locations of other shards are not blocked */
+	map<string, DBManagerAllocationSlot>::iterator it;
+	while ((it = shard.slots.find(location)) != shard.slots.end() && it->second.managerPtr == NULL) {
+		shard.opened.wait(lock);	/* Another thread is opening this location (see below), wait for its manager */
+	}
 	try {
-		DBManagerAllocationSlot& slot= this->managersStore.at(location);        /* Try to find a reference to the a slot */
+		DBManagerAllocationSlot& slot= shard.slots.at(location);        /* Try to find a reference to the a slot */
 		/* If now exception is raised, it means that there already a manager with this location in the store */
 #ifdef DEBUG
 		cout << string(__func__) + "() called for an existing location \"" + location + "\"\n";
@@ -167,96 +245,254 @@ DBManager& DBManagerFactory::getDBManager(const string& location, const string&
 				}
 		}
 		else if (slot.servedReferences == 0) {	/* This slot is not used anymore... we will adjust exclusivity to the new request */
+#ifdef __unix__
+			if (slot.lockFd != NULL)
+				slot.getLockOn(slot.lockFilename, exclusive);	/* Also towards other processes (this may raise an exception if they use the database) */
+#endif
 			slot.exclusive = exclusive;
 		}
+		servedSlot = &slot;
 	}
 	catch (const std::out_of_range& ex) {	/* If getting out of range, it means this location does not exist in the store. Create the slot and DBManager */
 		string databaseType = this->locationUrlToProto(location);
-		if(databaseType == SQLITE_URL_PROTO) {	/* Handle sqlite:// URLs */
+		if(databaseType == SQLITE_URL_PROTO || databaseType == SQLITE_SHARDED_URL_PROTO) {	/* Handle sqlite:// and sqlite-sharded:// URLs */
 			string databasePath = this->locationUrlToPath(location);
-			manager = new SQLiteDBManager(databasePath, configurationDescriptionFile);	/* Allocate a new manager */
-			DBManagerAllocationSlot newSlot(manager, exclusive);	/* Store the pointer to this new manager in a new slot */
-#ifdef DEBUG
-			cout << string(__func__) + "() just created a new instance for a new location \"" + location + "\"\n";
-#endif
+			map<string, string> options = this->locationUrlToOptions(location);
+			/* Opening the database may take long (its structure is checked, and migrated if needed): insert an empty slot so that other threads wait for this location only, and open it without the shard locked */
+			shard.slots.emplace(location, DBManagerAllocationSlot(NULL, exclusive));
+			lock.unlock();
+			DBManagerAllocationSlot newSlot(NULL, exclusive);	/* The slot that will store the pointer to the new manager */
+			try {
 #ifdef __unix__
-			/* Create a lock file for this location */
-			string prefix = LOCK_FILE_PREFIX;
-			string lockBasename = databasePath;
-			while(lockBasename.find("/") != string::npos) {	/* Replace / by _ in database location filename */
-				lockBasename.replace(lockBasename.find_first_of("/"), 1, "_");
+				/* Create a lock file for this location, before opening the database, so that a database used exclusively by another process is not modified */
+				string prefix = LOCK_FILE_PREFIX;
+				string lockBasename = databasePath;
+				while(lockBasename.find("/") != string::npos) {	/* Replace / by _ in database location filename */
+					lockBasename.replace(lockBasename.find_first_of("/"), 1, "_");
+				}
+				newSlot.getLockOn(prefix + lockBasename + ".lock", exclusive);	/* Other processes can share the database, unless exclusivity is requested */
+#endif
+				if(databaseType == SQLITE_SHARDED_URL_PROTO) {
+					if(schema != NULL)
+						manager = new ShardedDBManager(databasePath, *schema, options);	/* Allocate a new manager, databasePath is the directory of the shards */
+					else
+						manager = new ShardedDBManager(databasePath, configurationDescriptionFile, options);	/* Allocate a new manager, databasePath is the directory of the shards */
+				}
+				else if(schema != NULL)
+					manager = new SQLiteDBManager(databasePath, *schema, options);	/* Allocate a new manager */
+				else
+					manager = new SQLiteDBManager(databasePath, configurationDescriptionFile, options);	/* Allocate a new manager */
+			}
+			catch (...) {
+				newSlot.releaseLock();
+				lock.lock();
+				shard.slots.erase(location);	/* The threads waiting for this location will try to open it themselves */
+				shard.opened.notify_all();
+				throw;
 			}
-			newSlot.getLockOn(prefix + lockBasename + ".lock");
+			newSlot.managerPtr = manager;
+#ifdef DEBUG
+			cout << string(__func__) + "() just created a new instance for a new location \"" + location + "\"\n";
 #endif
-
-			this->managersStore.emplace(location, newSlot);	/* Add this new slot to the store */
+			if (databaseType == SQLITE_URL_PROTO)
+				this->registerSQLiteDBManager(dynamic_cast<SQLiteDBManager*>(manager));
+
+			lock.lock();
+			servedSlot = &(shard.slots.emplace(location, newSlot).first->second);	/* Get the empty slot inserted above back */
+			newSlot.servedReferences = servedSlot->servedReferences.load();	/* References may have been counted meanwhile (see incRefCount()) */
+			*servedSlot = newSlot;	/* Fill the slot with the new manager */
+			shard.opened.notify_all();
 		}
 		else {
-			throw invalid_argument("Unrecognized database type: \"" + databaseType + "\". Supported type: sqlite");
+			throw invalid_argument("Unrecognized database type: \"" + databaseType + "\". Supported types: sqlite, sqlite-sharded");
 		}
 	}
-	this->incRefCount(location); /* If we reach there, either the manager pointer already existed or we have just successfully allocated it. In all cases, increment the reference count */
+	servedSlot->servedReferences++; /* If we reach there, either the manager pointer already existed or we have just successfully allocated it. In all cases, increment the reference count */
 #ifdef DEBUG
-	cout << string(__func__) + "(): reference count for location \"" + location + "\" is now " + to_string(this->getRefCount(location)) + "\n";
+	cout << string(__func__) + "(): reference count for location \"" + location + "\" is now " + to_string(servedSlot->servedReferences) + "\n";
 #endif
-	return *manager;
+	return *servedSlot;
 }
 
-void DBManagerFactory::freeDBManager(const string& location) {
-	this->decRefCount(location); /* If no manager is known for this location, this call will do nothing */
-#ifdef DEBUG
-	cout << string(__func__) + "(): reference count for location \"" + location + "\" has been decremented to " + to_string(this->getRefCount(location)) + "\n";
-#endif
-	if (!this->isUsed(location)) {	/* Instance in this slot is not referenced anymore, destroy the slot */
-		try {
-			DBManagerAllocationSlot& slot = this->managersStore.at(location);	/* Get a reference to the slot corresponding to this manager URL */
+vector<DBPrewarmResult> DBManagerFactory::prewarm(const vector<string>& locations, const string& configurationDescriptionFile, const unsigned int& threads) {
+	return this->prewarm(locations, configurationDescriptionFile, NULL, threads);
+}
 
-			slot.releaseLock();	/* Release any potential lock */
+vector<DBPrewarmResult> DBManagerFactory::prewarm(const vector<string>& locations, const DBSchemaDescriptor& schema, const unsigned int& threads) {
+	return this->prewarm(locations, "", &schema, threads);
+}
 
-			/* Now remove the DBManager pointed to by the slot */
-			if(this->locationUrlToProto(location) == SQLITE_URL_PROTO) {	/* Handle sqlite:// URLs */
-				// Lionel: FIXME: Casting here could be avoided, if we used a virtual destructor in base class DBManager and all its derived classes
-				SQLiteDBManager *db = dynamic_cast<SQLiteDBManager*>(slot.managerPtr);
-				if(db != NULL) {
-					delete db;
-					slot.managerPtr = NULL;
-				}
+vector<DBPrewarmResult> DBManagerFactory::prewarm(const vector<string>& locations, const string& configurationDescriptionFile, const DBSchemaDescriptor* schema, unsigned int threads) {
+	vector<DBPrewarmResult> results;
+	results.reserve(locations.size());
+	for (auto &location : locations) {
+		results.push_back(DBPrewarmResult{location, false, 0, ""});
+	}
+
+	std::atomic<size_t> nextLocation(0);
+	auto worker = [&]() {
+		for (size_t i = nextLocation++; i < results.size(); i = nextLocation++) {
+			DBPrewarmResult& result = results[i];
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			try {
+				DBManagerAllocationSlot& slot = this->getOrCreateDBManager(result.location, configurationDescriptionFile, schema, false);
+				DBManagerStoreShard& shard = this->getShard(result.location);
+				std::lock_guard<std::mutex> lock(shard.mut);	/* Like in freeDBManager(), the reference count is only decremented with the shard locked */
+				slot.servedReferences--;	/* Don't keep the reference: the slot remains in the store until freeDBManager() is called for this location */
+				result.opened = true;
 			}
-			else {
-				cerr << string(__func__) + "(): Error: unknown database type \"" + this->locationUrlToProto(location) + "\". Pointed DBManager object will not be deallocated properly, a memory leak will occur\n";
+			catch (const std::exception& e) {
+				result.error = e.what();
 			}
-			this->managersStore.erase(location);
+			result.microseconds = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+#ifdef DEBUG
+			cout << string(__func__) + "(): \"" + result.location + "\" " + (result.opened ? "opened" : "failed") + " in " + to_string(result.microseconds) + "us\n";
+#endif
 		}
-		catch (const std::out_of_range& ex) {
-			return; /* If getting out of range, it means this location does not exist in the store... do nothing */
+	};
+
+	if (threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 1U);
+	threads = std::min(threads, static_cast<unsigned int>(locations.size()));
+	vector<std::thread> pool;
+	for (unsigned int i = 1; i < threads; i++) {	/* The calling thread is one of the threads */
+		pool.emplace_back(worker);
+	}
+	worker();
+	for (auto &thread : pool) {
+		thread.join();
+	}
+	return results;
+}
+
+void DBManagerFactory::acquireSlot(DBManagerAllocationSlot& slot) {
+	/* The exclusivity of a slot can only change when it is not referenced, and the caller holds a reference on it */
+	if (slot.exclusive) {
+		throw runtime_error("Failed to ensure requested exclusivity for an exclusive DBManager");
+	}
+	slot.servedReferences++;
+}
+
+void DBManagerFactory::releaseSlot(const string& location, DBManagerAllocationSlot& slot) {
+	/* As long as other references exist, the slot can't be destroyed: just decrement its reference count
+	 * A reference count of 1 can't be decremented here, because the slot must be destroyed atomically with this decrement (see freeDBManager())
+	 */
+	unsigned int references = slot.servedReferences;
+	while (references > 1) {
+		if (slot.servedReferences.compare_exchange_weak(references, references - 1))
+			return;
+	}
+	this->freeDBManager(location);
+}
+
+void DBManagerFactory::freeDBManager(const string& location) {
+	DBManagerStoreShard& shard = this->getShard(location);
+	std::lock_guard<std::mutex> lock(shard.mut);	/* Decrementing the reference count and destroying the slot is atomic, so that no other thread can be served the manager in between */
+	map<string, DBManagerAllocationSlot>::iterator it = shard.slots.find(location);
+	if (it == shard.slots.end() || it->second.managerPtr == NULL)
+		return;	/* If no manager is known for this location (or it is still being opened, see getOrCreateDBManager()), this call will do nothing */
+	DBManagerAllocationSlot& slot = it->second;	/* Get a reference to the slot corresponding to this manager URL */
+	unsigned int references = slot.servedReferences;
+	while (references > 0 && !slot.servedReferences.compare_exchange_weak(references, references - 1)) {	/* Decrease the reference count if positive (references held by containers may be released concurrently, see releaseSlot()) */
+	}
+	if (references <= 1)
+		slot.exclusive = false;	/* Reset exclusivity if no reference exists anymore on this slot */
+#ifdef DEBUG
+	cout << string(__func__) + "(): reference count for location \"" + location + "\" has been decremented to " + to_string(slot.servedReferences) + "\n";
+#endif
+	if (references <= 1) {	/* Instance in this slot is not referenced anymore, destroy the slot */
+		slot.releaseLock();	/* Release any potential lock */
+
+		/* Now remove the DBManager pointed to by the slot */
+		if(this->locationUrlToProto(location) == SQLITE_URL_PROTO) {	/* sqlite:// managers are also known by the connection cap (see setMaxOpenDatabases()) */
+			this->unregisterSQLiteDBManager(dynamic_cast<SQLiteDBManager*>(slot.managerPtr));
 		}
+		delete slot.managerPtr;
+		slot.managerPtr = NULL;
+		shard.slots.erase(it);
 	}
 }
 
 void DBManagerFactory::freeAllDBManagers(const bool& ignoreRefCount) {
-	for (auto &it : this->managersStore) {
-		if (!ignoreRefCount && this->isUsed(it.first)) {
-			throw runtime_error("Refusing to free the DBManager for a slot that is still referenced");
-		}
-		if (this->locationUrlToProto(it.first) == SQLITE_URL_PROTO) {
+	for (auto &shard : this->managersStore) {
+		std::lock_guard<std::mutex> lock(shard.mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		for (auto &it : shard.slots) {
+			if (!ignoreRefCount && it.second.servedReferences > 0) {
+				throw runtime_error("Refusing to free the DBManager for a slot that is still referenced");
+			}
 			DBManagerAllocationSlot& slot = it.second;	/* Get the allocation slot for this manager URL */
 
 			slot.releaseLock();	/* Release any potential lock */
 
-			// Lionel: FIXME: Casting here could be avoided, if we used a virtual destructor in base class DBManager and all its derived classes
-			SQLiteDBManager *db = dynamic_cast<SQLiteDBManager*>(slot.managerPtr);
-			if (db != NULL) {
-				delete db;
-				db = NULL;
+			if (this->locationUrlToProto(it.first) == SQLITE_URL_PROTO) {	/* sqlite:// managers are also known by the connection cap (see setMaxOpenDatabases()) */
+				this->unregisterSQLiteDBManager(dynamic_cast<SQLiteDBManager*>(slot.managerPtr));
 			}
+			delete slot.managerPtr;
+			slot.managerPtr = NULL;
 		}
+		shard.slots.clear();
 	}
-	this->managersStore.clear();
+}
+
+void DBManagerFactory::setMaxOpenDatabases(const unsigned int& maxOpenDatabases) {
+	this->maxOpenDatabases = maxOpenDatabases;
+	this->closeIdleDatabases(NULL);
+}
+
+void DBManagerFactory::closeIdleDatabases(const SQLiteDBManager* except) {
+	unsigned int maxOpen = this->maxOpenDatabases;
+	if (maxOpen == 0)
+		return;	/* No limit */
+
+	std::lock_guard<std::mutex> lock(this->sqliteManagersMut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+	vector<SQLiteDBManager*> openManagers;
+	for (auto manager : this->sqliteManagers) {
+		if (manager->isConnectionOpen())
+			openManagers.push_back(manager);
+	}
+	if (openManagers.size() <= maxOpen)
+		return;
+
+	std::sort(openManagers.begin(), openManagers.end(), [](const SQLiteDBManager* a, const SQLiteDBManager* b) {
+		return a->getLastUse() < b->getLastUse();	/* Least recently used first */
+	});
+	size_t toClose = openManagers.size() - maxOpen;
+	for (auto manager : openManagers) {
+		if (toClose == 0)
+			break;
+		if (manager == except)
+			continue;
+		/* A manager running a request is skipped (it is locked, or its connection is used by a non atomic request, and closeConnection() does not wait for it), the next call will try again */
+		if (manager->closeConnection()) {
+#ifdef DEBUG
+			cout << string(__func__) + "(): closed an idle database connection\n";
+#endif
+			toClose--;
+		}
+	}
+}
+
+void DBManagerFactory::registerSQLiteDBManager(SQLiteDBManager* manager) {
+	manager->setReopenCallback([this](SQLiteDBManager& reopened) {
+		this->closeIdleDatabases(&reopened);
+	});
+	{
+		std::lock_guard<std::mutex> lock(this->sqliteManagersMut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		this->sqliteManagers.push_back(manager);
+	}
+	this->closeIdleDatabases(manager);	/* The new manager has just opened its connection */
+}
+
+void DBManagerFactory::unregisterSQLiteDBManager(const SQLiteDBManager* manager) {
+	std::lock_guard<std::mutex> lock(this->sqliteManagersMut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+	this->sqliteManagers.erase(std::remove(this->sqliteManagers.begin(), this->sqliteManagers.end(), manager), this->sqliteManagers.end());
 }
 
 void DBManagerFactory::incRefCount(const string& location) {
+	DBManagerStoreShard& shard = this->getShard(location);
+	std::lock_guard<std::mutex> lock(shard.mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
 	try {
-		DBManagerAllocationSlot& slot= this->managersStore.at(location);	/* Get a reference to the corresponding slot */
+		DBManagerAllocationSlot& slot= shard.slots.at(location);	/* Get a reference to the corresponding slot */
 		slot.servedReferences++;	/* And increase the reference count */
 	}
 	catch (const std::out_of_range& ex) {
@@ -265,8 +501,10 @@ void DBManagerFactory::incRefCount(const string& location) {
 }
 
 void DBManagerFactory::decRefCount(const string& location) {
+	DBManagerStoreShard& shard = this->getShard(location);
+	std::lock_guard<std::mutex> lock(shard.mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
 	try {
-		DBManagerAllocationSlot& slot = this->managersStore.at(location);	/* Get a reference to the corresponding slot */
+		DBManagerAllocationSlot& slot = shard.slots.at(location);	/* Get a reference to the corresponding slot */
 		if (slot.servedReferences > 0) {
 			slot.servedReferences--;	/* Decrease the reference count if positive */
 			if (slot.servedReferences == 0)
@@ -279,8 +517,10 @@ void DBManagerFactory::decRefCount(const string& location) {
 }
 
 unsigned int DBManagerFactory::getRefCount(const string& location) const {
+	const DBManagerStoreShard& shard = this->getShard(location);
+	std::lock_guard<std::mutex> lock(shard.mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
 	try {
-		const DBManagerAllocationSlot &slot = this->managersStore.at(location);	/* Get a reference to the corresponding slot */
+		const DBManagerAllocationSlot &slot = shard.slots.at(location);	/* Get a reference to the corresponding slot */
 		return slot.servedReferences;	/* ... and return the reference count */
 	}
 	catch (const std::out_of_range& ex) {
@@ -299,8 +539,10 @@ bool DBManagerFactory::isUsed(const string& location) const {
 }
 
 bool DBManagerFactory::isExclusive(const string& location) const {
+	const DBManagerStoreShard& shard = this->getShard(location);
+	std::lock_guard<std::mutex> lock(shard.mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
 	try {
-		const DBManagerAllocationSlot& slot = this->managersStore.at(location);	/* Get a reference to the corresponding slot */
+		const DBManagerAllocationSlot& slot = shard.slots.at(location);	/* Get a reference to the corresponding slot */
 		return slot.exclusive;
 	}
 	catch (const std::out_of_range& ex) {
@@ -323,7 +565,7 @@ string DBManagerFactory::locationUrlToPath(const string& location) const {
 	static const string separator = "://";
 	if(location.find(separator) != string::npos) {
 		unsigned int startPos = location.find(separator)+separator.length();
-		databasePath = location.substr(startPos, location.length()-startPos);
+		databasePath = location.substr(startPos, location.find('?', startPos)-startPos);	/* Options are not part of the path */
 		if ((databasePath.length() >= 1) &&
 			(databasePath[0] != '/')) {	/* If path is not absolute... */
 			databasePath.insert(0, 1, '/');	/* Make it absolute relative to the root by prepending a '/' */
@@ -331,3 +573,22 @@ string DBManagerFactory::locationUrlToPath(const string& location) const {
 	}
 	return databasePath;
 }
+
+map<string, string> DBManagerFactory::locationUrlToOptions(const string& location) const {
+	map<string, string> options;
+	string::size_type optionPos = location.find('?');
+	while (optionPos != string::npos) {
+		optionPos++;	/* Skip the '?' or '&' separator */
+		string::size_type optionEnd = location.find('&', optionPos);
+		string option = location.substr(optionPos, optionEnd-optionPos);
+		if (!option.empty()) {
+			string::size_type equalPos = option.find('=');
+			if (equalPos == string::npos)
+				options[option] = "";
+			else
+				options[option.substr(0, equalPos)] = option.substr(equalPos+1);
+		}
+		optionPos = optionEnd;
+	}
+	return options;
+}
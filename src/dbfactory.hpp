@@ -35,13 +35,37 @@ If not, see <http://www.gnu.org/licenses/>.
 #include <string>
 #include <map>
 #include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
 
 #include "dbmanagerapi.hpp"	// For LIBDBMANAGER_API
 
 //Library includes
 #include "dbmanager.hpp"
+#include "dbschemadescriptor.hpp"
+
+/**
+ * \def DBMANAGER_FACTORY_SHARDS
+ * The number of independently locked parts of the store of DBManagerFactory (locations are spread among them by hash, so that threads using different locations seldom wait for each other)
+ */
+#define DBMANAGER_FACTORY_SHARDS 16
+
+/**
+ * \struct DBPrewarmResult
+ *
+ * \brief The outcome of opening one database location in DBManagerFactory::prewarm()
+ */
+struct DBPrewarmResult {
+	std::string location;             /*!< The location URL of the database */
+	bool opened;                      /*!< true if a DBManager is ready for this location */
+	unsigned long long microseconds;  /*!< The time spent opening (and migrating) the database, in microseconds */
+	std::string error;                /*!< The reason why the database could not be opened, if opened is false */
+};
 
 class DBManagerAllocationSlot;	/* Forward declaration */
+class SQLiteDBManager;	/* Forward declaration */
 
 void swap(DBManagerAllocationSlot& first, DBManagerAllocationSlot& second) noexcept;
 
@@ -65,11 +89,12 @@ class DBManagerAllocationSlot {
 
 public:
 	DBManager*    managerPtr;	/*!< A pointer to the manager object corresponding to this allocated slot */
-	unsigned int  servedReferences;	/*!< The number of references that have been given to this allocated slot */
+	std::atomic<unsigned int> servedReferences;	/*!< The number of references that have been given to this allocated slot (only modified with the lock of the slot's shard held, but can be read at any time) */
 	bool          exclusive;	/*!< Should we allow to serve only one instance of this DBManager? */
 #ifdef __unix__
 	std::string   lockFilename;	/*!< A filename used as lock for this slot */
 	FILE*         lockFd;	/*!< A file descriptor on which flock() has been called on the file lockFilename */
+	bool          lockExclusive;	/*!< Is the flock() held on lockFd exclusive (or shared)? */
 #endif
 	/**
 	 * \brief Class constructor
@@ -97,18 +122,40 @@ public:
 	/**
 	 * \brief Get an OS-wide lock (inter-process)
 	 *
+	 * Several processes can hold a shared lock on the same file at the same time, an exclusive lock can only be held when no other lock is held.
+	 * If this slot already holds a lock on \p lockFilename, it is converted to the requested kind.
+	 * A file locked exclusively by its last user only to delete it (see releaseLock()) is not a failure: its deletion is waited for (for a few milliseconds at most), then a new file is locked.
 	 * Warning: this method may raise exceptions
 	 *
 	 * \param lockFilename A filename on which we will grab a lock
+	 * \param exclusive Should the lock be exclusive (or shared)?
 	 */
-	void getLockOn(const std::string& lockFilename);
+	void getLockOn(const std::string& lockFilename, const bool& exclusive = false);
 
 	/**
 	 * \brief Release the OS-wide lock grabbed by this slot (if any)
+	 *
+	 * The lock file is only deleted if no other process holds a lock on it.
 	 */
 	void releaseLock();
 };
 
+/**
+ * \struct DBManagerStoreShard
+ *
+ * \brief One independently locked part of the store of DBManagerFactory
+ */
+struct DBManagerStoreShard {
+	mutable std::mutex mut;	/*!< The mutex protecting slots (mutable... so that it can be locked on a const object) */
+	std::map<std::string, DBManagerAllocationSlot> slots;	/*!< The slots of the locations that belong to this shard. The key is a location string, the payload is an DBManagerAllocationSlot object. A slot whose managerPtr is NULL is being opened, without the shard locked (see DBManagerFactory::getOrCreateDBManager()) */
+	std::condition_variable opened;	/*!< Notified (with mut) when a slot of this shard has been opened, or removed because its opening failed */
+
+	/**
+	 * \brief Constructor, builds an empty shard
+	 */
+	DBManagerStoreShard() : mut(), slots(), opened() { }
+};
+
 /**
  * \class DBManagerFactory
  *
@@ -117,6 +164,7 @@ public:
  * This class has methods to obtains database manager instances based on specific URL.
  * For example the URL "sqlite://[sqlite database file full path]" will give you a database manager that handle SQLite databases.
  * This class implements the singleton design pattern (in the lazy way).
+ * Its methods can be called from any thread: the store is split in shards that are locked independently, so getting or freeing managers for different locations seldom contends.
  *
  */
 class LIBDBMANAGER_API DBManagerFactory {
@@ -144,6 +192,19 @@ public:
 	 * \return DBManager& The reference to an instance of the DBManager class.
 	 */
 	DBManager& getDBManager(const std::string& location, const std::string& configurationDescriptionFile="", const bool& exclusive = false);
+
+	/**
+	 * \brief DBManager getter, for a precompiled database description
+	 *
+	 * Same as getDBManager() above, but the database structure is described by \p schema (as generated by dbmanager-schemagen) instead of an XML configuration, so no XML is parsed at runtime.
+	 * \p schema is only used if no DBManager exists yet for \p location.
+	 *
+	 * \param location The location, in a URL address, of the database to manage.
+	 * \param schema The description of the database structure (it must outlive the DBManager, which is the case of the constexpr objects generated by dbmanager-schemagen)
+	 * \param exclusive When true, ensures that only one reference can exist at a time for this location. If a second call is performed on getDBManager, an exception will be raised
+	 * \return DBManager& The reference to an instance of the DBManager class.
+	 */
+	DBManager& getDBManager(const std::string& location, const DBSchemaDescriptor& schema, const bool& exclusive = false);
 	
 	/**
 	 * \brief DBManager releaser
@@ -154,10 +215,109 @@ public:
 	 */
 	void freeDBManager(const std::string& location);
 
+	/**
+	 * \brief Limit the number of SQLite databases that have an open connection
+	 *
+	 * When more than \p maxOpenDatabases sqlite:// managers have an open connection, the connections of the least recently used ones are closed (together with their page cache), and opened again on their next use.
+	 * The managers themselves (and their lock files) remain allocated, so the references already served stay valid.
+	 * The connection of a manager running a request (atomic or not) is not closed; it is closed by a later call, once the request is over.
+	 * Only the main connection of each manager is counted and closed: the connections of the reader threads of its worker pool and its snapshots are neither counted nor closed, so a manager running asynchronous requests keeps up to one connection per reader thread open beyond the limit. The shards of sqlite-sharded:// managers are not counted.
+	 *
+	 * \param maxOpenDatabases The maximum number of open connections, or 0 for no limit (the default)
+	 */
+	void setMaxOpenDatabases(const unsigned int& maxOpenDatabases);
+
+	/**
+	 * \brief Open many databases in parallel
+	 *
+	 * Allocates a DBManager for each location of \p locations that is not allocated yet, checking its database structure against \p configurationDescriptionFile (see getDBManager()), using up to \p threads threads.
+	 * No reference is kept on the managers: they remain allocated in the factory, so that later getDBManager() calls for these locations (with any configuration) return them immediately. They are deallocated like the other managers, when freeDBManager() is called once more than getDBManager().
+	 * Databases are opened without the store locked, so the threads only wait for each other when \p locations contains the same location more than once.
+	 *
+	 * \param locations The location URLs of the databases
+	 * \param configurationDescriptionFile The path to the configuration file to use for these databases, or the configuration content directly provided as a std::string (no carriage return allowed in this case)
+	 * \param threads The maximum number of threads opening databases, 0 to use as many threads as processor cores
+	 * \return The outcome for each location of \p locations, in the same order
+	 */
+	std::vector<DBPrewarmResult> prewarm(const std::vector<std::string>& locations, const std::string& configurationDescriptionFile = "", const unsigned int& threads = 0);
+
+	/**
+	 * \brief Open many databases in parallel, for a precompiled database description
+	 *
+	 * Same as prewarm() above, but the database structure is described by \p schema (see getDBManager()).
+	 *
+	 * \param locations The location URLs of the databases
+	 * \param schema The description of the database structure (it must outlive the DBManagers)
+	 * \param threads The maximum number of threads opening databases, 0 to use as many threads as processor cores
+	 * \return The outcome for each location of \p locations, in the same order
+	 */
+	std::vector<DBPrewarmResult> prewarm(const std::vector<std::string>& locations, const DBSchemaDescriptor& schema, const unsigned int& threads = 0);
+
 private:
 	DBManagerFactory();
 	~DBManagerFactory();
 
+	/**
+	 * \brief Get the shard of the store a location belongs to
+	 *
+	 * \param location The URL of the database
+	 * \return The shard (its mutex must be locked before accessing its slots)
+	 */
+	DBManagerStoreShard& getShard(const std::string& location);
+
+	/**
+	 * \brief Get the shard of the store a location belongs to (const version)
+	 *
+	 * \param location The URL of the database
+	 * \return The shard (its mutex must be locked before accessing its slots)
+	 */
+	const DBManagerStoreShard& getShard(const std::string& location) const;
+
+	/**
+	 * \brief Allocation slot getter, shared by both public getDBManager() methods and by DBManagerContainer
+	 *
+	 * The reference count of the returned slot has been incremented.
+	 * A new manager is created without its shard locked, so that databases of the same shard can be opened in parallel: meanwhile, its slot holds no manager, and other threads asking for the same location wait for it.
+	 *
+	 * \param location The location, in a URL address, of the database to manage.
+	 * \param configurationDescriptionFile The XML configuration to use if \p schema is NULL
+	 * \param schema The precompiled description of the database structure, or NULL to use \p configurationDescriptionFile
+	 * \param exclusive When true, ensures that only one reference can exist at a time for this location
+	 * \return DBManagerAllocationSlot& The slot holding the instance of the DBManager class (its address remains valid until its last reference is released).
+	 */
+	DBManagerAllocationSlot& getOrCreateDBManager(const std::string& location, const std::string& configurationDescriptionFile, const DBSchemaDescriptor* schema, const bool& exclusive);
+
+	/**
+	 * \brief Parallel opening of databases, shared by both public prewarm() methods
+	 *
+	 * \param locations The location URLs of the databases
+	 * \param configurationDescriptionFile The XML configuration to use if \p schema is NULL
+	 * \param schema The precompiled description of the database structure, or NULL to use \p configurationDescriptionFile
+	 * \param threads The maximum number of threads opening databases, 0 to use as many threads as processor cores
+	 * \return The outcome for each location of \p locations, in the same order
+	 */
+	std::vector<DBPrewarmResult> prewarm(const std::vector<std::string>& locations, const std::string& configurationDescriptionFile, const DBSchemaDescriptor* schema, unsigned int threads);
+
+	/**
+	 * \brief Get one more reference on a slot on which the caller already holds a reference
+	 *
+	 * Since the slot can't be destroyed while the caller holds a reference, this only increments its reference count atomically, without looking up or locking the store.
+	 * Warning: this method will raise a runtime_error if the slot is exclusive
+	 *
+	 * \param slot The slot
+	 */
+	void acquireSlot(DBManagerAllocationSlot& slot);
+
+	/**
+	 * \brief Release a reference on a slot
+	 *
+	 * Unless this is the last reference, this only decrements the reference count of the slot atomically, without looking up or locking the store. The last reference is released by freeDBManager().
+	 *
+	 * \param location The location URL of the slot
+	 * \param slot The slot
+	 */
+	void releaseSlot(const std::string& location, DBManagerAllocationSlot& slot);
+
 	/**
 	 * \brief Increment reference count for a specific location
 	 *
@@ -223,12 +383,23 @@ private:
 	 * \brief Extract the path part of a location URL
 	 *
 	 * locationUrlToPath("sqlite:///tmp") => "/tmp"
+	 * locationUrlToPath("sqlite:///tmp/db?journal_mode=wal") => "/tmp/db"
 	 *
 	 * \param location The URL string
 	 * \return The path part as a string
 	 */
 	std::string locationUrlToPath(const std::string& location) const;
 
+	/**
+	 * \brief Extract the options part of a location URL
+	 *
+	 * locationUrlToOptions("sqlite:///tmp/db?journal_mode=wal&readers=4") => {"journal_mode": "wal", "readers": "4"}
+	 *
+	 * \param location The URL string
+	 * \return The options, by name (an option without a value is mapped to an empty string)
+	 */
+	std::map<std::string, std::string> locationUrlToOptions(const std::string& location) const;
+
 	/**
 	 * \brief Free all DB managers that have been allocated by this factory
 	 *
@@ -240,8 +411,32 @@ private:
 	 */
 	void freeAllDBManagers(const bool& ignoreRefCount = false);
 
-	std::map<std::string, DBManagerAllocationSlot> managersStore;	/*!< A map (containing elements called "slots" in this code) storing all allocated instances of DBManager objects. The key is a location string, the payload is an DBManagerAllocationSlot object */
-	/* Note: when accessing an element of this map, use the std::map::at() method, because DBManagerAllocationSlot's constructor requires one argument and std::map::operator[] needs to be able to insert an element using a constructor without argument */
+	/**
+	 * \brief Close the connections of the least recently used SQLite databases, until at most maxOpenDatabases are open
+	 *
+	 * \param except A manager whose connection must not be closed (the one being opened), or NULL
+	 */
+	void closeIdleDatabases(const SQLiteDBManager* except);
+
+	/**
+	 * \brief Start limiting the open connections of a sqlite:// manager (see setMaxOpenDatabases())
+	 *
+	 * \param manager The manager, just allocated by this factory
+	 */
+	void registerSQLiteDBManager(SQLiteDBManager* manager);
+
+	/**
+	 * \brief Stop limiting the open connections of a sqlite:// manager, before it is deallocated
+	 *
+	 * \param manager The manager
+	 */
+	void unregisterSQLiteDBManager(const SQLiteDBManager* manager);
+
+	DBManagerStoreShard managersStore[DBMANAGER_FACTORY_SHARDS];	/*!< The maps (containing elements called "slots" in this code) storing all allocated instances of DBManager objects, split in shards that are locked independently (see getShard()) */
+	std::atomic<unsigned int> maxOpenDatabases;	/*!< The maximum number of sqlite:// managers with an open connection, 0 for no limit */
+	std::mutex sqliteManagersMut;	/*!< The mutex protecting sqliteManagers (locked after the mutex of a shard or of a manager, never before) */
+	std::vector<SQLiteDBManager*> sqliteManagers;	/*!< The sqlite:// managers allocated by this factory, whose connections may be closed to honour maxOpenDatabases */
+	/* Note: when accessing an element of these maps, use the std::map::at() method, because DBManagerAllocationSlot's constructor requires one argument and std::map::operator[] needs to be able to insert an element using a constructor without argument */
 
 };
 
@@ -82,6 +82,22 @@ public:
 		}
 	}
 
+	/**
+	 * \brief Check if the factory has allocated a DBManager for a specific location (even if it is not referenced)
+	 *
+	 * \param location The URL of the database
+	 * \return true if a slot exists for \p location
+	 */
+	bool isAllocated(const std::string& location) const {
+		try {
+			this->factory.getRefCount(location);
+			return true;
+		}
+		catch (const std::out_of_range& ex) {
+			return false;
+		}
+	}
+
 	/**
 	 * \brief Free all DB managers that have been allocated by this factory
 	 */
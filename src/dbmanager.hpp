@@ -40,9 +40,104 @@ If not, see <http://www.gnu.org/licenses/>.
 #include <map>
 #include <exception>
 #include <mutex>
+#include <functional>
+#include <future>
+#include <memory>
 
 #include "dbmanagerapi.hpp"	// For LIBDBMANAGER_API
 
+/**
+ * \struct DBMigrationOperation
+ *
+ * \brief Description of one of the operations a migration would perform on a database.
+ *
+ */
+struct DBMigrationOperation {
+	std::string operation;           /*!< The kind of operation: create-table, add-columns, drop-columns, rebuild-table, drop-table, create-relation, create-index, drop-index, insert-default-records or apply-policy */
+	std::string table;               /*!< The name of the table the operation applies to */
+	std::vector<std::string> fields; /*!< The names of the fields the operation applies to, if any */
+	unsigned long long rows;         /*!< The number of rows the operation will copy, insert or delete */
+};
+
+/**
+ * \enum DBManagerError
+ *
+ * \brief Cause of the failure of the last request of a thread (see DBManager::getLastError()).
+ *
+ */
+enum class DBManagerError {
+	None,   /*!< No database error occurred (the request succeeded, or failed for a logical reason, eg: no matching record) */
+	Busy,   /*!< The database was locked by another connection or process for longer than the busy timeout: the request can be retried later */
+	Other   /*!< Any other database error */
+};
+
+/**
+ * \struct DBBusyStatistics
+ *
+ * \brief Counters of the time a manager spent waiting for a database locked by another connection or process.
+ *
+ */
+struct DBBusyStatistics {
+	unsigned long long retries;          /*!< The number of times a locked database was waited for before retrying */
+	unsigned long long waitMicroseconds; /*!< The total time spent waiting, in microseconds */
+	unsigned long long timeouts;         /*!< The number of times waiting was given up (the request then failed with DBManagerError::Busy) */
+};
+
+/**
+ * \interface DBSnapshot
+ *
+ * \brief Interface for reading a database as it was at a given time (see DBManager::snapshot()).
+ *
+ * All the reads of a snapshot see the same state of the database, whatever is written to the database meanwhile.
+ * A snapshot can be used by several threads, its reads are then run one after the other.
+ *
+ */
+class LIBDBMANAGER_API DBSnapshot {
+
+public:
+	/**
+	 * \brief Destructor, releases the snapshot
+	 */
+	virtual ~DBSnapshot() { }
+
+	/**
+	 * \brief table content getter
+	 *
+	 * \param table The name of the SQL table.
+	 * \param columns The columns name to obtain from the table. Leave empty for all columns.
+	 * \param distinct Set to true to remove duplicated records from the result.
+	 * \return The records list obtained from the SQL table (see DBManager::get()).
+	 */
+	virtual std::vector< std::map<std::string, std::string> > get(const std::string& table, const std::vector<std::string >& columns = std::vector<std::string >(), const bool& distinct = false) const = 0;
+
+	/**
+	 * \brief table record counter
+	 *
+	 * \param table The name of the SQL table.
+	 * \param refFields The reference fields values to identify the records to count. Leave empty to count all records.
+	 * \return The number of matching records (see DBManager::count()).
+	 */
+	virtual unsigned long long count(const std::string& table, const std::map<std::string, std::string>& refFields = std::map<std::string, std::string>()) const = 0;
+
+	/**
+	 * \brief linked records getter
+	 *
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \return The linked records, for each linked table (see DBManager::getLinkedRecords()).
+	 */
+	virtual std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecords(const std::string& table, const std::map<std::string, std::string>& record) const = 0;
+
+	/**
+	 * \brief linked records counter
+	 *
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \return The number of linked records, for each relationship of table (see DBManager::countLinked()).
+	 */
+	virtual std::map<std::string, unsigned int> countLinked(const std::string& table, const std::map<std::string, std::string>& record) const = 0;
+};
+
 /**
  * \interface DBManager
  *
@@ -53,13 +148,27 @@ If not, see <http://www.gnu.org/licenses/>.
  */
 class LIBDBMANAGER_API DBManager {
 
-protected:
+public:
 	/**
 	 * \brief Base class destructor
 	 *
-	 * This destructor is protected to force calling the derived class destructor... never the base class destructor
+	 * This destructor is virtual, so that managers can be destroyed through a DBManager pointer, whatever their type
 	 */
-	~DBManager() { } // Lionel: FIXME: -Weffc++ will still complain because derived class do not have virtual destructors
+	virtual ~DBManager() { }
+
+protected:
+
+	/**
+	 * \brief last error accessor
+	 *
+	 * Implementations reset it when a request starts, and set it when the request fails because of a database error.
+	 *
+	 * \return The cause of the failure of the last request run by the calling thread.
+	 */
+	static DBManagerError& lastError() noexcept {
+		static thread_local DBManagerError error = DBManagerError::None;
+		return error;
+	}
 
 public:
 	/**
@@ -75,6 +184,18 @@ public:
 	 */
 	virtual std::vector< std::map<std::string, std::string> > get(const std::string& table, const std::vector<std::string >& columns = std::vector<std::string >(), const bool& distinct = false, const bool& isAtomic = true) const noexcept = 0;
 
+	/**
+	 * \brief table record counter
+	 *
+	 * Counts the records of a table, without fetching them.
+	 *
+	 * \param table The name of the SQL table.
+	 * \param refFields The reference fields values to identify the records to count. Leave empty to count all records.
+	 * \param isAtomic A flag to do the operations in an atomic way.
+	 * \return The number of matching records (0 on error).
+	 */
+	virtual unsigned long long count(const std::string& table, const std::map<std::string, std::string>& refFields = std::map<std::string, std::string>(), const bool& isAtomic = true) const = 0;
+
 	/**
 	 * \brief table record setter
 	 *
@@ -149,6 +270,30 @@ public:
 	 */
 	virtual bool unlinkRecords(const std::string& table1, const std::map<std::string, std::string>& record1, const std::string& table2, const std::map<std::string, std::string>& record2, const bool & isAtomic = true) = 0;
 
+	/**
+	 * \brief table record setter
+	 *
+	 * Allows to link many pairs of records from 2 different tables in one call. A relationship must exists between those tables. If given records do not exist in tables, they are inserted.
+	 * \param table1 The name of the first SQL table that contains the first record of each pair.
+	 * \param table2 The name of the second SQL table that contains the second record of each pair.
+	 * \param pairs The pairs of records to link (first: the record in table1, second: the record in table2).
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return The success or failure of the operation. Pairs that were already linked are not considered as a failure.
+	 */
+	virtual bool linkRecords(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs, const bool & isAtomic = true) = 0;
+
+	/**
+	 * \brief table record setter
+	 *
+	 * Allows to unlink many pairs of records from 2 different tables in one call. A relationship must exists between those tables. Pairs that are not linked are ignored.
+	 * \param table1 The name of the first SQL table that contains the first record of each pair.
+	 * \param table2 The name of the second SQL table that contains the second record of each pair.
+	 * \param pairs The pairs of records to unlink (first: the record in table1, second: the record in table2).
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return The success or failure of the operation. Pairs that were not linked are not considered as a failure.
+	 */
+	virtual bool unlinkRecords(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs, const bool & isAtomic = true) = 0;
+
 	/**
 	 * \brief table record getter
 	 *
@@ -160,14 +305,121 @@ public:
 	 */
 	virtual std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecords(const std::string& table, const std::map<std::string, std::string>& record, const bool & isAtomic = true) const = 0;
 
+	/**
+	 * \brief table record setter
+	 *
+	 * Allows to link 2 records from 2 different tables, given their ids. A relationship must exists between those tables. Records must already exist in tables.
+	 * \param table1 The name of the first SQL table that contains the first record to link.
+	 * \param id1 The id of the first record in table1.
+	 * \param table2 The name of the second SQL table that contains the second record to link.
+	 * \param id2 The id of the second record in table2.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return The success or failure of the operation.
+	 */
+	virtual bool linkById(const std::string& table1, const std::string& id1, const std::string& table2, const std::string& id2, const bool & isAtomic = true) = 0;
+
+	/**
+	 * \brief table record setter
+	 *
+	 * Allows to unlink 2 records from 2 different tables, given their ids. A relationship must exists between those tables.
+	 * \param table1 The name of the first SQL table that contains the first record to unlink.
+	 * \param id1 The id of the first record in table1.
+	 * \param table2 The name of the second SQL table that contains the second record to unlink.
+	 * \param id2 The id of the second record in table2.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return The success or failure of the operation.
+	 */
+	virtual bool unlinkById(const std::string& table1, const std::string& id1, const std::string& table2, const std::string& id2, const bool & isAtomic = true) = 0;
+
+	/**
+	 * \brief table record getter
+	 *
+	 * Allows to obtain all records linked to a specific record, given its id.
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param id The id of the record in table.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return All the records linked to the specified record organized by tables.
+	 */
+	virtual std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecordsById(const std::string& table, const std::string& id, const bool & isAtomic = true) const = 0;
+
+	/**
+	 * \brief table record getter
+	 *
+	 * Allows to obtain all records reachable from a specific record by following a chain of relationships (eg: all devices of a site, through the path zone, room, device).
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param path The names of the tables to go through, in order. A relationship must exist between each table and the next one in the path.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return All the records reached at each step of the path, organized by tables.
+	 */
+	virtual std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecords(const std::string& table, const std::map<std::string, std::string>& record, const std::vector<std::string>& path, const bool & isAtomic = true) const = 0;
+
+	/**
+	 * \brief table record getter
+	 *
+	 * Allows to obtain all records reachable from a specific record by following at most depth relationships, whatever the tables.
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param depth The maximum number of relationships to follow (1 gives the same records as getLinkedRecords()).
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return All the records reachable from the specified record (the record itself excluded), organized by tables.
+	 */
+	virtual std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecordsByDepth(const std::string& table, const std::map<std::string, std::string>& record, const unsigned int& depth, const bool & isAtomic = true) const = 0;
+
+	/**
+	 * \brief table record getter
+	 *
+	 * Allows to obtain a page of the records linked to a specific record through one relationship. Records are sorted by id.
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param relationship The name of the relationship (ie: the name of its joining table).
+	 * \param limit The maximum number of records to return.
+	 * \param afterId The id of the last record of the previous page (leave empty to get the first page).
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return At most limit linked records, whose id is greater than afterId.
+	 */
+	virtual std::vector<std::map<std::string,std::string>> getLinkedRecords(const std::string& table, const std::map<std::string, std::string>& record, const std::string& relationship, const unsigned int& limit, const std::string& afterId = "", const bool & isAtomic = true) const = 0;
+
+	/**
+	 * \brief table record counter
+	 *
+	 * Allows to count the records linked to a specific record, without fetching them.
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return The number of linked records, for each relationship (ie: joining table name) of table.
+	 */
+	virtual std::map<std::string, unsigned int> countLinked(const std::string& table, const std::map<std::string, std::string>& record, const bool & isAtomic = true) const = 0;
+
+	/**
+	 * \brief snapshot getter
+	 *
+	 * Allows to run several reads on the same state of the database, without locking this manager.
+	 * Whether writers continue meanwhile depends on the implementation: with SQLite, they only do in WAL journal mode, otherwise the snapshot blocks them until it is released (see SQLiteDBManager::snapshot()).
+	 * The snapshot must be released before this manager.
+	 * \return A snapshot of the database as it is now, or NULL on error.
+	 */
+	virtual std::unique_ptr<DBSnapshot> snapshot() const = 0;
+
 	/**
 	 * \brief database status check
 	 *
 	 * Allows to check the status of a database. It could be used with a file that describes the schemas of the database. This methods, if properly implemented, may allow to have a migration mechasnism.
 	 * \param isAtomic A boolean to indicates that the operation should be done in an atomic way.
+	 * \param forceFullCheck Implementations may skip checking a database that was already checked against the same description. Set this to true to always check the whole database.
 	 * \return The success or failure of the operation.
 	 */
-	virtual bool checkDefaultTables(const bool& isAtomic = true) { return true; };
+	virtual bool checkDefaultTables(const bool& isAtomic = true, const bool& forceFullCheck = false) { return true; };
+
+	/**
+	 * \brief database migration planning method
+	 *
+	 * Lists the operations that checkDefaultTables() would perform to migrate the database to a new description, without modifying the database.
+	 * \param configurationDescription The database description to migrate to (either the PATH to an XML file, or the XML content itself).
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return The ordered list of operations. It is empty if the database already matches the description, or if the description can't be parsed.
+	 */
+	virtual std::vector<DBMigrationOperation> planMigration(const std::string& configurationDescription, const bool& isAtomic = true) const = 0;
 
 	/**
 	 * \brief table listing method
@@ -188,6 +440,237 @@ public:
 	 */
 	virtual void setDatabaseConfigurationFile(const std::string& databaseConfigurationFile = "") = 0;
 
+	/**
+	 * \brief migration progress callback setter
+	 *
+	 * Sets a function that is called each time a chunk of rows was copied while a table is rebuilt by checkDefaultTables().
+	 * It is called with the manager locked, so it must not use the manager.
+	 *
+	 * \param callback The function to call with the name of the table being copied, the number of rows already copied and the total number of rows to copy. Use an empty function to stop reporting progress.
+	 */
+	virtual void setMigrationProgressCallback(const std::function<void(const std::string&, unsigned long long, unsigned long long)>& callback) { };
+
+	/**
+	 * \brief migration cancellation hook setter
+	 *
+	 * Sets a function that is called before each chunk of rows is copied while a table is rebuilt by checkDefaultTables().
+	 * If it returns true, the migration is stopped and rolled back (if it is atomic), and checkDefaultTables() fails.
+	 * It is called with the manager locked, so it must not use the manager.
+	 *
+	 * \param hook The function to call. Use an empty function to remove the hook.
+	 */
+	virtual void setMigrationCancelHook(const std::function<bool()>& hook) { };
+
+	/**
+	 * \brief last error getter
+	 *
+	 * Requests report failures through their return value (false, or an empty result). This method tells whether the last request run by the calling thread failed because the database was busy, so that it can be retried instead of being given up.
+	 * Asynchronous requests are run by other threads: the futures returned by getAsync() and the other asynchronous methods only hold the result, use submit() to also get the cause of a failure.
+	 *
+	 * \return The cause of the failure of the last request run by the calling thread.
+	 */
+	static DBManagerError getLastError() noexcept {
+		return lastError();
+	}
+
+	/**
+	 * \brief busy statistics getter
+	 *
+	 * \return The counters of the time spent waiting for the database while it was locked by another connection or process (see the busy_timeout option in README.md). The default implementation returns zeros.
+	 */
+	virtual DBBusyStatistics getBusyStatistics() const { return DBBusyStatistics{0, 0, 0}; };
+
+	/**
+	 * \brief asynchronous request submission method
+	 *
+	 * Runs \p request in the background, on the threads running the other asynchronous requests (see getAsync()), then calls \p completion on the same thread.
+	 * This is the building block for integrating this manager with other asynchronous frameworks (see awaitabledbmanager.hpp).
+	 * The default implementation runs both functions immediately, on the calling thread.
+	 *
+	 * \param request The request to run. It is called with the isAtomic flag it must pass to the methods of this manager (false when it is already run in a read transaction on a connection of its own, in which case it must not modify the database). Exceptions it throws are ignored.
+	 * \param completion The function to call after \p request (may be empty). Unlike \p request, it can use this manager freely, for example to resume a coroutine.
+	 * \param readOnly Set to true if \p request only reads the database.
+	 */
+	virtual void post(const std::function<void(bool)>& request, const std::function<void()>& completion, const bool& readOnly = false) {
+		try {
+			request(true);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "post(): request failed: " << e.what() << std::endl;
+		}
+		if (completion) {
+			completion();
+		}
+	}
+
+	/**
+	 * \brief asynchronous request submission method, reporting the cause of failures
+	 *
+	 * Runs \p request in the background like post(), and returns its result with the last error of the thread that ran it (see getLastError()).
+	 * Unlike the futures returned by getAsync() and the other asynchronous methods, this tells whether a failed request can be retried.
+	 *
+	 * \param request The request to run. It is called with the isAtomic flag it must pass to the methods of this manager (see post()).
+	 * \param readOnly Set to true if \p request only reads the database.
+	 * \return A future that will hold the result of \p request and the cause of its failure (or the exception it threw).
+	 */
+	template<typename R>
+	std::future<std::pair<R, DBManagerError>> submit(const std::function<R(bool)>& request, const bool& readOnly = false) {
+		std::shared_ptr<std::promise<std::pair<R, DBManagerError>>> result = std::make_shared<std::promise<std::pair<R, DBManagerError>>>();
+		std::future<std::pair<R, DBManagerError>> future = result->get_future();
+		this->post([request, result](bool isAtomic) {
+			try {
+				R value = request(isAtomic);
+				result->set_value(std::make_pair(value, lastError()));	/* The error was recorded by the thread that ran the request */
+			}
+			catch (...) {
+				result->set_exception(std::current_exception());
+			}
+		}, std::function<void()>(), readOnly);
+		return future;
+	}
+
+	/**
+	 * \brief asynchronous table content getter
+	 *
+	 * Runs get() in the background.
+	 * The default implementation runs each request on a new thread, implementations may run them on their own worker threads instead.
+	 * Asynchronous reads are not ordered with asynchronous writes: to read what a write stored, wait for the future that write returned first.
+	 * The future only holds the result: the cause of a failure (see getLastError()) is only known by the thread that ran the request, use submit() to get it.
+	 *
+	 * \param table The name of the SQL table.
+	 * \param columns The columns name to obtain from the table. Leave empty for all columns.
+	 * \param distinct Set to true to remove duplicated records from the result.
+	 * \return A future that will hold the result of get().
+	 */
+	virtual std::future<std::vector<std::map<std::string, std::string>>> getAsync(const std::string& table, const std::vector<std::string>& columns = std::vector<std::string>(), const bool& distinct = false) const {
+		return std::async(std::launch::async, [this, table, columns, distinct]() { return this->get(table, columns, distinct); });
+	}
+
+	/**
+	 * \brief asynchronous table record setter
+	 *
+	 * Runs insert() in the background, see getAsync().
+	 *
+	 * \param table The name of the SQL table in which the record will be inserted.
+	 * \param values The record to insert in the table.
+	 * \return A future that will hold the result of insert().
+	 */
+	std::future<bool> insertAsync(const std::string& table, const std::map<std::string, std::string>& values) {
+		return this->insertAsync(table, std::vector<std::map<std::string,std::string>>({values}));
+	}
+
+	/**
+	 * \brief asynchronous table record setter
+	 *
+	 * Runs insert() in the background, see getAsync().
+	 *
+	 * \param table The name of the SQL table in which the records will be inserted.
+	 * \param values The records to insert in the table.
+	 * \return A future that will hold the result of insert().
+	 */
+	virtual std::future<bool> insertAsync(const std::string& table, const std::vector<std::map<std::string, std::string>>& values) {
+		return std::async(std::launch::async, [this, table, values]() { return this->insert(table, values); });
+	}
+
+	/**
+	 * \brief asynchronous table record setter
+	 *
+	 * Runs modify() in the background, see getAsync().
+	 *
+	 * \param table The name of the SQL table in which the record will be updated.
+	 * \param refFields The reference fields values to identify the record to update in the table.
+	 * \param values The new record values to update in the table.
+	 * \param insertIfNotExists If set to true, the record will be inserted if it does not exist yet.
+	 * \return A future that will hold the result of modify().
+	 */
+	virtual std::future<bool> modifyAsync(const std::string& table, const std::map<std::string, std::string>& refFields, const std::map<std::string, std::string>& values, const bool& insertIfNotExists = true) {
+		return std::async(std::launch::async, [this, table, refFields, values, insertIfNotExists]() { return this->modify(table, refFields, values, insertIfNotExists); });
+	}
+
+	/**
+	 * \brief asynchronous table record remover
+	 *
+	 * Runs remove() in the background, see getAsync().
+	 *
+	 * \param table The name of the SQL table in which records will be deleted.
+	 * \param refFields The reference fields values to identify the records to delete.
+	 * \return A future that will hold the result of remove().
+	 */
+	virtual std::future<bool> removeAsync(const std::string& table, const std::map<std::string, std::string>& refFields) {
+		return std::async(std::launch::async, [this, table, refFields]() { return this->remove(table, refFields); });
+	}
+
+	/**
+	 * \brief asynchronous records linker
+	 *
+	 * Runs linkRecords() in the background, see getAsync().
+	 *
+	 * \param table1 The first table name.
+	 * \param record1 The record in table1 to link.
+	 * \param table2 The second table name.
+	 * \param record2 The record in table2 to link.
+	 * \return A future that will hold the result of linkRecords().
+	 */
+	virtual std::future<bool> linkRecordsAsync(const std::string& table1, const std::map<std::string, std::string>& record1, const std::string& table2, const std::map<std::string, std::string>& record2) {
+		return std::async(std::launch::async, [this, table1, record1, table2, record2]() { return this->linkRecords(table1, record1, table2, record2); });
+	}
+
+	/**
+	 * \brief asynchronous records linker
+	 *
+	 * Runs linkRecords() on a batch of pairs in the background, see getAsync().
+	 *
+	 * \param table1 The first table name.
+	 * \param table2 The second table name.
+	 * \param pairs The pairs of records to link, the first record of each pair being in table1 and the second one in table2.
+	 * \return A future that will hold the result of linkRecords().
+	 */
+	virtual std::future<bool> linkRecordsAsync(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs) {
+		return std::async(std::launch::async, [this, table1, table2, pairs]() { return this->linkRecords(table1, table2, pairs); });
+	}
+
+	/**
+	 * \brief asynchronous records unlinker
+	 *
+	 * Runs unlinkRecords() in the background, see getAsync().
+	 *
+	 * \param table1 The first table name.
+	 * \param record1 The record in table1 to unlink.
+	 * \param table2 The second table name.
+	 * \param record2 The record in table2 to unlink.
+	 * \return A future that will hold the result of unlinkRecords().
+	 */
+	virtual std::future<bool> unlinkRecordsAsync(const std::string& table1, const std::map<std::string, std::string>& record1, const std::string& table2, const std::map<std::string, std::string>& record2) {
+		return std::async(std::launch::async, [this, table1, record1, table2, record2]() { return this->unlinkRecords(table1, record1, table2, record2); });
+	}
+
+	/**
+	 * \brief asynchronous records unlinker
+	 *
+	 * Runs unlinkRecords() on a batch of pairs in the background, see getAsync().
+	 *
+	 * \param table1 The first table name.
+	 * \param table2 The second table name.
+	 * \param pairs The pairs of records to unlink, the first record of each pair being in table1 and the second one in table2.
+	 * \return A future that will hold the result of unlinkRecords().
+	 */
+	virtual std::future<bool> unlinkRecordsAsync(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs) {
+		return std::async(std::launch::async, [this, table1, table2, pairs]() { return this->unlinkRecords(table1, table2, pairs); });
+	}
+
+	/**
+	 * \brief asynchronous linked records getter
+	 *
+	 * Runs getLinkedRecords() in the background, see getAsync().
+	 *
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \return A future that will hold the result of getLinkedRecords().
+	 */
+	virtual std::future<std::map<std::string, std::vector<std::map<std::string,std::string>>>> getLinkedRecordsAsync(const std::string& table, const std::map<std::string, std::string>& record) const {
+		return std::async(std::launch::async, [this, table, record]() { return this->getLinkedRecords(table, record); });
+	}
+
 	/**
 	 * \brief table dump method
 	 *
@@ -36,39 +36,47 @@ using namespace std;
 
 DBManagerContainer::DBManagerContainer(std::string dbLocation, std::string configurationDescriptionFile, bool exclusive):
 		dbLocation(dbLocation),
-		configurationDescriptionFile(configurationDescriptionFile),
 		exclusive(exclusive),
-		dbm(DBManagerFactory::getInstance().getDBManager(dbLocation, configurationDescriptionFile, exclusive)) {
+		slot(&DBManagerFactory::getInstance().getOrCreateDBManager(dbLocation, configurationDescriptionFile, NULL, exclusive)),
+		dbm(slot->managerPtr) {
 }
 
 DBManagerContainer::DBManagerContainer(const DBManagerContainer& other):
 		dbLocation(other.dbLocation),
-		configurationDescriptionFile(other.configurationDescriptionFile),
 		exclusive(other.exclusive),
-		dbm(DBManagerFactory::getInstance().getDBManager(dbLocation, configurationDescriptionFile, exclusive)) {
+		slot(other.slot),
+		dbm(other.dbm) {
+	if (this->slot != NULL) {
+		DBManagerFactory::getInstance().acquireSlot(*(this->slot));	/* We share the slot of other, no need to look it up again */
+	}
+}
+
+DBManagerContainer::DBManagerContainer(DBManagerContainer&& other) noexcept:
+		dbLocation(std::move(other.dbLocation)),
+		exclusive(other.exclusive),
+		slot(other.slot),
+		dbm(other.dbm) {
+	other.slot = NULL;	/* The reference is now ours, other won't release it */
+	other.dbm = NULL;
 }
 
 DBManagerContainer::~DBManagerContainer() {
-	DBManagerFactory::getInstance().freeDBManager(this->dbLocation);
+	if (this->slot != NULL) {
+		DBManagerFactory::getInstance().releaseSlot(this->dbLocation, *(this->slot));
+	}
 }
 
-void swap(DBManagerContainer& first, DBManagerContainer& second) {
+DBManagerContainer& DBManagerContainer::operator=(DBManagerContainer&& other) noexcept {
+	swap(*this, other);	/* Our previous reference will be released when other is destructed */
+	return *this;
+}
+
+void swap(DBManagerContainer& first, DBManagerContainer& second) noexcept {
 	using std::swap;	// Enable ADL
 
 	swap(first.dbLocation, second.dbLocation);
-	swap(first.configurationDescriptionFile, second.configurationDescriptionFile);
 	swap(first.exclusive, second.exclusive);
-
-	/* We whould use swap() here to be exception safe but DBManager does not implement the swap() method */
-	/* Because we are dealing with references, there is no risk of exception during the following 3 lines, which is what we must ensure in this swap() method */
-	DBManager& temp = first.dbm;
-	try {
-		first.dbm = second.dbm;
-		second.dbm = temp;
-	}
-	catch (exception& ex) {
-		cerr << string(__func__) + "(): Error while swapping arguments' dbm attributes\n";
-		throw ex;
-	}
+	swap(first.slot, second.slot);
+	swap(first.dbm, second.dbm);
 	/* Once we have swapped the members of the two instances... the two instances have actually been swapped */
 }
@@ -40,12 +40,15 @@ If not, see <http://www.gnu.org/licenses/>.
 //Library includes
 #include "dbmanager.hpp"
 
+class DBManagerAllocationSlot;	/* Forward declaration */
+
 /**
  * \class DBManagerContainer
  *
  * \brief Class to encapsulate a DBManager object (generated by class DBManagerFactory)
  * It will ensure the object is created (if not already existing), and the reference count is kepts up to date during the life cycle of DBManagerContainer
- * (DBManagerFactory::getInstance().freeDBManager() will be called when this DBManagerContainer is destructed)
+ * (DBManagerFactory::getInstance().freeDBManager() will be called when the last DBManagerContainer referencing this object is destructed)
+ * A container holds a pointer to the allocation slot of its DBManager in the factory: copying or destructing a container only changes the reference count of this slot (the factory is only looked up when a container is created from a location, or when the last reference is released)
  */
 class LIBDBMANAGER_API DBManagerContainer {
 
@@ -58,7 +61,7 @@ class LIBDBMANAGER_API DBManagerContainer {
 	 * \param first The first object
 	 * \param second The second object
 	 */
-	friend void swap(DBManagerContainer& first, DBManagerContainer& second);
+	friend void swap(DBManagerContainer& first, DBManagerContainer& second) noexcept;
 
 public:
 	/**
@@ -79,6 +82,15 @@ public:
 	 */
 	DBManagerContainer(const DBManagerContainer& other);
 
+	/**
+	 * \brief Move constructor
+	 *
+	 * The reference held by \p other is transferred to the new object, \p other must not be used afterwards (except for being destructed or assigned to)
+	 *
+	 * \param other The object to move from
+	 */
+	DBManagerContainer(DBManagerContainer&& other) noexcept;
+
 	/**
 	 * \brief Class destructor
 	 *
@@ -92,6 +104,16 @@ public:
 	 * Private... we don't accept assignment, just instanciate a new object instead or use references
 	 */
 	DBManagerContainer& operator=(const DBManagerContainer& other) = delete;
+
+	/**
+	 * \brief Move assignment operator
+	 *
+	 * The reference held by \p other is transferred to us, and the reference we held is released when \p other is destructed
+	 *
+	 * \param other The object to move from
+	 * \return Ourselves, with our new identity
+	 */
+	DBManagerContainer& operator=(DBManagerContainer&& other) noexcept;
 	
 	/**
 	 * \brief Attribute getter
@@ -101,15 +123,15 @@ public:
 	 * \return A reference to the encapsulated DBManager object
 	 */
 	inline DBManager& getDBManager() const {
-		return this->dbm;
+		return *(this->dbm);
 	}
 
 private:
 	std::string dbLocation;	/*!< The location URL of the database handled by the DBManager object encapsulated in this container */
-	std::string configurationDescriptionFile;	/*!< The path to the configuration file to use for the encapsulated DBManager object in this container, or the configuration content directly provided as a std::string (no carriage return allowed in this case) */
 	bool exclusive;	/*!< If true, it will be forbidden to share the encapsulated DBManager with any other container. This means copy construction and assignment will fail with an excpetion */
 
-	DBManager& dbm;	/*!< The DBManager object encapsulated in this container. Use DBManagerContainer::getDBManager() method to get access to this attribute */
+	DBManagerAllocationSlot* slot;	/*!< The allocation slot of the encapsulated DBManager in the factory, on which this container holds a reference (NULL if this container was moved from) */
+	DBManager* dbm;	/*!< The DBManager object encapsulated in this container. Use DBManagerContainer::getDBManager() method to get access to this attribute */
 };
 
 #endif //_DBMANAGERCONTAINER_HPP_
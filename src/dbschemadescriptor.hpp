@@ -0,0 +1,132 @@
+/*
+This file is part of libdbmanager
+(see the file COPYING in the root of the sources for a link to the
+homepage of libdbmanager)
+
+libdbmanager is a C++ library providing methods for reading/modifying a
+database using only C++ methods & objects and no SQL
+Copyright (C) 2016 Legrand SA
+
+libdbmanager is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License version 3
+(dated 29 June 2007) as published by the Free Software Foundation.
+
+libdbmanager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with libdbmanager (in the source code, it is enclosed in
+the file named "lgpl-3.0.txt" in the root of the sources).
+If not, see <http://www.gnu.org/licenses/>.
+*/
+/**
+ *
+ * \file dbschemadescriptor.hpp
+ *
+ * \brief Types describing a whole database structure at compile time, as generated by dbmanager-schemagen from an XML database configuration
+ */
+
+#ifndef _DBSCHEMADESCRIPTOR_HPP_
+#define _DBSCHEMADESCRIPTOR_HPP_
+
+//STL includes
+#include <cstddef>
+
+/**
+ * \struct DBFieldDescriptor
+ *
+ * \brief Description of a field of a table (the counterpart of a \<field\> element of the XML database configuration).
+ *
+ */
+struct DBFieldDescriptor {
+	const char* name;          /*!< The name of the field */
+	const char* defaultValue;  /*!< The default value of the field */
+	bool isNotNull;            /*!< Is the field declared NOT NULL? */
+	bool isUnique;             /*!< Is the field declared UNIQUE? */
+};
+
+/**
+ * \struct DBIndexDescriptor
+ *
+ * \brief Description of a secondary index of a table (the counterpart of an \<index\> element of the XML database configuration).
+ *
+ */
+struct DBIndexDescriptor {
+	const char* name;                /*!< The name of the index */
+	const char* const* fields;       /*!< The names of the indexed fields, in order */
+	std::size_t fieldCount;          /*!< The number of indexed fields */
+	bool isUnique;                   /*!< Is the index unique? */
+};
+
+/**
+ * \struct DBRecordValueDescriptor
+ *
+ * \brief Value of one field of a default record.
+ *
+ */
+struct DBRecordValueDescriptor {
+	const char* field;         /*!< The name of the field */
+	const char* value;         /*!< The value of the field */
+};
+
+/**
+ * \struct DBRecordDescriptor
+ *
+ * \brief Description of a default record of a table (the counterpart of a \<record\> element of the XML database configuration).
+ *
+ */
+struct DBRecordDescriptor {
+	const DBRecordValueDescriptor* values;  /*!< The values of the fields of the record */
+	std::size_t valueCount;                 /*!< The number of values */
+};
+
+/**
+ * \struct DBTableDescriptor
+ *
+ * \brief Description of a table (the counterpart of a \<table\> element of the XML database configuration).
+ *
+ */
+struct DBTableDescriptor {
+	const char* name;                          /*!< The name of the table */
+	const DBFieldDescriptor* fields;           /*!< The fields of the table */
+	std::size_t fieldCount;                    /*!< The number of fields */
+	const DBIndexDescriptor* indexes;          /*!< The secondary indexes of the table */
+	std::size_t indexCount;                    /*!< The number of secondary indexes */
+	const DBRecordDescriptor* defaultRecords;  /*!< The records to insert in the table when it is empty, in order */
+	std::size_t defaultRecordCount;            /*!< The number of default records */
+	bool withoutRowid;                         /*!< Shall the table be stored without rowid? */
+	bool strict;                               /*!< Shall the table be a STRICT table? */
+};
+
+/**
+ * \struct DBRelationshipDescriptor
+ *
+ * \brief Description of a relationship between 2 tables (the counterpart of a \<relationship\> element of the XML database configuration).
+ *
+ */
+struct DBRelationshipDescriptor {
+	const char* kind;          /*!< The kind of relationship (only m:n relationships are handled for the moment) */
+	const char* policy;        /*!< The policy used to populate the joining table (none, link-all) */
+	const char* firstTable;    /*!< The name of the first table of the relationship */
+	const char* secondTable;   /*!< The name of the second table of the relationship */
+	bool reverseIndex;         /*!< Shall the second column of the joining table be indexed? */
+};
+
+/**
+ * \struct DBSchemaDescriptor
+ *
+ * \brief Description of a whole database structure (the counterpart of the \<database\> element of the XML database configuration).
+ *
+ * Instances are meant to be generated by dbmanager-schemagen as constexpr objects, and given to DBManagerFactory::getDBManager() instead of an XML database configuration, so that no XML is parsed at runtime.
+ * All pointers must remain valid as long as a DBManager uses the schema.
+ */
+struct DBSchemaDescriptor {
+	const DBTableDescriptor* tables;                 /*!< The tables of the database, in order */
+	std::size_t tableCount;                          /*!< The number of tables */
+	const DBRelationshipDescriptor* relationships;   /*!< The relationships between tables, in order */
+	std::size_t relationshipCount;                   /*!< The number of relationships */
+};
+
+#endif //_DBSCHEMADESCRIPTOR_HPP_
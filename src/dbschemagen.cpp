@@ -0,0 +1,287 @@
+/*
+This file is part of libdbmanager
+(see the file COPYING in the root of the sources for a link to the
+homepage of libdbmanager)
+
+libdbmanager is a C++ library providing methods for reading/modifying a
+database using only C++ methods & objects and no SQL
+Copyright (C) 2016 Legrand SA
+
+libdbmanager is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License version 3
+(dated 29 June 2007) as published by the Free Software Foundation.
+
+libdbmanager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with libdbmanager (in the source code, it is enclosed in
+the file named "lgpl-3.0.txt" in the root of the sources).
+If not, see <http://www.gnu.org/licenses/>.
+*/
+/**
+ *
+ * \file dbschemagen.cpp
+ *
+ * \brief dbmanager-schemagen: compiles an XML database configuration into a C++ header of constexpr descriptors (see dbschemadescriptor.hpp)
+ *
+ * Usage: dbmanager-schemagen <XML database configuration> <C++ namespace> [<output header>]
+ * The header is written to the standard output if no output file is given.
+ *
+ * Besides the DBSchemaDescriptor object (named "schema"), the generated header defines one constant per table name (in the "tables" namespace) and one constant per field name (in the "fields::<table>" namespace), so that code using them gets table and field names checked by the compiler.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <set>
+#include <cctype>	/* For isalnum() */
+
+#include "sqlschema.hpp"
+
+using namespace std;
+
+/**
+ * \brief Reserved C++ keywords, that can't be used as identifiers
+ */
+static const set<string> cppKeywords = {
+	"alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch", "char", "char16_t", "char32_t", "class",
+	"compl", "const", "constexpr", "const_cast", "continue", "decltype", "default", "delete", "do", "double", "dynamic_cast", "else", "enum", "explicit",
+	"export", "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not",
+	"not_eq", "nullptr", "operator", "or", "or_eq", "private", "protected", "public", "register", "reinterpret_cast", "return", "short", "signed",
+	"sizeof", "static", "static_assert", "static_cast", "struct", "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef",
+	"typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while", "xor", "xor_eq"
+};
+
+/**
+ * \brief Convert a table or field name to a C++ identifier
+ *
+ * Characters that are not allowed in identifiers are replaced by '_', names starting with a digit and keywords get a '_' suffix or prefix.
+ *
+ * \param name The name to convert
+ * \return The C++ identifier
+ */
+string toIdentifier(const string& name) {
+	string identifier;
+	for(auto &c : name) {
+		identifier += (isalnum(static_cast<unsigned char>(c)) ? c : '_');
+	}
+	if(identifier.empty() || isdigit(static_cast<unsigned char>(identifier[0])))
+		identifier = "_" + identifier;
+	if(cppKeywords.find(identifier) != cppKeywords.end())
+		identifier += "_";
+	return identifier;
+}
+
+/**
+ * \brief Convert a string to a C++ string literal
+ *
+ * \param value The string to convert
+ * \return The string literal, including its double quotes
+ */
+string toLiteral(const string& value) {
+	stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+	ss << "\"";
+	for(auto &c : value) {
+		unsigned char u = static_cast<unsigned char>(c);
+		if(c == '"' || c == '\\') {
+			ss << "\\" << c;
+		}
+		else if(u < 0x20 || u >= 0x7f) {	/* Always 3 octal digits, so that the next character can't be taken as part of the escape sequence */
+			ss << "\\" << static_cast<char>('0' + (u >> 6)) << static_cast<char>('0' + ((u >> 3) & 7)) << static_cast<char>('0' + (u & 7));
+		}
+		else {
+			ss << c;
+		}
+	}
+	ss << "\"";
+	return ss.str();
+}
+
+/**
+ * \brief Generate the C++ header describing a schema
+ *
+ * \param schema The schema, as parsed from the XML database configuration
+ * \param source The XML database configuration the schema comes from (only used in comments)
+ * \param nameSpace The namespace in which everything is generated
+ * \param out The stream to write the header to
+ * \return true on success, false if two table names (or two field names of a table) give the same C++ identifier
+ */
+bool generateHeader(const SQLSchema& schema, const string& source, const string& nameSpace, ostream& out) {
+
+	vector<SQLTable> tables = schema.getTables();
+	map<string, vector<map<string, string>>> defaultRecords = schema.getDefaultRecords();
+	vector<SQLRelationship> relationships = schema.getRelationships();
+
+	string guard = "_" + toIdentifier(nameSpace) + "_HPP_";
+	for(auto &c : guard) {
+		c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+	}
+
+	out << "/* Generated by dbmanager-schemagen from " << source << ", do not edit */" << endl;
+	out << "#ifndef " << guard << endl;
+	out << "#define " << guard << endl << endl;
+	out << "#include <dbschemadescriptor.hpp>" << endl << endl;
+	out << "namespace " << nameSpace << " {" << endl << endl;
+
+	//Names of tables and fields
+	set<string> tableIdentifiers;
+	out << "namespace tables {" << endl;
+	for(auto &table : tables) {
+		string identifier = toIdentifier(table.getName());
+		if(!tableIdentifiers.insert(identifier).second) {
+			cerr << "Table \"" << table.getName() << "\": identifier " << identifier << " is already used by another table" << endl;
+			return false;
+		}
+		out << "\tconstexpr const char* " << identifier << " = " << toLiteral(table.getName()) << ";" << endl;
+	}
+	out << "} // namespace tables" << endl << endl;
+
+	out << "namespace fields {" << endl;
+	for(auto &table : tables) {
+		set<string> fieldIdentifiers;
+		out << "\tnamespace " << toIdentifier(table.getName()) << " {" << endl;
+		if(table.isReferenced()) {
+			fieldIdentifiers.insert(PK_FIELD_NAME);
+			out << "\t\tconstexpr const char* " << PK_FIELD_NAME << " = " << toLiteral(PK_FIELD_NAME) << ";" << endl;
+		}
+		for(auto &field : table.getFields()) {
+			string identifier = toIdentifier(std::get<0>(field));
+			if(!fieldIdentifiers.insert(identifier).second) {
+				cerr << "Field \"" << std::get<0>(field) << "\" of table \"" << table.getName() << "\": identifier " << identifier << " is already used by another field" << endl;
+				return false;
+			}
+			out << "\t\tconstexpr const char* " << identifier << " = " << toLiteral(std::get<0>(field)) << ";" << endl;
+		}
+		out << "\t} // namespace " << toIdentifier(table.getName()) << endl;
+	}
+	out << "} // namespace fields" << endl << endl;
+
+	//Descriptors, their arrays are named after the position of the table in the schema so that no name can clash
+	out << "namespace detail {" << endl;
+	for(size_t i = 0; i < tables.size(); i++) {
+		const SQLTable& table = tables.at(i);
+		string prefix = "table" + to_string(i);
+
+		vector<tuple<string, string, bool, bool>> fields = table.getFields();
+		if(!fields.empty()) {
+			out << "\tconstexpr DBFieldDescriptor " << prefix << "_fields[] = {" << endl;
+			for(auto &field : fields) {
+				out << "\t\t{ " << toLiteral(std::get<0>(field)) << ", " << toLiteral(std::get<1>(field)) << ", " << (std::get<2>(field) ? "true" : "false") << ", " << (std::get<3>(field) ? "true" : "false") << " }," << endl;
+			}
+			out << "\t};" << endl;
+		}
+
+		vector<tuple<string, vector<string>, bool>> indexes = table.getIndexes();
+		for(size_t j = 0; j < indexes.size(); j++) {
+			out << "\tconstexpr const char* " << prefix << "_index" << j << "_fields[] = {";
+			for(auto &it : std::get<1>(indexes.at(j))) {
+				out << " " << toLiteral(it) << ",";
+			}
+			out << " nullptr };" << endl;	/* Never empty, even if the index has no field */
+		}
+		if(!indexes.empty()) {
+			out << "\tconstexpr DBIndexDescriptor " << prefix << "_indexes[] = {" << endl;
+			for(size_t j = 0; j < indexes.size(); j++) {
+				out << "\t\t{ " << toLiteral(std::get<0>(indexes.at(j))) << ", " << prefix << "_index" << j << "_fields, " << std::get<1>(indexes.at(j)).size() << ", " << (std::get<2>(indexes.at(j)) ? "true" : "false") << " }," << endl;
+			}
+			out << "\t};" << endl;
+		}
+
+		vector<map<string, string>> records;
+		if(defaultRecords.find(table.getName()) != defaultRecords.end())
+			records = defaultRecords[table.getName()];
+		for(size_t j = 0; j < records.size(); j++) {
+			out << "\tconstexpr DBRecordValueDescriptor " << prefix << "_record" << j << "_values[] = {" << endl;
+			for(auto &it : records.at(j)) {
+				out << "\t\t{ " << toLiteral(it.first) << ", " << toLiteral(it.second) << " }," << endl;
+			}
+			out << "\t\t{ nullptr, nullptr }" << endl;	/* Never empty, even if the record has no value */
+			out << "\t};" << endl;
+		}
+		if(!records.empty()) {
+			out << "\tconstexpr DBRecordDescriptor " << prefix << "_records[] = {" << endl;
+			for(size_t j = 0; j < records.size(); j++) {
+				out << "\t\t{ " << prefix << "_record" << j << "_values, " << records.at(j).size() << " }," << endl;
+			}
+			out << "\t};" << endl;
+		}
+	}
+
+	if(!tables.empty()) {
+		out << "\tconstexpr DBTableDescriptor tables[] = {" << endl;
+		for(size_t i = 0; i < tables.size(); i++) {
+			const SQLTable& table = tables.at(i);
+			string prefix = "table" + to_string(i);
+			size_t fieldCount = table.getFields().size();
+			size_t indexCount = table.getIndexes().size();
+			size_t recordCount = (defaultRecords.find(table.getName()) != defaultRecords.end() ? defaultRecords[table.getName()].size() : 0);
+			out << "\t\t{ " << toLiteral(table.getName()) << ", "
+			    << (fieldCount ? prefix + "_fields" : "nullptr") << ", " << fieldCount << ", "
+			    << (indexCount ? prefix + "_indexes" : "nullptr") << ", " << indexCount << ", "
+			    << (recordCount ? prefix + "_records" : "nullptr") << ", " << recordCount << ", "
+			    << (table.isWithoutRowid() ? "true" : "false") << ", " << (table.isStrict() ? "true" : "false") << " }," << endl;
+		}
+		out << "\t};" << endl;
+	}
+
+	if(!relationships.empty()) {
+		out << "\tconstexpr DBRelationshipDescriptor relationships[] = {" << endl;
+		for(auto &it : relationships) {
+			out << "\t\t{ " << toLiteral(it.kind) << ", " << toLiteral(it.policy) << ", " << toLiteral(it.firstTable) << ", " << toLiteral(it.secondTable) << ", " << (it.reverseIndex ? "true" : "false") << " }," << endl;
+		}
+		out << "\t};" << endl;
+	}
+	out << "} // namespace detail" << endl << endl;
+
+	out << "constexpr DBSchemaDescriptor schema = { "
+	    << (tables.empty() ? "nullptr" : "detail::tables") << ", " << tables.size() << ", "
+	    << (relationships.empty() ? "nullptr" : "detail::relationships") << ", " << relationships.size() << " };" << endl << endl;
+
+	out << "} // namespace " << nameSpace << endl << endl;
+	out << "#endif //" << guard << endl;
+
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+
+	if(argc < 3 || argc > 4) {
+		cerr << "Usage: " << argv[0] << " <XML database configuration> <C++ namespace> [<output header>]" << endl;
+		return 2;
+	}
+
+	string source(argv[1]);
+	string nameSpace(argv[2]);
+	if(nameSpace != toIdentifier(nameSpace)) {
+		cerr << "Invalid C++ namespace \"" << nameSpace << "\"" << endl;
+		return 2;
+	}
+
+	SQLSchema schema;
+	if(!schema.parse(source)) {
+		cerr << "Unable to parse XML database configuration " << source << endl;
+		return 1;
+	}
+
+	stringstream header(ios_base::in | ios_base::out | ios_base::ate);
+	if(!generateHeader(schema, source, nameSpace, header))
+		return 1;
+
+	if(argc == 4) {
+		ofstream out(argv[3]);
+		out << header.str();
+		out.close();
+		if(!out) {
+			cerr << "Unable to write " << argv[3] << endl;
+			return 1;
+		}
+	}
+	else {
+		cout << header.str();
+	}
+
+	return 0;
+}
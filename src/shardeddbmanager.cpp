@@ -0,0 +1,870 @@
+/*
+This file is part of libdbmanager
+(see the file COPYING in the root of the sources for a link to the
+homepage of libdbmanager)
+
+libdbmanager is a C++ library providing methods for reading/modifying a
+database using only C++ methods & objects and no SQL
+Copyright (C) 2016 Legrand SA
+
+libdbmanager is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License version 3
+(dated 29 June 2007) as published by the Free Software Foundation.
+
+libdbmanager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with libdbmanager (in the source code, it is enclosed in
+the file named "lgpl-3.0.txt" in the root of the sources).
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "shardeddbmanager.hpp"
+#include <fstream>
+#include <sstream>
+#include <future>
+#include <memory>
+#include <cstdlib>	/* For strtoul() */
+#include <cerrno>
+#include <stdexcept>
+
+extern "C" {
+	#include <sys/stat.h>	/* For mkdir() */
+}
+
+using namespace std;
+
+/**
+ * \def SHARDS_DESCRIPTION_FILE
+ * The file, stored in the directory of the shards, that records the partitioning parameters (they can't change once records have been stored)
+ */
+#define SHARDS_DESCRIPTION_FILE "shards.conf"
+
+/**
+ * \def SHARD_FILE_PREFIX
+ * The prefix of the name of the SQLite database file of each shard (followed by the index of the shard)
+ */
+#define SHARD_FILE_PREFIX "shard-"
+
+/**
+ * \def FNV_OFFSET_BASIS
+ * The initial value of the FNV-1a 64-bit hash used to assign records to shards
+ */
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+
+/**
+ * \def FNV_PRIME
+ * The multiplier of the FNV-1a 64-bit hash used to assign records to shards
+ */
+#define FNV_PRIME 1099511628211ULL
+
+/**
+ * \class ShardedDBSnapshot
+ *
+ * \brief Implementation of the DBSnapshot interface for a sharded database
+ *
+ * Reads are routed to the snapshots of the shards like the reads of the manager. The snapshots of the shards are taken one after the other, so a write spanning several shards may only be seen in some of them.
+ */
+class ShardedDBSnapshot : public DBSnapshot {
+public:
+	/**
+	 * \brief Constructor
+	 *
+	 * \param manager The manager of the database.
+	 * \param shards The snapshots of all the shards, in order.
+	 */
+	ShardedDBSnapshot(const ShardedDBManager& manager, std::vector<std::unique_ptr<DBSnapshot>> shards) :
+			manager(manager),
+			shards(std::move(shards)) {
+	}
+
+	ShardedDBSnapshot(const ShardedDBSnapshot&) = delete;
+	ShardedDBSnapshot& operator=(const ShardedDBSnapshot&) = delete;
+
+	std::vector< std::map<std::string, std::string> > get(const std::string& table, const std::vector<std::string >& columns, const bool& distinct) const {
+		if (!this->manager.isPartitioned(table))
+			return this->shards[0]->get(table, columns, distinct);
+
+		vector<vector<map<string, string>>> parts;
+		for(auto &shard : this->shards) {
+			parts.push_back(shard->get(table, columns, distinct));
+		}
+		return this->manager.mergeRecords(parts, distinct);
+	}
+
+	unsigned long long count(const std::string& table, const std::map<std::string, std::string>& refFields) const {
+		if (!this->manager.isPartitioned(table))
+			return this->shards[0]->count(table, refFields);
+
+		unsigned long long result = 0;
+		for(auto &index : this->manager.shardsOf(table, refFields)) {
+			result += this->shards[index]->count(table, refFields);
+		}
+		return result;
+	}
+
+	std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecords(const std::string& table, const std::map<std::string, std::string>& record) const {
+		vector<map<string, vector<map<string, string>>>> parts;
+		for(auto &index : this->manager.shardsOf(table, record)) {
+			parts.push_back(this->shards[index]->getLinkedRecords(table, record));
+		}
+		return this->manager.mergeLinkedRecords(parts);
+	}
+
+	std::map<std::string, unsigned int> countLinked(const std::string& table, const std::map<std::string, std::string>& record) const {
+		vector<map<string, unsigned int>> parts;
+		for(auto &index : this->manager.shardsOf(table, record)) {
+			parts.push_back(this->shards[index]->countLinked(table, record));
+		}
+		return this->manager.mergeLinkCounts(parts);
+	}
+
+private:
+	const ShardedDBManager& manager;	/*!< The manager of the database, routing the reads */
+	std::vector<std::unique_ptr<DBSnapshot>> shards;	/*!< The snapshots of the shards */
+};
+
+ShardedDBManager::ShardedDBManager(const std::string& directory,
+                                   const std::string& configurationDescriptionFile,
+                                   const std::map<std::string, std::string>& options) :
+			directory(directory),
+			configurationDescriptionFile(configurationDescriptionFile),
+			schemaDescriptor(NULL),
+			key(),
+			shards(),
+			keyedTables(),
+			partitionedTables() {
+
+	this->open(options);
+}
+
+ShardedDBManager::ShardedDBManager(const std::string& directory,
+                                   const DBSchemaDescriptor& schema,
+                                   const std::map<std::string, std::string>& options) :
+			directory(directory),
+			configurationDescriptionFile(),
+			schemaDescriptor(&schema),
+			key(),
+			shards(),
+			keyedTables(),
+			partitionedTables() {
+
+	this->open(options);
+}
+
+ShardedDBManager::~ShardedDBManager() noexcept {
+	for(auto &shard : this->shards) {
+		delete shard;
+	}
+	this->shards.clear();
+}
+
+void ShardedDBManager::open(const std::map<std::string, std::string>& options) {
+
+	/* The partitioning parameters are ours, all other options are passed to each shard */
+	map<string, string> shardOptions(options);
+	unsigned long shardCount = 0;
+	map<string, string>::iterator shardsOption = shardOptions.find("shards");
+	if (shardsOption != shardOptions.end()) {
+		char* end = NULL;
+		shardCount = strtoul(shardsOption->second.c_str(), &end, 10);
+		if (shardsOption->second.empty() || *end != '\0')
+			shardCount = 0;
+		shardOptions.erase(shardsOption);
+	}
+	map<string, string>::iterator keyOption = shardOptions.find("key");
+	if (keyOption != shardOptions.end()) {
+		this->key = keyOption->second;
+		shardOptions.erase(keyOption);
+	}
+	if (shardCount == 0 || this->key.empty()) {
+		throw invalid_argument("Sharded databases need a number of shards and a key field (shards=N&key=field)");
+	}
+
+	if (mkdir(this->directory.c_str(), 0755) != 0 && errno != EEXIST) {
+		throw runtime_error("Unable to create the shards directory " + this->directory);
+	}
+
+	/* Records are already spread over the shards according to the parameters stored when the database was created: refuse other ones */
+	stringstream description;
+	description << "shards=" << shardCount << "\n" << "key=" << this->key << "\n";
+	string descriptionFile = this->directory + "/" + SHARDS_DESCRIPTION_FILE;
+	ifstream storedDescription(descriptionFile);
+	if (storedDescription.is_open()) {
+		stringstream stored;
+		stored << storedDescription.rdbuf();
+		if (stored.str() != description.str()) {
+			throw invalid_argument("Sharding parameters do not match the ones of the existing database in " + this->directory);
+		}
+	}
+	else {
+		ofstream newDescription(descriptionFile);
+		newDescription << description.str();
+		if (!newDescription) {
+			throw runtime_error("Unable to write " + descriptionFile);
+		}
+	}
+
+	try {
+		for(unsigned int i = 0; i < shardCount; i++) {
+			string filename = this->directory + "/" + SHARD_FILE_PREFIX + std::to_string(i) + ".sqlite";
+			if (this->schemaDescriptor != NULL)
+				this->shards.push_back(new SQLiteDBManager(filename, *(this->schemaDescriptor), shardOptions));
+			else
+				this->shards.push_back(new SQLiteDBManager(filename, this->configurationDescriptionFile, shardOptions));
+		}
+	}
+	catch (...) {	/* Release the shards already opened... we are failing at construction */
+		for(auto &shard : this->shards) {
+			delete shard;
+		}
+		this->shards.clear();
+		throw;
+	}
+
+	SQLSchema schema;
+	if (this->loadSchema(schema)) {
+		this->analyzeSchema(schema);
+		this->pruneDefaultRecords(schema);
+	}
+}
+
+bool ShardedDBManager::loadSchema(SQLSchema& schema) const {
+
+	return (this->schemaDescriptor != NULL) ? schema.load(*(this->schemaDescriptor)) : schema.parse(this->configurationDescriptionFile);
+}
+
+void ShardedDBManager::analyzeSchema(const SQLSchema& schema) {
+
+	this->keyedTables.clear();
+	this->partitionedTables.clear();
+	for(auto &table : schema.getTables()) {
+		for(auto &field : table.getFields()) {
+			if (std::get<0>(field) == this->key) {
+				this->keyedTables.emplace(table.getName(), std::get<1>(field));
+				this->partitionedTables.emplace(table.getName());
+			}
+		}
+	}
+	/* Links are stored with the records they link, so the joining table of a keyed table is partitioned too */
+	for(auto &relationship : schema.getRelationships()) {
+		if (this->isKeyed(relationship.firstTable) || this->isKeyed(relationship.secondTable)) {
+			this->partitionedTables.emplace(relationship.firstTable + "_" + relationship.secondTable);
+		}
+	}
+}
+
+void ShardedDBManager::pruneDefaultRecords(const SQLSchema& schema) {
+
+	/* Each shard has inserted the default records of all tables when it was created, keep those of keyed tables in their own shard only */
+	for(auto &it : schema.getDefaultRecords()) {
+		if (!this->isKeyed(it.first))
+			continue;
+		for(auto &record : it.second) {
+			unsigned int owner = this->shardOf(it.first, record);
+			for(unsigned int i = 0; i < this->shards.size(); i++) {
+				if (i == owner || this->shards[i]->count(it.first, record) == 0)
+					continue;
+				/* Default links (see the link-all policy) have been created in this shard too, remove them before the record */
+				for(auto &linked : this->shards[i]->getLinkedRecords(it.first, record)) {
+					vector<pair<map<string, string>, map<string, string>>> pairs;
+					for(auto &linkedRecord : linked.second) {
+						pairs.push_back(make_pair(record, linkedRecord));
+					}
+					this->shards[i]->unlinkRecords(it.first, linked.first, pairs);
+				}
+				this->shards[i]->remove(it.first, record);
+			}
+		}
+	}
+}
+
+DBBusyStatistics ShardedDBManager::getBusyStatistics() const {
+
+	DBBusyStatistics result{0, 0, 0};
+	for(auto &shard : this->shards) {
+		DBBusyStatistics statistics = shard->getBusyStatistics();
+		result.retries += statistics.retries;
+		result.waitMicroseconds += statistics.waitMicroseconds;
+		result.timeouts += statistics.timeouts;
+	}
+	return result;
+}
+
+unsigned int ShardedDBManager::getShardCount() const {
+
+	return this->shards.size();
+}
+
+unsigned int ShardedDBManager::getShardOf(const std::string& keyValue) const {
+
+	/* FNV-1a: unlike std::hash, its result does not depend on the standard library, so records are found again by any build */
+	unsigned long long hash = FNV_OFFSET_BASIS;
+	for(auto &c : keyValue) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= FNV_PRIME;
+	}
+	return hash % this->shards.size();
+}
+
+bool ShardedDBManager::isPartitioned(const std::string& table) const {
+
+	return this->partitionedTables.find(table) != this->partitionedTables.end();
+}
+
+bool ShardedDBManager::isKeyed(const std::string& table) const {
+
+	return this->keyedTables.find(table) != this->keyedTables.end();
+}
+
+unsigned int ShardedDBManager::shardOf(const std::string& table, const std::map<std::string, std::string>& record) const {
+
+	map<string, string>::const_iterator keyValue = record.find(this->key);
+	if (keyValue != record.end())
+		return this->getShardOf(keyValue->second);
+	else
+		return this->getShardOf(this->keyedTables.at(table));	/* The record will get the default value of the key field */
+}
+
+std::set<unsigned int> ShardedDBManager::shardsOf(const std::string& table, const std::map<std::string, std::string>& record) const {
+
+	set<unsigned int> result;
+	if (this->isKeyed(table) && record.find(this->key) != record.end()) {
+		result.emplace(this->getShardOf(record.at(this->key)));
+	}
+	else {	/* Records of replicated tables are in all shards, and records of keyed tables can be in any shard if their key is not given */
+		for(unsigned int i = 0; i < this->shards.size(); i++) {
+			result.emplace(i);
+		}
+	}
+	return result;
+}
+
+std::set<unsigned int> ShardedDBManager::shardsOfPair(const std::string& table1,
+                                                      const std::map<std::string, std::string>& record1,
+                                                      const std::string& table2,
+                                                      const std::map<std::string, std::string>& record2) const {
+
+	set<unsigned int> shards1 = this->shardsOf(table1, record1);
+	set<unsigned int> result;
+	for(auto &shard : this->shardsOf(table2, record2)) {
+		if (shards1.find(shard) != shards1.end())
+			result.emplace(shard);
+	}
+	return result;
+}
+
+template<typename R>
+std::vector<R> ShardedDBManager::scatter(const std::function<R(SQLiteDBManager&, unsigned int, bool)>& request,
+                                         const bool& readOnly,
+                                         const bool& isAtomic,
+                                         const std::set<unsigned int>& shardIndexes) const {
+
+	set<unsigned int> indexes(shardIndexes);
+	if (indexes.empty()) {
+		for(unsigned int i = 0; i < this->shards.size(); i++) {
+			indexes.emplace(i);
+		}
+	}
+
+	vector<future<pair<R, DBManagerError>>> results;
+	for(auto &index : indexes) {
+		SQLiteDBManager* shard = this->shards[index];
+		shared_ptr<promise<pair<R, DBManagerError>>> result = make_shared<promise<pair<R, DBManagerError>>>();
+		results.push_back(result->get_future());
+		if (indexes.size() == 1) {	/* Nothing to parallelize, run the request in the calling thread, as the caller asked */
+			R value = request(*shard, index, isAtomic);
+			result->set_value(make_pair(value, lastError()));
+			continue;
+		}
+		shard->post([request, shard, index, result](bool isAtomic) {
+			try {
+				R value = request(*shard, index, isAtomic);
+				result->set_value(make_pair(value, lastError()));	/* The error was recorded by the thread of the worker pool */
+			}
+			catch (...) {
+				result->set_exception(std::current_exception());
+			}
+		}, []() {}, readOnly);
+	}
+
+	vector<R> values;
+	DBManagerError error = DBManagerError::None;
+	for(auto &result : results) {
+		pair<R, DBManagerError> value = result.get();
+		values.push_back(value.first);
+		if (value.second == DBManagerError::Busy || (value.second == DBManagerError::Other && error == DBManagerError::None))
+			error = value.second;	/* A busy shard means that the request can be retried */
+	}
+	lastError() = error;
+	return values;
+}
+
+std::vector< std::map<std::string, std::string> > ShardedDBManager::get(const std::string& table,
+                                                                        const std::vector<std::string >& columns,
+                                                                        const bool& distinct,
+                                                                        const bool& isAtomic) const noexcept {
+
+	if (!this->isPartitioned(table))
+		return this->shards[0]->get(table, columns, distinct, isAtomic);
+
+	try {
+		vector<vector<map<string, string>>> parts = this->scatter<vector<map<string, string>>>([&table, &columns, distinct](SQLiteDBManager& shard, unsigned int, bool isAtomic) {
+			return shard.get(table, columns, distinct, isAtomic);
+		}, true, isAtomic);
+		return this->mergeRecords(parts, distinct);
+	}
+	catch (const std::exception& e) {
+		cerr << "get: " << e.what() << endl;
+		return vector<map<string, string>>();
+	}
+}
+
+unsigned long long ShardedDBManager::count(const std::string& table,
+                                           const std::map<std::string, std::string>& refFields,
+                                           const bool& isAtomic) const {
+
+	if (!this->isPartitioned(table))
+		return this->shards[0]->count(table, refFields, isAtomic);
+
+	set<unsigned int> shardIndexes = this->shardsOf(table, refFields);
+	if (shardIndexes.size() == 1)
+		return this->shards[*shardIndexes.begin()]->count(table, refFields, isAtomic);
+
+	unsigned long long result = 0;
+	for(auto &part : this->scatter<unsigned long long>([&table, &refFields](SQLiteDBManager& shard, unsigned int, bool isAtomic) {
+		return shard.count(table, refFields, isAtomic);
+	}, true, isAtomic)) {
+		result += part;
+	}
+	return result;
+}
+
+bool ShardedDBManager::insert(const std::string& table,
+                              const std::vector<std::map<std::string , std::string>>& values,
+                              const bool& isAtomic) {
+
+	if (!this->isPartitioned(table)) {	/* Replicated table, all shards must store the records */
+		bool result = true;
+		for(auto part : this->scatter<bool>([&table, &values](SQLiteDBManager& shard, unsigned int, bool isAtomic) {
+			return shard.insert(table, values, isAtomic);
+		}, false, isAtomic)) {
+			result = result && part;
+		}
+		return result;
+	}
+	if (!this->isKeyed(table)) {
+		cerr << "insert: links of the partitioned joining table " << table << " must be created with linkRecords()" << endl;
+		return false;
+	}
+
+	map<unsigned int, vector<map<string, string>>> recordsByShard;
+	for(auto &record : values) {
+		recordsByShard[this->shardOf(table, record)].push_back(record);
+	}
+	if (recordsByShard.size() == 1)
+		return this->shards[recordsByShard.begin()->first]->insert(table, recordsByShard.begin()->second, isAtomic);
+
+	set<unsigned int> shardIndexes;
+	for(auto &it : recordsByShard) {
+		shardIndexes.emplace(it.first);
+	}
+	bool result = true;
+	for(auto part : this->scatter<bool>([&table, &recordsByShard](SQLiteDBManager& shard, unsigned int index, bool isAtomic) {
+		return shard.insert(table, recordsByShard.at(index), isAtomic);
+	}, false, isAtomic, shardIndexes)) {
+		result = result && part;
+	}
+	return result;
+}
+
+bool ShardedDBManager::modify(const std::string& table,
+                              const std::map<std::string, std::string>& refFields,
+                              const std::map<std::string, std::string >& values,
+                              const bool& insertIfNotExists,
+                              const bool& isAtomic) noexcept {
+
+	try {
+		if (!this->isPartitioned(table)) {	/* Replicated table, all shards must store the modification */
+			bool result = true;
+			for(auto part : this->scatter<bool>([&table, &refFields, &values, insertIfNotExists](SQLiteDBManager& shard, unsigned int, bool isAtomic) {
+				return shard.modify(table, refFields, values, insertIfNotExists, isAtomic);
+			}, false, isAtomic)) {
+				result = result && part;
+			}
+			return result;
+		}
+
+		map<string, string>::const_iterator newKey = values.find(this->key);
+		map<string, string>::const_iterator refKey = refFields.find(this->key);
+		if (newKey != values.end() && (refKey == refFields.end() || refKey->second != newKey->second)) {
+			cerr << "modify: the key field " << this->key << " of a record can't be modified" << endl;
+			return false;
+		}
+
+		set<unsigned int> shardIndexes = this->shardsOf(table, refFields);
+		if (shardIndexes.size() == 1)
+			return this->shards[*shardIndexes.begin()]->modify(table, refFields, values, insertIfNotExists, isAtomic);
+
+		/* The matching records can be in any shard, they are modified where they are */
+		bool result = false;
+		for(auto part : this->scatter<bool>([&table, &refFields, &values](SQLiteDBManager& shard, unsigned int, bool isAtomic) {
+			return shard.modify(table, refFields, values, false, isAtomic);
+		}, false, isAtomic)) {
+			result = result || part;
+		}
+		if (!result && insertIfNotExists && this->isKeyed(table)) {	/* No record matched, insert the record we would have got after modification (see SQLiteDBManager::modify()) */
+			map<string, string> record(values);
+			record.insert(refFields.begin(), refFields.end());
+			result = this->shards[this->shardOf(table, record)]->insert(table, vector<map<string, string>>({record}), isAtomic);
+		}
+		return result;
+	}
+	catch (const std::exception& e) {
+		cerr << "modify: " << e.what() << endl;
+		return false;
+	}
+}
+
+bool ShardedDBManager::remove(const std::string& table,
+                              const std::map<std::string, std::string>& refFields,
+                              const bool& isAtomic) {
+
+	if (!this->isPartitioned(table)) {	/* Replicated table, all shards must store the removal */
+		bool result = true;
+		for(auto part : this->scatter<bool>([&table, &refFields](SQLiteDBManager& shard, unsigned int, bool isAtomic) {
+			return shard.remove(table, refFields, isAtomic);
+		}, false, isAtomic)) {
+			result = result && part;
+		}
+		return result;
+	}
+
+	set<unsigned int> shardIndexes = this->shardsOf(table, refFields);
+	if (shardIndexes.size() == 1)
+		return this->shards[*shardIndexes.begin()]->remove(table, refFields, isAtomic);
+
+	bool result = false;
+	for(auto part : this->scatter<bool>([&table, &refFields](SQLiteDBManager& shard, unsigned int, bool isAtomic) {
+		return shard.remove(table, refFields, isAtomic);
+	}, false, isAtomic)) {
+		result = result || part;	/* Matching records may only exist in some shards */
+	}
+	return result;
+}
+
+bool ShardedDBManager::linkRecords(const std::string& table1,
+                                   const std::map<std::string, std::string>& record1,
+                                   const std::string& table2,
+                                   const std::map<std::string, std::string>& record2,
+                                   const bool& isAtomic) {
+
+	return this->linkRecords(table1, table2, vector<pair<map<string, string>, map<string, string>>>({make_pair(record1, record2)}), isAtomic);
+}
+
+bool ShardedDBManager::unlinkRecords(const std::string& table1,
+                                     const std::map<std::string, std::string>& record1,
+                                     const std::string& table2,
+                                     const std::map<std::string, std::string>& record2,
+                                     const bool& isAtomic) {
+
+	return this->unlinkRecords(table1, table2, vector<pair<map<string, string>, map<string, string>>>({make_pair(record1, record2)}), isAtomic);
+}
+
+bool ShardedDBManager::linkRecords(const std::string& table1,
+                                   const std::string& table2,
+                                   const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs,
+                                   const bool& isAtomic) {
+
+	map<unsigned int, vector<pair<map<string, string>, map<string, string>>>> pairsByShard;
+	if (!this->groupPairs(__func__, table1, table2, pairs, pairsByShard))
+		return false;
+	if (pairsByShard.size() == 1)
+		return this->shards[pairsByShard.begin()->first]->linkRecords(table1, table2, pairsByShard.begin()->second, isAtomic);
+
+	set<unsigned int> shardIndexes;
+	for(auto &it : pairsByShard) {
+		shardIndexes.emplace(it.first);
+	}
+	bool result = true;
+	for(auto part : this->scatter<bool>([&table1, &table2, &pairsByShard](SQLiteDBManager& shard, unsigned int index, bool isAtomic) {
+		return shard.linkRecords(table1, table2, pairsByShard.at(index), isAtomic);
+	}, false, isAtomic, shardIndexes)) {
+		result = result && part;
+	}
+	return result;
+}
+
+bool ShardedDBManager::unlinkRecords(const std::string& table1,
+                                     const std::string& table2,
+                                     const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs,
+                                     const bool& isAtomic) {
+
+	map<unsigned int, vector<pair<map<string, string>, map<string, string>>>> pairsByShard;
+	if (!this->groupPairs(__func__, table1, table2, pairs, pairsByShard))
+		return false;
+	if (pairsByShard.size() == 1)
+		return this->shards[pairsByShard.begin()->first]->unlinkRecords(table1, table2, pairsByShard.begin()->second, isAtomic);
+
+	set<unsigned int> shardIndexes;
+	for(auto &it : pairsByShard) {
+		shardIndexes.emplace(it.first);
+	}
+	bool result = true;
+	for(auto part : this->scatter<bool>([&table1, &table2, &pairsByShard](SQLiteDBManager& shard, unsigned int index, bool isAtomic) {
+		return shard.unlinkRecords(table1, table2, pairsByShard.at(index), isAtomic);
+	}, false, isAtomic, shardIndexes)) {
+		result = result && part;
+	}
+	return result;
+}
+
+bool ShardedDBManager::groupPairs(const std::string& caller,
+                                  const std::string& table1,
+                                  const std::string& table2,
+                                  const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs,
+                                  std::map<unsigned int, std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>>& pairsByShard) const {
+
+	bool partitioned = this->isKeyed(table1) || this->isKeyed(table2);
+	for(auto &it : pairs) {
+		set<unsigned int> shardIndexes = this->shardsOfPair(table1, it.first, table2, it.second);
+		if (shardIndexes.empty()) {
+			cerr << caller << ": records of " << table1 << " and " << table2 << " are stored in different shards" << endl;
+			return false;
+		}
+		if (partitioned && shardIndexes.size() > 1) {
+			cerr << caller << ": the key field " << this->key << " is needed to find the shard of the records of " << table1 << " and " << table2 << endl;
+			return false;
+		}
+		for(auto &shard : shardIndexes) {
+			pairsByShard[shard].push_back(it);
+		}
+	}
+	return true;
+}
+
+std::vector<std::map<std::string, std::string>> ShardedDBManager::mergeRecords(const std::vector<std::vector<std::map<std::string, std::string>>>& parts, const bool& distinct) const {
+
+	vector<map<string, string>> result;
+	set<map<string, string>> seen;
+	for(auto &part : parts) {
+		for(auto &record : part) {
+			if (!distinct || seen.insert(record).second)	/* Records are only distinct within each shard */
+				result.push_back(record);
+		}
+	}
+	return result;
+}
+
+std::map<std::string, unsigned int> ShardedDBManager::mergeLinkCounts(const std::vector<std::map<std::string, unsigned int>>& parts) const {
+
+	map<string, unsigned int> result(parts.at(0));
+	for(unsigned int i = 1; i < parts.size(); i++) {
+		for(auto &it : parts[i]) {
+			if (this->isPartitioned(it.first))	/* Each link is stored in one shard only */
+				result[it.first] += it.second;
+		}
+	}
+	return result;
+}
+
+std::map<std::string, std::vector<std::map<std::string,std::string>>> ShardedDBManager::mergeLinkedRecords(const std::vector<std::map<std::string, std::vector<std::map<std::string,std::string>>>>& parts) const {
+
+	map<string, vector<map<string, string>>> result;
+	map<string, set<map<string, string>>> seen;
+	for(auto &part : parts) {
+		for(auto &it : part) {
+			vector<map<string, string>>& records = result[it.first];
+			for(auto &record : it.second) {
+				/* Records of replicated tables are the same in all shards */
+				if (this->isKeyed(it.first) || seen[it.first].insert(record).second)
+					records.push_back(record);
+			}
+		}
+	}
+	return result;
+}
+
+std::map<std::string, std::vector<std::map<std::string,std::string>>> ShardedDBManager::getLinkedRecords(const std::string& table,
+                                                                                                          const std::map<std::string, std::string>& record,
+                                                                                                          const bool& isAtomic) const {
+
+	set<unsigned int> shardIndexes = this->shardsOf(table, record);
+	if (shardIndexes.size() == 1)
+		return this->shards[*shardIndexes.begin()]->getLinkedRecords(table, record, isAtomic);
+
+	return this->mergeLinkedRecords(this->scatter<map<string, vector<map<string, string>>>>([&table, &record](SQLiteDBManager& shard, unsigned int, bool isAtomic) {
+		return shard.getLinkedRecords(table, record, isAtomic);
+	}, true, isAtomic));
+}
+
+bool ShardedDBManager::linkById(const std::string& table1,
+                                const std::string& id1,
+                                const std::string& table2,
+                                const std::string& id2,
+                                const bool& isAtomic) {
+
+	cerr << "linkById: record ids are not unique across shards, use linkRecords() instead" << endl;
+	return false;
+}
+
+bool ShardedDBManager::unlinkById(const std::string& table1,
+                                  const std::string& id1,
+                                  const std::string& table2,
+                                  const std::string& id2,
+                                  const bool& isAtomic) {
+
+	cerr << "unlinkById: record ids are not unique across shards, use unlinkRecords() instead" << endl;
+	return false;
+}
+
+std::map<std::string, std::vector<std::map<std::string,std::string>>> ShardedDBManager::getLinkedRecordsById(const std::string& table,
+                                                                                                              const std::string& id,
+                                                                                                              const bool& isAtomic) const {
+
+	cerr << "getLinkedRecordsById: record ids are not unique across shards, use getLinkedRecords() instead" << endl;
+	return map<string, vector<map<string, string>>>();
+}
+
+std::map<std::string, std::vector<std::map<std::string,std::string>>> ShardedDBManager::getLinkedRecords(const std::string& table,
+                                                                                                          const std::map<std::string, std::string>& record,
+                                                                                                          const std::vector<std::string>& path,
+                                                                                                          const bool& isAtomic) const {
+
+	set<unsigned int> shardIndexes = this->shardsOf(table, record);
+	if (shardIndexes.size() == 1)
+		return this->shards[*shardIndexes.begin()]->getLinkedRecords(table, record, path, isAtomic);
+
+	return this->mergeLinkedRecords(this->scatter<map<string, vector<map<string, string>>>>([&table, &record, &path](SQLiteDBManager& shard, unsigned int, bool isAtomic) {
+		return shard.getLinkedRecords(table, record, path, isAtomic);
+	}, true, isAtomic));
+}
+
+std::map<std::string, std::vector<std::map<std::string,std::string>>> ShardedDBManager::getLinkedRecordsByDepth(const std::string& table,
+                                                                                                                 const std::map<std::string, std::string>& record,
+                                                                                                                 const unsigned int& depth,
+                                                                                                                 const bool& isAtomic) const {
+
+	set<unsigned int> shardIndexes = this->shardsOf(table, record);
+	if (shardIndexes.size() == 1)
+		return this->shards[*shardIndexes.begin()]->getLinkedRecordsByDepth(table, record, depth, isAtomic);
+
+	return this->mergeLinkedRecords(this->scatter<map<string, vector<map<string, string>>>>([&table, &record, depth](SQLiteDBManager& shard, unsigned int, bool isAtomic) {
+		return shard.getLinkedRecordsByDepth(table, record, depth, isAtomic);
+	}, true, isAtomic));
+}
+
+std::vector<std::map<std::string,std::string>> ShardedDBManager::getLinkedRecords(const std::string& table,
+                                                                                  const std::map<std::string, std::string>& record,
+                                                                                  const std::string& relationship,
+                                                                                  const unsigned int& limit,
+                                                                                  const std::string& afterId,
+                                                                                  const bool& isAtomic) const {
+
+	set<unsigned int> shardIndexes = this->shardsOf(table, record);
+	if (shardIndexes.size() == 1)
+		return this->shards[*shardIndexes.begin()]->getLinkedRecords(table, record, relationship, limit, afterId, isAtomic);
+	if (!this->isPartitioned(relationship))	/* All links are in the first shard */
+		return this->shards[0]->getLinkedRecords(table, record, relationship, limit, afterId, isAtomic);
+
+	cerr << "getLinkedRecords: pages are based on record ids, which are not unique across shards (the key field " << this->key << " is needed)" << endl;
+	return vector<map<string, string>>();
+}
+
+std::map<std::string, unsigned int> ShardedDBManager::countLinked(const std::string& table,
+                                                                  const std::map<std::string, std::string>& record,
+                                                                  const bool& isAtomic) const {
+
+	set<unsigned int> shardIndexes = this->shardsOf(table, record);
+	if (shardIndexes.size() == 1)
+		return this->shards[*shardIndexes.begin()]->countLinked(table, record, isAtomic);
+
+	return this->mergeLinkCounts(this->scatter<map<string, unsigned int>>([&table, &record](SQLiteDBManager& shard, unsigned int, bool isAtomic) {
+		return shard.countLinked(table, record, isAtomic);
+	}, true, isAtomic));
+}
+
+std::unique_ptr<DBSnapshot> ShardedDBManager::snapshot() const {
+
+	vector<unique_ptr<DBSnapshot>> shardSnapshots;
+	for(auto &shard : this->shards) {
+		shardSnapshots.push_back(shard->snapshot());
+		if (!shardSnapshots.back())
+			return unique_ptr<DBSnapshot>();
+	}
+	return unique_ptr<DBSnapshot>(new ShardedDBSnapshot(*this, std::move(shardSnapshots)));
+}
+
+bool ShardedDBManager::checkDefaultTables(const bool& isAtomic, const bool& forceFullCheck) {
+
+	bool result = true;
+	for(auto part : this->scatter<bool>([forceFullCheck](SQLiteDBManager& shard, unsigned int, bool isAtomic) {
+		return static_cast<DBManager&>(shard).checkDefaultTables(isAtomic, forceFullCheck);	/* Only public in the DBManager interface */
+	}, false, isAtomic)) {
+		result = result && part;
+	}
+
+	SQLSchema schema;
+	if (result && this->loadSchema(schema)) {	/* Default records may have been inserted again in emptied tables */
+		this->pruneDefaultRecords(schema);
+	}
+	return result;
+}
+
+std::vector<DBMigrationOperation> ShardedDBManager::planMigration(const std::string& configurationDescription,
+                                                                  const bool& isAtomic) const {
+
+	return this->shards[0]->planMigration(configurationDescription, isAtomic);
+}
+
+std::vector< std::string > ShardedDBManager::listTables(const bool& isAtomic) const {
+
+	return this->shards[0]->listTables(isAtomic);
+}
+
+void ShardedDBManager::setDatabaseConfigurationFile(const std::string& databaseConfigurationFile) {
+
+	this->configurationDescriptionFile = databaseConfigurationFile;
+	this->schemaDescriptor = NULL;	/* The XML configuration replaces any precompiled description */
+	for(auto &shard : this->shards) {
+		shard->setDatabaseConfigurationFile(databaseConfigurationFile);
+	}
+	SQLSchema schema;
+	if (schema.parse(databaseConfigurationFile)) {
+		this->analyzeSchema(schema);
+	}
+}
+
+void ShardedDBManager::setMigrationProgressCallback(const std::function<void(const std::string&, unsigned long long, unsigned long long)>& callback) {
+
+	for(auto &shard : this->shards) {
+		shard->setMigrationProgressCallback(callback);
+	}
+}
+
+void ShardedDBManager::setMigrationCancelHook(const std::function<bool()>& hook) {
+
+	for(auto &shard : this->shards) {
+		shard->setMigrationCancelHook(hook);
+	}
+}
+
+std::string ShardedDBManager::to_string(const std::string& dumpTableName) const {
+
+	stringstream result;
+	for(unsigned int i = 0; i < this->shards.size(); i++) {
+		result << "Shard " << i << ":\n" << this->shards[i]->to_string(dumpTableName);
+	}
+	return result.str();
+}
+
+std::string ShardedDBManager::dumpTablesAsHtml() const {
+
+	stringstream result;
+	for(unsigned int i = 0; i < this->shards.size(); i++) {
+		result << "<h1>Shard " << i << "</h1>\n" << this->shards[i]->dumpTablesAsHtml();
+	}
+	return result.str();
+}
@@ -0,0 +1,574 @@
+/*
+This file is part of libdbmanager
+(see the file COPYING in the root of the sources for a link to the
+homepage of libdbmanager)
+
+libdbmanager is a C++ library providing methods for reading/modifying a
+database using only C++ methods & objects and no SQL
+Copyright (C) 2016 Legrand SA
+
+libdbmanager is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License version 3
+(dated 29 June 2007) as published by the Free Software Foundation.
+
+libdbmanager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with libdbmanager (in the source code, it is enclosed in
+the file named "lgpl-3.0.txt" in the root of the sources).
+If not, see <http://www.gnu.org/licenses/>.
+*/
+/**
+ *
+ * \file shardeddbmanager.hpp
+ *
+ * \brief Implementation of the DBManager interface spreading one database over several SQLite files
+ */
+
+#ifndef _SHARDED_DBMANAGER_HPP_
+#define _SHARDED_DBMANAGER_HPP_
+
+//STL includes
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <utility>
+#include <functional>
+
+//Project includes
+#include "dbmanager.hpp"
+#include "dbschemadescriptor.hpp"
+#include "sqlitedbmanager.hpp"
+#include "sqlschema.hpp"
+
+/**
+ * \class ShardedDBManager
+ *
+ * \brief Class for managing requests to a database partitioned over several sqlite3 databases (shards).
+ *
+ * All shards are stored in the same directory, and have the same structure.
+ * Tables that contain the key field are partitioned: each of their records is stored in the shard given by a hash of its key value.
+ * Other tables are replicated: their records are written to all shards, and read from the first one.
+ * The joining table of a relationship involving a partitioned table is partitioned too.
+ *
+ * Requests on a partitioned table with a key value are run by the shard of this value only.
+ * Other requests are run by all shards in parallel (using their worker pools, see SQLiteDBManager::post()), and their results are merged.
+ * Requests run by several shards are atomic on each shard, but not across shards.
+ * Their isAtomic flag is ignored (as if it was true): the worker pool of each shard runs its part of the request atomically, either on its writer thread or in a read transaction of a reader thread. It is only passed to the shard when a single shard runs the request.
+ *
+ * Limitations:
+ * - records can only be linked if they are stored in the same shard (records of replicated tables are stored in all shards),
+ * - the key value of a record can't be modified (this would move the record to another shard),
+ * - uniqueness is only enforced within each shard,
+ * - record ids are only unique within each shard, so methods using ids (linkById(), unlinkById(), getLinkedRecordsById(), paginated getLinkedRecords()) are not supported across shards.
+ */
+class ShardedDBManager : public DBManager {
+
+public:
+	/**
+	 * \brief Constructor.
+	 *
+	 * \param directory The directory containing the SQLite database files of the shards (created if it does not exist).
+	 * \param configurationDescriptionFile The configuration file for database migration.
+	 * \param options Options applied when the database is opened:
+	 *        - "shards": the number of shards (mandatory).
+	 *        - "key": the name of the field used to partition records (mandatory).
+	 *        - other options are passed to the SQLiteDBManager of each shard.
+	 */
+	ShardedDBManager(const std::string& directory, const std::string& configurationDescriptionFile, const std::map<std::string, std::string>& options);
+
+	/**
+	 * \brief Constructor from a precompiled schema.
+	 *
+	 * \param directory The directory containing the SQLite database files of the shards (created if it does not exist).
+	 * \param schema The description of the database structure, as generated by dbmanager-schemagen (it must outlive this object).
+	 * \param options Options applied when the database is opened (see the other constructor).
+	 */
+	ShardedDBManager(const std::string& directory, const DBSchemaDescriptor& schema, const std::map<std::string, std::string>& options);
+
+	/**
+	 * \brief Destructor.
+	 */
+	~ShardedDBManager() noexcept;
+
+	ShardedDBManager(const ShardedDBManager& other) = delete;
+	ShardedDBManager& operator=(const ShardedDBManager& other) = delete;
+
+	/**
+	 * \brief table content getter
+	 *
+	 * This method is the implementation of the DBManager interface get method. Records of partitioned tables are fetched from all shards in parallel.
+	 *
+	 * \param table The name of the SQL table.
+	 * \param columns The columns name to obtain from the table. Leave empty for all columns.
+	 * \param distinct Set to true to remove duplicated records from the result.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return vector< map<string, string> > The record list obtained from the SQL table.
+	 */
+	std::vector< std::map<std::string, std::string> > get(const std::string& table, const std::vector<std::string >& columns = std::vector<std::string >(), const bool& distinct = false, const bool& isAtomic = true) const noexcept;
+
+	/**
+	 * \brief table record counter
+	 *
+	 * This method is the implementation of the DBManager interface count method. Records of partitioned tables are counted by the shard of the key value in \p refFields, or by all shards in parallel.
+	 *
+	 * \param table The name of the SQL table.
+	 * \param refFields The reference fields values to identify the records to count. Leave empty to count all records.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return The number of matching records (0 on error).
+	 */
+	unsigned long long count(const std::string& table, const std::map<std::string, std::string>& refFields = std::map<std::string, std::string>(), const bool& isAtomic = true) const;
+
+	/**
+	 * \brief table record setter
+	 *
+	 * This method is the implementation of the DBManager interface insert method. Each record of a partitioned table is inserted in the shard of its key value (or of the default value of the key field).
+	 *
+	 * \param table The name of the SQL table in which the records will be inserted.
+	 * \param values The records to insert in the table.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool insert(const std::string& table, const std::vector<std::map<std::string , std::string>>& values = std::vector<std::map<std::string , std::string >>(), const bool& isAtomic = true);
+
+	/**
+	 * \brief table record setter
+	 *
+	 * This method is the implementation of the DBManager interface modify method. The key value of a record can't be modified.
+	 *
+	 * \param table The name of the SQL table in which the record will be updated.
+	 * \param refFields The reference fields values to identify the record to update in the table.
+	 * \param values The new record values to update in the table.
+	 * \param insertIfNotExists If set to true, the record will be inserted if it does not exist yet.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool modify(const std::string& table, const std::map<std::string, std::string>& refFields, const std::map<std::string, std::string >& values, const bool& insertIfNotExists = true, const bool& isAtomic = true) noexcept;
+
+	/**
+	 * \brief table record remover
+	 *
+	 * This method is the implementation of the DBManager interface remove method.
+	 *
+	 * \param table The name of the SQL table in which records will be deleted.
+	 * \param refFields The reference fields values to identify the records to delete.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool remove(const std::string& table, const std::map<std::string, std::string>& refFields, const bool& isAtomic = true);
+
+	/**
+	 * \brief records linker
+	 *
+	 * This method is the implementation of the DBManager interface linkRecords method. Both records must be stored in the same shard.
+	 *
+	 * \param table1 The first table name.
+	 * \param record1 The record in table1 to link.
+	 * \param table2 The second table name.
+	 * \param record2 The record in table2 to link.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool linkRecords(const std::string& table1, const std::map<std::string, std::string>& record1, const std::string& table2, const std::map<std::string, std::string>& record2, const bool & isAtomic = true);
+
+	/**
+	 * \brief records unlinker
+	 *
+	 * This method is the implementation of the DBManager interface unlinkRecords method.
+	 *
+	 * \param table1 The first table name.
+	 * \param record1 The record in table1 to unlink.
+	 * \param table2 The second table name.
+	 * \param record2 The record in table2 to unlink.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool unlinkRecords(const std::string& table1, const std::map<std::string, std::string>& record1, const std::string& table2, const std::map<std::string, std::string>& record2, const bool & isAtomic = true);
+
+	/**
+	 * \brief records linker
+	 *
+	 * This method is the implementation of the DBManager interface linkRecords method, for a batch of pairs. The pairs are grouped by shard, and the groups are linked in parallel.
+	 *
+	 * \param table1 The first table name.
+	 * \param table2 The second table name.
+	 * \param pairs The pairs of records to link, the first record of each pair being in table1 and the second one in table2.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool linkRecords(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs, const bool & isAtomic = true);
+
+	/**
+	 * \brief records unlinker
+	 *
+	 * This method is the implementation of the DBManager interface unlinkRecords method, for a batch of pairs.
+	 *
+	 * \param table1 The first table name.
+	 * \param table2 The second table name.
+	 * \param pairs The pairs of records to unlink, the first record of each pair being in table1 and the second one in table2.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool unlinkRecords(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs, const bool & isAtomic = true);
+
+	/**
+	 * \brief linked records getter
+	 *
+	 * This method is the implementation of the DBManager interface getLinkedRecords method.
+	 *
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return map<string, vector<map<string,string>>> The linked records, for each linked table.
+	 */
+	std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecords(const std::string& table, const std::map<std::string, std::string>& record, const bool & isAtomic = true) const;
+
+	/**
+	 * \brief records linker
+	 *
+	 * Not supported: record ids are only unique within each shard.
+	 *
+	 * \return false
+	 */
+	bool linkById(const std::string& table1, const std::string& id1, const std::string& table2, const std::string& id2, const bool & isAtomic = true);
+
+	/**
+	 * \brief records unlinker
+	 *
+	 * Not supported: record ids are only unique within each shard.
+	 *
+	 * \return false
+	 */
+	bool unlinkById(const std::string& table1, const std::string& id1, const std::string& table2, const std::string& id2, const bool & isAtomic = true);
+
+	/**
+	 * \brief linked records getter
+	 *
+	 * Not supported: record ids are only unique within each shard.
+	 *
+	 * \return An empty map
+	 */
+	std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecordsById(const std::string& table, const std::string& id, const bool & isAtomic = true) const;
+
+	/**
+	 * \brief linked records getter
+	 *
+	 * This method is the implementation of the DBManager interface getLinkedRecords method, following a path of relationships.
+	 *
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param path The tables to go through.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return map<string, vector<map<string,string>>> The linked records, for each table of the path.
+	 */
+	std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecords(const std::string& table, const std::map<std::string, std::string>& record, const std::vector<std::string>& path, const bool & isAtomic = true) const;
+
+	/**
+	 * \brief linked records getter
+	 *
+	 * This method is the implementation of the DBManager interface getLinkedRecordsByDepth method.
+	 *
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param depth The maximum number of relationships to follow.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return map<string, vector<map<string,string>>> The linked records, for each table.
+	 */
+	std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecordsByDepth(const std::string& table, const std::map<std::string, std::string>& record, const unsigned int& depth, const bool & isAtomic = true) const;
+
+	/**
+	 * \brief linked records getter
+	 *
+	 * This method is the implementation of the DBManager interface paginated getLinkedRecords method.
+	 * It is only supported if \p table is partitioned (the page is read from the shard of \p record), or if the records of \p relationship are stored in the first shard.
+	 *
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param relationship The name of the relationship (ie: the name of its joining table).
+	 * \param limit The maximum number of records to return.
+	 * \param afterId The id of the last record of the previous page (leave empty to get the first page).
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return vector<map<string,string>> At most limit linked records, whose id is greater than afterId.
+	 */
+	std::vector<std::map<std::string,std::string>> getLinkedRecords(const std::string& table, const std::map<std::string, std::string>& record, const std::string& relationship, const unsigned int& limit, const std::string& afterId = "", const bool & isAtomic = true) const;
+
+	/**
+	 * \brief table record counter
+	 *
+	 * This method is the implementation of the DBManager interface countLinked method.
+	 *
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return map<string, unsigned int> The number of linked records, for each relationship of table.
+	 */
+	std::map<std::string, unsigned int> countLinked(const std::string& table, const std::map<std::string, std::string>& record, const bool & isAtomic = true) const;
+
+	/**
+	 * \brief snapshot getter
+	 *
+	 * This method is the implementation of the DBManager interface snapshot method. It takes a snapshot of each shard (see SQLiteDBManager::snapshot()), one after the other: a write spanning several shards may only be seen in some of them.
+	 *
+	 * \return A snapshot of the database, or NULL if a shard could not be opened.
+	 */
+	std::unique_ptr<DBSnapshot> snapshot() const;
+
+	/**
+	 * \brief database migration method
+	 *
+	 * This method is the implementation of the DBManager interface checkDefaultTables method. All shards are migrated in parallel.
+	 *
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \param forceFullCheck Set to true to check the structure of all tables, even if the description did not change.
+	 * \return bool The success or failure of the operation (on all shards).
+	 */
+	bool checkDefaultTables(const bool& isAtomic = true, const bool& forceFullCheck = false);
+
+	/**
+	 * \brief database migration planning method
+	 *
+	 * This method is the implementation of the DBManager interface planMigration method. All shards have the same structure, so the plan of the first one is returned.
+	 *
+	 * \param configurationDescription The configuration file path or content describing the target structure.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return vector<DBMigrationOperation> The operations needed to migrate each shard.
+	 */
+	std::vector<DBMigrationOperation> planMigration(const std::string& configurationDescription, const bool& isAtomic = true) const;
+
+	/**
+	 * \brief table listing method
+	 *
+	 * This method is the implementation of the DBManager interface listTables method.
+	 *
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return vector<string> The list of table names of the database.
+	 */
+	std::vector< std::string > listTables(const bool& isAtomic = true) const;
+
+	/**
+	 * \brief configuration file setter
+	 *
+	 * This method is the implementation of the DBManager interface setDatabaseConfigurationFile method.
+	 *
+	 * \param databaseConfigurationFile The configuration file path or content.
+	 */
+	void setDatabaseConfigurationFile(const std::string& databaseConfigurationFile = "");
+
+	/**
+	 * \brief migration progress callback setter
+	 *
+	 * This method is the implementation of the DBManager interface setMigrationProgressCallback method. The callback is called by the threads migrating the shards, possibly concurrently.
+	 *
+	 * \param callback The function to call after each chunk of rows copied.
+	 */
+	void setMigrationProgressCallback(const std::function<void(const std::string&, unsigned long long, unsigned long long)>& callback);
+
+	/**
+	 * \brief migration cancellation hook setter
+	 *
+	 * This method is the implementation of the DBManager interface setMigrationCancelHook method. The hook is called by the threads migrating the shards, possibly concurrently.
+	 *
+	 * \param hook The function to call before each chunk of rows is copied, the migration is cancelled if it returns true.
+	 */
+	void setMigrationCancelHook(const std::function<bool()>& hook);
+
+	/**
+	 * \brief table dump method
+	 *
+	 * This method is the implementation of the DBManager interface to_string method. Shards are dumped one after the other.
+	 *
+	 * \param dumpTableName A specific table to dump (if empty, we will dump all tables).
+	 * \return A string representing (visually) the requested data.
+	 */
+	std::string to_string(const std::string& dumpTableName = "") const;
+
+	/**
+	 * \brief table dump method
+	 *
+	 * This method is the implementation of the DBManager interface dumpTablesAsHtml method. Shards are dumped one after the other.
+	 *
+	 * \return string The HTML formated string containing infos and contents of tables of the database.
+	 */
+	std::string dumpTablesAsHtml() const;
+
+	/**
+	 * \brief busy statistics getter
+	 *
+	 * This method is the implementation of the DBManager interface getBusyStatistics method.
+	 *
+	 * \return The sum of the counters of all shards.
+	 */
+	DBBusyStatistics getBusyStatistics() const;
+
+	/**
+	 * \brief shard count getter
+	 *
+	 * \return The number of shards.
+	 */
+	unsigned int getShardCount() const;
+
+	/**
+	 * \brief shard lookup method
+	 *
+	 * The shard of a record only depends on its key value and on the number of shards (a stable hash is used, so that records are found again by other builds of this library).
+	 *
+	 * \param keyValue The value of the key field.
+	 * \return The index of the shard storing the records with this key value.
+	 */
+	unsigned int getShardOf(const std::string& keyValue) const;
+
+private:
+	friend class ShardedDBSnapshot;	/* Routes its reads like we do */
+
+	/**
+	 * \brief shards opening method
+	 *
+	 * Checks the options, opens (and migrates) all shards, and removes the default records of partitioned tables from the shards they don't belong to.
+	 *
+	 * \param options The options passed to the constructor.
+	 */
+	void open(const std::map<std::string, std::string>& options);
+
+	/**
+	 * \brief schema loading method
+	 *
+	 * \param schema The schema to fill from the precompiled description or from the configuration file.
+	 * \return true if the description could be loaded.
+	 */
+	bool loadSchema(SQLSchema& schema) const;
+
+	/**
+	 * \brief schema analysis method
+	 *
+	 * Finds out which tables are partitioned.
+	 *
+	 * \param schema The description of the database structure.
+	 */
+	void analyzeSchema(const SQLSchema& schema);
+
+	/**
+	 * \brief table info getter
+	 *
+	 * \param table The name of the table.
+	 * \return true if the records of \p table are spread over the shards, false if they are replicated in all shards.
+	 */
+	bool isPartitioned(const std::string& table) const;
+
+	/**
+	 * \brief default records cleaning method
+	 *
+	 * Each shard inserts the default records of all tables in its empty tables: remove the default records of keyed tables (and their links) from the shards they don't belong to.
+	 *
+	 * \param schema The description of the database structure.
+	 */
+	void pruneDefaultRecords(const SQLSchema& schema);
+
+	/**
+	 * \brief table info getter
+	 *
+	 * \param table The name of the table.
+	 * \return true if \p table contains the key field.
+	 */
+	bool isKeyed(const std::string& table) const;
+
+	/**
+	 * \brief record routing method
+	 *
+	 * \param table The name of a keyed table (see isKeyed()).
+	 * \param record The record.
+	 * \return The shard storing \p record (using the default value of the key field if \p record does not contain it).
+	 */
+	unsigned int shardOf(const std::string& table, const std::map<std::string, std::string>& record) const;
+
+	/**
+	 * \brief record routing method
+	 *
+	 * \param table The name of the table.
+	 * \param record The reference fields values identifying records of \p table.
+	 * \return The shard storing the matching records if \p table is keyed and \p record contains the key field, all shards otherwise.
+	 */
+	std::set<unsigned int> shardsOf(const std::string& table, const std::map<std::string, std::string>& record) const;
+
+	/**
+	 * \brief record routing method
+	 *
+	 * \param table1 The first table name.
+	 * \param record1 The record in table1.
+	 * \param table2 The second table name.
+	 * \param record2 The record in table2.
+	 * \return The shards that store the link between \p record1 and \p record2 (all shards if both tables are replicated), or an empty set if both records are stored in different shards.
+	 */
+	std::set<unsigned int> shardsOfPair(const std::string& table1, const std::map<std::string, std::string>& record1, const std::string& table2, const std::map<std::string, std::string>& record2) const;
+
+	/**
+	 * \brief link routing method
+	 *
+	 * Groups pairs of records by the shard that stores their link.
+	 *
+	 * \param caller The name of the calling method, for error messages.
+	 * \param table1 The first table name.
+	 * \param table2 The second table name.
+	 * \param pairs The pairs of records, the first record of each pair being in table1 and the second one in table2.
+	 * \param[out] pairsByShard The pairs to handle in each shard.
+	 * \return false if a pair can't be handled by one shard (records stored in different shards, or missing key field).
+	 */
+	bool groupPairs(const std::string& caller, const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs, std::map<unsigned int, std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>>& pairsByShard) const;
+
+	/**
+	 * \brief records merging method
+	 *
+	 * \param parts The records found in each shard.
+	 * \param distinct Set to true to remove duplicated records from the result.
+	 * \return The merged records.
+	 */
+	std::vector<std::map<std::string, std::string>> mergeRecords(const std::vector<std::vector<std::map<std::string, std::string>>>& parts, const bool& distinct) const;
+
+	/**
+	 * \brief linked records counts merging method
+	 *
+	 * Links of partitioned joining tables are stored in one shard only, so their counts are summed. Links of replicated joining tables are counted once.
+	 *
+	 * \param parts The counts of linked records found in each shard (at least one).
+	 * \return The merged counts.
+	 */
+	std::map<std::string, unsigned int> mergeLinkCounts(const std::vector<std::map<std::string, unsigned int>>& parts) const;
+
+	/**
+	 * \brief linked records merging method
+	 *
+	 * Merges the linked records found in each shard: records of keyed tables are concatenated, duplicates of records of replicated tables are removed.
+	 *
+	 * \param parts The linked records found in each shard.
+	 * \return The merged linked records.
+	 */
+	std::map<std::string, std::vector<std::map<std::string,std::string>>> mergeLinkedRecords(const std::vector<std::map<std::string, std::vector<std::map<std::string,std::string>>>>& parts) const;
+
+	/**
+	 * \brief parallel request method
+	 *
+	 * Runs \p request on some shards in parallel, each one on the worker pool of its shard, and waits for their results.
+	 * The last error of the calling thread is set from the errors of all shards (see DBManager::getLastError()).
+	 *
+	 * \param request The request, called with the shard, the index of the shard and the isAtomic flag to pass to the methods of the shard.
+	 * \param readOnly Set to true if \p request only reads the database.
+	 * \param isAtomic The isAtomic flag of the caller, passed to \p request if it is run by a single shard (in the calling thread). It is ignored when several shards run \p request: each worker pool then gives its own flag.
+	 * \param shardIndexes The shards to run the request on (leave empty for all shards).
+	 * \return The results of each shard, in the order of \p shardIndexes.
+	 */
+	template<typename R>
+	std::vector<R> scatter(const std::function<R(SQLiteDBManager&, unsigned int, bool)>& request, const bool& readOnly, const bool& isAtomic, const std::set<unsigned int>& shardIndexes = std::set<unsigned int>()) const;
+
+	std::string directory;	/*!< The directory containing the shards */
+	std::string configurationDescriptionFile;	/*!< The configuration file path or the content of this file */
+	const DBSchemaDescriptor* schemaDescriptor;	/*!< The precompiled description of the database structure (NULL when configurationDescriptionFile is used) */
+	std::string key;	/*!< The name of the field used to partition records */
+	std::vector<SQLiteDBManager*> shards;	/*!< The shards */
+	std::map<std::string, std::string> keyedTables;	/*!< The tables containing the key field, with the default value of this field */
+	std::set<std::string> partitionedTables;	/*!< The keyed tables, and the joining tables of their relationships */
+};
+
+#endif //_SHARDED_DBMANAGER_HPP_
@@ -22,23 +22,19 @@ the file named "lgpl-3.0.txt" in the root of the sources).
 If not, see <http://www.gnu.org/licenses/>.
 */
 #include "sqlitedbmanager.hpp"
+#include "sqliteworkerpool.hpp"
 #include <fstream>
-#include <unistd.h>	/* For access() */
 #include <cstdlib>	/* For strtol() */
+#include <algorithm>	/* For find() */
+#include <cctype>	/* For toupper() */
+#include <random>	/* For the jitter of the busy handler */
+#include <thread>	/* For this_thread::sleep_for() */
+#include <chrono>
+#include <sqlite3.h>	/* For sqlite3_busy_handler() */
 
 using namespace SQLite;
 using namespace std;
 
-/**
- * \brief Tests if a file is readable
- *
- * \param filename The name (PATH) of the file to test
- * \return true if the file is readable, false otherwise
- */
-inline bool fileIsReadable(const std::string& filename) {
-	return (access(filename.c_str(), R_OK) == 0);
-}
-
 /* ### Useful note ###
  *
  * Methods that affect the database are built this way : they are separated in 2 methods.
@@ -62,13 +58,351 @@ inline bool fileIsReadable(const std::string& filename) {
 #ifndef SQLITE_OPEN_CREATE
 #define SQLITE_OPEN_CREATE OPEN_CREATE
 #endif
+#ifndef SQLITE_OPEN_READONLY
+#define SQLITE_OPEN_READONLY OPEN_READONLY
+#endif
+
+/**
+ * \def LINKS_CHUNK_SIZE
+ * The maximum number of links written to a joining table by one single SQL statement (each link uses 2 bound parameters, and SQLite limits the number of parameters of a statement to 999 by default)
+ */
+#define LINKS_CHUNK_SIZE 256
+
+/**
+ * \def IDS_CHUNK_SIZE
+ * The maximum number of record ids bound to one single SQL statement when fetching records by ids or walking links from them (SQLite limits the number of parameters of a statement to 999 by default, this leaves room for the other parameters of the statement)
+ */
+#define IDS_CHUNK_SIZE 512
+
+/**
+ * \def REVERSE_INDEX_SUFFIX
+ * The suffix appended to the name of a joining table to name the index on its second column
+ */
+#define REVERSE_INDEX_SUFFIX "#reverse"
+
+/**
+ * \def DEFAULT_MIGRATION_CHUNK_SIZE
+ * The maximum number of rows copied at once when a table is rebuilt during a migration (progress is reported and cancellation is checked between chunks), unless the migration_chunk_size option says otherwise
+ */
+#define DEFAULT_MIGRATION_CHUNK_SIZE 10000
+
+/**
+ * \def DEFAULT_READER_THREADS
+ * The number of reader threads started with the worker pool of a database in WAL journal mode, unless the readers option says otherwise
+ */
+#define DEFAULT_READER_THREADS 2
+
+/**
+ * \def DEFAULT_BUSY_TIMEOUT
+ * The maximum time (in ms) spent waiting for a database locked by another connection or process before a request fails, unless the busy_timeout option says otherwise (0 gives up immediately, like SQLite does by default)
+ */
+#define DEFAULT_BUSY_TIMEOUT 0
+
+/**
+ * \def DEFAULT_BUSY_BACKOFF
+ * The first delay (in ms) waited for a locked database before retrying, unless the busy_backoff option says otherwise. It is doubled at each retry
+ */
+#define DEFAULT_BUSY_BACKOFF 1
+
+/**
+ * \def MAX_BUSY_BACKOFF
+ * The maximum delay (in ms) waited for a locked database before retrying, so that a released lock is noticed early enough even with long timeouts
+ */
+#define MAX_BUSY_BACKOFF 100
+
+/* The clock giving the order in which managers were used (see SQLiteDBManager::getLastUse()) */
+static std::atomic<unsigned long long> useClock(0);
+
+/* The time at which the current thread started waiting for a locked database (see SQLiteDBManager::busyHandler()) */
+static thread_local std::chrono::steady_clock::time_point busyWaitStart;
+
+/* The manager whose worker pool owns the current thread (only set on reader threads, while they run a request), and the read-only connection of this thread (see SQLiteDBManager::conn()) */
+static thread_local const SQLiteDBManager* readerConnectionOwner = NULL;
+static thread_local Database* readerConnection = NULL;
+
+/**
+ * \brief Split ids into chunks small enough to be bound to one SQL statement each (SQLite limits the number of parameters of a statement to 999 by default)
+ *
+ * \param ids The ids
+ * \return The chunks, of at most IDS_CHUNK_SIZE ids each (none if \p ids is empty)
+ */
+static std::vector<std::vector<std::string>> splitIds(const std::set<std::string>& ids) {
+	std::vector<std::vector<std::string>> chunks;
+	for(auto &id : ids) {
+		if(chunks.empty() || chunks.back().size() >= IDS_CHUNK_SIZE)
+			chunks.push_back(std::vector<std::string>());
+		chunks.back().push_back(id);
+	}
+	return chunks;
+}
+
+/**
+ * \brief Get the SQL placeholders for a list of bound parameters
+ *
+ * \param count The number of parameters
+ * \return "?, ?, ..." with \p count placeholders
+ */
+static std::string sqlPlaceholders(const size_t& count) {
+	std::string result;
+	for(size_t i = 0; i < count; i++) {
+		result += (i == 0 ? "?" : ", ?");
+	}
+	return result;
+}
+
+/**
+ * \brief Get the storage options of a table from the SQL statement that created it (they are written after the closing parenthesis of the column definitions)
+ *
+ * This is only used if SQLite is too old to give them in pragma_table_list (before version 3.37.0)
+ *
+ * \param sql The CREATE TABLE statement of the table, as stored in sqlite_master
+ * \param withoutRowid Set to true if the table is stored without rowid
+ * \param strict Set to true if the table is strict
+ */
+static void parseTableOptions(const std::string& sql, bool& withoutRowid, bool& strict) {
+	std::string options = sql.substr(sql.find_last_of(')') + 1);
+	std::transform(options.begin(), options.end(), options.begin(), ::toupper);
+	withoutRowid = (options.find("WITHOUT ROWID") != std::string::npos);
+	strict = (options.find("STRICT") != std::string::npos);
+}
+
+/**
+ * \class SQLiteDBSnapshot
+ *
+ * \brief Implementation of the DBSnapshot interface for a sqlite3 database
+ *
+ * Reads are run by the methods of the manager, with the snapshot connection set as the connection of the calling thread (see SQLiteDBManager::conn()), like requests of reader threads.
+ */
+class SQLiteDBSnapshot : public DBSnapshot {
+public:
+	/**
+	 * \brief Constructor, starts the read transaction
+	 *
+	 * \param manager The manager of the database.
+	 * \param connection A read-only connection to the database, owned by this instance.
+	 */
+	SQLiteDBSnapshot(const SQLiteDBManager& manager, std::unique_ptr<Database> connection) :
+			manager(manager),
+			mut(),
+			connection(std::move(connection)),
+			transaction(new Transaction(*(this->connection))) {
+
+		/* A deferred transaction only gets a snapshot at its first read: read now, so that we see the database as it is when we are created */
+		Statement query(*(this->connection), "SELECT COUNT(*) FROM sqlite_master");
+		query.executeStep();
+	}
+
+	~SQLiteDBSnapshot() noexcept {
+		this->transaction.reset();	/* Rolls back the read transaction before the connection is closed */
+	}
+
+	SQLiteDBSnapshot(const SQLiteDBSnapshot&) = delete;
+	SQLiteDBSnapshot& operator=(const SQLiteDBSnapshot&) = delete;
+
+	std::vector< std::map<std::string, std::string> > get(const std::string& table, const std::vector<std::string >& columns, const bool& distinct) const {
+		return this->run<vector<map<string, string>>>([this, &table, &columns, &distinct]() { return this->manager.get(table, columns, distinct, false); });
+	}
+
+	unsigned long long count(const std::string& table, const std::map<std::string, std::string>& refFields) const {
+		return this->run<unsigned long long>([this, &table, &refFields]() { return this->manager.count(table, refFields, false); });
+	}
+
+	std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecords(const std::string& table, const std::map<std::string, std::string>& record) const {
+		return this->run<map<string, vector<map<string, string>>>>([this, &table, &record]() { return this->manager.getLinkedRecords(table, record, false); });
+	}
+
+	std::map<std::string, unsigned int> countLinked(const std::string& table, const std::map<std::string, std::string>& record) const {
+		return this->run<map<string, unsigned int>>([this, &table, &record]() { return this->manager.countLinked(table, record, false); });
+	}
+
+private:
+	/**
+	 * \brief Runs a read of the manager on the snapshot connection
+	 *
+	 * \param request The read, which must call the methods of the manager with isAtomic set to false.
+	 * \return The result of \p request.
+	 */
+	template<typename R>
+	R run(const std::function<R()>& request) const {
+		std::lock_guard<std::mutex> lock(this->mut);	/* A connection can only run one statement at a time */
+		const SQLiteDBManager* previousOwner = readerConnectionOwner;	/* The calling thread may be a reader thread */
+		Database* previousConnection = readerConnection;
+		readerConnectionOwner = &(this->manager);
+		readerConnection = this->connection.get();
+		try {
+			R result = request();
+			readerConnectionOwner = previousOwner;
+			readerConnection = previousConnection;
+			return result;
+		}
+		catch (...) {
+			readerConnectionOwner = previousOwner;
+			readerConnection = previousConnection;
+			throw;
+		}
+	}
+
+	const SQLiteDBManager& manager;	/*!< The manager of the database */
+	mutable std::mutex mut;	/*!< The mutex serializing the reads of the snapshot */
+	std::unique_ptr<Database> connection;	/*!< The connection of the snapshot (must outlive transaction) */
+	std::unique_ptr<Transaction> transaction;	/*!< The read transaction holding the snapshot */
+};
+
+/**
+ * \class ForeignKeysSuspender
+ *
+ * \brief Disables foreign key constraints on a database during its lifetime, if they were enabled
+ *
+ * Foreign key constraints can't be enabled or disabled inside a transaction, so an instance must be created before the transaction starts, and must be destroyed after it ends.
+ * While foreign keys are disabled, a referenced table can be rebuilt in place without rebuilding the joining tables that reference it (see SQLiteDBManager::rebuildTableCore())
+ */
+class ForeignKeysSuspender {
+public:
+	/**
+	 * \brief Constructor
+	 *
+	 * \param db The database on which foreign keys are suspended
+	 * \param tablesToCheck The set in which the tables whose foreign keys must be checked are recorded while foreign keys are suspended (it is cleared)
+	 */
+	ForeignKeysSuspender(Database& db, std::set<std::string>& tablesToCheck) : db(db), tablesToCheck(tablesToCheck), suspended(false) {
+		this->tablesToCheck.clear();
+		Statement query(this->db, "PRAGMA foreign_keys");
+		this->suspended = (query.executeStep() && query.getColumn(0).getInt() == 1);
+		if(this->suspended)
+			this->db.exec("PRAGMA foreign_keys = OFF");
+	}
+
+	/**
+	 * \brief Destructor, enables foreign keys again if they were suspended
+	 */
+	~ForeignKeysSuspender() noexcept {
+		if(this->suspended) {
+			try {
+				this->db.exec("PRAGMA foreign_keys = ON");
+			}
+			catch(const Exception &e) {
+				cerr << "~ForeignKeysSuspender: " << e.what() << endl;
+			}
+		}
+	}
+
+	ForeignKeysSuspender(const ForeignKeysSuspender&) = delete;
+	ForeignKeysSuspender& operator=(const ForeignKeysSuspender&) = delete;
+
+	/**
+	 * \brief Checks that no foreign key constraint was violated while foreign keys were suspended
+	 *
+	 * This must be run before the transaction is committed
+	 * Only the tables recorded in tablesToCheck are checked, so nothing is done if no table was rebuilt
+	 *
+	 * \return true if all foreign key constraints are satisfied (or if foreign keys were not enabled in the first place)
+	 */
+	bool check() const {
+		if(!this->suspended)
+			return true;
+		try {
+			/* Tables dropped meanwhile are skipped */
+			Statement query(this->db, "SELECT \"table\" FROM sqlite_master, pragma_foreign_key_check(name) WHERE type = 'table' AND name = ?");
+			for(auto &it : this->tablesToCheck) {
+				query.bind(1, it);
+				if(query.executeStep()) {
+					cerr << "ForeignKeysSuspender: foreign key constraint violated in table \"" << query.getColumn(0).getText() << "\"" << endl;
+					return false;
+				}
+				query.reset();
+			}
+			return true;
+		}
+		catch(const Exception &e) {
+			cerr << "ForeignKeysSuspender: " << e.what() << endl;
+			return false;
+		}
+	}
+
+private:
+	Database& db;	/*!< The database on which foreign keys are suspended */
+	std::set<std::string>& tablesToCheck;	/*!< The tables whose foreign keys must be checked */
+	bool suspended;	/*!< Were foreign keys enabled, and thus disabled by this instance? */
+};
+
+/**
+ * \class SQLiteDBManager::ConnectionUse
+ *
+ * \brief Marks the connection of a manager as used by a request run with isAtomic set to false, during its lifetime
+ *
+ * Such requests use the connection without locking the manager, so closeConnection() doesn't close it while an instance exists.
+ * Nothing is counted when the request runs on a snapshot or a reader connection (see conn()): these are never closed by closeConnection().
+ */
+class SQLiteDBManager::ConnectionUse {
+public:
+	/**
+	 * \brief Constructor, opens the connection again if it was closed
+	 *
+	 * \param manager The manager whose connection is used
+	 */
+	explicit ConnectionUse(const SQLiteDBManager& manager) : manager(manager), counted(readerConnectionOwner != &manager) {
+		if(this->counted) {
+			std::lock_guard<std::mutex> lock(this->manager.mut);	/* closeConnection() checks connectionUsers with the manager locked */
+			this->manager.connectionUsers++;
+			try {
+				this->manager.conn();	/* Opens the connection again now, with the manager locked */
+			}
+			catch(const Exception &e) {
+				cerr << "ConnectionUse: " << e.what() << endl;	/* The request fails when it uses the connection */
+			}
+		}
+	}
+
+	/**
+	 * \brief Destructor, the connection can be closed again
+	 */
+	~ConnectionUse() noexcept {
+		if(this->counted)
+			this->manager.connectionUsers--;
+	}
+
+	ConnectionUse(const ConnectionUse&) = delete;
+	ConnectionUse& operator=(const ConnectionUse&) = delete;
+
+private:
+	const SQLiteDBManager& manager;	/*!< The manager whose connection is used */
+	bool counted;	/*!< Is the connection of the manager used (rather than a snapshot or a reader connection)? */
+};
+
 SQLiteDBManager::SQLiteDBManager(const std::string& filename,
-                                 const std::string& configurationDescriptionFile) :
+                                 const std::string& configurationDescriptionFile,
+                                 const std::map<std::string, std::string>& options) :
 			filename(filename),
 			configurationDescriptionFile(configurationDescriptionFile),
+			schemaDescriptor(NULL),
 			mut(),
-			db(new Database(this->filename, SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE)) {
-
+			db(new Database(this->filename, SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE)),
+			migrationProgressCallback(),
+			migrationCancelHook(),
+			migrationChunkSize(DEFAULT_MIGRATION_CHUNK_SIZE),
+			readerCount(DEFAULT_READER_THREADS),
+			workerPoolMut(),
+			workerPool(),
+			busyTimeout(DEFAULT_BUSY_TIMEOUT),
+			busyBackoff(DEFAULT_BUSY_BACKOFF),
+			busyRetries(0),
+			busyWaitTime(0),
+			busyTimeouts(0),
+			journalMode(),
+			closedFingerprint(0),
+			closedSchemaVersion(0),
+			connectionOpen(true),
+			lastUse(0),
+			connectionUsers(0),
+			reopenCallback(),
+			foreignKeysToCheck() {
+
+	this->installBusyHandler(*(this->db));	/* Before the options are applied: changing the journal mode needs to lock the database */
+	if (!this->applyOptions(options)) {
+		delete this->db;
+		this->db = NULL;
+		throw invalid_argument("Invalid database options");
+	}
 	this->db->exec("PRAGMA foreign_keys = ON");	/*Activation of foreign key support in SQLite database */
 	if (!this->checkDefaultTables()) {			  /* Will proceed migration if some changes are detected between configuration file and database state */
 		if (this->db != NULL) {	/* Release memory... we are failing at construction */
@@ -79,7 +413,52 @@ SQLiteDBManager::SQLiteDBManager(const std::string& filename,
 	}
 }
 
+SQLiteDBManager::SQLiteDBManager(const std::string& filename,
+                                 const DBSchemaDescriptor& schema,
+                                 const std::map<std::string, std::string>& options) :
+			filename(filename),
+			configurationDescriptionFile(),
+			schemaDescriptor(&schema),
+			mut(),
+			db(new Database(this->filename, SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE)),
+			migrationProgressCallback(),
+			migrationCancelHook(),
+			migrationChunkSize(DEFAULT_MIGRATION_CHUNK_SIZE),
+			readerCount(DEFAULT_READER_THREADS),
+			workerPoolMut(),
+			workerPool(),
+			busyTimeout(DEFAULT_BUSY_TIMEOUT),
+			busyBackoff(DEFAULT_BUSY_BACKOFF),
+			busyRetries(0),
+			busyWaitTime(0),
+			busyTimeouts(0),
+			journalMode(),
+			closedFingerprint(0),
+			closedSchemaVersion(0),
+			connectionOpen(true),
+			lastUse(0),
+			connectionUsers(0),
+			reopenCallback(),
+			foreignKeysToCheck() {
+
+	this->installBusyHandler(*(this->db));	/* Before the options are applied: changing the journal mode needs to lock the database */
+	if (!this->applyOptions(options)) {
+		delete this->db;
+		this->db = NULL;
+		throw invalid_argument("Invalid database options");
+	}
+	this->db->exec("PRAGMA foreign_keys = ON");	/*Activation of foreign key support in SQLite database */
+	if (!this->checkDefaultTables()) {
+		if (this->db != NULL) {	/* Release memory... we are failing at construction */
+			delete this->db;
+			this->db = NULL;
+		}
+		throw invalid_argument("Invalid precompiled database description");
+	}
+}
+
 SQLiteDBManager::~SQLiteDBManager() noexcept {
+	this->workerPool.reset();	/* Runs the pending asynchronous requests, which still need db */
 	if (this->db != NULL) {
 		delete this->db;
 		this->db = NULL;
@@ -100,13 +479,15 @@ const string SQLiteDBManager::escDQ(const std::string& in) const {
 	return escaped;
 }
 
-bool SQLiteDBManager::checkDefaultTables(const bool& isAtomic) {
+bool SQLiteDBManager::checkDefaultTables(const bool& isAtomic,
+                                         const bool& forceFullCheck) {
+	this->lastError() = DBManagerError::None;
 	if (isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
 
-		Transaction transaction(*(this->db));
-		if (this->checkDefaultTablesCore()) {
-			transaction.commit();
+		ForeignKeysSuspender foreignKeysSuspender(this->conn(), this->foreignKeysToCheck);	/* Must outlive the transaction */
+		Transaction transaction(this->conn());
+		if (this->checkDefaultTablesCore(forceFullCheck) && foreignKeysSuspender.check() && this->commitTransaction(transaction)) {
 			return true;
 		}
 		else {
@@ -114,239 +495,144 @@ bool SQLiteDBManager::checkDefaultTables(const bool& isAtomic) {
 		}
 	}
 	else {
-		return this->checkDefaultTablesCore();
+		ConnectionUse use(*this);
+		return this->checkDefaultTablesCore(forceFullCheck);
 	}
 }
 
-bool SQLiteDBManager::checkDefaultTablesCore() {
+bool SQLiteDBManager::checkDefaultTablesCore(const bool& forceFullCheck) {
 
 	try {
-		bool validXmlContent = false;	/* Do we consider the input XML as valid ? */
 		bool result = false;
-		TiXmlDocument doc;
-		/* Load the default table model base on the provided input XML definition
-		 * This XML can be provided inside a file (this->configurationDescriptionFile then contains the PATH to this file)
-		 * or it can be provided directly as a string buffer (this->configurationDescriptionFile then stores the actual XML content)
-		 */
+		SQLSchema schema;
+		bool loaded = (this->schemaDescriptor != NULL) ? schema.load(*(this->schemaDescriptor)) : schema.parse(this->configurationDescriptionFile);
+		if (!loaded) {
+			throw string("Unable to load any configuration file.");
+		}
 
-		if (fileIsReadable(this->configurationDescriptionFile)) { /* We first check if this->configurationDescriptionFile is an existing file... */
+		vector<SQLTable> tables = schema.getTables();
+		map<string, vector<map<string, string>>> defaultRecords = schema.getDefaultRecords();
+
+		//If the database structure was already checked against this exact schema, and has not been modified since then, there is no need to check it again
+		//We only check the default records and relationships policies, since they depend on the content of tables
+		bool fullCheck = forceFullCheck || (this->getSchemaFingerprintCore(schema) != this->getStoredSchemaFingerprintCore());
 #ifdef DEBUG
-			cout << "Reading XML database description from file " + this->configurationDescriptionFile << endl;
-#endif
-			doc.LoadFile(this->configurationDescriptionFile.c_str());
-			validXmlContent = true;
+		if (!fullCheck) {
+			cout << "Database structure matches the XML database description, skipping the full check" << endl;
 		}
-		else { /* ...as a second chance, we try to parse this->configurationDescriptionFile directly as XML */
-			validXmlContent = (doc.Parse(this->configurationDescriptionFile.data()) == NULL);
-#ifdef DEBUG
-			if (validXmlContent) {
-				cout << "Read XML database description directly from provided buffer" << endl;
-			}
 #endif
-		}
 
-		if (validXmlContent) {
-			vector<SQLTable> tables;
-			map<string, vector<map<string, string>>> defaultRecords;
-			/*
-			 * The expect structure the configuration file is :
-			 * <database>
-			 * 	<table name="...">
-			 * 		<field name="..." default-value="..." is-not-null="..." is-unique="..." />
-			 * 		<field name="..." default-value="..." is-not-null="..." is-unique="..." />
-			 * 		<default-records>
-			 * 			<record>
-			 * 				<field name="..." value="..." />
-			 * 				<field name="..." value="..." />
-			 * 			</record>
-			 * 			<record>
-			 * 				<field name="..." value="..." />
-			 * 				<field name="..." value="..." />
-			 * 			</record>
-			 * 		</default-records>
-			 * 	</table>
-			 * 	<table name="...">
-			 * 		<field name="..." default-value="..." is-not-null="..." is-unique="..." />
-			 * 		<field name="..." default-value="..." is-not-null="..." is-unique="..." />
-			 * 		<default-records>
-			 * 			<record>
-			 * 				<field name="..." value="..." />
-			 * 				<field name="..." value="..." />
-			 * 			</record>
-			 * 			<record>
-			 * 				<field name="..." value="..." />
-			 * 				<field name="..." value="..." />
-			 * 			</record>
-			 * 		</default-records>
-			 * 	</table>
-			 * 	<!-- kind possible value : m:n -->
-			 * 	<!-- policy possible value : none, link-all -->
-			 * 	<relationship kind="..." policy="..." first-table="..." second-table="..." />
-			 * 	<relationship kind="..." policy="..." first-table="..." second-table="..." />
-			 * </database>
-			 */
-			TiXmlElement *dbElem = doc.FirstChildElement();
-			//We check first "basics" tables
-			if(dbElem && (string(dbElem->Value()) == "database")) {
-				TiXmlElement *tableElem = dbElem->FirstChildElement();
-				while(tableElem) {
-					if(string(tableElem->Value()) == "table") {
-						SQLTable table(tableElem->Attribute("name"));
-						TiXmlElement *fieldElem = tableElem->FirstChildElement();
-						while(fieldElem) {
-							if(string(fieldElem->Value()) == "field") {
-								string name = fieldElem->Attribute("name");
-								string defaultValue = fieldElem->Attribute("default-value");
-								bool isNotNull = (string(fieldElem->Attribute("is-not-null")) == "true");
-								bool isUnique  = (string(fieldElem->Attribute("is-unique")) == "true");
-								table.addField(tuple<string,string,bool,bool>(name, defaultValue, isNotNull, isUnique));
-							}
-							else if(string(fieldElem->Value()) == "default-records") {
-								TiXmlElement *recordElem = fieldElem->FirstChildElement();
-								while(recordElem) {
-									if(string(recordElem->Value()) == "record") {
-										map<string, string> record;
-										TiXmlElement *fieldValueElem = recordElem->FirstChildElement();
-										while(fieldValueElem) {
-											if(string(fieldValueElem->Value()) == "field") {
-												string name = fieldValueElem->Attribute("name");
-												string value = fieldValueElem->Attribute("value");
-												record.emplace(name, value);
-											}
-											fieldValueElem = fieldValueElem->NextSiblingElement();
-										}
-										if(defaultRecords.find(table.getName()) != defaultRecords.end()) {
-											defaultRecords[table.getName()].push_back(record);
-										}
-										else {
-											defaultRecords.emplace(table.getName(), vector<map<string, string>>({record}));
-										}
-									}
-									recordElem = recordElem->NextSiblingElement();
-								}
-							}
-							fieldElem = fieldElem->NextSiblingElement();
-						}
-						tables.push_back(table);
-					}
-					tableElem = tableElem->NextSiblingElement();
+		//We check relations in order to add foreign keys and create tables for m:n relationships.
+		set<string> relationShipTables;	//Tables creation for relationship purpose.
+		map<string, string> relationshipPolicies;
+		map<string, vector<string>> relationshipLinkedTables;
+		set<string> referencedTables;
+		for(auto &relationship : schema.getRelationships()) {
+			if(relationship.kind == "m:n") {
+				vector<string> linkedtables;
+				linkedtables.push_back(relationship.firstTable);
+				linkedtables.push_back(relationship.secondTable);
+				string relationshipTableName;
+				if(fullCheck) {
+					relationshipTableName = this->createRelationCore(relationship.kind, linkedtables, relationship.reverseIndex);
 				}
-			}
-
-			//Then we check relations in order to add foreign keys and create tables for m:n relationships.
-			dbElem = doc.FirstChildElement();
-			set<string> relationShipTables;	//Tables creation for relationship purpose.
-			map<string, string> relationshipPolicies;
-			map<string, vector<string>> relationshipLinkedTables;
-			set<string> referencedTables;
-			if(dbElem && (string(dbElem->Value()) == "database")) {
-				TiXmlElement *relationElem = dbElem->FirstChildElement();
-				while(relationElem) {
-					if(string(relationElem->Value()) == "relationship") {
-								string kind = relationElem->Attribute("kind");
-								if(kind == "m:n") {
-									string firstTableName = relationElem->Attribute("first-table");
-									string secondTableName = relationElem->Attribute("second-table");
-
-									for(auto &it : tables) {
-										if(it.getName() == firstTableName || it.getName() == secondTableName) {
-											it.markReferenced();
-										}
-									}
-									vector<string> linkedtables;
-									linkedtables.push_back(firstTableName);
-									linkedtables.push_back(secondTableName);
-									string relationshipTableName = this->createRelationCore(relationElem->Attribute("kind"), linkedtables);
-									relationShipTables.emplace(relationshipTableName);
-									relationshipPolicies.emplace(relationshipTableName, relationElem->Attribute("policy"));
-									relationshipLinkedTables.emplace(relationshipTableName, linkedtables);
-									referencedTables.emplace(firstTableName);
-									referencedTables.emplace(secondTableName);
-								}
-					}
-					relationElem = relationElem->NextSiblingElement();
+				else {
+					relationshipTableName = relationship.firstTable + "_" + relationship.secondTable;
 				}
+				relationShipTables.emplace(relationshipTableName);
+				relationshipPolicies.emplace(relationshipTableName, relationship.policy);
+				relationshipLinkedTables.emplace(relationshipTableName, linkedtables);
+				referencedTables.emplace(relationship.firstTable);
+				referencedTables.emplace(relationship.secondTable);
 			}
-			result = true;
+		}
+		result = true;
 
-			//Check if tables in database match parsed models
+		//Check if tables in database match parsed models
+		if(fullCheck) {
+			map<string, SQLTable> tablesInDb = this->getTablesFromDatabaseCore();	/* All tables are introspected at once */
 			for(auto &table : tables) {
-				result = result && this->checkTableInDatabaseMatchesModelCore(table);
+				result = result && this->checkTableInDatabaseMatchesModelCore(table, tablesInDb);
 			}
+		}
 
-			//Insert the default record specified in the configuration file if the concerned table is empty.
-			for(auto &it : defaultRecords) {
-				if(this->getCore(it.first).empty()) {
-					result = result && this->insertCore(it.first, it.second);
-				}
+		//Insert the default record specified in the configuration file if the concerned table is empty.
+		for(auto &it : defaultRecords) {
+			if(this->isTableEmptyCore(it.first)) {
+				result = result && this->insertCore(it.first, it.second);
 			}
+		}
 
-			//Policy application for all relationship tables.
-			for(auto &it : relationShipTables) {
-				result = result && this->applyPolicyCore(it, relationshipPolicies[it], relationshipLinkedTables[it]);
-			}
+		//Policy application for all relationship tables.
+		for(auto &it : relationShipTables) {
+			result = result && this->applyPolicyCore(it, relationshipPolicies[it], relationshipLinkedTables[it]);
+		}
 
-			if(tables.empty()) {
-				cerr << "WARNING: Be careful there is no table in the database configuration file." << endl;
-			}
+		if(tables.empty()) {
+			cerr << "WARNING: Be careful there is no table in the database configuration file." << endl;
+		}
 
-			//Remove tables that are present in database but not in models
-			set<string> sqliteSpecificTables;		//Tables not to delete if they exist because they are necessary for internal sqlite behavior.
-			sqliteSpecificTables.emplace("sqlite_sequence");
+		if(!fullCheck)
+			return result;
 
-			//We get all tables in database.
-			vector<string> tablesInDbTmp = listTablesCore();
-			set<string> tablesInDb;
-			for(auto &it :tablesInDbTmp) {
-				tablesInDb.emplace(it);
-			}
+		//Remove tables that are present in database but not in models
+		set<string> sqliteSpecificTables;		//Tables not to delete if they exist because they are necessary for internal sqlite behavior.
+		sqliteSpecificTables.emplace("sqlite_sequence");
 
-			//We remove from this list the modelized tables
-			for(auto &table : tables) {
-				if(tablesInDb.find(table.getName()) != tablesInDb.end()) {
-					tablesInDb.erase(tablesInDb.find(table.getName()));
-				}
-			}
+		//We get all tables in database.
+		vector<string> tablesInDbTmp = listTablesCore();
+		set<string> tablesInDb;
+		for(auto &it :tablesInDbTmp) {
+			tablesInDb.emplace(it);
+		}
 
-			//We remove from this list the internal sqlite tables tables
-			for(auto &it : sqliteSpecificTables) {
-				if(tablesInDb.find(it) != tablesInDb.end()) {
-					tablesInDb.erase(tablesInDb.find(it));
-				}
+		//We remove from this list the modelized tables
+		for(auto &table : tables) {
+			if(tablesInDb.find(table.getName()) != tablesInDb.end()) {
+				tablesInDb.erase(tablesInDb.find(table.getName()));
 			}
+		}
 
-			//We remove from this list the relationship tables
-			for(auto &it : relationShipTables) {
-				if(tablesInDb.find(it) != tablesInDb.end()) {
-					tablesInDb.erase(tablesInDb.find(it));
-				}
+		//We remove from this list the internal sqlite tables tables
+		for(auto &it : sqliteSpecificTables) {
+			if(tablesInDb.find(it) != tablesInDb.end()) {
+				tablesInDb.erase(tablesInDb.find(it));
 			}
+		}
 
-			//We remove the unnecessary relationship tables and we list the tables that are referenced so we can remove them properly after removed relationship tables.
-			set<string> tablesToDeleteInSecond;
-			for(auto &it : tablesInDb) {
-				if(this->isReferencedCore(it) && this->getPrimaryKeysCore(it).size() == 1) {
-					tablesToDeleteInSecond.emplace(it);
-				}
-				else {
-					result = result &&  this->deleteTableCore(it);
-				}
+		//We remove from this list the relationship tables
+		for(auto &it : relationShipTables) {
+			if(tablesInDb.find(it) != tablesInDb.end()) {
+				tablesInDb.erase(tablesInDb.find(it));
 			}
+		}
 
-			//We remove those referenced tables.
-			for(auto &it : tablesToDeleteInSecond) {
+		//We remove the unnecessary relationship tables and we list the tables that are referenced so we can remove them properly after removed relationship tables.
+		set<string> tablesToDeleteInSecond;
+		for(auto &it : tablesInDb) {
+			if(this->isReferencedCore(it) && this->getPrimaryKeysCore(it).size() == 1) {
+				tablesToDeleteInSecond.emplace(it);
+			}
+			else {
 				result = result &&  this->deleteTableCore(it);
 			}
+		}
 
-			//Unmarking referenced tables that should't be referenced anymore.
-			for(auto &it : this->listTablesCore()) {
-				if(this->isReferencedCore(it) && (referencedTables.find(it) == referencedTables.end()) && (relationShipTables.find(it) == relationShipTables.end())) {
-					this->unmarkReferencedCore(it);
-				}
+		//We remove those referenced tables.
+		for(auto &it : tablesToDeleteInSecond) {
+			result = result &&  this->deleteTableCore(it);
+		}
+
+		//Unmarking referenced tables that should't be referenced anymore.
+		for(auto &it : this->listTablesCore()) {
+			if(this->isReferencedCore(it) && (referencedTables.find(it) == referencedTables.end()) && (relationShipTables.find(it) == relationShipTables.end())) {
+				this->unmarkReferencedCore(it);
 			}
 		}
-		else {
-			throw string("Unable to load any configuration file.");
+
+		//The database structure now matches the schema, remember it (this must be the last structure modification)
+		if(result) {
+			this->storeSchemaFingerprintCore(this->getSchemaFingerprintCore(schema));
 		}
 
 		return result;
@@ -361,1654 +647,3444 @@ bool SQLiteDBManager::checkDefaultTablesCore() {
 	}
 }
 
-void SQLiteDBManager::checkTableInDatabaseMatchesModel(const SQLTable& model,
-                                                       const bool& isAtomic) noexcept {
-
-	if(isAtomic) {
-		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+unsigned int SQLiteDBManager::getSchemaFingerprintCore(const SQLSchema& schema) const {
 
-		Transaction transaction(*(this->db));
-		if(this->checkTableInDatabaseMatchesModelCore(model))
-			transaction.commit();
-	}
-	else {
-		this->checkTableInDatabaseMatchesModelCore(model);
-	}
+	/* The schema version of SQLite is incremented each time the structure of the database is modified
+	 * Taking it into account ensures that any modification made to the database structure after it was checked (by this library or by anyone else) invalidates the fingerprint
+	 */
+	return schema.getFingerprint(std::to_string(this->getSchemaVersionCore()));
 }
 
-bool SQLiteDBManager::checkTableInDatabaseMatchesModelCore(const SQLTable& model) noexcept {
-	bool result = true;
-	//Create table if it doesn't exist in the database.
-	if (!this->db->tableExists(model.getName())) {
-		result = result && this->createTableCore(model);
-	}
-	else {
-		SQLTable tableInDb = this->getTableFromDatabaseCore(model.getName());
+int SQLiteDBManager::getSchemaVersionCore() const {
 
-		//Add new fields and remove useless ones from the existing table in database if it differ from model.
-		if(model != tableInDb) {
-			result = result && this->addFieldsToTableCore(tableInDb.getName(), model.diff(tableInDb));
-			result = result && this->removeFieldsFromTableCore(tableInDb.getName(), tableInDb.diff(model));
-		}
+	Statement query(this->conn(), "PRAGMA schema_version");
+	if(query.executeStep()) {
+		return query.getColumn(0).getInt();
 	}
-	return result;
-}
 
-bool SQLiteDBManager::createTable(const SQLTable& table,
-                                  const bool& isAtomic) noexcept {
-	if(isAtomic) {
-		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+	return 0;
+}
 
-		Transaction transaction(*(this->db));
+unsigned int SQLiteDBManager::getStoredSchemaFingerprintCore() const {
 
-		bool result = this->createTableCore(table);
-		if(result)
-			transaction.commit();
-		return result;
-	}
-	else {
-		return this->createTableCore(table);
+	Statement query(this->conn(), "PRAGMA user_version");
+	if(query.executeStep()) {
+		return static_cast<unsigned int>(query.getColumn(0).getInt());
 	}
+
+	return 0;
 }
 
-bool SQLiteDBManager::createTableCore(const SQLTable& table) noexcept {
-	try {
-		stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
-		ss << "CREATE TABLE \"" << this->escDQ(table.getName()) << "\" (";
-		const vector< tuple<string,string,bool,bool> > fields = table.getFields();
+void SQLiteDBManager::storeSchemaFingerprintCore(const unsigned int& fingerprint) {
 
-		if (table.isReferenced()) {
-			ss << "\"id\" INTEGER PRIMARY KEY AUTOINCREMENT, ";
-		}
+	/* PRAGMA statements can't take bound parameters, but the fingerprint is a number so there is no need to escape it */
+	this->conn().exec("PRAGMA user_version = " + std::to_string(fingerprint));
+}
 
-		for (vector< tuple<string,string,bool,bool> >::const_iterator it = fields.begin(); it != fields.end(); ++it) {
-			/* Check if iterator is on the first element of the list, and add a separator otherwise */
-			if (it != fields.begin()) {
-				ss << ", ";
-			}
-			const string& fieldName = std::get<0>(*it);
-			const string& defaultValue = std::get<1>(*it);
-			const bool& notNullProperty = std::get<2>(*it);
-			const bool& uniqueProperty = std::get<3>(*it);
-			//0 -> field name
-			//1 -> field default value
-			//2 -> field is not null
-			//3 -> field is unique
-			ss << "\"" << this->escDQ(fieldName) << "\" TEXT ";
-			if (notNullProperty)
-				ss << "NOT NULL ";
-			if (uniqueProperty)
-				ss << "UNIQUE ON CONFLICT ABORT ";
-			ss << "DEFAULT \"" << this->escDQ(defaultValue) << "\"";
-		}
+bool SQLiteDBManager::isTableEmptyCore(const std::string& table) const {
 
+	Statement query(this->conn(), "SELECT 1 FROM \"" + this->escDQ(table) + "\" LIMIT 1");
+	return !query.executeStep();
+}
 
-		ss << ")";
+unsigned long long SQLiteDBManager::getRowCountCore(const std::string& table) const {
 
-		this->db->exec(ss.str());
-		return true;
-	}
-	catch(const Exception & e) {
-		cerr << "createTableCore: " << e.what() << endl;
-		return false;
+	Statement query(this->conn(), "SELECT COUNT(*) FROM \"" + this->escDQ(table) + "\"");
+	if(query.executeStep()) {
+		return static_cast<unsigned long long>(query.getColumn(0).getInt64());
 	}
+
+	return 0;
 }
 
-bool SQLiteDBManager::addFieldsToTable(const std::string& table,
-                                       const std::vector<std::tuple<std::string, std::string, bool, bool> >& fields,
-                                       const bool& isAtomic) noexcept {
+std::vector<DBMigrationOperation> SQLiteDBManager::planMigration(const std::string& configurationDescription,
+                                                                 const bool& isAtomic) const {
 
+	this->lastError() = DBManagerError::None;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		Transaction transaction(*(this->db));
 
-		bool result = this->addFieldsToTableCore(table, fields);
-		if(result)
-			transaction.commit();
-		return result;
+		return this->planMigrationCore(configurationDescription, false);	/* An atomic migration suspends foreign keys (see checkDefaultTables()) */
 	}
 	else {
-		return this->addFieldsToTableCore(table, fields);
+		ConnectionUse use(*this);
+		return this->planMigrationCore(configurationDescription, this->areForeignKeysEnabled());
 	}
 }
 
-bool SQLiteDBManager::addFieldsToTableCore(const std::string& table,
-                                           const std::vector<std::tuple<std::string, std::string, bool, bool> >& fields) noexcept {
+std::vector<DBMigrationOperation> SQLiteDBManager::planMigrationCore(const std::string& configurationDescription,
+                                                                     const bool& foreignKeysEnabled) const {
 
-	/* The logical steps to follow in this methods :
-	 *                     [case where table is not referenced] -> (4) -> (5) -> (6) -------------------------------------
-	 * 					  /                                                                                               \
-	 * (1) -> (2) -> (3)--																								   --> result
-	 * 					  \																								  /
-	 * 					   [case where table is referenced] -> (7) -> (8) -> (9) -> (10) -> (11) -> (12) -> (13) -> (14) -
+	/* The steps below are the ones of checkDefaultTablesCore(), in the same order
+	 * Since each operation depends on the result of the previous ones, the structure and the number of rows of tables are simulated in memory instead of being modified
 	 */
+	vector<DBMigrationOperation> plan;
 	try {
-		bool result = true;
+		SQLSchema schema;
+		if(!schema.parse(configurationDescription)) {
+			cerr << __func__ << "(): unable to load any configuration file." << endl;
+			return plan;
+		}
 
-		if(!fields.empty()) {
-			//(1) We save the current table
-			SQLTable newTable = this->getTableFromDatabaseCore(table);
-			//(2) Then we save table's records
-			vector<map<string, string>> records = this->getCore(table);
+		bool fullCheck = (this->getSchemaFingerprintCore(schema) != this->getStoredSchemaFingerprintCore());
 
-			//(3) We can add the new fields informations
-			for(auto &it : fields) {
-				string name = std::get<0>(it);
-				string dv = std::get<1>(it);
-				bool nn = std::get<2>(it);
-				bool unique = std::get<3>(it);
-				newTable.addField(tuple<string,string,bool,bool>(name, dv, nn, unique));
+		//(1) We get the current structure of the database
+		map<string, SQLTable> tablesInDb = this->getTablesFromDatabaseCore();
+		map<string, unsigned long long> rowCounts;
+		for(auto &it : tablesInDb) {
+			rowCounts[it.first] = this->getRowCountCore(it.first);
+		}
+		map<string, pair<string, string>> relationshipsInDb = this->getRelationshipsCore();
+
+		//Rebuilding a table copies its own records, and the records of its joining tables twice if they have to be moved aside and back (see rebuildTableCore())
+		auto rebuildCost = [this, &rowCounts, &relationshipsInDb, &foreignKeysEnabled](const SQLTable& newTable) {
+			unsigned long long cost = rowCounts[newTable.getName()];
+			if(this->rebuildMovesJoiningTables(newTable, foreignKeysEnabled)) {
+				for(auto &it : relationshipsInDb) {
+					if(it.second.first == newTable.getName() || it.second.second == newTable.getName()) {
+						cost += 2 * rowCounts[it.first];
+					}
+				}
 			}
-
-			if(!newTable.isReferenced()) {
-				//(4) Now that everything is saved, we can drop the "old" table
-				result = result && this->deleteTableCore(table);
-				if(!result)
-					return result;
-
-				//(5) We can recreate the table
-				result = result &&this->createTableCore(newTable);
-				if(!result)
-					return result;
-
-				//(6) The new table is created, populate with old records (new fields will have default value)
-				result = result &&this->insertCore(newTable.getName(), records);
+			return cost;
+		};
+		auto fieldNames = [](const vector<tuple<string, string, bool, bool>>& fields) {
+			vector<string> names;
+			for(auto &it : fields) {
+				names.push_back(std::get<0>(it));
 			}
-			else {
-				//(7) We'll search if a join table (or more) exists. If so, the table is referenced for a m:n relationship, otherwise it's a 1:n or a 1:1 relationship.
-				set<string> linkingTables;
-				for(auto &name : this->listTablesCore()) {
-					if(name.find(table + "_") != string::npos || name.find("_" + table) != string::npos) {
-						linkingTables.emplace(name);
+			return names;
+		};
+
+		//(2) Relationships (sorted by joining table name, as policies are applied in that order)
+		map<string, SQLRelationship> relationships;
+		set<string> referencedTables;
+		for(auto &relationship : schema.getRelationships()) {
+			if(relationship.kind == "m:n") {
+				string relationName = relationship.firstTable + "_" + relationship.secondTable;
+				relationships.emplace(relationName, relationship);
+				referencedTables.emplace(relationship.firstTable);
+				referencedTables.emplace(relationship.secondTable);
+
+				if(!fullCheck)
+					continue;
+
+				string fieldName1 = relationship.firstTable + "#" + PK_FIELD_NAME;
+				string fieldName2 = relationship.secondTable + "#" + PK_FIELD_NAME;
+				if(tablesInDb.find(relationName) == tablesInDb.end()) {
+					//Linked tables that have no primary key yet are rebuilt to get one
+					for(auto &linked : {relationship.firstTable, relationship.secondTable}) {
+						map<string, SQLTable>::iterator table = tablesInDb.find(linked);
+						if(table != tablesInDb.end() && !table->second.isReferenced()) {
+							table->second.markReferenced();
+							plan.push_back(DBMigrationOperation{"rebuild-table", linked, {PK_FIELD_NAME}, rebuildCost(table->second)});
+						}
+					}
+					plan.push_back(DBMigrationOperation{"create-relation", relationName, {fieldName1, fieldName2}, 0});
+					tablesInDb.emplace(relationName, SQLTable(relationName));
+					rowCounts[relationName] = 0;
+					relationshipsInDb.emplace(relationName, make_pair(relationship.firstTable, relationship.secondTable));
+				}
+				else if(relationship.reverseIndex != this->hasReverseIndexCore(relationName)) {
+					if(relationship.reverseIndex) {
+						plan.push_back(DBMigrationOperation{"create-index", relationName, {fieldName2}, rowCounts[relationName]});
+					}
+					else {
+						plan.push_back(DBMigrationOperation{"drop-index", relationName, {fieldName2}, 0});
 					}
 				}
-				//No need to check field properties of linking tables as these tables fit a specific model : 2 integer column noted as primary keys and referencing the primary keys of 2 tables.
+			}
+		}
+
+		//(3) Tables
+		if(fullCheck) {
+			for(auto &model : schema.getTables()) {
+				map<string, SQLTable>::iterator table = tablesInDb.find(model.getName());
+				if(table == tablesInDb.end()) {
+					plan.push_back(DBMigrationOperation{"create-table", model.getName(), fieldNames(model.getFields()), 0});
+					tablesInDb.emplace(model.getName(), model);
+					rowCounts[model.getName()] = 0;
+				}
+				else {
+					//Indexes that are not in the model anymore are dropped first (see checkTableInDatabaseMatchesModelCore())
+					vector<tuple<string, vector<string>, bool>> modelIndexes = model.getIndexes();
+					vector<tuple<string, vector<string>, bool>> keptIndexes;
+					for(auto &it : table->second.getIndexes()) {
+						if(find(modelIndexes.begin(), modelIndexes.end(), it) == modelIndexes.end()) {
+							plan.push_back(DBMigrationOperation{"drop-index", model.getName(), std::get<1>(it), 0});
+						}
+						else {
+							keptIndexes.push_back(it);
+						}
+					}
 
-				if(!linkingTables.empty()) {	//TODO: Handle the 1:1 and 1:n relationships cases.
-					//(8) Now we have all the linker tables names, we can fetch their records.
-					map<string, vector<map<string, string>>> recordsByTable;
-					for(auto &name : linkingTables) {
-						recordsByTable.emplace(name, this->getCore(name));
+					vector<tuple<string, string, bool, bool>> addedFields;
+					vector<tuple<string, string, bool, bool>> removedFields;
+					if(model != table->second) {
+						addedFields = model.diff(table->second);
+						removedFields = table->second.diff(model);
 					}
-					//(9) Now the linking Tables are saved, we can drop them
-					for(auto &name : linkingTables) {
-						result = result && this->deleteTableCore(name);
-						if(!result)
-							return result;
+
+					//New columns are added in place when possible (see addFieldsToTableCore())
+					if(!addedFields.empty()) {
+						if(this->canAddFieldsInPlace(addedFields)) {
+							plan.push_back(DBMigrationOperation{"add-columns", model.getName(), fieldNames(addedFields), 0});
+						}
+						else {
+							plan.push_back(DBMigrationOperation{"rebuild-table", model.getName(), fieldNames(addedFields), rebuildCost(table->second)});
+						}
 					}
-					//(10) We can now drop our referenced table
-					result = result && this->deleteTableCore(newTable.getName());
-					if(!result)
-						return result;
-					//(11) We can recreate our referenced table
-					result = result && this->createTableCore(newTable);
-					if(!result)
-						return result;
-					//(12) We can populate it
-					result = result && this->insertCore(newTable.getName(), records);
-					if(!result)
-						return result;
-					//(13) Now that the table is recreated we can recreate the linking tables
-					for(auto &name : linkingTables) {
-						string nameOfOthertable;
-						vector<string> tables;
-						if(name.find(table + string("_")) != string::npos) {
-							string temp = table + "_";
-							size_t start = temp.length();
-							size_t length = name.length()-temp.length();
-							nameOfOthertable = name.substr(start, length);
-							tables.push_back(table);
-							tables.push_back(nameOfOthertable);
+
+					//Columns are dropped in place when possible (see removeFieldsFromTableCore()), SQLite then rewrites the table content
+					if(!removedFields.empty()) {
+						SQLTable tableWithKeptIndexes(table->second);	/* The indexes that are not in the model anymore were dropped above */
+						for(auto &it : table->second.getIndexes()) {
+							if(find(keptIndexes.begin(), keptIndexes.end(), it) == keptIndexes.end()) {
+								tableWithKeptIndexes.removeIndex(std::get<0>(it));
+							}
+						}
+						if(this->canRemoveFieldsInPlace(this->getIndexedFields(tableWithKeptIndexes), fieldNames(removedFields))) {
+							plan.push_back(DBMigrationOperation{"drop-columns", model.getName(), fieldNames(removedFields), rowCounts[model.getName()]});
 						}
 						else {
-							string temp = "_" + table;
-							size_t start = 0;
-							size_t length = name.length()-temp.length();
-							nameOfOthertable = name.substr(start, length);
-							tables.push_back(nameOfOthertable);
-							tables.push_back(table);
+							plan.push_back(DBMigrationOperation{"rebuild-table", model.getName(), fieldNames(removedFields), rebuildCost(table->second)});
 						}
-						result = result && (name == this->createRelationCore("m:n", tables));
-						if(!result)
-							return result;
 					}
 
-					//(14) Now the linking tables are recreated we can populate them
-					for(auto &name : linkingTables) {
-						result = result && this->insertCore(name, recordsByTable[name]);
-						if(!result)
-							return result;
+					//Tables whose storage options change are rebuilt (see checkTableInDatabaseMatchesModelCore())
+					if(this->needsStorageRebuildCore(model, table->second)) {
+						plan.push_back(DBMigrationOperation{"rebuild-table", model.getName(), {}, rebuildCost(table->second)});
+					}
+
+					for(auto &it : modelIndexes) {
+						if(find(keptIndexes.begin(), keptIndexes.end(), it) == keptIndexes.end()) {
+							plan.push_back(DBMigrationOperation{"create-index", model.getName(), std::get<1>(it), rowCounts[model.getName()]});
+						}
 					}
+
+					table->second = model;
 				}
 			}
 		}
 
-		return result;
+		//(4) Default records are inserted in empty tables
+		for(auto &it : schema.getDefaultRecords()) {
+			if(rowCounts[it.first] == 0) {
+				plan.push_back(DBMigrationOperation{"insert-default-records", it.first, {}, it.second.size()});
+				rowCounts[it.first] = it.second.size();
+			}
+		}
+
+		//(5) Policies are applied to empty joining tables
+		for(auto &it : relationships) {
+			if(it.second.policy == "link-all" && rowCounts[it.first] == 0) {
+				unsigned long long rows = rowCounts[it.second.firstTable] * rowCounts[it.second.secondTable];
+				plan.push_back(DBMigrationOperation{"apply-policy", it.first, {}, rows});
+				rowCounts[it.first] = rows;
+			}
+		}
+
+		if(!fullCheck)
+			return plan;
+
+		//(6) Tables that are not part of the description are dropped, referenced tables last
+		set<string> tablesToDelete;
+		for(auto &it : tablesInDb) {
+			if(it.first != "sqlite_sequence" && relationships.find(it.first) == relationships.end()) {
+				tablesToDelete.emplace(it.first);
+			}
+		}
+		for(auto &model : schema.getTables()) {
+			tablesToDelete.erase(model.getName());
+		}
+		for(auto &referencedLast : {false, true}) {
+			for(auto &it : tablesToDelete) {
+				if(tablesInDb.at(it).isReferenced() == referencedLast) {
+					plan.push_back(DBMigrationOperation{"drop-table", it, {}, rowCounts[it]});
+				}
+			}
+		}
+		for(auto &it : tablesToDelete) {
+			tablesInDb.erase(it);
+			relationshipsInDb.erase(it);
+		}
+
+		//(7) Tables that are not part of a relationship anymore lose their primary key
+		for(auto &it : tablesInDb) {
+			if(it.second.isReferenced() && referencedTables.find(it.first) == referencedTables.end() && relationships.find(it.first) == relationships.end()) {
+				SQLTable newTable(it.second);
+				newTable.unmarkReferenced();
+				plan.push_back(DBMigrationOperation{"rebuild-table", it.first, {PK_FIELD_NAME}, rebuildCost(newTable)});
+			}
+		}
 	}
 	catch(const Exception &e) {
-		cerr << "addFieldsToTableCore: " << e.what() << endl;
-		return false;
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return vector<DBMigrationOperation>();
 	}
+
+	return plan;
 }
 
-bool SQLiteDBManager::removeFieldsFromTable(const std::string& table,
-                                            const std::vector<std::tuple<std::string, std::string, bool, bool> >& fields,
-                                            const bool& isAtomic) noexcept {
+void SQLiteDBManager::checkTableInDatabaseMatchesModel(const SQLTable& model,
+                                                       const bool& isAtomic) noexcept {
 
+	this->lastError() = DBManagerError::None;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		Transaction transaction(*(this->db));
-		bool result = this->removeFieldsFromTableCore(table, fields);
-		if(result)
-			transaction.commit();
-		return result;
+
+		Transaction transaction(this->conn());
+		if(this->checkTableInDatabaseMatchesModelCore(model))
+			this->commitTransaction(transaction);
 	}
 	else {
-		return this->removeFieldsFromTableCore(table, fields);
+		ConnectionUse use(*this);
+		this->checkTableInDatabaseMatchesModelCore(model);
 	}
 }
 
-bool SQLiteDBManager::removeFieldsFromTableCore(const std::string& table,
-                                                const std::vector<std::tuple<std::string, std::string, bool, bool> >& fields) noexcept {
+bool SQLiteDBManager::checkTableInDatabaseMatchesModelCore(const SQLTable& model) noexcept {
+	return this->checkTableInDatabaseMatchesModelCore(model, this->getTablesFromDatabaseCore(model.getName()));
+}
 
-	/* The logical steps to follow in this methods :
-	 *                     [case where table is not referenced] -> (4) -> (5) -> (6) -------------------------------------
-	 * 					  /                                                                                               \
-	 * (1) -> (2) -> (3)--																								   --> result
-	 * 					  \																								  /
-	 * 					   [case where table is referenced] -> (7) -> (8) -> (9) -> (10) -> (11) -> (12) -> (13) -> (14) -
-	 */
-	try {
-		bool result = true;
-		if(!fields.empty()) {
-			//(1) We save the current table
-			SQLTable newTable = this->getTableFromDatabaseCore(table);
-
-			//(2) We can remove the fields
-			for(auto &current : newTable.getFields()) {
-				for(auto &toDelete : fields) {
-					if(toDelete == current) {
-						cout << "Removing field " << std::get<0>(current) << endl;
-						newTable.removeField(std::get<0>(current));
-					}
+bool SQLiteDBManager::checkTableInDatabaseMatchesModelCore(const SQLTable& model,
+                                                           const std::map<std::string, SQLTable>& tablesInDb) noexcept {
+	bool result = true;
+	map<string, SQLTable>::const_iterator current = tablesInDb.find(model.getName());
+	//Create table if it doesn't exist in the database.
+	if (current == tablesInDb.end()) {
+		result = result && this->createTableCore(model);
+	}
+	else {
+		SQLTable tableInDb(current->second);
+		vector<tuple<string, vector<string>, bool>> modelIndexes = model.getIndexes();
+
+		//Drop the indexes that are not in the model anymore (or that changed) first, so that they don't prevent fields from being removed in place.
+		for(auto &it : tableInDb.getIndexes()) {
+			if(find(modelIndexes.begin(), modelIndexes.end(), it) == modelIndexes.end()) {
+				result = result && this->dropIndexCore(std::get<0>(it));
+				tableInDb.removeIndex(std::get<0>(it));
+			}
+		}
+
+		//Add new fields and remove useless ones from the existing table in database if it differ from model.
+		if(model != tableInDb) {
+			result = result && this->addFieldsToTableCore(tableInDb.getName(), model.diff(tableInDb));
+			result = result && this->removeFieldsFromTableCore(tableInDb.getName(), tableInDb.diff(model));
+		}
+
+		//Rebuild the table if its storage options changed.
+		if(result) {
+			SQLTable newTable = (model != tableInDb ? this->getTableFromDatabaseCore(model.getName()) : tableInDb);	/* Only introspect the table again if its fields were modified */
+			if(this->needsStorageRebuildCore(model, newTable)) {
+				vector<string> columns;
+				if(newTable.isReferenced()) {
+					columns.push_back(PK_FIELD_NAME);
 				}
+				for(auto &it : newTable.getFields()) {
+					columns.push_back(std::get<0>(it));
+				}
+				newTable.setWithoutRowid(model.isWithoutRowid());
+				newTable.setStrict(model.isStrict());
+				result = this->rebuildTableCore(newTable, columns);
 			}
+		}
 
-			//(3) Then we save table's records
-			vector<string> columns;
-			for(auto &it : newTable.getFields()) {
-				columns.push_back(std::get<0>(it));
+		//Create the missing indexes (indexes that were kept are recreated when a table is rebuilt).
+		vector<tuple<string, vector<string>, bool>> indexesInDb = (model != tableInDb ? this->getIndexesCore(model.getName()) : tableInDb.getIndexes());
+		for(auto &it : modelIndexes) {
+			if(find(indexesInDb.begin(), indexesInDb.end(), it) == indexesInDb.end()) {
+				result = result && this->createIndexCore(model.getName(), it);
 			}
-			vector<map<string, string>> records = this->getCore(table, columns);
+		}
+	}
+	return result;
+}
 
-			if(!newTable.isReferenced()) {
-				//(4) Now that everything is saved, we can drop the "old" table
-				result = result && this->deleteTableCore(table);
-				if(!result)
-					return result;
+bool SQLiteDBManager::createTable(const SQLTable& table,
+                                  const bool& isAtomic) noexcept {
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
 
-				//(5) We can recreate the table
-				result = result &&this->createTableCore(newTable);
-				if(!result)
-					return result;
-	
-				//(6) The new table is created, populate with old records (new fields will have default value)
-				result = result &&this->insertCore(newTable.getName(), records);
-			}
-			else {
-				//(7) We'll search if a join table (or more) exists. If so, the table is referenced for a m:n relationship, otherwise it's a 1:n or a 1:1 relationship.
-				set<string> linkingTables;
-				for(auto &name : this->listTablesCore()) {
-					if(name.find(table + "_") != string::npos || name.find("_" + table) != string::npos) {
-						linkingTables.emplace(name);
-					}
-				}
-				//No need to check field properties of linking tables as these tables fit a specific model : 2 integer column noted as primary keys and referencing the primary keys of 2 tables.
+		Transaction transaction(this->conn());
 
-				if(!linkingTables.empty()) {	//TODO: Handle the 1:1 and 1:n relationships cases.
-					//(8) Now we have all the linker tables names, we can fetch their records.
-					map<string, vector<map<string, string>>> recordsByTable;
-					for(auto &name : linkingTables) {
-						recordsByTable.emplace(name, this->getCore(name));
-					}
-					//(9) Now the linking Tables are saved, we can drop them
-					for(auto &name : linkingTables) {
-						result = result && this->deleteTableCore(name);
-						if(!result)
-							return result;
-					}
-					//(10) We can now drop our referenced table
-					result = result && this->deleteTableCore(newTable.getName());
-					if(!result)
-						return result;
-					//(11) We can recreate our referenced table
-					result = result && this->createTableCore(newTable);
-					if(!result)
-						return result;
-					//(12) We can populate it
-					result = result && this->insertCore(newTable.getName(), records);
-					if(!result)
-						return result;
-					//(13) Now that the table is recreated we can recreate the linking tables
-					for(auto &name : linkingTables) {
-						string nameOfOthertable;
-						vector<string> tables;
-						if(name.find(table + string("_")) != string::npos) {
-							string temp = table + "_";
-							size_t start = temp.length();
-							size_t length = name.length()-temp.length();
-							nameOfOthertable = name.substr(start, length);
-							tables.push_back(table);
-							tables.push_back(nameOfOthertable);
-						}
-						else {
-							string temp = "_" + table;
-							size_t start = 0;
-							size_t length = name.length()-temp.length();
-							nameOfOthertable = name.substr(start, length);
-							tables.push_back(nameOfOthertable);
-							tables.push_back(table);
-						}
-						result = result && (name == this->createRelationCore("m:n", tables));
-						if(!result)
-							return result;
-					}
+		bool result = this->createTableCore(table);
+		if(result)
+			result = this->commitTransaction(transaction);
+		return result;
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->createTableCore(table);
+	}
+}
 
-					//(14) Now the linking tables are recreated we can populate them
-					for(auto &name : linkingTables) {
-						result = result && this->insertCore(name, recordsByTable[name]);
-						if(!result)
-							return result;
-					}
-				}
+bool SQLiteDBManager::createTableCore(const SQLTable& table) noexcept {
+	try {
+		stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+		string primaryKey;
+		bool strict = false;
+		this->getTableOptionsCore(table, primaryKey, strict);
+
+		ss << "CREATE TABLE \"" << this->escDQ(table.getName()) << "\" (";
+		const vector< tuple<string,string,bool,bool> > fields = table.getFields();
+
+		if (table.isReferenced()) {
+			ss << "\"id\" INTEGER PRIMARY KEY AUTOINCREMENT, ";
+		}
+
+		for (vector< tuple<string,string,bool,bool> >::const_iterator it = fields.begin(); it != fields.end(); ++it) {
+			/* Check if iterator is on the first element of the list, and add a separator otherwise */
+			if (it != fields.begin()) {
+				ss << ", ";
 			}
+			ss << this->fieldDefinition(*it, (std::get<0>(*it) == primaryKey));
 		}
 
+
+		ss << ")";
+		if (!primaryKey.empty()) {
+			ss << " WITHOUT ROWID";
+		}
+		if (strict) {
+			ss << (primaryKey.empty() ? " " : ", ") << "STRICT";
+		}
+
+		this->conn().exec(ss.str());
+
+		bool result = true;
+		for(auto &it : table.getIndexes()) {
+			result = result && this->createIndexCore(table.getName(), it);
+		}
 		return result;
 	}
-	catch(const Exception &e) {
-		cerr << "removeFieldsFromTableCore: " << e.what() << endl;
+	catch(const Exception & e) {
+		this->recordError(e);
+		cerr << "createTableCore: " << e.what() << endl;
 		return false;
 	}
 }
 
+bool SQLiteDBManager::createIndexCore(const std::string& table,
+                                      const std::tuple<std::string, std::vector<std::string>, bool>& index) noexcept {
 
-bool SQLiteDBManager::deleteTable(const std::string& table,
-                                  const bool& isAtomic) noexcept {
-
-	if(isAtomic) {
-		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-
-		Transaction transaction(*(this->db));
+	stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+	ss << "CREATE " << (std::get<2>(index) ? "UNIQUE " : "") << "INDEX \"" << this->escDQ(std::get<0>(index)) << "\" ON \"" << this->escDQ(table) << "\" (";
+	for(vector<string>::const_iterator it = std::get<1>(index).begin(); it != std::get<1>(index).end(); ++it) {
+		/* Check if iterator is on the first element of the list, and add a separator otherwise */
+		if(it != std::get<1>(index).begin()) {
+			ss << ", ";
+		}
+		ss << "\"" << this->escDQ(*it) << "\"";
+	}
+	ss << ")";
 
-		bool result = this->deleteTableCore(table);
-		if (result)
-			transaction.commit();
-		return result;
+	try {
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
+#endif
+		this->conn().exec(ss.str());
+		return true;
 	}
-	else {
-		return this->deleteTableCore(table);
+	catch(const Exception & e) {
+		this->recordError(e);
+		cerr << __func__ << "(): exception while running SQL cmd \"" << ss.str() << "\": " << e.what() << endl;
+		return false;
 	}
 }
 
-bool SQLiteDBManager::deleteTableCore(const std::string& table) noexcept {
+bool SQLiteDBManager::dropIndexCore(const std::string& index) noexcept {
 	string ss;
 
-	ss = "DROP TABLE \"" + this->escDQ(table) + "\"";
+	ss = "DROP INDEX IF EXISTS \"" + this->escDQ(index) + "\"";
 
 	try {
-		this->db->exec(ss);
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"" << ss << "\"" << endl;
+#endif
+		this->conn().exec(ss);
 		return true;
 	}
 	catch(const Exception & e) {
+		this->recordError(e);
 		cerr << __func__ << "(): exception while running SQL cmd \"" << ss << "\": " << e.what() << endl;
 		return false;
 	}
 }
 
-bool SQLiteDBManager::createTable(const std::string& table,
-                                  const std::map< std::string, std::string >& values,
-                                  const bool& isAtomic) {
+std::string SQLiteDBManager::fieldDefinition(const std::tuple<std::string, std::string, bool, bool>& field,
+                                             const bool& primaryKey) const {
+
+	stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+	const string& fieldName = std::get<0>(field);
+	const string& defaultValue = std::get<1>(field);
+	const bool& notNullProperty = std::get<2>(field);
+	const bool& uniqueProperty = std::get<3>(field);
+	//0 -> field name
+	//1 -> field default value
+	//2 -> field is not null
+	//3 -> field is unique
+	ss << "\"" << this->escDQ(fieldName) << "\" TEXT ";
+	if (notNullProperty)
+		ss << "NOT NULL ";
+	if (primaryKey)
+		ss << "PRIMARY KEY ON CONFLICT ABORT ";
+	else if (uniqueProperty)
+		ss << "UNIQUE ON CONFLICT ABORT ";
+	ss << "DEFAULT \"" << this->escDQ(defaultValue) << "\"";
+
+	return ss.str();
+}
 
-	SQLTable tab(table);
-	for(const auto &it : values) {
-		tab.addField(tuple<string, string, bool, bool>(it.first, it.second, true, false));
+void SQLiteDBManager::getTableOptionsCore(const SQLTable& table,
+                                          std::string& primaryKey,
+                                          bool& strict) const {
+
+	primaryKey.clear();
+	if(table.isWithoutRowid() && !table.isReferenced()) {
+		for(auto &it : table.getFields()) {	/* If there are several unique fields, the first one in alphabetical order is used, so that the choice doesn't depend on the order of fields */
+			if(std::get<3>(it) && (primaryKey.empty() || std::get<0>(it) < primaryKey)) {
+				primaryKey = std::get<0>(it);
+			}
+		}
 	}
-	return this->createTable(tab, isAtomic);
+
+	strict = table.isStrict() && (this->getSQLiteVersionCore() >= 3037000);
 }
 
-std::vector< std::string > SQLiteDBManager::listTables(const bool& isAtomic) const {
-	if(isAtomic) {
-		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		return listTablesCore();
-	}
-	else {
-		return listTablesCore();
+bool SQLiteDBManager::canAddFieldsInPlace(const std::vector<std::tuple<std::string, std::string, bool, bool> >& fields) const {
+
+	for(auto &it : fields) {
+		if(std::get<3>(it)) {
+			return false;
+		}
 	}
+	return true;
 }
 
-std::vector< std::string > SQLiteDBManager::listTablesCore() const {
-	//All the tables names are in the sqlite_master table.
-	try {
-		vector<string> tablesInDb;
-		for(auto &it : getCore("sqlite_master")) {
-			if(it["type"] == "table")
-				tablesInDb.push_back(it["name"]);
+bool SQLiteDBManager::canRemoveFieldsInPlace(const std::set<std::string>& indexedFields,
+                                             const std::vector<std::string>& fields) const {
+
+	if(this->getSQLiteVersionCore() < 3035000)
+		return false;
+
+	for(auto &it : fields) {
+		if(indexedFields.find(it) != indexedFields.end()) {
+			return false;
 		}
+	}
+	return true;
+}
 
-		return tablesInDb;
+bool SQLiteDBManager::needsStorageRebuildCore(const SQLTable& model,
+                                              const SQLTable& tableInDb) const {
+
+	string primaryKey;
+	bool strict = false;
+	this->getTableOptionsCore(model, primaryKey, strict);
+	return (tableInDb.isWithoutRowid() != !primaryKey.empty() || tableInDb.isStrict() != strict);
+}
+
+bool SQLiteDBManager::rebuildMovesJoiningTables(const SQLTable& newTable,
+                                                const bool& foreignKeysEnabled) const {
+
+	return (foreignKeysEnabled || !newTable.isReferenced());
+}
+
+bool SQLiteDBManager::addFieldsToTable(const std::string& table,
+                                       const std::vector<std::tuple<std::string, std::string, bool, bool> >& fields,
+                                       const bool& isAtomic) noexcept {
+
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		ForeignKeysSuspender foreignKeysSuspender(this->conn(), this->foreignKeysToCheck);	/* Must outlive the transaction */
+		Transaction transaction(this->conn());
+
+		bool result = this->addFieldsToTableCore(table, fields) && foreignKeysSuspender.check();
+		if(result)
+			result = this->commitTransaction(transaction);
+		return result;
 	}
-	catch(const Exception &e) {
-		cerr << "listTablesCore: " << e.what() << endl;
-		return vector<string>();
+	else {
+		ConnectionUse use(*this);
+		return this->addFieldsToTableCore(table, fields);
 	}
 }
 
-bool SQLiteDBManager::areForeignKeysEnabled() const {
-	Statement query(*(this->db), "PRAGMA foreign_keys");
-	while (query.executeStep()) {
-		if (string(query.getColumn(0).getText()) == "1") {
+bool SQLiteDBManager::addFieldsToTableCore(const std::string& table,
+                                           const std::vector<std::tuple<std::string, std::string, bool, bool> >& fields) noexcept {
+
+	try {
+		if(fields.empty())
+			return true;
+
+		//(1) If the new columns can be added in place, there is no need to rebuild the table (and its joining tables), existing records get the default value of the new fields
+		if(this->canAddFieldsInPlace(fields)) {
+			for(auto &it : fields) {
+				string query = "ALTER TABLE \"" + this->escDQ(table) + "\" ADD COLUMN " + this->fieldDefinition(it);
+#ifdef DEBUG
+				cout << __func__ << "(): running SQL query \"" << query << "\"" << endl;
+#endif
+				this->conn().exec(query);
+			}
 			return true;
 		}
-		else {
-			//cout << "Text of pragma is " << query.getColumn(0).getText() << endl;
+
+		//(2) Otherwise, we build the new table model from the current table, and we rebuild the table, copying all current columns (new fields will have default value)
+		SQLTable newTable = this->getTableFromDatabaseCore(table);
+		vector<string> columns;
+		if(newTable.isReferenced()) {
+			columns.push_back(PK_FIELD_NAME);
 		}
+		for(auto &it : newTable.getFields()) {
+			columns.push_back(std::get<0>(it));
+		}
+		for(auto &it : fields) {
+			newTable.addField(it);
+		}
+
+		return this->rebuildTableCore(newTable, columns);
+	}
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << "addFieldsToTableCore: " << e.what() << endl;
+		return false;
 	}
-	return false;
 }
 
-std::string SQLiteDBManager::tableToString(const std::string& tableName) const {
+bool SQLiteDBManager::removeFieldsFromTable(const std::string& table,
+                                            const std::vector<std::tuple<std::string, std::string, bool, bool> >& fields,
+                                            const bool& isAtomic) noexcept {
 
-	stringstream dump;
-
-	const vector<map<string, string> > records = this->get(tableName); // Get all records
-	map<string, bool> uniqueness = this->getUniqueness(tableName);	// Get the list of unique records for this table
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		ForeignKeysSuspender foreignKeysSuspender(this->conn(), this->foreignKeysToCheck);	/* Must outlive the transaction */
+		Transaction transaction(this->conn());
+		bool result = this->removeFieldsFromTableCore(table, fields) && foreignKeysSuspender.check();
+		if(result)
+			result = this->commitTransaction(transaction);
+		return result;
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->removeFieldsFromTableCore(table, fields);
+	}
+}
 
-	if (!records.empty()) {
-		/* Compute the longest name for each column (between column names and values) */
-		map<string, unsigned int> longests;	/* string is the column name, unsigned int is the column width (in characters) */
-		for (vector<map<string, string> >::const_iterator vectIt = records.begin(); vectIt != records.end(); ++vectIt) {
-			for (map<string, string>::const_iterator mapIt = vectIt->begin(); mapIt != vectIt->end(); ++mapIt) {
-				/* Initialise count... if column is not known yet, set the length to fit the column name */
-				const string& columnName = mapIt->first;
-				const string& recordValue = mapIt->second;
+bool SQLiteDBManager::removeFieldsFromTableCore(const std::string& table,
+                                                const std::vector<std::tuple<std::string, std::string, bool, bool> >& fields) noexcept {
 
-				if (longests.find(columnName) == longests.end()) {	/* New column (absent from map "longests" */
-					unsigned int columnHeaderSz = columnName.size();	/* Start from the size of the column */
-					if (this->isPrimaryKeyCore(tableName, columnName)) {	/* This column stores primary keys */
-						columnHeaderSz+=5;	/* Get more room for suffix " [PK]" (5 chars) */
-					}
-					if (uniqueness[columnName]) {	/* This column stores unique entries */
-						columnHeaderSz+=4;	/* Get more room for suffix " [U]" (4 chars) */
-					}
-					longests.emplace(columnName, columnHeaderSz);
-				}
+	try {
+		if(fields.empty())
+			return true;
 
-				/* Only if we find a value that is larger than the column name, increase the max length */
-				if (recordValue.size() > longests[columnName]) {
-					longests[columnName] = recordValue.size();
+		//(1) We build the new table model from the current table, without the fields to remove
+		SQLTable newTable = this->getTableFromDatabaseCore(table);
+		vector<string> removedFields;
+		for(auto &current : newTable.getFields()) {
+			for(auto &toDelete : fields) {
+				if(toDelete == current) {
+					cout << "Removing field " << std::get<0>(current) << endl;
+					newTable.removeField(std::get<0>(current));
+					removedFields.push_back(std::get<0>(current));
 				}
 			}
 		}
 
-		/* Write the first line: column names */
-		stringstream Hsep;	/* Horizontal separator between rows (records) */
-		stringstream headers;	/* Headers line */
-		Hsep << "+-";	/* Start with left border */
-		headers << "| ";
-		for (map<string, string>::const_iterator mapIt = records.at(0).begin(); mapIt != records.at(0).end(); ++mapIt) {
-			/* Check if iterator is on the first column, and add a separator otherwise */
-			if (mapIt != records.at(0).begin()) {	/* If not the first column of the table */
-				Hsep << "-+-";	/* Add separators */
-				headers << " | ";
-			}
-
-			const string& columnName = mapIt->first;
-
-			Hsep << string(longests[columnName], '-');	/* Fill hypens */
-
-			string columnHeader(columnName);
-			if (this->isPrimaryKeyCore(tableName, columnName)) {	/* This column stores primary keys */
-				columnHeader += " [PK]";
-			}
-			if (uniqueness[columnName]) {	/* This column stores unique entries */
-				columnHeader += " [U]";
+		//(2) If the columns can be dropped in place, there is no need to rebuild the table (and its joining tables)
+		if(this->canRemoveFieldsInPlace(this->getIndexedFieldsCore(table), removedFields)) {
+			for(auto &it : removedFields) {
+				string query = "ALTER TABLE \"" + this->escDQ(table) + "\" DROP COLUMN \"" + this->escDQ(it) + "\"";
+#ifdef DEBUG
+				cout << __func__ << "(): running SQL query \"" << query << "\"" << endl;
+#endif
+				this->conn().exec(query);
 			}
-
-			headers << columnHeader << string(longests[columnName]-columnHeader.size(), ' ');	/* Write header and pad with spaces */
+			return true;
 		}
-		Hsep << "-+";	/* Add right border */
-		headers << " |";
 
-		/* Once here, we have created the headers line and a Hsep separator to use between all records */
-		stringstream values;
-		for (vector<map<string, string> >::const_iterator vectIt = records.begin(); vectIt != records.end(); ++vectIt) {
-			values << "| ";	/* Start with left border */
-			for (map<string, string>::const_iterator mapIt = vectIt->begin(); mapIt != vectIt->end(); ++mapIt) {
-				/* Check if iterator is on the first column, and add a separator otherwise */
-				if (mapIt != vectIt->begin()) {	/* If not the first column of the table */
-					values << " | ";	/* Add separator */
-				}
-				const string& columnName = mapIt->first;
-				const string& recordValue = mapIt->second;
-				values << recordValue << string(longests[columnName]-recordValue.size(), ' ');	/* Write value for this record (row) and pad with spaces */
-			}
-			values << " |" << endl; /* Add right border */
+		//(3) Otherwise, we rebuild the table, copying the columns that are kept
+		vector<string> columns;
+		if(newTable.isReferenced()) {
+			columns.push_back(PK_FIELD_NAME);
+		}
+		for(auto &it : newTable.getFields()) {
+			columns.push_back(std::get<0>(it));
 		}
 
-		stringstream tableDump;
-		tableDump << "Table: " << tableName << endl;
-		tableDump << Hsep.str() << endl;
-		tableDump << headers.str() << endl;
-		tableDump << Hsep.str() << endl;
-		tableDump << values.str();	/* Note: values already terminates with endl */
-		tableDump << Hsep.str() << endl;
-
-		dump << tableDump.str();
+		return this->rebuildTableCore(newTable, columns);
 	}
-	else {	/* If we reach here, records.empty() == true */
-		set<string> columnNames = this->getFieldNames(tableName);
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << "removeFieldsFromTableCore: " << e.what() << endl;
+		return false;
+	}
+}
 
-		dump << "Table: " << tableName << " is empty" << endl;
-		dump << "Columns are: ";
+bool SQLiteDBManager::rebuildTableCore(const SQLTable& newTable,
+                                       const std::vector<std::string>& columns) {
 
-		for (set<string>::const_iterator setIt = columnNames.begin(); setIt != columnNames.end(); ++setIt) {
-			if (setIt != columnNames.begin()) {
-				dump << ", ";
-			}
-			dump << *setIt;
-			if (this->isPrimaryKeyCore(tableName, *setIt)) {	/* This column stores primary keys */
-				dump << " [PK]";
+	/* The logical steps to follow in this methods :
+	 * (1) -> (2) -> (3) -> (4) -> (5) -> (6) -> (7) -> (8) -> result
+	 * All rows are copied by SQLite itself (INSERT ... SELECT), so they never go through this process memory.
+	 */
+	string table = newTable.getName();
+	string newTableName = table + "__new";
+
+	//(1) We get the joining tables of m:n relationships involving this table, they may have to be recreated because they reference our table (see rebuildMovesJoiningTables())
+	//If foreign keys are disabled, they are not enforced while the table is replaced: they will have to be checked (see ForeignKeysSuspender)
+	bool foreignKeysEnabled = this->areForeignKeysEnabled();
+	map<string, pair<string, string>> relationships;
+	for(auto &it : this->getRelationshipsCore()) {
+		if(it.second.first == table || it.second.second == table) {
+			if(!foreignKeysEnabled) {
+				this->foreignKeysToCheck.emplace(it.first);
 			}
-			if (uniqueness[*setIt]) {	/* This column stores unique entries */
-				dump << " [U]";
+			if(this->rebuildMovesJoiningTables(newTable, foreignKeysEnabled)) {
+				relationships.emplace(it.first, it.second);
 			}
 		}
-		dump << endl;
 	}
-	return dump.str();
-}
 
-std::string SQLiteDBManager::to_string(const std::string& dumpTableName) const {
-	stringstream dump;
+	//(2) We move the content of joining tables aside, in temporary tables, and we drop the joining tables
+	map<string, bool> reverseIndexes;
+	for(auto &it : relationships) {
+		reverseIndexes.emplace(it.first, this->hasReverseIndexCore(it.first));
+		string query = "CREATE TEMP TABLE \"" + this->escDQ(it.first + "__saved") + "\" AS SELECT * FROM \"" + this->escDQ(it.first) + "\" WHERE 0";
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"" << query << "\"" << endl;
+#endif
+		this->conn().exec(query);
+		if(!this->copyRowsCore(it.first, it.first, "main", it.first + "__saved", vector<string>()))
+			return false;
+		if(!this->deleteTableCore(it.first))
+			return false;
+	}
+
+	//(3) We create the new table under a temporary name
+	//Its indexes are only created once the current table (and its indexes, which have the same names) is dropped
+	SQLTable tmpTable(newTable);
+	tmpTable.setName(newTableName);
+	for(auto &it : newTable.getIndexes()) {
+		tmpTable.removeIndex(std::get<0>(it));
+	}
+	if(!this->createTableCore(tmpTable))
+		return false;
+
+	//(4) We copy the records of the current table
+	if(!columns.empty()) {
+		if(!this->copyRowsCore(table, table, "main", newTableName, columns))
+			return false;
+	}
+
+	//(5) We drop the current table
+	if(!this->deleteTableCore(table))
+		return false;
 
+	//(6) We give the new table its final name
+	string query = "ALTER TABLE \"" + this->escDQ(newTableName) + "\" RENAME TO \"" + this->escDQ(table) + "\"";
 #ifdef DEBUG
-	cout << __func__ << "(): Starting parsing database" << endl;
+	cout << __func__ << "(): running SQL query \"" << query << "\"" << endl;
 #endif
-	const vector< string > tables = this->listTables();
-	
-	bool specificTableFound = false;	/* Did we find a specific table we were asked to dump? */
-	if (this->areForeignKeysEnabled()) {
-		dump << "Foreign Keys are enabled" << endl;
+	this->conn().exec(query);
+	for(auto &it : newTable.getIndexes()) {
+		if(!this->createIndexCore(table, it))
+			return false;
 	}
-	else {
-		dump << "Foreign Keys are disabled" << endl;
+
+	//(7) We recreate the joining tables and we copy back their content
+	for(auto &it : relationships) {
+		vector<string> tables({it.second.first, it.second.second});
+		if(it.first != this->createRelationCore("m:n", tables, reverseIndexes[it.first]))
+			return false;
+		if(!this->copyRowsCore(it.first, it.first + "__saved", "temp", it.first, vector<string>()))
+			return false;
+
+		//(8) We drop the temporary tables
+		this->conn().exec("DROP TABLE temp.\"" + this->escDQ(it.first + "__saved") + "\"");
 	}
-	dump << "Database stored in " << this->filename << endl << "List of tables (" << tables.size() << "): ";
-	for (vector<string>::const_iterator tableName = tables.begin(); tableName != tables.end(); ++tableName) {
-		if (tableName != tables.begin()) {
-			dump << ", ";
+
+	return true;
+}
+
+bool SQLiteDBManager::copyRowsCore(const std::string& name,
+                                   const std::string& source,
+                                   const std::string& sourceSchema,
+                                   const std::string& destination,
+                                   const std::vector<std::string>& columns) {
+
+	string qualifiedSource = "\"" + this->escDQ(sourceSchema) + "\".\"" + this->escDQ(source) + "\"";
+
+	//(1) Rows are copied in the order of a key, so that each chunk starts where the previous one ended (without having to skip the rows already copied)
+	//This key is the first column of the primary key if the table has one (joining tables and tables stored without rowid), the rowid otherwise
+	string key = "rowid";
+	Statement indexList(this->conn(), "PRAGMA \"" + this->escDQ(sourceSchema) + "\".index_list(\"" + this->escDQ(source) + "\")");
+	while(indexList.executeStep()) {
+		if(string(indexList.getColumn(3).getText()) == "pk") {
+			Statement indexInfo(this->conn(), "PRAGMA \"" + this->escDQ(sourceSchema) + "\".index_info(\"" + this->escDQ(indexList.getColumn(1).getText()) + "\")");
+			if(indexInfo.executeStep()) {
+				key = indexInfo.getColumn(2).getText();
+			}
 		}
-		if (*tableName == dumpTableName) {	/* We have found the table name that we were requested to dump */
-			specificTableFound = true;
+	}
+
+	stringstream ssColumns(ios_base::in | ios_base::out | ios_base::ate);
+	for(vector<string>::const_iterator it = columns.begin(); it != columns.end(); ++it) {
+		/* Check if iterator is on the first element of the list, and add a separator otherwise */
+		if(it != columns.begin()) {
+			ssColumns << ", ";
 		}
-		dump << "\"" << *tableName << "\"";
+		ssColumns << "\"" << this->escDQ(*it) << "\"";
 	}
-	dump << endl;
 
-	if (dumpTableName != "") {	/* A table name was specified as argument */
-		if (specificTableFound) {
-			/* The specified table was found... dump only this table (not the whole db) */
-			return this->tableToString(dumpTableName);
+	unsigned long long total = 0;
+	Statement count(this->conn(), "SELECT COUNT(*) FROM " + qualifiedSource);
+	if(count.executeStep()) {
+		total = static_cast<unsigned long long>(count.getColumn(0).getInt64());
+	}
+
+	//(2) Each chunk ends at the greatest key of the next migrationChunkSize rows (if the key is not unique, a chunk may be a bit larger, since all rows with the same key are copied at once)
+	unsigned long long done = 0;
+	bool first = true;
+	string lastKey;
+	while(true) {
+		if(this->migrationCancelHook && this->migrationCancelHook()) {
+			cerr << __func__ << "(): migration cancelled while copying table " << name << endl;
+			return false;
 		}
-		else {	/* The specified table was not found */
+
+		stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+		ss << "SELECT MAX(k) FROM (SELECT \"" << this->escDQ(key) << "\" AS k FROM " << qualifiedSource;
+		if(!first) {
+			ss << " WHERE \"" << this->escDQ(key) << "\" > ?";
+		}
+		ss << " ORDER BY \"" << this->escDQ(key) << "\" LIMIT " << this->migrationChunkSize << ")";
+		Statement bounds(this->conn(), ss.str());
+		if(!first) {
+			bounds.bind(1, lastKey);
+		}
+		if(!bounds.executeStep() || bounds.getColumn(0).isNull()) {
+			break;
+		}
+		string chunkLastKey = bounds.getColumn(0).getText();
+
+		ss.str("");
+		ss << "INSERT INTO \"" << this->escDQ(destination) << "\"";
+		if(!columns.empty()) {
+			ss << " (" << ssColumns.str() << ") SELECT " << ssColumns.str();
+		}
+		else {
+			ss << " SELECT *";
+		}
+		ss << " FROM " << qualifiedSource << " WHERE ";
+		if(!first) {
+			ss << "\"" << this->escDQ(key) << "\" > ? AND ";
+		}
+		ss << "\"" << this->escDQ(key) << "\" <= ?";
 #ifdef DEBUG
-			cerr << __func__ << "(): The table specified (\"" << dumpTableName << "\") does not exist. Dumping all database instead" << endl;
+		cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
 #endif
+		Statement insert(this->conn(), ss.str());
+		int index = 1;
+		if(!first) {
+			insert.bind(index++, lastKey);
 		}
-	}
+		insert.bind(index, chunkLastKey);
+		done += insert.exec();
 
-	for (vector<string>::const_iterator tableName = tables.begin(); tableName != tables.end(); ++tableName) {
-		/* tableName will loop through every table name in the database */
-		dump << this->tableToString(*tableName);
+		if(this->migrationProgressCallback) {
+			this->migrationProgressCallback(name, done, total);
+		}
+
+		lastKey = chunkLastKey;
+		first = false;
 	}
-#ifdef DEBUG
-	cout << __func__ << "(): Finished parsing database" << endl;
-#endif
-	return dump.str();
+
+	return true;
 }
 
-std::string SQLiteDBManager::dumpTablesAsHtml() const {
-	stringstream htmlDump;
-	htmlDump << "<!DOCTYPE html>";
-	htmlDump << "<head>";
-	htmlDump << "<title>Condutor tables dump</title>";
-	htmlDump <<	"<link rel=\"icon\" href=\"../favicon.ico\">";
-	htmlDump <<	"<!-- Bootstrap core CSS -->";
-	htmlDump <<	"<link href=\"../css/bootstrap.css\" rel=\"stylesheet\">";
-	htmlDump <<	"<!-- HTML5 shim and Respond.js IE8 support of HTML5 elements and media queries -->";
-	htmlDump <<	"<!--[if lt IE 9]>";
-	htmlDump <<	"<script src=\"../js/html5shiv.min.js\"></script>";
-	htmlDump <<	"<script src=\"../js/respond.min.js\"></script>";
-	htmlDump <<	"<![endif]-->";
-	htmlDump <<	"<!-- [if (It IE 9) & (!IEMobile)]>";
-	htmlDump <<	"<script src=\"../js/css3-mediaqueries.js\"></script>";
-	htmlDump <<	"<![endif]-->";
-	htmlDump << "</head>";
-	htmlDump << "<body>";
-	htmlDump << "<h1> Dump of Conductor Tables </h1>";
-	
-	if (this->areForeignKeysEnabled()) {
-		htmlDump << "<p> Foreign Keys are enabled </p>";
+bool SQLiteDBManager::deleteTable(const std::string& table,
+                                  const bool& isAtomic) noexcept {
+
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+
+		Transaction transaction(this->conn());
+
+		bool result = this->deleteTableCore(table);
+		if(result)
+			result = this->commitTransaction(transaction);
+		return result;
 	}
 	else {
-		htmlDump << "<p> Foreign Keys are disabled </p>";
+		ConnectionUse use(*this);
+		return this->deleteTableCore(table);
 	}
+}
 
-	const vector< string > tables = this->listTables();
+bool SQLiteDBManager::deleteTableCore(const std::string& table) noexcept {
+	string ss;
 
-	for (vector<string>::const_iterator tableName = tables.begin(); tableName != tables.end(); ++tableName) {
-		/* tableName will loop through every table name in the database */
-		htmlDump << "<h3> Table : " << *tableName << "</h3>";
-		vector<map<string, string> > records = this->get(*tableName); // Get all records
-		map<string, bool> uniqueness = this->getUniqueness(*tableName);
+	ss = "DROP TABLE \"" + this->escDQ(table) + "\"";
 
-		if (!records.empty()) {
-			htmlDump << "<table class=\"table table-striped table-bordered table-hover\">";
-			htmlDump << "<thead>";
-			htmlDump << "<tr>";
-			/* Write the first line: column names */
-			for (map<string, string>::iterator mapIt = records.at(0).begin(); mapIt != records.at(0).end(); ++mapIt) {
-				const string& columnName = mapIt->first;
-				
-				htmlDump << "<th>" << columnName;
-				if (this->isPrimaryKeyCore(*tableName, columnName)) {
-					htmlDump << " [PK] ";
-				}
-				if (uniqueness[columnName]) {
-					htmlDump << " [U] ";
-				}
-				htmlDump << "</th>";
-			}
-			htmlDump << "</tr>";
-			htmlDump << "</thead>";
-			
-			/* Write all records, one record per table row, one field in each table cell */
-			htmlDump << "<tbody>";
-			for (vector<map<string, string> >::iterator vectIt = records.begin(); vectIt != records.end(); ++vectIt) {
-				htmlDump << "<tr>";
-				for (map<string, string>::iterator mapIt = vectIt->begin(); mapIt != vectIt->end(); ++mapIt) {
-					const string& recordValue = mapIt->second;
-					htmlDump << "<td>" << recordValue << "</td>";
+	try {
+		this->conn().exec(ss);
+		return true;
+	}
+	catch(const Exception & e) {
+		this->recordError(e);
+		cerr << __func__ << "(): exception while running SQL cmd \"" << ss << "\": " << e.what() << endl;
+		return false;
+	}
+}
+
+bool SQLiteDBManager::createTable(const std::string& table,
+                                  const std::map< std::string, std::string >& values,
+                                  const bool& isAtomic) {
+
+	this->lastError() = DBManagerError::None;
+	SQLTable tab(table);
+	for(const auto &it : values) {
+		tab.addField(tuple<string, string, bool, bool>(it.first, it.second, true, false));
+	}
+	return this->createTable(tab, isAtomic);
+}
+
+std::vector< std::string > SQLiteDBManager::listTables(const bool& isAtomic) const {
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		return listTablesCore();
+	}
+	else {
+		ConnectionUse use(*this);
+		return listTablesCore();
+	}
+}
+
+std::map<std::string, SQLTable> SQLiteDBManager::getTablesFromDatabase(const bool& byPragmas,
+                                                                        const bool& isAtomic) const {
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		return this->getTablesFromDatabaseCore("", byPragmas);
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->getTablesFromDatabaseCore("", byPragmas);
+	}
+}
+
+std::vector< std::string > SQLiteDBManager::listTablesCore() const {
+	//All the tables names are in the sqlite_master table.
+	try {
+		vector<string> tablesInDb;
+		for(auto &it : getCore("sqlite_master")) {
+			if(it["type"] == "table")
+				tablesInDb.push_back(it["name"]);
+		}
+
+		return tablesInDb;
+	}
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << "listTablesCore: " << e.what() << endl;
+		return vector<string>();
+	}
+}
+
+Database& SQLiteDBManager::conn() const {
+	if (readerConnectionOwner == this) {
+		return *readerConnection;
+	}
+	if (this->db == NULL) {	/* The connection was closed by closeConnection() */
+		this->reopen();
+	}
+	this->lastUse.store(useClock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	return *(this->db);
+}
+
+void SQLiteDBManager::reopen() const {
+#ifdef DEBUG
+	cout << __func__ << "(): opening the database " << this->filename << " again" << endl;
+#endif
+	std::unique_ptr<Database> connection(new Database(this->filename, SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE));
+	this->installBusyHandler(*connection);
+	if (!this->journalMode.empty()) {	/* Journal modes other than wal only apply to the connection that sets them */
+		connection->exec("PRAGMA journal_mode = " + this->journalMode);
+	}
+	connection->exec("PRAGMA foreign_keys = ON");
+	this->db = connection.release();
+	this->connectionOpen = true;
+
+	/* The database structure was checked when it was opened the first time: skip the check if nobody modified it meanwhile (by a migration, or by other means) */
+	if (this->getStoredSchemaFingerprintCore() != this->closedFingerprint || this->getSchemaVersionCore() != this->closedSchemaVersion) {
+		SQLiteDBManager* self = const_cast<SQLiteDBManager*>(this);	/* The migration does not change this object, only the database */
+		ForeignKeysSuspender foreignKeysSuspender(*(this->db), self->foreignKeysToCheck);	/* Must outlive the transaction */
+		Transaction transaction(*(this->db));
+		if (!(self->checkDefaultTablesCore() && foreignKeysSuspender.check() && this->commitTransaction(transaction)))
+			cerr << __func__ << "(): the database " << this->filename << " was modified while it was closed, and does not match its description anymore" << endl;
+	}
+
+	if (this->reopenCallback) {
+		this->reopenCallback(*const_cast<SQLiteDBManager*>(this));
+	}
+}
+
+bool SQLiteDBManager::closeConnection() {
+	std::unique_lock<std::mutex> lock(this->mut, std::try_to_lock);
+	if (!lock.owns_lock())
+		return false;	/* A request is running */
+	if (this->connectionUsers > 0)
+		return false;	/* A request run with isAtomic set to false is using the connection (see ConnectionUse) */
+
+	if (this->db != NULL) {
+		try {
+			this->closedFingerprint = this->getStoredSchemaFingerprintCore();
+			this->closedSchemaVersion = this->getSchemaVersionCore();
+		}
+		catch (const Exception &e) {
+			cerr << __func__ << "(): " << e.what() << endl;
+			this->closedFingerprint = 0;
+			this->closedSchemaVersion = -1;	/* Never a schema version of SQLite: the structure will be checked again when the database is opened again */
+		}
+		delete this->db;
+		this->db = NULL;
+		this->connectionOpen = false;
+	}
+	return true;
+}
+
+bool SQLiteDBManager::isConnectionOpen() const {
+	return this->connectionOpen.load();	/* Does not lock the manager: called by the reopen callbacks of other managers */
+}
+
+unsigned long long SQLiteDBManager::getLastUse() const {
+	return this->lastUse.load(std::memory_order_relaxed);
+}
+
+void SQLiteDBManager::setReopenCallback(const std::function<void(SQLiteDBManager&)>& callback) {
+	std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+	this->reopenCallback = callback;
+}
+
+bool SQLiteDBManager::applyOptions(const std::map<std::string, std::string>& options) {
+	static const vector<string> journalModes = {"delete", "truncate", "persist", "memory", "wal", "off"};
+
+	for (const auto& option : options) {
+		if (option.first == "journal_mode") {
+			string journalMode(option.second);
+			std::transform(journalMode.begin(), journalMode.end(), journalMode.begin(), ::tolower);
+			if (std::find(journalModes.begin(), journalModes.end(), journalMode) == journalModes.end()) {
+				cerr << __func__ << "(): unknown journal mode \"" << option.second << "\"" << endl;
+				return false;
+			}
+			try {
+				this->db->exec("PRAGMA journal_mode = " + journalMode);
+				this->journalMode = journalMode;	/* Applied again if the connection is closed and opened again */
+			}
+			catch (const Exception &e) {
+				cerr << __func__ << "(): " << e.what() << endl;
+				return false;
+			}
+		}
+		else if (option.first == "busy_timeout" || option.first == "busy_backoff") {
+			char* end = NULL;
+			long milliseconds = strtol(option.second.c_str(), &end, 10);
+			if (option.second.empty() || *end != '\0' || milliseconds < 0) {
+				cerr << __func__ << "(): invalid " << option.first << " \"" << option.second << "\"" << endl;
+				return false;
+			}
+			if (option.first == "busy_timeout")
+				this->busyTimeout = static_cast<unsigned int>(milliseconds);
+			else
+				this->busyBackoff = static_cast<unsigned int>(milliseconds);
+		}
+		else if (option.first == "readers") {
+			char* end = NULL;
+			long readers = strtol(option.second.c_str(), &end, 10);
+			if (option.second.empty() || *end != '\0' || readers < 0) {
+				cerr << __func__ << "(): invalid number of readers \"" << option.second << "\"" << endl;
+				return false;
+			}
+			this->readerCount = static_cast<unsigned int>(readers);
+		}
+		else if (option.first == "migration_chunk_size") {
+			char* end = NULL;
+			long rows = strtol(option.second.c_str(), &end, 10);
+			if (option.second.empty() || *end != '\0' || rows <= 0) {
+				cerr << __func__ << "(): invalid migration chunk size \"" << option.second << "\"" << endl;
+				return false;
+			}
+			this->migrationChunkSize = static_cast<unsigned int>(rows);
+		}
+		else {
+			cerr << __func__ << "(): unknown option \"" << option.first << "\"" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+void SQLiteDBManager::installBusyHandler(Database& connection) const {
+	sqlite3_busy_handler(connection.getHandle(), &SQLiteDBManager::busyHandler, const_cast<SQLiteDBManager*>(this));
+}
+
+int SQLiteDBManager::busyHandler(void* manager, int count) noexcept {
+	static thread_local std::minstd_rand jitter(std::random_device{}());
+	const SQLiteDBManager* self = static_cast<const SQLiteDBManager*>(manager);
+
+	/* count is the number of times the handler was already called for the lock we are waiting for */
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (count == 0)
+		busyWaitStart = now;
+	std::chrono::microseconds waited = std::chrono::duration_cast<std::chrono::microseconds>(now - busyWaitStart);
+	std::chrono::microseconds timeout = std::chrono::milliseconds(self->busyTimeout);
+	if (waited >= timeout) {
+		self->busyTimeouts++;
+		return 0;	/* Give up, the request fails with SQLITE_BUSY */
+	}
+
+	/* Exponential backoff, with a random delay between half and all of the backoff so that processes waiting for the same lock don't retry together */
+	unsigned long long backoff = std::max(1U, self->busyBackoff) * 1000ULL;
+	for (int retry = 0; retry < count && backoff < MAX_BUSY_BACKOFF * 1000ULL; retry++) {
+		backoff *= 2;
+	}
+	backoff = std::min(backoff, MAX_BUSY_BACKOFF * 1000ULL);
+	std::chrono::microseconds delay(backoff / 2 + jitter() % (backoff / 2 + 1));
+	delay = std::min(delay, timeout - waited);
+
+	std::this_thread::sleep_for(delay);
+	self->busyRetries++;
+	self->busyWaitTime += delay.count();
+	return 1;	/* Retry */
+}
+
+void SQLiteDBManager::recordError(const Exception& e) noexcept {
+	lastError() = (e.getErrorCode() == SQLITE_BUSY) ? DBManagerError::Busy : DBManagerError::Other;
+}
+
+bool SQLiteDBManager::commitTransaction(Transaction& transaction) noexcept {
+	try {
+		transaction.commit();
+		return true;
+	}
+	catch(const Exception &e) {	/* Other connections may prevent the commit, eg: a snapshot outside of WAL journal mode */
+		recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return false;
+	}
+}
+
+DBBusyStatistics SQLiteDBManager::getBusyStatistics() const {
+	return DBBusyStatistics{this->busyRetries.load(), this->busyWaitTime.load(), this->busyTimeouts.load()};
+}
+
+SQLiteWorkerPool& SQLiteDBManager::getWorkerPool() const {
+	std::lock_guard<std::mutex> poolLock(this->workerPoolMut);
+
+	if (!this->workerPool) {
+		vector<Database*> readConnections;
+		try {
+			bool isWal = false;
+			{
+				std::lock_guard<std::mutex> lock(this->mut);
+				Statement query(this->conn(), "PRAGMA journal_mode");
+				isWal = (query.executeStep() && string(query.getColumn(0).getText()) == "wal");
+			}
+			for (unsigned int reader = 0; isWal && reader < this->readerCount; reader++) {
+				readConnections.push_back(new Database(this->filename, SQLITE_OPEN_READONLY));
+				this->installBusyHandler(*(readConnections.back()));
+			}
+		}
+		catch (const Exception &e) {
+			cerr << __func__ << "(): " << e.what() << ", asynchronous reads will be run by the writer thread" << endl;
+			for (auto connection : readConnections) {
+				delete connection;
+			}
+			readConnections.clear();
+		}
+		this->workerPool.reset(new SQLiteWorkerPool(readConnections));
+	}
+	return *(this->workerPool);
+}
+
+void SQLiteDBManager::postRequest(const std::function<void(bool)>& request, const std::function<void()>& completion, const bool& readOnly) const {
+	this->getWorkerPool().post([this, request, completion](Database* connection) {
+		try {
+			if (connection == NULL) {	/* Writer thread: the request is atomic, on db */
+				request(true);
+			}
+			else {
+				readerConnectionOwner = this;	/* conn() now returns connection on this thread */
+				readerConnection = connection;
+				{
+					std::unique_ptr<Transaction> snapshot;	/* All the queries of the request read the same state of the database */
+					try {
+						snapshot.reset(new Transaction(*connection));
+					}
+					catch (const Exception &e) {
+						cerr << "postRequest(): " << e.what() << endl;
+					}
+					request(false);
 				}
-				htmlDump << "</tr>";
+				readerConnectionOwner = NULL;
+				readerConnection = NULL;
 			}
-			htmlDump << "</tbody>";
-			htmlDump << "</table>";
+		}
+		catch (const std::exception &e) {
+			readerConnectionOwner = NULL;
+			readerConnection = NULL;
+			cerr << "postRequest(): request failed: " << e.what() << endl;
+		}
+		if (completion) {	/* The thread is back to its normal state, the completion can use this manager */
+			completion();
+		}
+	}, readOnly);
+}
+
+template<typename R>
+std::future<R> SQLiteDBManager::submitJob(const std::function<R(bool)>& job, const bool& readOnly) const {
+	std::shared_ptr<std::packaged_task<R(bool)>> task = std::make_shared<std::packaged_task<R(bool)>>(job);
+	std::future<R> result = task->get_future();
+
+	this->postRequest([task](bool isAtomic) { (*task)(isAtomic); }, std::function<void()>(), readOnly);
+	return result;
+}
+
+bool SQLiteDBManager::areForeignKeysEnabled() const {
+	Statement query(this->conn(), "PRAGMA foreign_keys");
+	while (query.executeStep()) {
+		if (string(query.getColumn(0).getText()) == "1") {
+			return true;
 		}
 		else {
-			set<string> columnNames = this->getFieldNames(*tableName);
-			
-			htmlDump << "<table class=\"table table-striped table-bordered table-hover\">";
-			htmlDump << "<thead>";
-			htmlDump << "<tr>";
-			/* Write the first line: column names */
-			for (auto &it : columnNames) {
-				htmlDump << "<th>" << it;
-				if (this->isPrimaryKeyCore(*tableName, it)) {
-					htmlDump << " [PK] ";
+			//cout << "Text of pragma is " << query.getColumn(0).getText() << endl;
+		}
+	}
+	return false;
+}
+
+std::string SQLiteDBManager::tableToString(const std::string& tableName) const {
+
+	stringstream dump;
+
+	const vector<map<string, string> > records = this->get(tableName); // Get all records
+	map<string, bool> uniqueness = this->getUniqueness(tableName);	// Get the list of unique records for this table
+
+	if (!records.empty()) {
+		/* Compute the longest name for each column (between column names and values) */
+		map<string, unsigned int> longests;	/* string is the column name, unsigned int is the column width (in characters) */
+		for (vector<map<string, string> >::const_iterator vectIt = records.begin(); vectIt != records.end(); ++vectIt) {
+			for (map<string, string>::const_iterator mapIt = vectIt->begin(); mapIt != vectIt->end(); ++mapIt) {
+				/* Initialise count... if column is not known yet, set the length to fit the column name */
+				const string& columnName = mapIt->first;
+				const string& recordValue = mapIt->second;
+
+				if (longests.find(columnName) == longests.end()) {	/* New column (absent from map "longests" */
+					unsigned int columnHeaderSz = columnName.size();	/* Start from the size of the column */
+					if (this->isPrimaryKeyCore(tableName, columnName)) {	/* This column stores primary keys */
+						columnHeaderSz+=5;	/* Get more room for suffix " [PK]" (5 chars) */
+					}
+					if (uniqueness[columnName]) {	/* This column stores unique entries */
+						columnHeaderSz+=4;	/* Get more room for suffix " [U]" (4 chars) */
+					}
+					longests.emplace(columnName, columnHeaderSz);
 				}
-				if (uniqueness[it]) {
-					htmlDump << " [U] ";
+
+				/* Only if we find a value that is larger than the column name, increase the max length */
+				if (recordValue.size() > longests[columnName]) {
+					longests[columnName] = recordValue.size();
 				}
-				htmlDump << "</th>";
 			}
-			htmlDump << "</tr>";
-			htmlDump << "</thead>";
-			htmlDump << "</table>";
 		}
+
+		/* Write the first line: column names */
+		stringstream Hsep;	/* Horizontal separator between rows (records) */
+		stringstream headers;	/* Headers line */
+		Hsep << "+-";	/* Start with left border */
+		headers << "| ";
+		for (map<string, string>::const_iterator mapIt = records.at(0).begin(); mapIt != records.at(0).end(); ++mapIt) {
+			/* Check if iterator is on the first column, and add a separator otherwise */
+			if (mapIt != records.at(0).begin()) {	/* If not the first column of the table */
+				Hsep << "-+-";	/* Add separators */
+				headers << " | ";
+			}
+
+			const string& columnName = mapIt->first;
+
+			Hsep << string(longests[columnName], '-');	/* Fill hypens */
+
+			string columnHeader(columnName);
+			if (this->isPrimaryKeyCore(tableName, columnName)) {	/* This column stores primary keys */
+				columnHeader += " [PK]";
+			}
+			if (uniqueness[columnName]) {	/* This column stores unique entries */
+				columnHeader += " [U]";
+			}
+
+			headers << columnHeader << string(longests[columnName]-columnHeader.size(), ' ');	/* Write header and pad with spaces */
+		}
+		Hsep << "-+";	/* Add right border */
+		headers << " |";
+
+		/* Once here, we have created the headers line and a Hsep separator to use between all records */
+		stringstream values;
+		for (vector<map<string, string> >::const_iterator vectIt = records.begin(); vectIt != records.end(); ++vectIt) {
+			values << "| ";	/* Start with left border */
+			for (map<string, string>::const_iterator mapIt = vectIt->begin(); mapIt != vectIt->end(); ++mapIt) {
+				/* Check if iterator is on the first column, and add a separator otherwise */
+				if (mapIt != vectIt->begin()) {	/* If not the first column of the table */
+					values << " | ";	/* Add separator */
+				}
+				const string& columnName = mapIt->first;
+				const string& recordValue = mapIt->second;
+				values << recordValue << string(longests[columnName]-recordValue.size(), ' ');	/* Write value for this record (row) and pad with spaces */
+			}
+			values << " |" << endl; /* Add right border */
+		}
+
+		stringstream tableDump;
+		tableDump << "Table: " << tableName << endl;
+		tableDump << Hsep.str() << endl;
+		tableDump << headers.str() << endl;
+		tableDump << Hsep.str() << endl;
+		tableDump << values.str();	/* Note: values already terminates with endl */
+		tableDump << Hsep.str() << endl;
+
+		dump << tableDump.str();
 	}
-	htmlDump << "</body>";
+	else {	/* If we reach here, records.empty() == true */
+		set<string> columnNames = this->getFieldNames(tableName);
 
-	return htmlDump.str();
-}
+		dump << "Table: " << tableName << " is empty" << endl;
+		dump << "Columns are: ";
+
+		for (set<string>::const_iterator setIt = columnNames.begin(); setIt != columnNames.end(); ++setIt) {
+			if (setIt != columnNames.begin()) {
+				dump << ", ";
+			}
+			dump << *setIt;
+			if (this->isPrimaryKeyCore(tableName, *setIt)) {	/* This column stores primary keys */
+				dump << " [PK]";
+			}
+			if (uniqueness[*setIt]) {	/* This column stores unique entries */
+				dump << " [U]";
+			}
+		}
+		dump << endl;
+	}
+	return dump.str();
+}
+
+std::string SQLiteDBManager::to_string(const std::string& dumpTableName) const {
+	stringstream dump;
+
+#ifdef DEBUG
+	cout << __func__ << "(): Starting parsing database" << endl;
+#endif
+	const vector< string > tables = this->listTables();
+	
+	bool specificTableFound = false;	/* Did we find a specific table we were asked to dump? */
+	if (this->areForeignKeysEnabled()) {
+		dump << "Foreign Keys are enabled" << endl;
+	}
+	else {
+		dump << "Foreign Keys are disabled" << endl;
+	}
+	dump << "Database stored in " << this->filename << endl << "List of tables (" << tables.size() << "): ";
+	for (vector<string>::const_iterator tableName = tables.begin(); tableName != tables.end(); ++tableName) {
+		if (tableName != tables.begin()) {
+			dump << ", ";
+		}
+		if (*tableName == dumpTableName) {	/* We have found the table name that we were requested to dump */
+			specificTableFound = true;
+		}
+		dump << "\"" << *tableName << "\"";
+	}
+	dump << endl;
+
+	if (dumpTableName != "") {	/* A table name was specified as argument */
+		if (specificTableFound) {
+			/* The specified table was found... dump only this table (not the whole db) */
+			return this->tableToString(dumpTableName);
+		}
+		else {	/* The specified table was not found */
+#ifdef DEBUG
+			cerr << __func__ << "(): The table specified (\"" << dumpTableName << "\") does not exist. Dumping all database instead" << endl;
+#endif
+		}
+	}
+
+	for (vector<string>::const_iterator tableName = tables.begin(); tableName != tables.end(); ++tableName) {
+		/* tableName will loop through every table name in the database */
+		dump << this->tableToString(*tableName);
+	}
+#ifdef DEBUG
+	cout << __func__ << "(): Finished parsing database" << endl;
+#endif
+	return dump.str();
+}
+
+std::string SQLiteDBManager::dumpTablesAsHtml() const {
+	stringstream htmlDump;
+	htmlDump << "<!DOCTYPE html>";
+	htmlDump << "<head>";
+	htmlDump << "<title>Condutor tables dump</title>";
+	htmlDump <<	"<link rel=\"icon\" href=\"../favicon.ico\">";
+	htmlDump <<	"<!-- Bootstrap core CSS -->";
+	htmlDump <<	"<link href=\"../css/bootstrap.css\" rel=\"stylesheet\">";
+	htmlDump <<	"<!-- HTML5 shim and Respond.js IE8 support of HTML5 elements and media queries -->";
+	htmlDump <<	"<!--[if lt IE 9]>";
+	htmlDump <<	"<script src=\"../js/html5shiv.min.js\"></script>";
+	htmlDump <<	"<script src=\"../js/respond.min.js\"></script>";
+	htmlDump <<	"<![endif]-->";
+	htmlDump <<	"<!-- [if (It IE 9) & (!IEMobile)]>";
+	htmlDump <<	"<script src=\"../js/css3-mediaqueries.js\"></script>";
+	htmlDump <<	"<![endif]-->";
+	htmlDump << "</head>";
+	htmlDump << "<body>";
+	htmlDump << "<h1> Dump of Conductor Tables </h1>";
+	
+	if (this->areForeignKeysEnabled()) {
+		htmlDump << "<p> Foreign Keys are enabled </p>";
+	}
+	else {
+		htmlDump << "<p> Foreign Keys are disabled </p>";
+	}
+
+	const vector< string > tables = this->listTables();
+
+	for (vector<string>::const_iterator tableName = tables.begin(); tableName != tables.end(); ++tableName) {
+		/* tableName will loop through every table name in the database */
+		htmlDump << "<h3> Table : " << *tableName << "</h3>";
+		vector<map<string, string> > records = this->get(*tableName); // Get all records
+		map<string, bool> uniqueness = this->getUniqueness(*tableName);
+
+		if (!records.empty()) {
+			htmlDump << "<table class=\"table table-striped table-bordered table-hover\">";
+			htmlDump << "<thead>";
+			htmlDump << "<tr>";
+			/* Write the first line: column names */
+			for (map<string, string>::iterator mapIt = records.at(0).begin(); mapIt != records.at(0).end(); ++mapIt) {
+				const string& columnName = mapIt->first;
+				
+				htmlDump << "<th>" << columnName;
+				if (this->isPrimaryKeyCore(*tableName, columnName)) {
+					htmlDump << " [PK] ";
+				}
+				if (uniqueness[columnName]) {
+					htmlDump << " [U] ";
+				}
+				htmlDump << "</th>";
+			}
+			htmlDump << "</tr>";
+			htmlDump << "</thead>";
+			
+			/* Write all records, one record per table row, one field in each table cell */
+			htmlDump << "<tbody>";
+			for (vector<map<string, string> >::iterator vectIt = records.begin(); vectIt != records.end(); ++vectIt) {
+				htmlDump << "<tr>";
+				for (map<string, string>::iterator mapIt = vectIt->begin(); mapIt != vectIt->end(); ++mapIt) {
+					const string& recordValue = mapIt->second;
+					htmlDump << "<td>" << recordValue << "</td>";
+				}
+				htmlDump << "</tr>";
+			}
+			htmlDump << "</tbody>";
+			htmlDump << "</table>";
+		}
+		else {
+			set<string> columnNames = this->getFieldNames(*tableName);
+			
+			htmlDump << "<table class=\"table table-striped table-bordered table-hover\">";
+			htmlDump << "<thead>";
+			htmlDump << "<tr>";
+			/* Write the first line: column names */
+			for (auto &it : columnNames) {
+				htmlDump << "<th>" << it;
+				if (this->isPrimaryKeyCore(*tableName, it)) {
+					htmlDump << " [PK] ";
+				}
+				if (uniqueness[it]) {
+					htmlDump << " [U] ";
+				}
+				htmlDump << "</th>";
+			}
+			htmlDump << "</tr>";
+			htmlDump << "</thead>";
+			htmlDump << "</table>";
+		}
+	}
+	htmlDump << "</body>";
+
+	return htmlDump.str();
+}
 
 bool SQLiteDBManager::isReferenced(const std::string& name,
                                    const bool& isAtomic) const {
 
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		return this->isReferencedCore(name);
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->isReferencedCore(name);
+	}
+}
+
+bool SQLiteDBManager::isReferencedCore(const std::string& name) const {
+	bool result = false;
+	try {
+		Statement query(this->conn(), "PRAGMA table_info(\"" + this->escDQ(name) + "\")");
+		while(query.executeStep()) {
+			////cout << query.getColumn(0).getInt() << "|" << query.getColumn(1).getText() << "|" << query.getColumn(2).getText() << "|" << query.getColumn(3).getInt() << "|" << query.getColumn(4).getText() << "|" << query.getColumn(5).getInt() << endl;
+			//+1 Because of behavior of the pragma.
+			//The pk column is equal to 0 if the field isn't part of the primary key.
+			//If the field is part of the primary key, it is equal to the index of the record +1
+			//(+1 because for record of index 0, it would be marked as not part of the primary key without the +1).
+			//Only the id column makes a table referenced (tables stored without rowid have another primary key).
+			if(query.getColumn(5).getInt() == (query.getColumn(0).getInt()+1) && string(query.getColumn(1).getText()) == PK_FIELD_NAME) {
+				result = true;
+			}
+		}
+	}
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << "isReferencedCore: " << e.what() << endl;
+	}
+	return result;
+}
+
+std::set<std::string> SQLiteDBManager::getPrimaryKeys(const std::string& name,
+                                                      const bool& isAtomic) const {
+
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		return this->getPrimaryKeysCore(name);
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->getPrimaryKeysCore(name);
+	}
+}
+
+std::set<std::string> SQLiteDBManager::getPrimaryKeysCore(const std::string& name) const {
+
+	set<string> result;
+	try {
+		Statement query(this->conn(), "PRAGMA table_info(\"" + this->escDQ(name) + "\")");
+		while (query.executeStep()) {
+			////cout << query.getColumn(0).getInt() << "|" << query.getColumn(1).getText() << "|" << query.getColumn(2).getText() << "|" << query.getColumn(3).getInt() << "|" << query.getColumn(4).getText() << "|" << query.getColumn(5).getInt() << endl;
+			//+1 Because of behavior of the pragma.
+			//The pk column is equal to 0 if the field isn't part of the primary key.
+			//If the field is part of the primary key, it is equal to the index of the record +1
+			//(+1 because for record of index 0, it would be marked as not part of the primary key without the +1).
+			if (query.getColumn(5).getInt() == (query.getColumn(0).getInt()+1)) {
+				result.emplace(query.getColumn(1).getText());
+			}
+		}
+	}
+	catch (const Exception &e) {
+		this->recordError(e);
+		cerr << "getPrimaryKeysCore: " << e.what() << endl;
+	}
+	return result;
+}
+
+std::map<std::string, std::string> SQLiteDBManager::getDefaultValues(const std::string& name,
+                                                                     const bool& isAtomic) const {
+
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		return this->getDefaultValuesCore(name);
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->getDefaultValuesCore(name);
+	}
+}
+
+std::map<std::string, std::string> SQLiteDBManager::getDefaultValuesCore(const std::string& name) const {
+
+	try {
+		bool referenced = this->isReferencedCore(name);
+		Statement query(this->conn(), "PRAGMA table_info(\"" + this->escDQ(name) + "\")");
+		map<string, string> defaultValues;
+		while(query.executeStep()) {
+			string fieldName = query.getColumn(1).getText();
+			if(!(referenced && (fieldName == PK_FIELD_NAME))) {
+				string dv = query.getColumn(4).getText();
+				if(dv.front() == '"' && dv.back() == '"') {
+					dv = dv.substr(1, dv.length()-2);
+				}
+				defaultValues.emplace(fieldName, dv);
+			}
+		}
+
+		return defaultValues;
+	}
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << "getDefaultValues: " << e.what() << endl;
+		return map<string, string>();
+	}
+}
+
+std::map<std::string, bool> SQLiteDBManager::getNotNullFlags(const std::string& name,
+                                                             const bool& isAtomic) const {
+
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		return this->getNotNullFlagsCore(name);
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->getNotNullFlagsCore(name);
+	}
+}
+
+std::map<std::string, bool> SQLiteDBManager::getNotNullFlagsCore(const std::string& name) const {
+
+	try {
+		bool referenced = this->isReferencedCore(name);
+		Statement query(this->conn(), "PRAGMA table_info(\"" + this->escDQ(name) + "\")");
+		map<string, bool> notNullFlags;
+		while(query.executeStep()) {
+			string fieldName = query.getColumn(1).getText();
+			if(!(referenced && (fieldName == PK_FIELD_NAME)))
+				notNullFlags.emplace(fieldName,(query.getColumn(3).getInt() == 1));
+		}
+
+		return notNullFlags;
+	}
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << "getNotNullFlagsCore: " << e.what() << endl;
+		return map<string, bool>();
+	}
+}
+
+std::map<std::string, bool> SQLiteDBManager::getUniqueness(const std::string& name,
+                                                           const bool& isAtomic) const {
+
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		return this->getUniquenessCore(name);
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->getUniquenessCore(name);
+	}
+}
+
+std::map<std::string, bool> SQLiteDBManager::getUniquenessCore(const std::string& name) const {
+
+	try {
+		bool referenced = this->isReferencedCore(name);
+		//(1) We get the field list
+		set<string> notUniqueFields = this->getFieldNamesCore(name);
+
+		//(2) We obtain the unique indexes
+		set<string> uniqueFields;
+		Statement query2(this->conn(), "PRAGMA index_list(\"" + this->escDQ(name) + "\")");
+		while(query2.executeStep()) {
+			string fieldName = query2.getColumn(1).getText();
+			if(!(referenced && (fieldName == PK_FIELD_NAME))) {
+				if(query2.getColumn(2).getInt() == 1 && string(query2.getColumn(3).getText()) != "c") {	/* Only UNIQUE constraints of fields (or the primary key of a table stored without rowid), not unique indexes declared separately */
+					Statement query3(this->conn(), "PRAGMA index_info(\"" + this->escDQ(fieldName) + "\")");
+					while(query3.executeStep()) {
+						uniqueFields.emplace(query3.getColumn(2).getText());
+					}
+				}
+			}
+		}
+
+		map<string, bool> uniqueness;
+		for(auto &it : uniqueFields) {
+			notUniqueFields.erase(notUniqueFields.find(it));
+			uniqueness.emplace(it, true);
+		}
+
+		for(auto &it : notUniqueFields) {
+			uniqueness.emplace(it, false);
+		}
+
+		return uniqueness;
+	}
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << "getUniquenessCore: " << e.what() << endl;
+		return map<string, bool>();
+	}
+}
+
+std::string SQLiteDBManager::createRelation(const std::string& kind,
+                                            const std::vector<std::string>& tables,
+                                            const bool& reverseIndex,
+                                            const bool& isAtomic) {
+
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		Transaction transaction(this->conn());
+		string result = this->createRelationCore(kind, tables, reverseIndex);
+		if(!result.empty() && !this->commitTransaction(transaction))
+			result.clear();
+		return result;
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->createRelationCore(kind, tables, reverseIndex);
+	}
+}
+
+std::string SQLiteDBManager::createRelationCore(const std::string& kind,
+                                                const std::vector<std::string>& tables,
+                                                const bool& reverseIndex) {
+
+	//m:n relationships
+	if(kind == "m:n" && tables.size() == 2) {
+		string table1 = tables.at(0);
+		string table2 = tables.at(1);
+		string relationName = table1 + "_" + table2;
+		bool addIt = true;
+		// We check that the joining table does not already exists in the database.
+		for(auto &it : listTablesCore()) {
+			if(it == relationName) {
+				addIt = false;
+			}
+		}
+
+		stringstream fieldName1;
+		fieldName1 << table1 << "#" << PK_FIELD_NAME;
+		stringstream fieldName2;
+		fieldName2 << table2 << "#" << PK_FIELD_NAME;
+
+		if(addIt) {
+			//If the joining table needs to be created, we first check that referenced table have primary keys.
+			//If they do not, we give them a primary key field.
+			if(!this->isReferencedCore(table1)) {
+				this->markReferencedCore(table1);
+			}
+			if(!this->isReferencedCore(table2)) {
+				this->markReferencedCore(table2);
+			}
+
+			stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+			ss << "CREATE TABLE \"" << this->escDQ(relationName) << "\" (";
+
+			ss << "\"" << this->escDQ(fieldName1.str())  << "\" INTEGER REFERENCES \"" << this->escDQ(table1) << "\"(\"" << this->escDQ(PK_FIELD_NAME) << "\"), ";
+			ss << "\"" << this->escDQ(fieldName2.str()) << "\" INTEGER REFERENCES \"" << this->escDQ(table2) << "\"(\"" << this->escDQ(PK_FIELD_NAME) << "\"), ";
+			ss << "PRIMARY KEY (\"" << this->escDQ(table1) << "#" << this->escDQ(PK_FIELD_NAME) << "\", \"" << this->escDQ(table2) << "#" << this->escDQ(PK_FIELD_NAME) << "\"))";
+			//The primary key contains the whole record, so there is no need to store it a second time in a rowid table
+			ss << " WITHOUT ROWID";
+
+			//We use the referenced table primary keys as foreign keys (see m:n relationship theory if it bugs you).
+			this->conn().exec(ss.str());
+		}
+
+		//The primary key only serves lookups by the first column, so lookups from the second table need their own index.
+		//This is also done for joining tables that already exist, so that databases created without this index are migrated.
+		stringstream ssIndex(ios_base::in | ios_base::out | ios_base::ate);
+		if(reverseIndex) {
+			ssIndex << "CREATE INDEX IF NOT EXISTS \"" << this->escDQ(relationName + REVERSE_INDEX_SUFFIX) << "\" ON \"" << this->escDQ(relationName) << "\" (\"" << this->escDQ(fieldName2.str()) << "\")";
+		}
+		else {
+			ssIndex << "DROP INDEX IF EXISTS \"" << this->escDQ(relationName + REVERSE_INDEX_SUFFIX) << "\"";
+		}
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"" << ssIndex.str() << "\"" << endl;
+#endif
+		this->conn().exec(ssIndex.str());
+
+		return relationName;
+	}
+	else {
+		return string();
+	}
+}
+
+int SQLiteDBManager::getSQLiteVersionCore() const {
+
+	Statement query(this->conn(), "SELECT sqlite_version()");
+	if(!query.executeStep())
+		return 0;
+
+	/* The version string is "X.Y.Z", convert it to the same format as SQLITE_VERSION_NUMBER (X*1000000 + Y*1000 + Z) */
+	string version = query.getColumn(0).getText();
+	int result = 0;
+	size_t start = 0;
+	for(unsigned int i = 0; i < 3; i++) {
+		size_t end = version.find('.', start);
+		result = result * 1000 + atoi(version.substr(start, end - start).c_str());
+		if(end == string::npos) {
+			for(i++; i < 3; i++)
+				result *= 1000;
+			break;
+		}
+		start = end + 1;
+	}
+
+	return result;
+}
+
+std::set<std::string> SQLiteDBManager::getIndexedFieldsCore(const std::string& name) const {
+
+	set<string> indexedFields;
+	Statement query(this->conn(), "PRAGMA index_list(\"" + this->escDQ(name) + "\")");
+	while(query.executeStep()) {
+		Statement query2(this->conn(), "PRAGMA index_info(\"" + this->escDQ(query.getColumn(1).getText()) + "\")");
+		while(query2.executeStep()) {
+			if(!query2.getColumn(2).isNull())	/* Expressions in indexes have no column name */
+				indexedFields.emplace(query2.getColumn(2).getText());
+		}
+	}
+
+	return indexedFields;
+}
+
+std::set<std::string> SQLiteDBManager::getIndexedFields(const SQLTable& table) const {
+
+	set<string> indexedFields;
+	for(auto &it : table.getFields()) {
+		if(std::get<3>(it)) {
+			indexedFields.emplace(std::get<0>(it));
+		}
+	}
+	for(auto &it : table.getIndexes()) {
+		indexedFields.insert(std::get<1>(it).begin(), std::get<1>(it).end());
+	}
+
+	return indexedFields;
+}
+
+std::vector<std::tuple<std::string, std::vector<std::string>, bool>> SQLiteDBManager::getIndexesCore(const std::string& name) const {
+
+	vector<tuple<string, vector<string>, bool>> indexes;
+	try {
+		Statement query(this->conn(), "PRAGMA index_list(\"" + this->escDQ(name) + "\")");
+		while(query.executeStep()) {
+			if(string(query.getColumn(3).getText()) != "c")	/* Only indexes created by CREATE INDEX, not those of UNIQUE or PRIMARY KEY constraints */
+				continue;
+			string indexName = query.getColumn(1).getText();
+			vector<string> indexedFields;
+			Statement query2(this->conn(), "PRAGMA index_info(\"" + this->escDQ(indexName) + "\")");
+			while(query2.executeStep()) {	/* Rows are sorted by rank of the column in the index */
+				indexedFields.push_back(query2.getColumn(2).getText());
+			}
+			indexes.push_back(make_tuple(indexName, indexedFields, (query.getColumn(2).getInt() == 1)));
+		}
+		std::sort(indexes.begin(), indexes.end());	/* Sorted by name, as in getTablesFromDatabaseCore() */
+	}
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return vector<tuple<string, vector<string>, bool>>();
+	}
+
+	return indexes;
+}
+
+bool SQLiteDBManager::hasReverseIndexCore(const std::string& joiningTable) const {
+
+	Statement query(this->conn(), "SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND name = ?");
+	query.bind(1, joiningTable + REVERSE_INDEX_SUFFIX);
+	return (query.executeStep() && query.getColumn(0).getInt() > 0);
+}
+
+std::vector< std::map<std::string, std::string> > SQLiteDBManager::get(const std::string& table,
+                                                                       const std::vector<std::string >& columns,
+                                                                       const bool& distinct,
+                                                                       const bool& isAtomic) const noexcept {
+
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		return this->getCore(table, columns, distinct);
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->getCore(table, columns, distinct);
+	}
+}
+
+bool SQLiteDBManager::insert(const std::string& table,
+                             const std::vector<std::map<std::string, std::string> >& values,
+							 const bool& isAtomic) {
+
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		Transaction transaction(this->conn());
+
+		bool result = this->insertCore(table, values);
+		if(result)
+			result = this->commitTransaction(transaction);
+		return result;
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->insertCore(table, values);
+	}
+}
+
+bool SQLiteDBManager::modify(const std::string& table,
+                             const std::map<std::string, std::string>& refFields,
+                             const std::map<std::string, std::string>& values,
+                             const bool& insertIfNotExists,
+                             const bool& isAtomic) noexcept {
+
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		Transaction transaction(this->conn());
+
+		bool result = this->modifyCore(table, refFields, values, insertIfNotExists);
+		if(result)
+			result = this->commitTransaction(transaction);
+		return result;
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->modifyCore(table, refFields, values, insertIfNotExists);
+	}
+}
+
+bool SQLiteDBManager::remove(const std::string& table,
+                             const std::map<std::string, std::string>& refFields,
+                             const bool& isAtomic) {
+
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		Transaction transaction(this->conn());
+
+		bool result = this->removeCore(table, refFields);
+		if(result)
+			result = this->commitTransaction(transaction);
+		return result;
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->removeCore(table, refFields);
+	}
+}
+
+std::vector< std::map<std::string, std::string> > SQLiteDBManager::getCore(const std::string& table,
+                                                                           const std::vector<std::string >& columns,
+                                                                           const bool& distinct) const noexcept {
+
+	try {
+		stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+		ss << "SELECT ";
+
+		if(distinct)
+			ss << "DISTINCT ";
+
+		vector<string > newColumns;
+		bool getAllFields = (columns.empty() || (columns.size() == 1 && columns.at(0) == "*"));	/* Shall be process all fields of the table? (there no filter) */
+		if (getAllFields) {
+			ss << "*";
+			//We fetch the names of table's columns in order to populate the map correctly
+			//(With only * as columns name, we are notable to match field names to field values in order to build the map)
+			Statement query(this->conn(), "PRAGMA table_info(\"" + this->escDQ(table) + "\");");
+			while(query.executeStep())
+				newColumns.push_back(query.getColumn(1).getText());
+		}
+		else {	/* There is a filter... insert the field names in the SQL command */
+			for (vector<std::string >::const_iterator it = columns.begin(); it != columns.end(); ++it) {
+				/* Check if iterator is on the first element of the list, and add a separator otherwise */
+				if (it != columns.begin()) {
+					ss << ", ";
+				}
+				ss << "\"" << this->escDQ(*it) << "\"";
+				newColumns.push_back(*it);
+			}
+		}
+
+		ss << " FROM \"" << this->escDQ(table) << "\"";
+		
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
+#endif
+		Statement query(this->conn(), ss.str());
+		
+		vector<map<string, string> > result;
+
+		while(query.executeStep()) {
+			map<string, string> record;
+
+			for(int i = 0; i < query.getColumnCount(); ++i) {
+				if(query.getColumn(i).isNull()) {
+					record.emplace(newColumns.at(i), "");
+				}
+				else {
+					record.emplace(newColumns.at(i), query.getColumn(i).getText());
+				}
+			}
+
+			result.push_back(record);
+		}
+
+		return result;
+	}
+	catch(const Exception & e) {
+		this->recordError(e);
+		cerr << "getCore: " << e.what() << endl;
+		return vector< map<string, string> >();
+	}
+}
+
+unsigned long long SQLiteDBManager::count(const std::string& table,
+                                          const std::map<std::string, std::string>& refFields,
+                                          const bool& isAtomic) const {
+
+	this->lastError() = DBManagerError::None;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		return this->isReferencedCore(name);
+		return this->countCore(table, refFields);
 	}
 	else {
-		return this->isReferencedCore(name);
+		ConnectionUse use(*this);
+		return this->countCore(table, refFields);
 	}
 }
 
-bool SQLiteDBManager::isReferencedCore(const std::string& name) const {
-	bool result = false;
+unsigned long long SQLiteDBManager::countCore(const std::string& table,
+                                              const std::map<std::string, std::string>& refFields) const {
+
 	try {
-		Statement query(*(this->db), "PRAGMA table_info(\"" + this->escDQ(name) + "\")");
-		while(query.executeStep()) {
-			////cout << query.getColumn(0).getInt() << "|" << query.getColumn(1).getText() << "|" << query.getColumn(2).getText() << "|" << query.getColumn(3).getInt() << "|" << query.getColumn(4).getText() << "|" << query.getColumn(5).getInt() << endl;
-			//+1 Because of behavior of the pragma.
-			//The pk column is equal to 0 if the field isn't part of the primary key.
-			//If the field is part of the primary key, it is equal to the index of the record +1
-			//(+1 because for record of index 0, it would be marked as not part of the primary key without the +1).
-			if(query.getColumn(5).getInt() == (query.getColumn(0).getInt()+1)) {
-				result = true;
+		stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+		ss << "SELECT COUNT(*) FROM \"" << this->escDQ(table) << "\"";
+		if (!refFields.empty()) {
+			ss << " WHERE ";
+			for (map<string, string>::const_iterator it = refFields.begin(); it != refFields.end(); ++it) {
+				if (it != refFields.begin()) {
+					ss << " AND ";
+				}
+				ss << "\"" << this->escDQ(it->first) << "\" = ?";
 			}
 		}
+
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
+#endif
+		Statement query(this->conn(), ss.str());
+		int index = 1;
+		for (auto &it : refFields) {
+			query.bind(index++, it.second);
+		}
+		if (query.executeStep()) {
+			return static_cast<unsigned long long>(query.getColumn(0).getInt64());
+		}
+		return 0;
 	}
-	catch(const Exception &e) {
-		cerr << "isReferencedCore: " << e.what() << endl;
+	catch (const Exception &e) {
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return 0;
 	}
-	return result;
 }
 
-std::set<std::string> SQLiteDBManager::getPrimaryKeys(const std::string& name,
-                                                      const bool& isAtomic) const {
+bool SQLiteDBManager::insertCore(const std::string& table,
+                                 const std::vector<std::map<std::string, string> >& values) {
 
-	if(isAtomic) {
-		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		return this->getPrimaryKeysCore(name);
+	try {
+		bool result = true;
+		for (vector<map<string, string> >::const_iterator vectIt = values.begin(); vectIt != values.end(); ++vectIt) {
+			stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+			//Only one request is used. We could have use one request for each record, but it would have been slower.
+			ss << "INSERT INTO \"" << this->escDQ(table) << "\" ";
+			if (!vectIt->empty()) {
+				stringstream columnsName(ios_base::in | ios_base::out | ios_base::ate);
+				stringstream columnsValue(ios_base::in | ios_base::out | ios_base::ate);
+				columnsName << "(";
+				columnsValue << "(";
+				for (map<string, string>::const_iterator mapIt = vectIt->begin(); mapIt != vectIt->end(); ++mapIt) {
+					/* Check if iterator is on the first element of the list, and add a separator otherwise */
+					if (mapIt != vectIt->begin()) {
+						columnsName << ",";
+						columnsValue << ",";
+					}
+					columnsName << "\"" << this->escDQ(mapIt->first) << "\"";
+					columnsValue << "\"" << this->escDQ(mapIt->second) << "\"";
+				}
+				columnsName << ")";
+				columnsValue << ")";
+
+				ss << columnsName.str() << " VALUES " << columnsValue.str() << ";";
+			}
+			else {
+				ss << "DEFAULT VALUES";
+			}
+#ifdef DEBUG
+			cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
+#endif
+			result = result && (this->conn().exec(ss.str()) > 0);
+		}
+
+		return result;
 	}
-	else {
-		return this->getPrimaryKeysCore(name);
+	catch (const Exception &e) {
+		this->recordError(e);
+		cerr  << __func__ << "(): " << e.what() << endl;
+		return false;
 	}
 }
 
-std::set<std::string> SQLiteDBManager::getPrimaryKeysCore(const std::string& name) const {
+bool SQLiteDBManager::modifyCore(const std::string& table,
+                                 const std::map<std::string, std::string>& refFields,
+                                 const std::map<std::string, std::string>& values,
+                                 const bool& insertIfNotExists) noexcept {
 
-	set<string> result;
-	try {
-		Statement query(*(this->db), "PRAGMA table_info(\"" + this->escDQ(name) + "\")");
-		while (query.executeStep()) {
-			////cout << query.getColumn(0).getInt() << "|" << query.getColumn(1).getText() << "|" << query.getColumn(2).getText() << "|" << query.getColumn(3).getInt() << "|" << query.getColumn(4).getText() << "|" << query.getColumn(5).getInt() << endl;
-			//+1 Because of behavior of the pragma.
-			//The pk column is equal to 0 if the field isn't part of the primary key.
-			//If the field is part of the primary key, it is equal to the index of the record +1
-			//(+1 because for record of index 0, it would be marked as not part of the primary key without the +1).
-			if (query.getColumn(5).getInt() == (query.getColumn(0).getInt()+1)) {
-				result.emplace(query.getColumn(1).getText());
+	if (values.empty()) return false;
+
+	stringstream sql_where(ios_base::in | ios_base::out | ios_base::ate);
+	if (!refFields.empty()) {
+		sql_where << "WHERE ";
+		for (map<string, string>::const_iterator it = refFields.begin(); it != refFields.end(); ++it) {
+			/* Check if iterator is on the first element of the list, and add a separator otherwise */
+			if (it != refFields.begin()) {
+				sql_where << " AND ";
 			}
+			sql_where << "\"" << this->escDQ(it->first) << "\" = \"" << this->escDQ(it->second) << "\"";
 		}
 	}
-	catch (const Exception &e) {
-		cerr << "getPrimaryKeysCore: " << e.what() << endl;
+
+	if (insertIfNotExists) {
+		/* Count the number of records matching refFields filter */
+		stringstream sql_cmd(ios_base::in | ios_base::out | ios_base::ate);
+		sql_cmd << "SELECT COUNT(*) AS RecordCount FROM \"" << this->escDQ(table) << "\" " << sql_where.str();
+
+		long int recordCount = 0;
+
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"" <<  sql_cmd.str() << "\"" << endl;
+#endif
+		Statement query(this->conn(), sql_cmd.str());
+
+		while (query.executeStep()) {
+			if (query.getColumnCount() != 1) {
+				cerr  << "modifyCore: COUNT query returned more than one line" << endl;
+			}
+			if (query.getColumn(0).isNull()) {
+				cerr  << "modifyCore: COUNT query returned empty line" << endl;
+			}
+			else {
+				recordCount = strtol(query.getColumn(0).getText(), NULL, 0);
+			}
+		}
+		//cout << "Got record count " << recordCount << "\n";
+
+		if (recordCount == 0) {	/* No matching field exist in the database... we can't modify... try insertion instead */
+			vector<map<string,string>> vals;
+			map<string,string> insertedValues(values);	/* Initialise the values to insert with the values provided for modification */
+
+			for (map<string, string>::const_iterator mapIt = refFields.begin(); mapIt != refFields.end(); ++mapIt) {	/* Parse the whole refFields map */
+				const string& refColumnName = mapIt->first;
+				const string& refRecordValue = mapIt->second;
+
+				if (insertedValues.find(refColumnName) == insertedValues.end()) {	/* refColumnName was not found inside the insertedValue map */
+					/* If this column was not part of the values to set, use the reference value (that we should have matched against) as the column+value pair to insert */
+					/* This will make sure that we build a record as close as possible to the supposed result we would have after a successful modify (instead of insert) */
+					insertedValues.emplace(std::make_pair(refColumnName, refRecordValue));
+				}
+			}
+
+			vals.push_back(insertedValues);
+#ifdef DEBUG
+			cout << __func__ << "(): Inserting rather than modifying (no pre-existing record)\n";
+#endif
+			return this->insertCore(table, vals);	/* Insert rather than modifying */
+		}
 	}
-	return result;
-}
+	/* If we reach here, we will modify, not insert */
+	try {
+		stringstream sql_cmd(ios_base::in | ios_base::out | ios_base::ate);
+		sql_cmd << "UPDATE \"" << this->escDQ(table) << "\" SET ";
 
-std::map<std::string, std::string> SQLiteDBManager::getDefaultValues(const std::string& name,
-                                                                     const bool& isAtomic) const {
+		for (std::map<std::string, std::string>::const_iterator it = values.begin(); it != values.end(); ++it) {
+			/* Check if iterator is on the first element of the list, and add a separator otherwise */
+			if (it != values.begin()) {
+				sql_cmd << ", ";
+			}
+			const string& fieldName = it->first;
+			const string& newValue = it->second;
+			sql_cmd << "\"" << this->escDQ(fieldName) << "\" = \"" << this->escDQ(newValue) << "\"";
+		}
+		sql_cmd << " " << sql_where.str();
 
-	if(isAtomic) {
-		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		return this->getDefaultValuesCore(name);
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"" << sql_cmd.str() << "\"" << endl;
+#endif
+		return this->conn().exec(sql_cmd.str()) > 0;
 	}
-	else {
-		return this->getDefaultValuesCore(name);
+	catch (const Exception &e) {
+		this->recordError(e);
+		cerr << "modifyCore: " << e.what() << endl;
+		return false;
 	}
 }
 
-std::map<std::string, std::string> SQLiteDBManager::getDefaultValuesCore(const std::string& name) const {
+bool SQLiteDBManager::removeCore(const std::string& table,
+                                 const std::map<std::string, std::string>& refFields) {
 
 	try {
-		bool referenced = this->isReferencedCore(name);
-		Statement query(*(this->db), "PRAGMA table_info(\"" + this->escDQ(name) + "\")");
-		map<string, string> defaultValues;
-		while(query.executeStep()) {
-			string fieldName = query.getColumn(1).getText();
-			if(!(referenced && (fieldName == PK_FIELD_NAME))) {
-				string dv = query.getColumn(4).getText();
-				if(dv.front() == '"' && dv.back() == '"') {
-					dv = dv.substr(1, dv.length()-2);
+		stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+
+		ss << "DELETE FROM \"" << this->escDQ(table) << "\"";
+			if (!refFields.empty()) {
+			ss << " WHERE ";
+
+			for (map<string, string>::const_iterator it = refFields.begin(); it != refFields.end(); ++it) {
+				/* Check if iterator is on the first element of the list, and add a separator otherwise */
+				if (it != refFields.begin()) {
+					ss << " AND ";
 				}
-				defaultValues.emplace(fieldName, dv);
+				const string& fieldName = it->first;
+				const string& value = it->second;
+				ss << "\"" << this->escDQ(fieldName) << "\" = \"" << this->escDQ(value) << "\"";
 			}
 		}
-
-		return defaultValues;
+		
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
+#endif
+		int rowsDeleted = this->conn().exec(ss.str());
+		return (refFields.empty() || rowsDeleted>0);	/* If refFields is empty, we wanted to erase all, only in that case, even 0 rows affected would mean success */
 	}
-	catch(const Exception &e) {
-		cerr << "getDefaultValues: " << e.what() << endl;
-		return map<string, string>();
+	catch (const Exception &e) {
+		this->recordError(e);
+		cerr << __func__ << "(): Exception while running query: " << e.what() << endl;
+		return false;
 	}
 }
 
-std::map<std::string, bool> SQLiteDBManager::getNotNullFlags(const std::string& name,
-                                                             const bool& isAtomic) const {
+std::set<std::string> SQLiteDBManager::getFieldNames(const std::string& name,
+                                                     const bool& isAtomic) const {
 
+	this->lastError() = DBManagerError::None;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		return this->getNotNullFlagsCore(name);
+		return this->getFieldNamesCore(name);
 	}
 	else {
-		return this->getNotNullFlagsCore(name);
+		ConnectionUse use(*this);
+		return this->getFieldNamesCore(name);
 	}
 }
 
-std::map<std::string, bool> SQLiteDBManager::getNotNullFlagsCore(const std::string& name) const {
+std::set<std::string> SQLiteDBManager::getFieldNamesCore(const std::string& name) const {
 
 	try {
 		bool referenced = this->isReferencedCore(name);
-		Statement query(*(this->db), "PRAGMA table_info(\"" + this->escDQ(name) + "\")");
-		map<string, bool> notNullFlags;
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"PRAGMA table_info(\"" + this->escDQ(name) + "\")\"" << endl;
+#endif
+		Statement query(this->conn(), "PRAGMA table_info(\"" + this->escDQ(name) + "\")");
+		set<string> fieldNamesSet;
 		while(query.executeStep()) {
 			string fieldName = query.getColumn(1).getText();
-			if(!(referenced && (fieldName == PK_FIELD_NAME)))
-				notNullFlags.emplace(fieldName,(query.getColumn(3).getInt() == 1));
+			if(!(referenced && (fieldName == PK_FIELD_NAME))) {
+				fieldNamesSet.emplace(fieldName);
+			}
 		}
 
-		return notNullFlags;
+		return fieldNamesSet;
 	}
 	catch(const Exception &e) {
-		cerr << "getNotNullFlagsCore: " << e.what() << endl;
-		return map<string, bool>();
+		this->recordError(e);
+		cerr << "getFieldsNameCore: " << e.what() << endl;
+		return set<string>();
 	}
 }
 
-std::map<std::string, bool> SQLiteDBManager::getUniqueness(const std::string& name,
-                                                           const bool& isAtomic) const {
+SQLTable SQLiteDBManager::getTableFromDatabaseCore(const std::string& table) const {
 
-	if(isAtomic) {
-		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		return this->getUniquenessCore(name);
-	}
-	else {
-		return this->getUniquenessCore(name);
+	map<string, SQLTable> tables = this->getTablesFromDatabaseCore(table);
+	map<string, SQLTable>::const_iterator it = tables.find(table);
+	if(it != tables.end()) {
+		return it->second;
 	}
+
+	return SQLTable(table);
 }
 
-std::map<std::string, bool> SQLiteDBManager::getUniquenessCore(const std::string& name) const {
+std::map<std::string, SQLTable> SQLiteDBManager::getTablesFromDatabaseCore(const std::string& table,
+                                                                            const bool& byPragmas) const {
+
+	map<string, SQLTable> tables;
+
+	if(byPragmas || this->getSQLiteVersionCore() < 3016000) {	/* Table-valued pragma functions are not available, introspect tables one by one */
+		for(auto &it : this->listTablesCore()) {
+			if(table.empty() || it == table) {
+				tables.emplace(it, this->getTableFromDatabaseByPragmasCore(it));
+			}
+		}
+		return tables;
+	}
 
 	try {
-		bool referenced = this->isReferencedCore(name);
-		//(1) We get the field list
-		set<string> notUniqueFields = this->getFieldNamesCore(name);
+		string filter = (table.empty() ? "" : " AND m.name = ?");
+		bool tableList = (this->getSQLiteVersionCore() >= 3037000);	/* pragma_table_list gives the options of tables since SQLite 3.37.0 */
 
-		//(2) We obtain the unique indexes
-		set<string> uniqueFields;
-		Statement query2(*(this->db), "PRAGMA index_list(\"" + this->escDQ(name) + "\")");
-		while(query2.executeStep()) {
-			string fieldName = query2.getColumn(1).getText();
-			if(!(referenced && (fieldName == PK_FIELD_NAME))) {
-				if(query2.getColumn(2).getInt() == 1) {
-					Statement query3(*(this->db), "PRAGMA index_info(\"" + this->escDQ(fieldName) + "\")");
-					while(query3.executeStep()) {
-						uniqueFields.emplace(query3.getColumn(2).getText());
-					}
+		//(1) The columns of all tables, with the options of each table (or the SQL statement that created it, if SQLite is too old)
+		stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+		ss << "SELECT m.name, m.sql, p.cid, p.name, p.\"notnull\", p.dflt_value, p.pk" << (tableList ? ", t.wr, t.strict" : "") << " FROM sqlite_master AS m";
+		if(tableList) {
+			ss << " JOIN pragma_table_list(m.name) AS t ON t.schema = 'main'";
+		}
+		ss << " JOIN pragma_table_info(m.name) AS p";
+		ss << " WHERE m.type = 'table'" << filter << " ORDER BY m.name, p.cid";
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
+#endif
+		Statement columnsQuery(this->conn(), ss.str());
+		if(!table.empty()) {
+			columnsQuery.bind(1, table);
+		}
+
+		map<string, map<string, pair<string, bool>>> columns;	/* For each table, the default value and not null flag of each column (sorted by name) */
+		while(columnsQuery.executeStep()) {
+			string tableName = columnsQuery.getColumn(0).getText();
+			map<string, SQLTable>::iterator tableInDb = tables.find(tableName);
+			if(tableInDb == tables.end()) {
+				tableInDb = tables.emplace(tableName, SQLTable(tableName)).first;
+				bool withoutRowid = false;
+				bool strict = false;
+				if(tableList) {
+					withoutRowid = (columnsQuery.getColumn(7).getInt() == 1);
+					strict = (columnsQuery.getColumn(8).getInt() == 1);
+				}
+				else {
+					parseTableOptions(columnsQuery.getColumn(1).getText(), withoutRowid, strict);
 				}
+				tableInDb->second.setWithoutRowid(withoutRowid);
+				tableInDb->second.setStrict(strict);
+			}
+
+			string fieldName = columnsQuery.getColumn(3).getText();
+			//See isReferencedCore()
+			if(fieldName == PK_FIELD_NAME && columnsQuery.getColumn(6).getInt() == (columnsQuery.getColumn(2).getInt()+1)) {
+				tableInDb->second.markReferenced();
+				continue;
+			}
+			string dv = columnsQuery.getColumn(5).getText();
+			if(dv.length() >= 2 && dv.front() == '"' && dv.back() == '"') {
+				dv = dv.substr(1, dv.length()-2);
 			}
+			columns[tableName][fieldName] = make_pair(dv, (columnsQuery.getColumn(4).getInt() == 1));
 		}
 
-		map<string, bool> uniqueness;
-		for(auto &it : uniqueFields) {
-			notUniqueFields.erase(notUniqueFields.find(it));
-			uniqueness.emplace(it, true);
+		//(2) The columns of all indexes
+		ss.str("");
+		ss << "SELECT m.name, l.name, l.\"unique\", l.origin, i.name FROM sqlite_master AS m JOIN pragma_index_list(m.name) AS l JOIN pragma_index_info(l.name) AS i";
+		ss << " WHERE m.type = 'table'" << filter << " ORDER BY m.name, l.name, i.seqno";
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
+#endif
+		Statement indexesQuery(this->conn(), ss.str());
+		if(!table.empty()) {
+			indexesQuery.bind(1, table);
 		}
 
-		for(auto &it : notUniqueFields) {
-			uniqueness.emplace(it, false);
+		map<string, set<string>> uniqueFields;
+		map<string, map<string, tuple<string, vector<string>, bool>>> indexes;
+		while(indexesQuery.executeStep()) {
+			string tableName = indexesQuery.getColumn(0).getText();
+			string indexName = indexesQuery.getColumn(1).getText();
+			bool unique = (indexesQuery.getColumn(2).getInt() == 1);
+			string origin = indexesQuery.getColumn(3).getText();
+			string fieldName = indexesQuery.getColumn(4).getText();
+			if(origin == "c") {	/* See getIndexesCore() */
+				map<string, tuple<string, vector<string>, bool>>::iterator index = indexes[tableName].find(indexName);
+				if(index == indexes[tableName].end()) {
+					index = indexes[tableName].emplace(indexName, make_tuple(indexName, vector<string>(), unique)).first;
+				}
+				std::get<1>(index->second).push_back(fieldName);
+			}
+			else if(unique) {	/* See getUniquenessCore() */
+				uniqueFields[tableName].emplace(fieldName);
+			}
 		}
 
-		return uniqueness;
+		//(3) We build the tables
+		for(auto &it : tables) {
+			for(auto &column : columns[it.first]) {
+				bool unique = (uniqueFields[it.first].find(column.first) != uniqueFields[it.first].end());
+				it.second.addField(tuple<string,string,bool,bool>(column.first, column.second.first, column.second.second, unique));
+			}
+			for(auto &index : indexes[it.first]) {
+				it.second.addIndex(index.second);
+			}
+		}
 	}
 	catch(const Exception &e) {
-		cerr << "getUniquenessCore: " << e.what() << endl;
-		return map<string, bool>();
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return map<string, SQLTable>();
 	}
+
+	return tables;
 }
 
-std::string SQLiteDBManager::createRelation(const std::string& kind,
-                                            const std::vector<std::string>& tables,
-                                            const bool& isAtomic) {
+SQLTable SQLiteDBManager::getTableFromDatabaseByPragmasCore(const std::string& table) const {
 
-	if(isAtomic) {
-		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		Transaction transaction(*(this->db));
-		string result = this->createRelationCore(kind, tables);
-		if(!result.empty())
-			transaction.commit();
-		return result;
+	SQLTable tableInDb(table);
+	if(this->isReferencedCore(tableInDb.getName())) {
+		tableInDb.markReferenced();
 	}
 	else {
-		return this->createRelationCore(kind, tables);
+		tableInDb.unmarkReferenced();
 	}
-}
 
-std::string SQLiteDBManager::createRelationCore(const std::string& kind,
-                                                const std::vector<std::string>& tables) {
+	set<string> fieldNames = this->getFieldNamesCore(tableInDb.getName());
+	map<string, string> defaultValues = this->getDefaultValuesCore(tableInDb.getName());
+	map<string, bool> notNullFlags = this->getNotNullFlagsCore(tableInDb.getName());
+	map<string, bool> uniqueness = this->getUniquenessCore(tableInDb.getName());
 
-	//m:n relationships
-	if(kind == "m:n" && tables.size() == 2) {
-		string table1 = tables.at(0);
-		string table2 = tables.at(1);
-		string relationName = table1 + "_" + table2;
-		bool addIt = true;
-		// We check that the joining table does not already exists in the database.
-		for(auto &it : listTablesCore()) {
-			if(it == relationName) {
-				addIt = false;
-			}
-		}
+	for(auto &name : fieldNames) {
+		tableInDb.addField(tuple<string,string,bool,bool>(name, defaultValues[name], notNullFlags[name], uniqueness[name]));
+	}
 
-		stringstream fieldName1;
-		fieldName1 << table1 << "#" << PK_FIELD_NAME;
-		stringstream fieldName2;
-		fieldName2 << table2 << "#" << PK_FIELD_NAME;
+	for(auto &it : this->getIndexesCore(tableInDb.getName())) {
+		tableInDb.addIndex(it);
+	}
 
-		if(addIt) {
-			//If the joining table needs to be created, we first check that referenced table have primary keys.
-			//If they do not, we give them a primary key field.
-			if(!this->isReferencedCore(table1)) {
-				this->markReferencedCore(table1);
+	//Table options are given by pragma_table_list since SQLite 3.37.0, they are parsed from the SQL statement that created the table otherwise
+	try {
+		bool tableList = (this->getSQLiteVersionCore() >= 3037000);
+		Statement query(this->conn(), tableList ? "SELECT wr, strict FROM pragma_table_list(?) WHERE schema = 'main'" : "SELECT sql FROM sqlite_master WHERE type = 'table' AND name = ?");
+		query.bind(1, table);
+		if(query.executeStep()) {
+			bool withoutRowid = false;
+			bool strict = false;
+			if(tableList) {
+				withoutRowid = (query.getColumn(0).getInt() == 1);
+				strict = (query.getColumn(1).getInt() == 1);
 			}
-			if(!this->isReferencedCore(table2)) {
-				this->markReferencedCore(table2);
+			else {
+				parseTableOptions(query.getColumn(0).getText(), withoutRowid, strict);
 			}
-
-			stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
-			ss << "CREATE TABLE \"" << this->escDQ(relationName) << "\" (";
-
-			ss << "\"" << this->escDQ(fieldName1.str())  << "\" INTEGER REFERENCES \"" << this->escDQ(table1) << "\"(\"" << this->escDQ(PK_FIELD_NAME) << "\"), ";
-			ss << "\"" << this->escDQ(fieldName2.str()) << "\" INTEGER REFERENCES \"" << this->escDQ(table2) << "\"(\"" << this->escDQ(PK_FIELD_NAME) << "\"), ";
-			ss << "PRIMARY KEY (\"" << this->escDQ(table1) << "#" << this->escDQ(PK_FIELD_NAME) << "\", \"" << this->escDQ(table2) << "#" << this->escDQ(PK_FIELD_NAME) << "\"))";
-
-			//We use the referenced table primary keys as foreign keys (see m:n relationship theory if it bugs you).
-			this->db->exec(ss.str());
+			tableInDb.setWithoutRowid(withoutRowid);
+			tableInDb.setStrict(strict);
 		}
-
-		return relationName;
 	}
-	else {
-		return string();
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
 	}
+
+	return tableInDb;
 }
 
-std::vector< std::map<std::string, std::string> > SQLiteDBManager::get(const std::string& table,
-                                                                       const std::vector<std::string >& columns,
-                                                                       const bool& distinct,
-                                                                       const bool& isAtomic) const noexcept {
+bool SQLiteDBManager::linkRecords(const std::string& table1,
+                                  const std::map<std::string, std::string>& record1,
+                                  const std::string& table2,
+                                  const std::map<std::string, std::string>& record2,
+                                  const bool& isAtomic) {
 
+	this->lastError() = DBManagerError::None;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		return this->getCore(table, columns, distinct);
+		Transaction transaction(this->conn());
+		bool result = this->linkRecordsCore(table1, record1, table2, record2);
+		if(result)
+			result = this->commitTransaction(transaction);
+		return result;
 	}
 	else {
-		return this->getCore(table, columns, distinct);
+		ConnectionUse use(*this);
+		return this->linkRecordsCore(table1, record1, table2, record2);
 	}
 }
 
-bool SQLiteDBManager::insert(const std::string& table,
-                             const std::vector<std::map<std::string, std::string> >& values,
-							 const bool& isAtomic) {
+bool SQLiteDBManager::linkRecordsCore(const std::string& table1,
+                                      const std::map<std::string, std::string>& record1,
+                                      const std::string& table2,
+                                      const std::map<std::string, std::string>& record2) {
+
+	unsigned int linksCreated = 0;
+	bool result = this->linkRecordsCore(table1, table2, vector<pair<map<string, string>, map<string, string>>>({make_pair(record1, record2)}), linksCreated);
 
+	return result && (linksCreated > 0);	/* Linking records that are already linked is considered as a failure */
+}
+
+bool SQLiteDBManager::linkRecords(const std::string& table1,
+                                  const std::string& table2,
+                                  const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string> > >& pairs,
+                                  const bool& isAtomic) {
+
+	this->lastError() = DBManagerError::None;
+	unsigned int linksCreated = 0;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		Transaction transaction(*(this->db));
-
-		bool result = this->insertCore(table, values);
+		Transaction transaction(this->conn());
+		bool result = this->linkRecordsCore(table1, table2, pairs, linksCreated);
 		if(result)
-			transaction.commit();
+			result = this->commitTransaction(transaction);
 		return result;
 	}
 	else {
-		return this->insertCore(table, values);
+		ConnectionUse use(*this);
+		return this->linkRecordsCore(table1, table2, pairs, linksCreated);
 	}
 }
 
-bool SQLiteDBManager::modify(const std::string& table,
-                             const std::map<std::string, std::string>& refFields,
-                             const std::map<std::string, std::string>& values,
-                             const bool& insertIfNotExists,
-                             const bool& isAtomic) noexcept {
+bool SQLiteDBManager::linkRecordsCore(const std::string& table1,
+                                      const std::string& table2,
+                                      const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string> > >& pairs,
+                                      unsigned int& linksCreated) {
 
-	if(isAtomic) {
-		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		Transaction transaction(*(this->db));
+	linksCreated = 0;
+	try {
+		//(1) We get the joining table name
+		string joiningTable = this->getJoiningTableCore(table1, table2);
+		if(joiningTable.empty())
+			return false;
 
-		bool result = this->modifyCore(table, refFields, values, insertIfNotExists);
-		if(result)
-			transaction.commit();
-		return result;
+		//(2) We get the ids of all records to link, in one pass on each table
+		set<map<string, string>> records1;
+		set<map<string, string>> records2;
+		for(auto &it : pairs) {
+			records1.emplace(it.first);
+			records2.emplace(it.second);
+		}
+		map<map<string, string>, set<string>> records1Ids = this->getRecordIdsCore(table1, records1);
+		map<map<string, string>, set<string>> records2Ids = this->getRecordIdsCore(table2, records2);
+
+		//(3) Records that do not exist yet are created
+		for(auto &it : records1) {
+			if(records1Ids.find(it) == records1Ids.end()) {
+				if(!this->insertCore(table1, vector<map<string,string>>({it})))
+					return false;
+				records1Ids[it].emplace(std::to_string(this->conn().getLastInsertRowid()));
+			}
+		}
+		for(auto &it : records2) {
+			if(records2Ids.find(it) == records2Ids.end()) {
+				if(!this->insertCore(table2, vector<map<string,string>>({it})))
+					return false;
+				records2Ids[it].emplace(std::to_string(this->conn().getLastInsertRowid()));
+			}
+		}
+
+		//(4) We build the list of links (all records matching a value are linked, as for the single pair version)
+		set<pair<string, string>> links;
+		for(auto &it : pairs) {
+			for(auto &itRecord1Ids : records1Ids[it.first]) {
+				for(auto &itRecord2Ids : records2Ids[it.second]) {
+					links.emplace(itRecord1Ids, itRecord2Ids);
+				}
+			}
+		}
+
+		//(5) We link those records (links that already exist are ignored)
+		linksCreated = this->writeLinksCore(joiningTable, table1, table2, links);
+		return true;
 	}
-	else {
-		return this->modifyCore(table, refFields, values, insertIfNotExists);
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return false;
 	}
 }
 
-bool SQLiteDBManager::remove(const std::string& table,
-                             const std::map<std::string, std::string>& refFields,
-                             const bool& isAtomic) {
+bool SQLiteDBManager::applyPolicy(const std::string& relationshipName,
+                                  const std::string& relationshipPolicy,
+                                  const std::vector<std::string>& linkedTables,
+                                  const bool& isAtomic) {
 
+	this->lastError() = DBManagerError::None;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		Transaction transaction(*(this->db));
-
-		bool result = this->removeCore(table, refFields);
+		Transaction transaction(this->conn());
+		bool result = this->applyPolicyCore(relationshipName, relationshipPolicy, linkedTables);
 		if(result)
-			transaction.commit();
+			result = this->commitTransaction(transaction);
 		return result;
 	}
 	else {
-		return this->removeCore(table, refFields);
+		ConnectionUse use(*this);
+		return this->applyPolicyCore(relationshipName, relationshipPolicy, linkedTables);
 	}
 }
 
-std::vector< std::map<std::string, std::string> > SQLiteDBManager::getCore(const std::string& table,
-                                                                           const std::vector<std::string >& columns,
-                                                                           const bool& distinct) const noexcept {
-
-	try {
-		stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
-		ss << "SELECT ";
-
-		if(distinct)
-			ss << "DISTINCT ";
+bool SQLiteDBManager::applyPolicyCore(const std::string& relationshipName,
+                                      const std::string& relationshipPolicy,
+                                      const std::vector<std::string>& linkedTables) {
 
-		vector<string > newColumns;
-		bool getAllFields = (columns.empty() || (columns.size() == 1 && columns.at(0) == "*"));	/* Shall be process all fields of the table? (there no filter) */
-		if (getAllFields) {
-			ss << "*";
-			//We fetch the names of table's columns in order to populate the map correctly
-			//(With only * as columns name, we are notable to match field names to field values in order to build the map)
-			Statement query(*(this->db), "PRAGMA table_info(\"" + this->escDQ(table) + "\");");
-			while(query.executeStep())
-				newColumns.push_back(query.getColumn(1).getText());
-		}
-		else {	/* There is a filter... insert the field names in the SQL command */
-			for (vector<std::string >::const_iterator it = columns.begin(); it != columns.end(); ++it) {
-				/* Check if iterator is on the first element of the list, and add a separator otherwise */
-				if (it != columns.begin()) {
-					ss << ", ";
+	bool result = true;
+	if(linkedTables.size() == 2 && this->isTableEmptyCore(relationshipName)) {
+		if(relationshipPolicy == "link-all") {
+			vector<map<string, string>> recordsToInsert;
+			for(auto &itRecordsTable1 : this->getCore(linkedTables.at(0))) {
+				for(auto &itRecordsTable2 : this->getCore(linkedTables.at(1))) {
+					map<string, string> record;
+					record.emplace(linkedTables.at(0) + "#" + PK_FIELD_NAME, itRecordsTable1[PK_FIELD_NAME]);
+					record.emplace(linkedTables.at(1) + "#" + PK_FIELD_NAME, itRecordsTable2[PK_FIELD_NAME]);
+					recordsToInsert.push_back(record);
 				}
-				ss << "\"" << this->escDQ(*it) << "\"";
-				newColumns.push_back(*it);
 			}
+			result = result && this->insertCore(relationshipName, recordsToInsert);
 		}
+	}
+	return result;
+}
 
-		ss << " FROM \"" << this->escDQ(table) << "\"";
-		
-#ifdef DEBUG
-		cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
-#endif
-		Statement query(*(this->db), ss.str());
-		
-		vector<map<string, string> > result;
+bool SQLiteDBManager::unlinkRecords(const std::string& table1,
+                                    const std::map<std::string, std::string>& record1,
+                                    const std::string& table2,
+                                    const std::map<std::string, std::string>& record2,
+                                    const bool& isAtomic) {
 
-		while(query.executeStep()) {
-			map<string, string> record;
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		Transaction transaction(this->conn());
+		bool result = this->unlinkRecordsCore(table1, record1, table2, record2);
+		if(result)
+			result = this->commitTransaction(transaction);
+		return result;
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->unlinkRecordsCore(table1, record1, table2, record2);
+	}
+}
 
-			for(int i = 0; i < query.getColumnCount(); ++i) {
-				if(query.getColumn(i).isNull()) {
-					record.emplace(newColumns.at(i), "");
-				}
-				else {
-					record.emplace(newColumns.at(i), query.getColumn(i).getText());
-				}
-			}
+bool SQLiteDBManager::unlinkRecordsCore(const std::string& table1,
+                                        const std::map<std::string, std::string>& record1,
+                                        const std::string& table2,
+                                        const std::map<std::string, std::string>& record2) {
 
-			result.push_back(record);
-		}
+	unsigned int linksRemoved = 0;
+	bool result = this->unlinkRecordsCore(table1, table2, vector<pair<map<string, string>, map<string, string>>>({make_pair(record1, record2)}), linksRemoved);
+
+	return result && (linksRemoved > 0);	/* Unlinking records that are not linked (or that do not exist) is considered as a failure */
+}
+
+bool SQLiteDBManager::unlinkRecords(const std::string& table1,
+                                    const std::string& table2,
+                                    const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string> > >& pairs,
+                                    const bool& isAtomic) {
 
+	this->lastError() = DBManagerError::None;
+	unsigned int linksRemoved = 0;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		Transaction transaction(this->conn());
+		bool result = this->unlinkRecordsCore(table1, table2, pairs, linksRemoved);
+		if(result)
+			result = this->commitTransaction(transaction);
 		return result;
 	}
-	catch(const Exception & e) {
-		cerr << "getCore: " << e.what() << endl;
-		return vector< map<string, string> >();
+	else {
+		ConnectionUse use(*this);
+		return this->unlinkRecordsCore(table1, table2, pairs, linksRemoved);
 	}
 }
 
-bool SQLiteDBManager::insertCore(const std::string& table,
-                                 const std::vector<std::map<std::string, string> >& values) {
+bool SQLiteDBManager::unlinkRecordsCore(const std::string& table1,
+                                        const std::string& table2,
+                                        const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string> > >& pairs,
+                                        unsigned int& linksRemoved) {
 
+	linksRemoved = 0;
 	try {
-		bool result = true;
-		for (vector<map<string, string> >::const_iterator vectIt = values.begin(); vectIt != values.end(); ++vectIt) {
-			stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
-			//Only one request is used. We could have use one request for each record, but it would have been slower.
-			ss << "INSERT INTO \"" << this->escDQ(table) << "\" ";
-			if (!vectIt->empty()) {
-				stringstream columnsName(ios_base::in | ios_base::out | ios_base::ate);
-				stringstream columnsValue(ios_base::in | ios_base::out | ios_base::ate);
-				columnsName << "(";
-				columnsValue << "(";
-				for (map<string, string>::const_iterator mapIt = vectIt->begin(); mapIt != vectIt->end(); ++mapIt) {
-					/* Check if iterator is on the first element of the list, and add a separator otherwise */
-					if (mapIt != vectIt->begin()) {
-						columnsName << ",";
-						columnsValue << ",";
-					}
-					columnsName << "\"" << this->escDQ(mapIt->first) << "\"";
-					columnsValue << "\"" << this->escDQ(mapIt->second) << "\"";
-				}
-				columnsName << ")";
-				columnsValue << ")";
+		//(1) We get the joining table name
+		string joiningTable = this->getJoiningTableCore(table1, table2);
+		if(joiningTable.empty())
+			return false;
 
-				ss << columnsName.str() << " VALUES " << columnsValue.str() << ";";
-			}
-			else {
-				ss << "DEFAULT VALUES";
+		//(2) We get the ids of all records to unlink, in one pass on each table. Records that do not exist cannot be linked.
+		set<map<string, string>> records1;
+		set<map<string, string>> records2;
+		for(auto &it : pairs) {
+			records1.emplace(it.first);
+			records2.emplace(it.second);
+		}
+		map<map<string, string>, set<string>> records1Ids = this->getRecordIdsCore(table1, records1);
+		map<map<string, string>, set<string>> records2Ids = this->getRecordIdsCore(table2, records2);
+
+		//(3) We build the list of links
+		set<pair<string, string>> links;
+		for(auto &it : pairs) {
+			if(records1Ids.find(it.first) == records1Ids.end() || records2Ids.find(it.second) == records2Ids.end())
+				continue;
+			for(auto &itRecord1Ids : records1Ids[it.first]) {
+				for(auto &itRecord2Ids : records2Ids[it.second]) {
+					links.emplace(itRecord1Ids, itRecord2Ids);
+				}
 			}
-#ifdef DEBUG
-			cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
-#endif
-			result = result && (this->db->exec(ss.str()) > 0);
 		}
 
-		return result;
+		//(4) We delete those links
+		linksRemoved = this->writeLinksCore(joiningTable, table1, table2, links, true);
+		return true;
 	}
-	catch (const Exception &e) {
-		cerr  << __func__ << "(): " << e.what() << endl;
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
 		return false;
 	}
 }
 
-bool SQLiteDBManager::modifyCore(const std::string& table,
-                                 const std::map<std::string, std::string>& refFields,
-                                 const std::map<std::string, std::string>& values,
-                                 const bool& insertIfNotExists) noexcept {
+std::string SQLiteDBManager::getJoiningTableCore(const std::string& table1,
+                                                 const std::string& table2) const {
 
-	if (values.empty()) return false;
+	string case1 = table1 + "_" + table2;
+	string case2 = table2 + "_" + table1;
+	if(this->conn().tableExists(case1))
+		return case1;
+	else if(this->conn().tableExists(case2))
+		return case2;
+	else
+		return string();
+}
 
-	stringstream sql_where(ios_base::in | ios_base::out | ios_base::ate);
-	if (!refFields.empty()) {
-		sql_where << "WHERE ";
-		for (map<string, string>::const_iterator it = refFields.begin(); it != refFields.end(); ++it) {
-			/* Check if iterator is on the first element of the list, and add a separator otherwise */
-			if (it != refFields.begin()) {
-				sql_where << " AND ";
-			}
-			sql_where << "\"" << this->escDQ(it->first) << "\" = \"" << this->escDQ(it->second) << "\"";
-		}
-	}
+std::map<std::map<std::string, std::string>, std::set<std::string> > SQLiteDBManager::getRecordIdsCore(const std::string& table,
+                                                                                                      const std::set<std::map<std::string, std::string> >& records) const {
 
-	if (insertIfNotExists) {
-		/* Count the number of records matching refFields filter */
-		stringstream sql_cmd(ios_base::in | ios_base::out | ios_base::ate);
-		sql_cmd << "SELECT COUNT(*) AS RecordCount FROM \"" << this->escDQ(table) << "\" " << sql_where.str();
+	map<map<string, string>, set<string>> result;
+	if(records.empty())
+		return result;
 
-		long int recordCount = 0;
+	set<string> fieldNames = this->getFieldNamesCore(table);
+	stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+	ss << "SELECT \"" << this->escDQ(PK_FIELD_NAME) << "\"";
+	for(auto &it : fieldNames) {
+		ss << ", \"" << this->escDQ(it) << "\"";
+	}
+	ss << " FROM \"" << this->escDQ(table) << "\"";
 
 #ifdef DEBUG
-		cout << __func__ << "(): running SQL query \"" <<  sql_cmd.str() << "\"" << endl;
+	cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
 #endif
-		Statement query(*(this->db), sql_cmd.str());
-
-		while (query.executeStep()) {
-			if (query.getColumnCount() != 1) {
-				cerr  << "modifyCore: COUNT query returned more than one line" << endl;
-			}
-			if (query.getColumn(0).isNull()) {
-				cerr  << "modifyCore: COUNT query returned empty line" << endl;
+	Statement query(this->conn(), ss.str());
+	while(query.executeStep()) {
+		map<string, string> record;
+		int i = 1;	/* Column 0 is the primary key */
+		for(auto &it : fieldNames) {
+			if(query.getColumn(i).isNull()) {
+				record.emplace(it, "");
 			}
 			else {
-				recordCount = strtol(query.getColumn(0).getText(), NULL, 0);
+				record.emplace(it, query.getColumn(i).getText());
 			}
+			i++;
 		}
-		//cout << "Got record count " << recordCount << "\n";
+		if(records.find(record) != records.end()) {
+			result[record].emplace(query.getColumn(0).getText());
+		}
+	}
 
-		if (recordCount == 0) {	/* No matching field exist in the database... we can't modify... try insertion instead */
-			vector<map<string,string>> vals;
-			map<string,string> insertedValues(values);	/* Initialise the values to insert with the values provided for modification */
+	return result;
+}
 
-			for (map<string, string>::const_iterator mapIt = refFields.begin(); mapIt != refFields.end(); ++mapIt) {	/* Parse the whole refFields map */
-				const string& refColumnName = mapIt->first;
-				const string& refRecordValue = mapIt->second;
+unsigned int SQLiteDBManager::writeLinksCore(const std::string& joiningTable,
+                                             const std::string& table1,
+                                             const std::string& table2,
+                                             const std::set<std::pair<std::string, std::string> >& links,
+                                             const bool& remove) {
 
-				if (insertedValues.find(refColumnName) == insertedValues.end()) {	/* refColumnName was not found inside the insertedValue map */
-					/* If this column was not part of the values to set, use the reference value (that we should have matched against) as the column+value pair to insert */
-					/* This will make sure that we build a record as close as possible to the supposed result we would have after a successful modify (instead of insert) */
-					insertedValues.emplace(std::make_pair(refColumnName, refRecordValue));
+	string ref1FieldName = table1 + "#" + PK_FIELD_NAME;
+	string ref2FieldName = table2 + "#" + PK_FIELD_NAME;
+	unsigned int rowsChanged = 0;
+
+	set<pair<string, string>>::const_iterator chunkStart = links.begin();
+	while(chunkStart != links.end()) {
+		/* Find the end of this chunk */
+		set<pair<string, string>>::const_iterator chunkEnd = chunkStart;
+		for(unsigned int count = 0; count < LINKS_CHUNK_SIZE && chunkEnd != links.end(); count++) {
+			++chunkEnd;
+		}
+
+		stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+		if(!remove) {
+			ss << "INSERT OR IGNORE INTO \"" << this->escDQ(joiningTable) << "\" (\"" << this->escDQ(ref1FieldName) << "\", \"" << this->escDQ(ref2FieldName) << "\") VALUES ";
+			for(set<pair<string, string>>::const_iterator it = chunkStart; it != chunkEnd; ++it) {
+				/* Check if iterator is on the first element of the chunk, and add a separator otherwise */
+				if(it != chunkStart) {
+					ss << ", ";
+				}
+				ss << "(?, ?)";
+			}
+		}
+		else {
+			ss << "DELETE FROM \"" << this->escDQ(joiningTable) << "\" WHERE ";
+			for(set<pair<string, string>>::const_iterator it = chunkStart; it != chunkEnd; ++it) {
+				/* Check if iterator is on the first element of the chunk, and add a separator otherwise */
+				if(it != chunkStart) {
+					ss << " OR ";
 				}
+				ss << "(\"" << this->escDQ(ref1FieldName) << "\" = ? AND \"" << this->escDQ(ref2FieldName) << "\" = ?)";
 			}
+		}
 
-			vals.push_back(insertedValues);
 #ifdef DEBUG
-			cout << __func__ << "(): Inserting rather than modifying (no pre-existing record)\n";
+		cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
 #endif
-			return this->insertCore(table, vals);	/* Insert rather than modifying */
+		Statement query(this->conn(), ss.str());
+		int index = 1;
+		for(set<pair<string, string>>::const_iterator it = chunkStart; it != chunkEnd; ++it) {
+			query.bind(index++, it->first);
+			query.bind(index++, it->second);
 		}
+		rowsChanged += query.exec();
+
+		chunkStart = chunkEnd;
 	}
-	/* If we reach here, we will modify, not insert */
-	try {
-		stringstream sql_cmd(ios_base::in | ios_base::out | ios_base::ate);
-		sql_cmd << "UPDATE \"" << this->escDQ(table) << "\" SET ";
 
-		for (std::map<std::string, std::string>::const_iterator it = values.begin(); it != values.end(); ++it) {
-			/* Check if iterator is on the first element of the list, and add a separator otherwise */
-			if (it != values.begin()) {
-				sql_cmd << ", ";
-			}
-			const string& fieldName = it->first;
-			const string& newValue = it->second;
-			sql_cmd << "\"" << this->escDQ(fieldName) << "\" = \"" << this->escDQ(newValue) << "\"";
-		}
-		sql_cmd << " " << sql_where.str();
+	return rowsChanged;
+}
 
-#ifdef DEBUG
-		cout << __func__ << "(): running SQL query \"" << sql_cmd.str() << "\"" << endl;
-#endif
-		return this->db->exec(sql_cmd.str()) > 0;
+bool SQLiteDBManager::linkById(const std::string& table1,
+                               const std::string& id1,
+                               const std::string& table2,
+                               const std::string& id2,
+                               const bool& isAtomic) {
+
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		Transaction transaction(this->conn());
+		bool result = this->linkByIdCore(table1, id1, table2, id2);
+		if(result)
+			result = this->commitTransaction(transaction);
+		return result;
 	}
-	catch (const Exception &e) {
-		cerr << "modifyCore: " << e.what() << endl;
-		return false;
+	else {
+		ConnectionUse use(*this);
+		return this->linkByIdCore(table1, id1, table2, id2);
 	}
 }
 
-bool SQLiteDBManager::removeCore(const std::string& table,
-                                 const std::map<std::string, std::string>& refFields) {
+bool SQLiteDBManager::unlinkById(const std::string& table1,
+                                 const std::string& id1,
+                                 const std::string& table2,
+                                 const std::string& id2,
+                                 const bool& isAtomic) {
+
+	this->lastError() = DBManagerError::None;
+	if(isAtomic) {
+		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+		Transaction transaction(this->conn());
+		bool result = this->linkByIdCore(table1, id1, table2, id2, true);
+		if(result)
+			result = this->commitTransaction(transaction);
+		return result;
+	}
+	else {
+		ConnectionUse use(*this);
+		return this->linkByIdCore(table1, id1, table2, id2, true);
+	}
+}
+
+bool SQLiteDBManager::linkByIdCore(const std::string& table1,
+                                   const std::string& id1,
+                                   const std::string& table2,
+                                   const std::string& id2,
+                                   const bool& remove) {
 
 	try {
-		stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+		string joiningTable = this->getJoiningTableCore(table1, table2);
+		if(joiningTable.empty())
+			return false;
 
-		ss << "DELETE FROM \"" << this->escDQ(table) << "\"";
-			if (!refFields.empty()) {
-			ss << " WHERE ";
+		/* Columns of the joining table are named after the tables, so the order of tables in the link does not matter */
+		return (this->writeLinksCore(joiningTable, table1, table2, set<pair<string, string>>({make_pair(id1, id2)}), remove) > 0);
+	}
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return false;
+	}
+}
 
-			for (map<string, string>::const_iterator it = refFields.begin(); it != refFields.end(); ++it) {
-				/* Check if iterator is on the first element of the list, and add a separator otherwise */
-				if (it != refFields.begin()) {
-					ss << " AND ";
-				}
-				const string& fieldName = it->first;
-				const string& value = it->second;
-				ss << "\"" << this->escDQ(fieldName) << "\" = \"" << this->escDQ(value) << "\"";
+std::map<std::string, std::pair<std::string, std::string> > SQLiteDBManager::getRelationshipsCore() const {
+
+	map<string, pair<string, string>> result;
+	for(auto &name : this->listTablesCore()) {
+		size_t pos = name.find('_');
+		if(pos == string::npos)
+			continue;
+		/* Only keep tables that really are joining tables (a regular table may also have an underscore in its name) */
+		set<string> fieldNames = this->getFieldNamesCore(name);
+		if(fieldNames.size() != 2)
+			continue;
+		for(; pos != string::npos; pos = name.find('_', pos + 1)) {	/* Table names may also contain underscores, so try all possible splits */
+			string table1 = name.substr(0, pos);
+			string table2 = name.substr(pos + 1);
+			if(fieldNames.find(table1 + "#" + PK_FIELD_NAME) != fieldNames.end() && fieldNames.find(table2 + "#" + PK_FIELD_NAME) != fieldNames.end()) {
+				result.emplace(name, make_pair(table1, table2));
+				break;
 			}
 		}
-		
-#ifdef DEBUG
-		cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
-#endif
-		int rowsDeleted = this->db->exec(ss.str());
-		return (refFields.empty() || rowsDeleted>0);	/* If refFields is empty, we wanted to erase all, only in that case, even 0 rows affected would mean success */
 	}
-	catch (const Exception &e) {
-		cerr << __func__ << "(): Exception while running query: " << e.what() << endl;
-		return false;
+
+	return result;
+}
+
+std::map<std::string, std::string> SQLiteDBManager::getLinkingTablesCore(const std::string& table) const {
+
+	map<string, string> result;
+	for(auto &it : this->getRelationshipsCore()) {
+		if(it.second.first == table) {
+			result.emplace(it.first, it.second.second);
+		}
+		else if(it.second.second == table) {
+			result.emplace(it.first, it.second.first);
+		}
 	}
+
+	return result;
 }
 
-std::set<std::string> SQLiteDBManager::getFieldNames(const std::string& name,
-                                                     const bool& isAtomic) const {
+std::map<std::string, std::vector<std::map<std::string,std::string> > > SQLiteDBManager::getLinkedRecords(const std::string& table,
+                                                                                                          const std::map<std::string, std::string>& record,
+                                                                                                          const bool& isAtomic) const {
 
+	this->lastError() = DBManagerError::None;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		return this->getFieldNamesCore(name);
+
+		return this->getLinkedRecordsCore(table, record);
 	}
 	else {
-		return this->getFieldNamesCore(name);
+		ConnectionUse use(*this);
+		return this->getLinkedRecordsCore(table, record);
 	}
 }
 
-std::set<std::string> SQLiteDBManager::getFieldNamesCore(const std::string& name) const {
+std::map<std::string, std::vector<std::map<std::string,std::string> > > SQLiteDBManager::getLinkedRecordsCore(const std::string& table,
+                                                                                                              const std::map<std::string, std::string>& record) const {
 
+	map<string, vector<map<string,string>>> result;
 	try {
-		bool referenced = this->isReferencedCore(name);
-#ifdef DEBUG
-		cout << __func__ << "(): running SQL query \"PRAGMA table_info(\"" + this->escDQ(name) + "\")\"" << endl;
-#endif
-		Statement query(*(this->db), "PRAGMA table_info(\"" + this->escDQ(name) + "\")");
-		set<string> fieldNamesSet;
-		while(query.executeStep()) {
-			string fieldName = query.getColumn(1).getText();
-			if(!(referenced && (fieldName == PK_FIELD_NAME))) {
-				fieldNamesSet.emplace(fieldName);
-			}
-		}
+		// (1) We get all record ids for records whose values matches the record given in parameter.
+		map<map<string, string>, set<string>> referenceRecordIds = this->getRecordIdsCore(table, set<map<string, string>>({record}));
 
-		return fieldNamesSet;
+		// (2) We fetch the related records of each of these ids
+		for(auto &id : referenceRecordIds[record]) {
+			this->getLinkedRecordsByIdCore(table, id, result);
+		}
 	}
 	catch(const Exception &e) {
-		cerr << "getFieldsNameCore: " << e.what() << endl;
-		return set<string>();
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return map<string, vector<map<string,string>>>();
 	}
+
+	return result;
 }
 
-SQLTable SQLiteDBManager::getTableFromDatabaseCore(const std::string& table) const {
+std::map<std::string, std::vector<std::map<std::string,std::string> > > SQLiteDBManager::getLinkedRecordsById(const std::string& table,
+                                                                                                              const std::string& id,
+                                                                                                              const bool& isAtomic) const {
 
-	SQLTable tableInDb(table);
-	if(this->isReferencedCore(tableInDb.getName())) {
-		tableInDb.markReferenced();
+	this->lastError() = DBManagerError::None;
+	map<string, vector<map<string,string>>> result;
+	try {
+		if(isAtomic) {
+			std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+
+			this->getLinkedRecordsByIdCore(table, id, result);
+		}
+		else {
+			ConnectionUse use(*this);
+			this->getLinkedRecordsByIdCore(table, id, result);
+		}
 	}
-	else {
-		tableInDb.unmarkReferenced();
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return map<string, vector<map<string,string>>>();
 	}
 
-	set<string> fieldNames = this->getFieldNamesCore(tableInDb.getName());
-	map<string, string> defaultValues = this->getDefaultValuesCore(tableInDb.getName());
-	map<string, bool> notNullFlags = this->getNotNullFlagsCore(tableInDb.getName());
-	map<string, bool> uniqueness = this->getUniquenessCore(tableInDb.getName());
+	return result;
+}
+
+void SQLiteDBManager::getLinkedRecordsByIdCore(const std::string& table,
+                                               const std::string& id,
+                                               std::map<std::string, std::vector<std::map<std::string,std::string> > >& result) const {
+
+	for(auto &it : this->getLinkingTablesCore(table)) {
+		const string& linkingTable = it.first;
+		const string& relatedTable = it.second;
+
+		vector<string> columns;
+		Statement tableInfo(this->conn(), "PRAGMA table_info(\"" + this->escDQ(relatedTable) + "\")");
+		while(tableInfo.executeStep())
+			columns.push_back(tableInfo.getColumn(1).getText());
+
+		stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+		ss << "SELECT ";
+		for(vector<string>::const_iterator col = columns.begin(); col != columns.end(); ++col) {
+			/* Check if iterator is on the first element of the list, and add a separator otherwise */
+			if(col != columns.begin()) {
+				ss << ", ";
+			}
+			ss << "r.\"" << this->escDQ(*col) << "\"";
+		}
+		ss << " FROM \"" << this->escDQ(linkingTable) << "\" j";
+		ss << " JOIN \"" << this->escDQ(relatedTable) << "\" r ON r.\"" << this->escDQ(PK_FIELD_NAME) << "\" = j.\"" << this->escDQ(relatedTable + "#" + PK_FIELD_NAME) << "\"";
+		ss << " WHERE j.\"" << this->escDQ(table + "#" + PK_FIELD_NAME) << "\" = ?";
 
-	for(auto &name : fieldNames) {
-		tableInDb.addField(tuple<string,string,bool,bool>(name, defaultValues[name], notNullFlags[name], uniqueness[name]));
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
+#endif
+		Statement query(this->conn(), ss.str());
+		query.bind(1, id);
+		while(query.executeStep()) {
+			map<string, string> record;
+			for(int i = 0; i < query.getColumnCount(); ++i) {
+				if(query.getColumn(i).isNull()) {
+					record.emplace(columns.at(i), "");
+				}
+				else {
+					record.emplace(columns.at(i), query.getColumn(i).getText());
+				}
+			}
+			result[relatedTable].push_back(record);
+		}
 	}
-
-	return tableInDb;
 }
 
-bool SQLiteDBManager::linkRecords(const std::string& table1,
-                                  const std::map<std::string, std::string>& record1,
-                                  const std::string& table2,
-                                  const std::map<std::string, std::string>& record2,
-                                  const bool& isAtomic) {
+std::map<std::string, std::vector<std::map<std::string,std::string> > > SQLiteDBManager::getLinkedRecords(const std::string& table,
+                                                                                                          const std::map<std::string, std::string>& record,
+                                                                                                          const std::vector<std::string>& path,
+                                                                                                          const bool& isAtomic) const {
 
+	this->lastError() = DBManagerError::None;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		Transaction transaction(*(this->db));
-		bool result = this->linkRecordsCore(table1, record1, table2, record2);
-		if(result)
-			transaction.commit();
-		return result;
+
+		return this->getLinkedRecordsCore(table, record, path);
 	}
 	else {
-		return this->linkRecordsCore(table1, record1, table2, record2);
+		ConnectionUse use(*this);
+		return this->getLinkedRecordsCore(table, record, path);
 	}
 }
 
-bool SQLiteDBManager::linkRecordsCore(const std::string& table1,
-                                      const std::map<std::string, std::string>& record1,
-                                      const std::string& table2,
-                                      const std::map<std::string, std::string>& record2) {
+std::map<std::string, std::vector<std::map<std::string,std::string> > > SQLiteDBManager::getLinkedRecordsCore(const std::string& table,
+                                                                                                              const std::map<std::string, std::string>& record,
+                                                                                                              const std::vector<std::string>& path) const {
 
-	//(1) We check if the records to link exists. If not we create them.
-	bool result = true;
-	bool record1Exist = false;
-	for(auto &it : this->getCore(table1)) {
-		it.erase(PK_FIELD_NAME);
-		if(it == record1)
-			record1Exist = true;
-	}
-	if(!record1Exist) {
-		result = result && this->insertCore(table1, vector<map<string,string>>({record1}));
-	}
-	bool record2Exist = false;
-	for(auto &it : this->getCore(table2)) {
-		it.erase(PK_FIELD_NAME);
-		if(it == record2)
-			record2Exist = true;
-	}
-	if(!record2Exist) {
-		result = result && this->insertCore(table2, vector<map<string,string>>({record2}));
-	}
+	map<string, vector<map<string,string>>> result;
+	try {
+		if(path.empty())
+			return result;
 
-	if(!result)
-		return result;
-	//(2) We get their ids.
-	set<string> record1Ids;
-	for(auto &it : this->getCore(table1)) {
-		string temp = it[PK_FIELD_NAME];
-		it.erase(PK_FIELD_NAME);
-		if(it == record1) {
-			record1Ids.emplace(temp);
-		}
-	}
-	set<string> record2Ids;
-	for(auto &it : this->getCore(table2)) {
-		string temp = it[PK_FIELD_NAME];
-		it.erase(PK_FIELD_NAME);
-		if(it == record2) {
-			record2Ids.emplace(temp);
+		// (1) We get the joining table of each step of the path
+		vector<string> joiningTables;
+		string previousTable = table;
+		for(auto &nextTable : path) {
+			string joiningTable = this->getJoiningTableCore(previousTable, nextTable);
+			if(joiningTable.empty()) {
+				cerr << __func__ << "(): no relationship between tables " << previousTable << " and " << nextTable << endl;
+				return result;
+			}
+			joiningTables.push_back(joiningTable);
+			previousTable = nextTable;
 		}
-	}
 
-	if(!result)
+		// (2) We get all record ids for records whose values matches the record given in parameter.
+		map<map<string, string>, set<string>> referenceRecordIds = this->getRecordIdsCore(table, set<map<string, string>>({record}));
+		const set<string>& startIds = referenceRecordIds[record];
+		if(startIds.empty())
 			return result;
-	//(3) We get the joining table name
-	string joiningTable;
-	for(auto &it : this->listTablesCore()) {
-		string case1 = table1 + "_" + table2;
-		string case2 = table2 + "_" + table1;
-		if(it == case1)
-			joiningTable = case1;
-		else if(it == case2)
-			joiningTable = case2;
-	}
 
-	result = result && (!joiningTable.empty());
+		// (3) We walk the path with one recursive query per chunk of start ids, each step of the path being tagged by its position
+		stringstream steps(ios_base::in | ios_base::out | ios_base::ate);
+		previousTable = table;
+		for(unsigned int i = 0; i < path.size(); i++) {
+			if(i != 0) {
+				steps << " UNION ALL ";
+			}
+			steps << "SELECT " << (i + 1) << ", \"" << this->escDQ(previousTable + "#" + PK_FIELD_NAME) << "\", \"" << this->escDQ(path.at(i) + "#" + PK_FIELD_NAME) << "\" FROM \"" << this->escDQ(joiningTables.at(i)) << "\"";
+			previousTable = path.at(i);
+		}
+		map<string, set<string>> reachedIds;
+		for(auto &chunk : splitIds(startIds)) {
+			stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+			ss << "WITH RECURSIVE steps(step, fromId, toId) AS (" << steps.str();
+			ss << "), reached(step, id) AS (SELECT 0, \"" << this->escDQ(PK_FIELD_NAME) << "\" FROM \"" << this->escDQ(table) << "\" WHERE \"" << this->escDQ(PK_FIELD_NAME) << "\" IN (" << sqlPlaceholders(chunk.size());
+			ss << ") UNION SELECT steps.step, steps.toId FROM reached JOIN steps ON steps.step = reached.step + 1 AND steps.fromId = reached.id)";
+			ss << " SELECT DISTINCT step, id FROM reached WHERE step > 0";
 
-	if(!result)
-		return result;
-	//(4) We check those records are not already linked
-	string ref1FieldName = table1 + "#" + PK_FIELD_NAME;
-	string ref2FieldName = table2 + "#" + PK_FIELD_NAME;
-	map<map<string, string>, bool> linkingRecordLinked;
-	bool allAlreadyLinked = true;
-	for(auto &itRecord1Ids : record1Ids) {
-		for(auto &itRecord2Ids : record2Ids) {
-			map<string, string> linkingRecord;
-			linkingRecord.emplace(ref1FieldName, itRecord1Ids);
-			linkingRecord.emplace(ref2FieldName, itRecord2Ids);
-			bool alreadyLinked = false;
-			for(auto &it : this->getCore(joiningTable)) {
-				if(it == linkingRecord)
-					alreadyLinked = true;
-			}
-			allAlreadyLinked = allAlreadyLinked && alreadyLinked;
-			linkingRecordLinked.emplace(linkingRecord, alreadyLinked);
-		}
-	}
-	result = result && !allAlreadyLinked;
-	if(!result)
-		return result;
-	//(5) We link those records.
-	for(auto &it : linkingRecordLinked) {
-		if(!it.second)
-		result = result && this->insertCore(joiningTable, vector<map<string,string>>({it.first}));
+#ifdef DEBUG
+			cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
+#endif
+			Statement query(this->conn(), ss.str());
+			int index = 1;
+			for(auto &id : chunk) {
+				query.bind(index++, id);
+			}
+			while(query.executeStep()) {
+				reachedIds[path.at(query.getColumn(0).getInt() - 1)].emplace(query.getColumn(1).getText());
+			}
+		}
+
+		// (4) We fetch the reached records
+		for(auto &it : reachedIds) {
+			result.emplace(it.first, this->getRecordsByIdsCore(it.first, it.second));
+		}
+	}
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return map<string, vector<map<string,string>>>();
 	}
 
 	return result;
 }
 
-bool SQLiteDBManager::applyPolicy(const std::string& relationshipName,
-                                  const std::string& relationshipPolicy,
-                                  const std::vector<std::string>& linkedTables,
-                                  const bool& isAtomic) {
+std::map<std::string, std::vector<std::map<std::string,std::string> > > SQLiteDBManager::getLinkedRecordsByDepth(const std::string& table,
+                                                                                                                 const std::map<std::string, std::string>& record,
+                                                                                                                 const unsigned int& depth,
+                                                                                                                 const bool& isAtomic) const {
 
+	this->lastError() = DBManagerError::None;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		Transaction transaction(*(this->db));
-		bool result = this->applyPolicyCore(relationshipName, relationshipPolicy, linkedTables);
-		if(result)
-			transaction.commit();
-		return result;
+
+		return this->getLinkedRecordsByDepthCore(table, record, depth);
 	}
 	else {
-		return this->applyPolicyCore(relationshipName, relationshipPolicy, linkedTables);
+		ConnectionUse use(*this);
+		return this->getLinkedRecordsByDepthCore(table, record, depth);
 	}
 }
 
-bool SQLiteDBManager::applyPolicyCore(const std::string& relationshipName,
-                                      const std::string& relationshipPolicy,
-                                      const std::vector<std::string>& linkedTables) {
+std::map<std::string, std::vector<std::map<std::string,std::string> > > SQLiteDBManager::getLinkedRecordsByDepthCore(const std::string& table,
+                                                                                                                     const std::map<std::string, std::string>& record,
+                                                                                                                     const unsigned int& depth) const {
 
-	bool result = true;
-	if(this->getCore(relationshipName).empty() && linkedTables.size() == 2) {
-		if(relationshipPolicy == "link-all") {
-			vector<map<string, string>> recordsToInsert;
-			for(auto &itRecordsTable1 : this->getCore(linkedTables.at(0))) {
-				for(auto &itRecordsTable2 : this->getCore(linkedTables.at(1))) {
-					map<string, string> record;
-					record.emplace(linkedTables.at(0) + "#" + PK_FIELD_NAME, itRecordsTable1[PK_FIELD_NAME]);
-					record.emplace(linkedTables.at(1) + "#" + PK_FIELD_NAME, itRecordsTable2[PK_FIELD_NAME]);
-					recordsToInsert.push_back(record);
-				}
+	map<string, vector<map<string,string>>> result;
+	try {
+		map<string, pair<string, string>> relationships = this->getRelationshipsCore();
+		if(depth == 0 || relationships.empty())
+			return result;
+
+		// (1) We get all record ids for records whose values matches the record given in parameter.
+		map<map<string, string>, set<string>> referenceRecordIds = this->getRecordIdsCore(table, set<map<string, string>>({record}));
+		const set<string>& startIds = referenceRecordIds[record];
+		if(startIds.empty())
+			return result;
+
+		// (2) We follow all the relationships (in both directions) with one recursive query per chunk of start ids (a record is reachable from the start ids if it is reachable from the ids of one chunk)
+		vector<string> tableNames;	/* Table names bound to the query, in order */
+		stringstream links(ios_base::in | ios_base::out | ios_base::ate);
+		for(map<string, pair<string, string>>::const_iterator it = relationships.begin(); it != relationships.end(); ++it) {
+			if(it != relationships.begin()) {
+				links << " UNION ALL ";
 			}
-			result = result && this->insertCore(relationshipName, recordsToInsert);
+			string field1 = this->escDQ(it->second.first + "#" + PK_FIELD_NAME);
+			string field2 = this->escDQ(it->second.second + "#" + PK_FIELD_NAME);
+			links << "SELECT ?, \"" << field1 << "\", ?, \"" << field2 << "\" FROM \"" << this->escDQ(it->first) << "\"";
+			links << " UNION ALL SELECT ?, \"" << field2 << "\", ?, \"" << field1 << "\" FROM \"" << this->escDQ(it->first) << "\"";
+			tableNames.push_back(it->second.first);
+			tableNames.push_back(it->second.second);
+			tableNames.push_back(it->second.second);
+			tableNames.push_back(it->second.first);
+		}
+		map<string, set<string>> reachedIds;
+		for(auto &chunk : splitIds(startIds)) {
+			stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+			ss << "WITH RECURSIVE links(fromTable, fromId, toTable, toId) AS (" << links.str();
+			ss << "), reached(tableName, id, depth) AS (SELECT ?, \"" << this->escDQ(PK_FIELD_NAME) << "\", 0 FROM \"" << this->escDQ(table) << "\" WHERE \"" << this->escDQ(PK_FIELD_NAME) << "\" IN (" << sqlPlaceholders(chunk.size());
+			ss << ") UNION SELECT links.toTable, links.toId, reached.depth + 1 FROM reached JOIN links ON links.fromTable = reached.tableName AND links.fromId = reached.id WHERE reached.depth < ?)";
+			ss << " SELECT DISTINCT tableName, id FROM reached WHERE depth > 0";
+
+#ifdef DEBUG
+			cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
+#endif
+			Statement query(this->conn(), ss.str());
+			int index = 1;
+			for(auto &name : tableNames) {
+				query.bind(index++, name);
+			}
+			query.bind(index++, table);
+			for(auto &id : chunk) {
+				query.bind(index++, id);
+			}
+			query.bind(index++, static_cast<int>(depth));
+			while(query.executeStep()) {
+				string tableName = query.getColumn(0).getText();
+				string id = query.getColumn(1).getText();
+				if(tableName == table && startIds.find(id) != startIds.end())
+					continue;	/* The reference record itself is not part of the result */
+				reachedIds[tableName].emplace(id);
+			}
+		}
+
+		// (3) We fetch the reached records
+		for(auto &it : reachedIds) {
+			result.emplace(it.first, this->getRecordsByIdsCore(it.first, it.second));
 		}
 	}
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return map<string, vector<map<string,string>>>();
+	}
+
 	return result;
 }
 
-bool SQLiteDBManager::unlinkRecords(const std::string& table1,
-                                    const std::map<std::string, std::string>& record1,
-                                    const std::string& table2,
-                                    const std::map<std::string, std::string>& record2,
-                                    const bool& isAtomic) {
+std::vector<std::map<std::string,std::string> > SQLiteDBManager::getLinkedRecords(const std::string& table,
+                                                                                  const std::map<std::string, std::string>& record,
+                                                                                  const std::string& relationship,
+                                                                                  const unsigned int& limit,
+                                                                                  const std::string& afterId,
+                                                                                  const bool& isAtomic) const {
 
+	this->lastError() = DBManagerError::None;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		Transaction transaction(*(this->db));
-		bool result = this->unlinkRecordsCore(table1, record1, table2, record2);
-		if(result)
-			transaction.commit();
-		return result;
+
+		return this->getLinkedRecordsCore(table, record, relationship, limit, afterId);
 	}
 	else {
-		return this->unlinkRecordsCore(table1, record1, table2, record2);
+		ConnectionUse use(*this);
+		return this->getLinkedRecordsCore(table, record, relationship, limit, afterId);
 	}
 }
 
-bool SQLiteDBManager::unlinkRecordsCore(const std::string& table1,
-                                        const std::map<std::string, std::string>& record1,
-                                        const std::string& table2,
-                                        const std::map<std::string, std::string>& record2) {
-
-	//(1) We check if the records to link exists. If not we create them.
-	bool result = true;
-	bool record1Exist = false;
-	for(auto &it : this->getCore(table1)) {
-		it.erase(PK_FIELD_NAME);
-		if(it == record1)
-			record1Exist = true;
-	}
-
-	bool record2Exist = false;
-	for(auto &it : this->getCore(table2)) {
-		it.erase(PK_FIELD_NAME);
-		if(it == record2)
-			record2Exist = true;
-	}
-
-	result = result && record1Exist && record2Exist;
+std::vector<std::map<std::string,std::string> > SQLiteDBManager::getLinkedRecordsCore(const std::string& table,
+                                                                                      const std::map<std::string, std::string>& record,
+                                                                                      const std::string& relationship,
+                                                                                      const unsigned int& limit,
+                                                                                      const std::string& afterId) const {
 
-	if(!result)
-		return result;
-	//(2) We get their ids.
-	set<string> record1Ids;
-	for(auto &it : this->getCore(table1)) {
-		string temp = it[PK_FIELD_NAME];
-		it.erase(PK_FIELD_NAME);
-		if(it == record1) {
-			record1Ids.emplace(temp);
-		}
-	}
-	set<string> record2Ids;
-	for(auto &it : this->getCore(table2)) {
-		string temp = it[PK_FIELD_NAME];
-		it.erase(PK_FIELD_NAME);
-		if(it == record2) {
-			record2Ids.emplace(temp);
+	vector<map<string,string>> result;
+	try {
+		// (1) We check that the relationship involves this table, and get the table on the other side
+		map<string, string> linkingTables = this->getLinkingTablesCore(table);
+		if(linkingTables.find(relationship) == linkingTables.end()) {
+			cerr << __func__ << "(): " << relationship << " is not a relationship of table " << table << endl;
+			return result;
 		}
-	}
+		const string& relatedTable = linkingTables[relationship];
 
-	if(!result)
+		// (2) We get all record ids for records whose values matches the record given in parameter.
+		map<map<string, string>, set<string>> referenceRecordIds = this->getRecordIdsCore(table, set<map<string, string>>({record}));
+		const set<string>& ids = referenceRecordIds[record];
+		if(ids.empty() || limit == 0)
 			return result;
-	//(3) We get the joining table name
-	string joiningTable;
-	for(auto &it : this->listTablesCore()) {
-		string case1 = table1 + "_" + table2;
-		string case2 = table2 + "_" + table1;
-		if(it == case1)
-			joiningTable = case1;
-		else if(it == case2)
-			joiningTable = case2;
-	}
 
-	result = result && (!joiningTable.empty());
+		// (3) We fetch one page of related records, using the related record id as a cursor
+		vector<string> columns;
+		Statement tableInfo(this->conn(), "PRAGMA table_info(\"" + this->escDQ(relatedTable) + "\")");
+		while(tableInfo.executeStep())
+			columns.push_back(tableInfo.getColumn(1).getText());
 
-	if(!result)
-		return result;
-	//(4) We check those records are not already linked
-	string ref1FieldName = table1 + "#" + PK_FIELD_NAME;
-	string ref2FieldName = table2 + "#" + PK_FIELD_NAME;
-	vector<map<string, string>> recordsToDelete;
-	for(auto &itRecord1Ids : record1Ids) {
-		for(auto &itRecord2Ids : record2Ids) {
-			map<string, string> linkingRecord;
-			linkingRecord.emplace(ref1FieldName, itRecord1Ids);
-			linkingRecord.emplace(ref2FieldName, itRecord2Ids);
-			for(auto &it : this->getCore(joiningTable)) {
-				if(it == linkingRecord)
-					recordsToDelete.push_back(it);
+		/* With many reference records, their ids are bound by chunks: each chunk gives its own first page, and the page is made of the first records of all of them */
+		map<long long, map<string, string>> page;	/* The related records, by id */
+		for(auto &chunk : splitIds(ids)) {
+			stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+			ss << "SELECT DISTINCT r.\"" << this->escDQ(PK_FIELD_NAME) << "\"";
+			for(auto &col : columns) {
+				ss << ", r.\"" << this->escDQ(col) << "\"";
+			}
+			ss << " FROM \"" << this->escDQ(relationship) << "\" j";
+			ss << " JOIN \"" << this->escDQ(relatedTable) << "\" r ON r.\"" << this->escDQ(PK_FIELD_NAME) << "\" = j.\"" << this->escDQ(relatedTable + "#" + PK_FIELD_NAME) << "\"";
+			ss << " WHERE j.\"" << this->escDQ(table + "#" + PK_FIELD_NAME) << "\" IN (" << sqlPlaceholders(chunk.size()) << ")";
+			if(!afterId.empty()) {
+				ss << " AND r.\"" << this->escDQ(PK_FIELD_NAME) << "\" > ?";
+			}
+			ss << " ORDER BY r.\"" << this->escDQ(PK_FIELD_NAME) << "\" LIMIT ?";
+
+#ifdef DEBUG
+			cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
+#endif
+			Statement query(this->conn(), ss.str());
+			int index = 1;
+			for(auto &id : chunk) {
+				query.bind(index++, id);
 			}
+			if(!afterId.empty()) {
+				query.bind(index++, afterId);
+			}
+			query.bind(index++, static_cast<int>(limit));
+			while(query.executeStep()) {
+				map<string, string> linkedRecord;
+				for(int i = 1; i < query.getColumnCount(); ++i) {	/* Column 0 is the id, used to sort the records */
+					if(query.getColumn(i).isNull()) {
+						linkedRecord.emplace(columns.at(i - 1), "");
+					}
+					else {
+						linkedRecord.emplace(columns.at(i - 1), query.getColumn(i).getText());
+					}
+				}
+				page.emplace(query.getColumn(0).getInt64(), linkedRecord);
+			}
+		}
+		for(auto &it : page) {
+			if(result.size() >= limit)
+				break;
+			result.push_back(it.second);
 		}
 	}
-	result = result && !recordsToDelete.empty();
-	if(!result)
-		return result;
-	//(5) We delete those records.
-	for(auto &it : recordsToDelete) {
-		result = result && this->removeCore(joiningTable, it);
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return vector<map<string,string>>();
 	}
 
 	return result;
 }
 
-std::map<std::string, std::vector<std::map<std::string,std::string> > > SQLiteDBManager::getLinkedRecords(const std::string& table,
-                                                                                                          const std::map<std::string, std::string>& record,
-                                                                                                          const bool& isAtomic) const {
+std::map<std::string, unsigned int> SQLiteDBManager::countLinked(const std::string& table,
+                                                                 const std::map<std::string, std::string>& record,
+                                                                 const bool& isAtomic) const {
 
+	this->lastError() = DBManagerError::None;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
 
-		return this->getLinkedRecordsCore(table, record);
+		return this->countLinkedCore(table, record);
 	}
 	else {
-		return this->getLinkedRecordsCore(table, record);
+		ConnectionUse use(*this);
+		return this->countLinkedCore(table, record);
 	}
 }
 
-std::map<std::string, std::vector<std::map<std::string,std::string> > > SQLiteDBManager::getLinkedRecordsCore(const std::string& table,
-                                                                                                              const std::map<std::string, std::string>& record) const {
+std::unique_ptr<DBSnapshot> SQLiteDBManager::snapshot() const {
 
-	// (1) We get all record ids for records whose values matches the record given in parameter.
-	set<string> referenceRecordIds;
-	for(auto &it : this->getCore(table)) {
-		string id = it[PK_FIELD_NAME];
-		it.erase(PK_FIELD_NAME);
-		if(it == record) {
-			referenceRecordIds.emplace(id);
-		}
+	this->lastError() = DBManagerError::None;
+	try {
+		std::unique_ptr<Database> connection(new Database(this->filename, SQLITE_OPEN_READONLY));
+		this->installBusyHandler(*connection);
+		return std::unique_ptr<DBSnapshot>(new SQLiteDBSnapshot(*this, std::move(connection)));
+	}
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return std::unique_ptr<DBSnapshot>();
 	}
+}
 
-	// (2) We find all the joining table names associated with this table and the relatedTables names
-	set<string> linkingTables;
-	map<string, string> relatedTables;
-	for(auto &name : this->listTablesCore()) {
-		if(name.find(table + "_") != string::npos || name.find("_" + table) != string::npos) {
-			linkingTables.emplace(name);
-			if(name.find(table + "_") != string::npos) {
-				string otherTableName = name.substr(string(table+"_").length(), name.length()-string(table+"_").length());
-				relatedTables.emplace(name, otherTableName);
+std::map<std::string, unsigned int> SQLiteDBManager::countLinkedCore(const std::string& table,
+                                                                     const std::map<std::string, std::string>& record) const {
+
+	map<string, unsigned int> result;
+	try {
+		// (1) We get all record ids for records whose values matches the record given in parameter.
+		map<map<string, string>, set<string>> referenceRecordIds = this->getRecordIdsCore(table, set<map<string, string>>({record}));
+		const set<string>& ids = referenceRecordIds[record];
+
+		// (2) We count the related records in each joining table
+		vector<vector<string>> chunks = splitIds(ids);
+		for(auto &it : this->getLinkingTablesCore(table)) {
+			if(ids.empty()) {
+				result.emplace(it.first, 0);
+				continue;
 			}
-			else {
-				string otherTableName = name.substr(0, name.length()-string("_"+table).length());
-				relatedTables.emplace(name, otherTableName);
+
+			/* The database counts the related records of one chunk of ids. With several chunks, a record may be related to ids of different chunks: the related ids are gathered instead */
+			string relatedField = "\"" + this->escDQ(it.second + "#" + PK_FIELD_NAME) + "\"";
+			set<string> relatedIds;
+			for(auto &chunk : chunks) {
+				stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+				ss << "SELECT " << (chunks.size() == 1 ? "COUNT(DISTINCT " + relatedField + ")" : "DISTINCT " + relatedField) << " FROM \"" << this->escDQ(it.first) << "\"";
+				ss << " WHERE \"" << this->escDQ(table + "#" + PK_FIELD_NAME) << "\" IN (" << sqlPlaceholders(chunk.size()) << ")";
+
+#ifdef DEBUG
+				cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
+#endif
+				Statement query(this->conn(), ss.str());
+				int index = 1;
+				for(auto &id : chunk) {
+					query.bind(index++, id);
+				}
+				while(query.executeStep()) {
+					if(chunks.size() == 1)
+						result.emplace(it.first, static_cast<unsigned int>(query.getColumn(0).getInt64()));
+					else
+						relatedIds.emplace(query.getColumn(0).getText());
+				}
 			}
+			if(chunks.size() > 1)
+				result.emplace(it.first, static_cast<unsigned int>(relatedIds.size()));
 		}
 	}
+	catch(const Exception &e) {
+		this->recordError(e);
+		cerr << __func__ << "(): " << e.what() << endl;
+		return map<string, unsigned int>();
+	}
 
-	// (3) We fetch the related records
-	map<string, vector<map<string,string>>> result;
-	for(auto &linkingTable : linkingTables) {
-		for(auto &it : this->getCore(linkingTable)) {
-			if(referenceRecordIds.find(it[table + "#" + PK_FIELD_NAME]) != referenceRecordIds.end()) {
-				string relatedId = it[relatedTables[linkingTable] + "#" + PK_FIELD_NAME];
-				for(auto &relatedRecord : this->getCore(relatedTables[linkingTable])) {
-					if(relatedRecord[PK_FIELD_NAME] == relatedId) {
-						if(result.find(relatedTables[linkingTable]) != result.end()) {
-							vector<map<string, string>> newVect;
-							result.emplace(relatedTables[linkingTable], newVect);
-						}
-						result[relatedTables[linkingTable]].push_back(relatedRecord);
-					}
+	return result;
+}
+
+std::vector<std::map<std::string,std::string> > SQLiteDBManager::getRecordsByIdsCore(const std::string& table,
+                                                                                     const std::set<std::string>& ids) const {
+
+	vector<string> columns;
+	Statement tableInfo(this->conn(), "PRAGMA table_info(\"" + this->escDQ(table) + "\")");
+	while(tableInfo.executeStep())
+		columns.push_back(tableInfo.getColumn(1).getText());
+
+	vector<map<string,string>> result;
+	set<string>::const_iterator chunkStart = ids.begin();
+	while(chunkStart != ids.end()) {
+		stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+		ss << "SELECT ";
+		for(vector<string>::const_iterator col = columns.begin(); col != columns.end(); ++col) {
+			/* Check if iterator is on the first element of the list, and add a separator otherwise */
+			if(col != columns.begin()) {
+				ss << ", ";
+			}
+			ss << "\"" << this->escDQ(*col) << "\"";
+		}
+		ss << " FROM \"" << this->escDQ(table) << "\" WHERE \"" << this->escDQ(PK_FIELD_NAME) << "\" IN (";
+		set<string>::const_iterator chunkEnd = chunkStart;
+		for(unsigned int count = 0; count < IDS_CHUNK_SIZE && chunkEnd != ids.end(); count++, ++chunkEnd) {
+			if(count != 0) {
+				ss << ", ";
+			}
+			ss << "?";
+		}
+		ss << ") ORDER BY \"" << this->escDQ(PK_FIELD_NAME) << "\"";
+
+#ifdef DEBUG
+		cout << __func__ << "(): running SQL query \"" << ss.str() << "\"" << endl;
+#endif
+		Statement query(this->conn(), ss.str());
+		int index = 1;
+		for(set<string>::const_iterator it = chunkStart; it != chunkEnd; ++it) {
+			query.bind(index++, *it);
+		}
+		while(query.executeStep()) {
+			map<string, string> record;
+			for(int i = 0; i < query.getColumnCount(); ++i) {
+				if(query.getColumn(i).isNull()) {
+					record.emplace(columns.at(i), "");
+				}
+				else {
+					record.emplace(columns.at(i), query.getColumn(i).getText());
 				}
 			}
+			result.push_back(record);
 		}
+
+		chunkStart = chunkEnd;
 	}
 
 	return result;
@@ -2017,15 +4093,18 @@ std::map<std::string, std::vector<std::map<std::string,std::string> > > SQLiteDB
 bool SQLiteDBManager::markReferenced(const std::string& name,
                                      const bool& isAtomic) {
 
+	this->lastError() = DBManagerError::None;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		Transaction transaction(*(this->db));
-		bool result = this->markReferencedCore(name);
+		ForeignKeysSuspender foreignKeysSuspender(this->conn(), this->foreignKeysToCheck);	/* Must outlive the transaction */
+		Transaction transaction(this->conn());
+		bool result = this->markReferencedCore(name) && foreignKeysSuspender.check();
 		if(result)
-			transaction.commit();
+			result = this->commitTransaction(transaction);
 		return result;
 	}
 	else {
+		ConnectionUse use(*this);
 		return this->markReferencedCore(name);
 	}
 }
@@ -2046,18 +4125,16 @@ bool SQLiteDBManager::markReferencedCore(const std::string& name) {
 	result = !this->isReferencedCore(name);
 
 	if(result) {
-		// (1) Save table fields
+		// (1) Get table fields
 		SQLTable table = this->getTableFromDatabaseCore(name);
-		// (2) Save table content
-		vector<map<string, string>> records = this->getCore(name);
-		// (3) Drop the current table
-		result = result && this->deleteTableCore(name);
-		// (4) Mark the table referenced
+		vector<string> columns;
+		for(auto &it : table.getFields()) {
+			columns.push_back(std::get<0>(it));
+		}
+		// (2) Mark the table referenced
 		table.markReferenced();
-		// (5) We recreate the table
-		result = result && this->createTableCore(table);
-		// (6) We populate the table
-		result = result && this->insertCore(name, records);
+		// (3) We rebuild the table, records get their primary key value when they are copied
+		result = result && this->rebuildTableCore(table, columns);
 	}
 
 	return result;
@@ -2065,15 +4142,17 @@ bool SQLiteDBManager::markReferencedCore(const std::string& name) {
 
 bool SQLiteDBManager::unmarkReferenced(const std::string& name,
                                        const bool& isAtomic) {
+	this->lastError() = DBManagerError::None;
 	if(isAtomic) {
 		std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
-		Transaction transaction(*(this->db));
+		Transaction transaction(this->conn());
 		bool result = this->unmarkReferencedCore(name);
 		if(result)
-			transaction.commit();
+			result = this->commitTransaction(transaction);
 		return result;
 	}
 	else {
+		ConnectionUse use(*this);
 		return this->unmarkReferencedCore(name);
 	}
 }
@@ -2088,22 +4167,16 @@ bool SQLiteDBManager::unmarkReferencedCore(const std::string& name) {
 		}
 
 	if(result) {
-		// (1) Save table fields
+		// (1) Get table fields
 		SQLTable table = this->getTableFromDatabaseCore(name);
-		// (2) Save table content
-		vector<map<string, string>> records = this->getCore(name);
-		// (3) Drop the current table
-		result = result && this->deleteTableCore(name);
-		// (4) Unmark the table referenced
-		table.unmarkReferenced();
-		// (5) We remove the primary key field values
-		for(auto &it : records) {
-			it.erase(PK_FIELD_NAME);
+		vector<string> columns;
+		for(auto &it : table.getFields()) {	/* The primary key field is not part of the fields, so its values are not copied */
+			columns.push_back(std::get<0>(it));
 		}
-		// (6) We recreate the table
-		result = result && this->createTableCore(table);
-		// (7) We populate the table
-		result = result && this->insertCore(name, records);
+		// (2) Unmark the table referenced
+		table.unmarkReferenced();
+		// (3) We rebuild the table
+		result = result && this->rebuildTableCore(table, columns);
 	}
 
 	return result;
@@ -2111,4 +4184,82 @@ bool SQLiteDBManager::unmarkReferencedCore(const std::string& name) {
 
 void SQLiteDBManager::setDatabaseConfigurationFile(const std::string& databaseConfigurationFile) {
 	this->configurationDescriptionFile = databaseConfigurationFile;
+	this->schemaDescriptor = NULL;	/* The XML configuration replaces any precompiled description */
+}
+
+void SQLiteDBManager::setMigrationProgressCallback(const std::function<void(const std::string&, unsigned long long, unsigned long long)>& callback) {
+	std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+	this->migrationProgressCallback = callback;
+}
+
+void SQLiteDBManager::setMigrationCancelHook(const std::function<bool()>& hook) {
+	std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+	this->migrationCancelHook = hook;
+}
+
+bool SQLiteDBManager::setMigrationChunkSize(const unsigned int& rows) {
+	if (rows == 0)
+		return false;
+
+	std::lock_guard<std::mutex> lock(this->mut);	/* Lock the mutex (will be unlocked when object lock goes out of scope) */
+	this->migrationChunkSize = rows;
+	return true;
+}
+
+void SQLiteDBManager::post(const std::function<void(bool)>& request, const std::function<void()>& completion, const bool& readOnly) {
+	this->postRequest(request, completion, readOnly);
+}
+
+std::future<std::vector<std::map<std::string, std::string>>> SQLiteDBManager::getAsync(const std::string& table,
+                                                                                      const std::vector<std::string>& columns,
+                                                                                      const bool& distinct) const {
+	return this->submitJob<vector<map<string, string>>>([=](bool isAtomic) { return this->get(table, columns, distinct, isAtomic); }, true);
+}
+
+std::future<bool> SQLiteDBManager::insertAsync(const std::string& table,
+                                               const std::vector<std::map<std::string, std::string>>& values) {
+	return this->submitJob<bool>([=](bool) { return this->insert(table, values); }, false);
+}
+
+std::future<bool> SQLiteDBManager::modifyAsync(const std::string& table,
+                                               const std::map<std::string, std::string>& refFields,
+                                               const std::map<std::string, std::string>& values,
+                                               const bool& insertIfNotExists) {
+	return this->submitJob<bool>([=](bool) { return this->modify(table, refFields, values, insertIfNotExists); }, false);
+}
+
+std::future<bool> SQLiteDBManager::removeAsync(const std::string& table,
+                                               const std::map<std::string, std::string>& refFields) {
+	return this->submitJob<bool>([=](bool) { return this->remove(table, refFields); }, false);
+}
+
+std::future<bool> SQLiteDBManager::linkRecordsAsync(const std::string& table1,
+                                                    const std::map<std::string, std::string>& record1,
+                                                    const std::string& table2,
+                                                    const std::map<std::string, std::string>& record2) {
+	return this->submitJob<bool>([=](bool) { return this->linkRecords(table1, record1, table2, record2); }, false);
+}
+
+std::future<bool> SQLiteDBManager::linkRecordsAsync(const std::string& table1,
+                                                    const std::string& table2,
+                                                    const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs) {
+	return this->submitJob<bool>([=](bool) { return this->linkRecords(table1, table2, pairs); }, false);
+}
+
+std::future<bool> SQLiteDBManager::unlinkRecordsAsync(const std::string& table1,
+                                                      const std::map<std::string, std::string>& record1,
+                                                      const std::string& table2,
+                                                      const std::map<std::string, std::string>& record2) {
+	return this->submitJob<bool>([=](bool) { return this->unlinkRecords(table1, record1, table2, record2); }, false);
+}
+
+std::future<bool> SQLiteDBManager::unlinkRecordsAsync(const std::string& table1,
+                                                      const std::string& table2,
+                                                      const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs) {
+	return this->submitJob<bool>([=](bool) { return this->unlinkRecords(table1, table2, pairs); }, false);
+}
+
+std::future<std::map<std::string, std::vector<std::map<std::string,std::string>>>> SQLiteDBManager::getLinkedRecordsAsync(const std::string& table,
+                                                                                                                      const std::map<std::string, std::string>& record) const {
+	return this->submitJob<map<string, vector<map<string, string>>>>([=](bool isAtomic) { return this->getLinkedRecords(table, record, isAtomic); }, true);
 }
@@ -40,11 +40,10 @@ If not, see <http://www.gnu.org/licenses/>.
 #include <map>
 #include <exception>
 #include <mutex>
-
-//tinyxml includes
-#define TIXML_USE_STL	/* Fix possibly badly packaged tinyxml headers */
-#include <tinyxml.h>
-#undef TIXML_USE_STL
+#include <functional>
+#include <future>
+#include <memory>
+#include <atomic>
 
 //SQLiteCpp includes
 #include "SQLiteCpp/SQLiteCpp.h"
@@ -52,6 +51,9 @@ If not, see <http://www.gnu.org/licenses/>.
 //Project includes
 #include "dbmanager.hpp"
 #include "sqltable.hpp"
+#include "sqlschema.hpp"
+
+class SQLiteWorkerPool;
 
 
 /**
@@ -72,8 +74,25 @@ public:
 	 *
 	 * \param filename The SQLite database file path.
 	 * \param configurationDescriptionFile The configuration file for database migration.
+	 * \param options Options applied when the database is opened:
+	 *        - "journal_mode": the SQLite journal mode (delete, truncate, persist, memory, wal or off).
+	 *        - "readers": the number of reader threads running asynchronous reads in WAL journal mode (defaults to DEFAULT_READER_THREADS).
+	 *        - "busy_timeout": the maximum time (in ms) spent waiting for the database when it is locked by another connection or process (defaults to DEFAULT_BUSY_TIMEOUT).
+	 *        - "busy_backoff": the first delay (in ms) waited before retrying, doubled at each retry (defaults to DEFAULT_BUSY_BACKOFF).
+	 *        - "migration_chunk_size": the maximum number of rows copied at once when a table is rebuilt during a migration (defaults to DEFAULT_MIGRATION_CHUNK_SIZE).
+	 */
+	SQLiteDBManager(const std::string& filename, const std::string& configurationDescriptionFile = "", const std::map<std::string, std::string>& options = std::map<std::string, std::string>());
+
+	/**
+	 * \brief Constructor from a precompiled schema.
+	 *
+	 * The database is migrated to the structure described by \p schema, without parsing any XML.
+	 *
+	 * \param filename The SQLite database file path.
+	 * \param schema The description of the database structure, as generated by dbmanager-schemagen (it must outlive this object).
+	 * \param options Options applied when the database is opened (see the other constructor).
 	 */
-	SQLiteDBManager(const std::string& filename, const std::string& configurationDescriptionFile = "");
+	SQLiteDBManager(const std::string& filename, const DBSchemaDescriptor& schema, const std::map<std::string, std::string>& options = std::map<std::string, std::string>());
 	
 	/**
 	 * \brief Destructor.
@@ -110,6 +129,18 @@ public:
 	 */
 	std::vector< std::map<std::string, std::string> > get(const std::string& table, const std::vector<std::string >& columns = std::vector<std::string >(), const bool& distinct = false, const bool& isAtomic = true) const noexcept;
 
+	/**
+	 * \brief table record counter
+	 *
+	 * This method is the implementation of the DBManager interface count method.
+	 *
+	 * \param table The name of the SQL table.
+	 * \param refFields The reference fields values to identify the records to count. Leave empty to count all records.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return The number of matching records (0 on error).
+	 */
+	unsigned long long count(const std::string& table, const std::map<std::string, std::string>& refFields = std::map<std::string, std::string>(), const bool& isAtomic = true) const;
+
 	/**
 	 * \brief table record setter
 	 *
@@ -170,6 +201,30 @@ public:
 	 */
 	bool unlinkRecords(const std::string& table1, const std::map<std::string, std::string>& record1, const std::string& table2, const std::map<std::string, std::string>& record2, const bool& isAtomic = true);
 
+	/**
+	 * \brief table record setter
+	 *
+	 * This method is the implementation of the DBManager interface linkRecords method (batch version).
+	 * \param table1 The name of the first SQL table that contains the first record of each pair.
+	 * \param table2 The name of the second SQL table that contains the second record of each pair.
+	 * \param pairs The pairs of records to link (first: the record in table1, second: the record in table2).
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool linkRecords(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs, const bool& isAtomic = true);
+
+	/**
+	 * \brief table record setter
+	 *
+	 * This method is the implementation of the DBManager interface unlinkRecords method (batch version).
+	 * \param table1 The name of the first SQL table that contains the first record of each pair.
+	 * \param table2 The name of the second SQL table that contains the second record of each pair.
+	 * \param pairs The pairs of records to unlink (first: the record in table1, second: the record in table2).
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool unlinkRecords(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs, const bool& isAtomic = true);
+
 	/**
 	 * \brief table record getter
 	 *
@@ -181,6 +236,113 @@ public:
 	 */
 	std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecords(const std::string& table, const std::map<std::string, std::string>& record, const bool & isAtomic = true) const;
 
+	/**
+	 * \brief table record setter
+	 *
+	 * This method is the implementation of the DBManager interface linkById method.
+	 * \param table1 The name of the first SQL table that contains the first record to link.
+	 * \param id1 The id of the first record in table1.
+	 * \param table2 The name of the second SQL table that contains the second record to link.
+	 * \param id2 The id of the second record in table2.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool linkById(const std::string& table1, const std::string& id1, const std::string& table2, const std::string& id2, const bool& isAtomic = true);
+
+	/**
+	 * \brief table record setter
+	 *
+	 * This method is the implementation of the DBManager interface unlinkById method.
+	 * \param table1 The name of the first SQL table that contains the first record to unlink.
+	 * \param id1 The id of the first record in table1.
+	 * \param table2 The name of the second SQL table that contains the second record to unlink.
+	 * \param id2 The id of the second record in table2.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool unlinkById(const std::string& table1, const std::string& id1, const std::string& table2, const std::string& id2, const bool& isAtomic = true);
+
+	/**
+	 * \brief table record getter
+	 *
+	 * This method is the implementation of the DBManager interface getLinkedRecordsById method.
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param id The id of the record in table.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return map<string, vector<map<string,string>>> All the records linked to the specified record organized by tables.
+	 */
+	std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecordsById(const std::string& table, const std::string& id, const bool & isAtomic = true) const;
+
+	/**
+	 * \brief table record getter
+	 *
+	 * This method is the implementation of the DBManager interface getLinkedRecords method (path version).
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param path The names of the tables to go through, in order.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return map<string, vector<map<string,string>>> All the records reached at each step of the path, organized by tables.
+	 */
+	std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecords(const std::string& table, const std::map<std::string, std::string>& record, const std::vector<std::string>& path, const bool & isAtomic = true) const;
+
+	/**
+	 * \brief table record getter
+	 *
+	 * This method is the implementation of the DBManager interface getLinkedRecordsByDepth method.
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param depth The maximum number of relationships to follow.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return map<string, vector<map<string,string>>> All the records reachable from the specified record, organized by tables.
+	 */
+	std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecordsByDepth(const std::string& table, const std::map<std::string, std::string>& record, const unsigned int& depth, const bool & isAtomic = true) const;
+
+	/**
+	 * \brief table record getter
+	 *
+	 * This method is the implementation of the DBManager interface getLinkedRecords method (paginated version).
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param relationship The name of the relationship (ie: the name of its joining table).
+	 * \param limit The maximum number of records to return.
+	 * \param afterId The id of the last record of the previous page (leave empty to get the first page).
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return vector<map<string,string>> At most limit linked records, whose id is greater than afterId.
+	 */
+	std::vector<std::map<std::string,std::string>> getLinkedRecords(const std::string& table, const std::map<std::string, std::string>& record, const std::string& relationship, const unsigned int& limit, const std::string& afterId = "", const bool & isAtomic = true) const;
+
+	/**
+	 * \brief table record counter
+	 *
+	 * This method is the implementation of the DBManager interface countLinked method.
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return map<string, unsigned int> The number of linked records, for each relationship of table.
+	 */
+	std::map<std::string, unsigned int> countLinked(const std::string& table, const std::map<std::string, std::string>& record, const bool & isAtomic = true) const;
+
+	/**
+	 * \brief snapshot getter
+	 *
+	 * This method is the implementation of the DBManager interface snapshot method.
+	 * The snapshot is a read transaction on a read-only connection of its own. Writers only continue while it exists in WAL journal mode (see the journal_mode option).
+	 * In other journal modes, the snapshot holds a shared lock on the database file: writes can't be committed until it is released, and fail as busy once the busy_timeout option expires (immediately by default).
+	 *
+	 * \return A snapshot of the database as it is now, or NULL if the database could not be opened.
+	 */
+	std::unique_ptr<DBSnapshot> snapshot() const;
+
+	/**
+	 * \brief database migration planning method
+	 *
+	 * This method is the implementation of the DBManager interface planMigration method.
+	 * \param configurationDescription The database description to migrate to (either the PATH to an XML file, or the XML content itself).
+	 * \param isAtomic A flag to operates the modifications in an atomic way. The plan is the one of checkDefaultTables() called with the same flag: foreign keys are suspended by an atomic migration, so rebuilt tables don't have to move their joining tables aside.
+	 * \return vector<DBMigrationOperation> The operations checkDefaultTables() would perform, in order, with the number of rows each of them copies, inserts or deletes.
+	 */
+	std::vector<DBMigrationOperation> planMigration(const std::string& configurationDescription, const bool& isAtomic = true) const;
+
 	/**
 	 * \brief table listing method
 	 *
@@ -191,6 +353,17 @@ public:
 	 */
 	std::vector<std::string> listTables(const bool& isAtomic = true) const;
 
+	/**
+	 * \brief table structure getter
+	 *
+	 * Get the structure of all the tables of the database, as it is compared with the database description during a migration.
+	 *
+	 * \param byPragmas If true, the tables are introspected one by one with pragmas (as with SQLite versions older than 3.16.0), instead of all at once.
+	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \return map<string, SQLTable> The tables of the database, by name.
+	 */
+	std::map<std::string, SQLTable> getTablesFromDatabase(const bool& byPragmas = false, const bool& isAtomic = true) const;
+
 	/**
 	 * \brief database configuration file setter
 	 *
@@ -200,6 +373,208 @@ public:
 	 */
 	void setDatabaseConfigurationFile(const std::string& databaseConfigurationFile = "");
 
+	/**
+	 * \brief migration progress callback setter
+	 *
+	 * This method is the implementation of the DBManager interface setMigrationProgressCallback method.
+	 *
+	 * \param callback The function to call with the name of the table being copied, the number of rows already copied and the total number of rows to copy.
+	 */
+	void setMigrationProgressCallback(const std::function<void(const std::string&, unsigned long long, unsigned long long)>& callback);
+
+	/**
+	 * \brief migration cancellation hook setter
+	 *
+	 * This method is the implementation of the DBManager interface setMigrationCancelHook method.
+	 *
+	 * \param hook The function to call before each chunk of rows is copied, the migration is cancelled if it returns true.
+	 */
+	void setMigrationCancelHook(const std::function<bool()>& hook);
+
+	/**
+	 * \brief migration chunk size setter
+	 *
+	 * Sets the maximum number of rows copied at once when a table is rebuilt during a migration (see the migration_chunk_size option).
+	 * Progress is reported and cancellation is checked between chunks: smaller chunks make them more frequent, but the migration slower.
+	 *
+	 * \param rows The number of rows per chunk (must not be 0).
+	 * \return bool false if \p rows is 0, in which case the chunk size is not modified.
+	 */
+	bool setMigrationChunkSize(const unsigned int& rows);
+
+	/**
+	 * \brief busy statistics getter
+	 *
+	 * This method is the implementation of the DBManager interface getBusyStatistics method.
+	 *
+	 * \return The counters of the time spent waiting for this database, on all its connections.
+	 */
+	DBBusyStatistics getBusyStatistics() const;
+
+	/**
+	 * \brief connection closing method
+	 *
+	 * Closes the connection to the database, releasing its page cache, unless a request is running. The next request opens it again (see conn()).
+	 * Requests run with isAtomic set to false don't lock this manager, but they mark the connection as used while they run, so it isn't closed under them either.
+	 * Snapshots and the connections of the reader threads are not closed.
+	 *
+	 * \return true if the connection is closed, false if a request was running.
+	 */
+	bool closeConnection();
+
+	/**
+	 * \brief connection status getter
+	 *
+	 * \return false if the connection was closed by closeConnection(), and not opened again yet.
+	 */
+	bool isConnectionOpen() const;
+
+	/**
+	 * \brief last use getter
+	 *
+	 * \return A number that is greater for managers used more recently (0 if this manager was never used).
+	 */
+	unsigned long long getLastUse() const;
+
+	/**
+	 * \brief reopen callback setter
+	 *
+	 * Sets a function that is called each time the connection is opened again after closeConnection(). It is called with this manager locked, so it must not use it (but it can close the connection of other managers).
+	 *
+	 * \param callback The function to call with this manager. Use an empty function to remove the callback.
+	 */
+	void setReopenCallback(const std::function<void(SQLiteDBManager&)>& callback);
+
+	/**
+	 * \brief asynchronous request submission method
+	 *
+	 * This method is the implementation of the DBManager interface post method.
+	 * \p request is run by the worker pool like the asynchronous requests (see getAsync()).
+	 *
+	 * \param request The request to run, called with the isAtomic flag to pass to the methods of this manager.
+	 * \param completion The function to call after \p request, on the same thread (may be empty).
+	 * \param readOnly Set to true if \p request only reads the database, so that it can be run by a reader thread.
+	 */
+	void post(const std::function<void(bool)>& request, const std::function<void()>& completion, const bool& readOnly = false);
+
+	/**
+	 * \brief asynchronous table content getter
+	 *
+	 * This method is the implementation of the DBManager interface getAsync method.
+	 * The request is run by a reader thread of the worker pool if the database is in WAL journal mode (see the readers option), or by its writer thread otherwise.
+	 *
+	 * \param table The name of the SQL table.
+	 * \param columns The columns name to obtain from the table. Leave empty for all columns.
+	 * \param distinct Set to true to remove duplicated records from the result.
+	 * \return A future that will hold the result of get().
+	 */
+	std::future<std::vector<std::map<std::string, std::string>>> getAsync(const std::string& table, const std::vector<std::string>& columns = std::vector<std::string>(), const bool& distinct = false) const;
+
+	/**
+	 * \brief asynchronous table record setter
+	 *
+	 * This method is the implementation of the DBManager interface insertAsync method.
+	 * The request is run by the writer thread of the worker pool, after all the writes submitted before it.
+	 *
+	 * \param table The name of the SQL table in which the records will be inserted.
+	 * \param values The records to insert in the table.
+	 * \return A future that will hold the result of insert().
+	 */
+	std::future<bool> insertAsync(const std::string& table, const std::vector<std::map<std::string, std::string>>& values);
+	using DBManager::insertAsync;	/* Don't hide the overload inserting a single record */
+
+	/**
+	 * \brief asynchronous table record setter
+	 *
+	 * This method is the implementation of the DBManager interface modifyAsync method.
+	 * The request is run by the writer thread of the worker pool, after all the writes submitted before it.
+	 *
+	 * \param table The name of the SQL table in which the record will be updated.
+	 * \param refFields The reference fields values to identify the record to update in the table.
+	 * \param values The new record values to update in the table.
+	 * \param insertIfNotExists If set to true, the record will be inserted if it does not exist yet.
+	 * \return A future that will hold the result of modify().
+	 */
+	std::future<bool> modifyAsync(const std::string& table, const std::map<std::string, std::string>& refFields, const std::map<std::string, std::string>& values, const bool& insertIfNotExists = true);
+
+	/**
+	 * \brief asynchronous table record remover
+	 *
+	 * This method is the implementation of the DBManager interface removeAsync method.
+	 * The request is run by the writer thread of the worker pool, after all the writes submitted before it.
+	 *
+	 * \param table The name of the SQL table in which records will be deleted.
+	 * \param refFields The reference fields values to identify the records to delete.
+	 * \return A future that will hold the result of remove().
+	 */
+	std::future<bool> removeAsync(const std::string& table, const std::map<std::string, std::string>& refFields);
+
+	/**
+	 * \brief asynchronous records linker
+	 *
+	 * This method is the implementation of the DBManager interface linkRecordsAsync method.
+	 * The request is run by the writer thread of the worker pool, after all the writes submitted before it.
+	 *
+	 * \param table1 The first table name.
+	 * \param record1 The record in table1 to link.
+	 * \param table2 The second table name.
+	 * \param record2 The record in table2 to link.
+	 * \return A future that will hold the result of linkRecords().
+	 */
+	std::future<bool> linkRecordsAsync(const std::string& table1, const std::map<std::string, std::string>& record1, const std::string& table2, const std::map<std::string, std::string>& record2);
+
+	/**
+	 * \brief asynchronous records linker
+	 *
+	 * This method is the implementation of the DBManager interface linkRecordsAsync method, for a batch of pairs.
+	 * The request is run by the writer thread of the worker pool, after all the writes submitted before it.
+	 *
+	 * \param table1 The first table name.
+	 * \param table2 The second table name.
+	 * \param pairs The pairs of records to link, the first record of each pair being in table1 and the second one in table2.
+	 * \return A future that will hold the result of linkRecords().
+	 */
+	std::future<bool> linkRecordsAsync(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs);
+
+	/**
+	 * \brief asynchronous records unlinker
+	 *
+	 * This method is the implementation of the DBManager interface unlinkRecordsAsync method.
+	 * The request is run by the writer thread of the worker pool, after all the writes submitted before it.
+	 *
+	 * \param table1 The first table name.
+	 * \param record1 The record in table1 to unlink.
+	 * \param table2 The second table name.
+	 * \param record2 The record in table2 to unlink.
+	 * \return A future that will hold the result of unlinkRecords().
+	 */
+	std::future<bool> unlinkRecordsAsync(const std::string& table1, const std::map<std::string, std::string>& record1, const std::string& table2, const std::map<std::string, std::string>& record2);
+
+	/**
+	 * \brief asynchronous records unlinker
+	 *
+	 * This method is the implementation of the DBManager interface unlinkRecordsAsync method, for a batch of pairs.
+	 * The request is run by the writer thread of the worker pool, after all the writes submitted before it.
+	 *
+	 * \param table1 The first table name.
+	 * \param table2 The second table name.
+	 * \param pairs The pairs of records to unlink, the first record of each pair being in table1 and the second one in table2.
+	 * \return A future that will hold the result of unlinkRecords().
+	 */
+	std::future<bool> unlinkRecordsAsync(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs);
+
+	/**
+	 * \brief asynchronous linked records getter
+	 *
+	 * This method is the implementation of the DBManager interface getLinkedRecordsAsync method.
+	 * The request is run like getAsync() requests, all its queries reading the same state of the database.
+	 *
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \return A future that will hold the result of getLinkedRecords().
+	 */
+	std::future<std::map<std::string, std::vector<std::map<std::string,std::string>>>> getLinkedRecordsAsync(const std::string& table, const std::map<std::string, std::string>& record) const;
+
 	/**
 	 * \brief table dump method
 	 *
@@ -255,6 +630,17 @@ private :
 	 */
 	std::vector< std::map<std::string, std::string> > getCore(const std::string& table, const std::vector<std::string >& columns = std::vector<std::string >(), const bool& distinct = false) const noexcept;
 
+	/**
+	 * \brief table record counter
+	 *
+	 * The 'core' of the count method, which contains all the SQL statements.
+	 *
+	 * \param table The name of the SQL table.
+	 * \param refFields The reference fields values to identify the records to count. Leave empty to count all records.
+	 * \return The number of matching records (0 on error).
+	 */
+	unsigned long long countCore(const std::string& table, const std::map<std::string, std::string>& refFields) const;
+
 	/**
 	 * \brief table record setter
 	 *
@@ -314,24 +700,178 @@ private :
 	 */
 	bool unlinkRecordsCore(const std::string& table1, const std::map<std::string, std::string>& record1, const std::string& table2, const std::map<std::string, std::string>& record2);
 
+	/**
+	 * \brief table record setter
+	 *
+	 * The 'core' of the batch linkRecords method, which contains all the SQL statements.
+	 * \param table1 The name of the first SQL table that contains the first record of each pair.
+	 * \param table2 The name of the second SQL table that contains the second record of each pair.
+	 * \param pairs The pairs of records to link (first: the record in table1, second: the record in table2).
+	 * \param[out] linksCreated The number of links actually added to the joining table (pairs already linked are not counted).
+	 * \return bool The success or failure of the operation.
+	 */
+	bool linkRecordsCore(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs, unsigned int& linksCreated);
+
+	/**
+	 * \brief table record setter
+	 *
+	 * The 'core' of the batch unlinkRecords method, which contains all the SQL statements.
+	 * \param table1 The name of the first SQL table that contains the first record of each pair.
+	 * \param table2 The name of the second SQL table that contains the second record of each pair.
+	 * \param pairs The pairs of records to unlink (first: the record in table1, second: the record in table2).
+	 * \param[out] linksRemoved The number of links actually removed from the joining table.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool unlinkRecordsCore(const std::string& table1, const std::string& table2, const std::vector<std::pair<std::map<std::string, std::string>, std::map<std::string, std::string>>>& pairs, unsigned int& linksRemoved);
+
+	/**
+	 * \brief relationship information getter
+	 *
+	 * Get the name of the joining table of the m:n relationship between two tables.
+	 * \param table1 The name of the first table of the relationship.
+	 * \param table2 The name of the second table of the relationship.
+	 * \return string The name of the joining table, or an empty string if there is no relationship between those tables.
+	 */
+	std::string getJoiningTableCore(const std::string& table1, const std::string& table2) const;
+
+	/**
+	 * \brief table record getter
+	 *
+	 * Find the ids of records in a referenced table. This is done in one single pass on the table, whatever the number of records to find.
+	 * A record matches if its values (all fields except the primary key) are exactly the ones provided.
+	 * \param table The name of the referenced SQL table.
+	 * \param records The records to find.
+	 * \return map<map<string,string>, set<string>> The ids of each record found (records that do not exist in the table are absent from the result).
+	 */
+	std::map<std::map<std::string, std::string>, std::set<std::string>> getRecordIdsCore(const std::string& table, const std::set<std::map<std::string, std::string>>& records) const;
+
+	/**
+	 * \brief table record setter
+	 *
+	 * Add or remove links (pairs of ids) in a joining table. Links are written by chunks, each chunk being written by a single SQL statement.
+	 * \param joiningTable The name of the joining table.
+	 * \param table1 The name of the table whose ids are the first element of each link.
+	 * \param table2 The name of the table whose ids are the second element of each link.
+	 * \param links The links to write.
+	 * \param remove If true, links are removed from the joining table, otherwise they are added (links already present are ignored).
+	 * \return unsigned int The number of rows actually added or removed.
+	 */
+	unsigned int writeLinksCore(const std::string& joiningTable, const std::string& table1, const std::string& table2, const std::set<std::pair<std::string, std::string>>& links, const bool& remove = false);
+
+	/**
+	 * \brief table record setter
+	 *
+	 * The 'core' of the linkById and unlinkById methods, which contains all the SQL statements.
+	 * \param table1 The name of the first SQL table that contains the first record.
+	 * \param id1 The id of the first record in table1.
+	 * \param table2 The name of the second SQL table that contains the second record.
+	 * \param id2 The id of the second record in table2.
+	 * \param remove If true, the records are unlinked, otherwise they are linked.
+	 * \return bool The success or failure of the operation (linking records that are already linked, or unlinking records that are not linked is a failure).
+	 */
+	bool linkByIdCore(const std::string& table1, const std::string& id1, const std::string& table2, const std::string& id2, const bool& remove = false);
+
+	/**
+	 * \brief relationship information getter
+	 *
+	 * Get all the m:n relationships of the database.
+	 * \return map<string, pair<string, string>> The names of the two tables of the relationship, for each joining table name.
+	 */
+	std::map<std::string, std::pair<std::string, std::string>> getRelationshipsCore() const;
+
+	/**
+	 * \brief relationship information getter
+	 *
+	 * Get all the joining tables of m:n relationships involving a table.
+	 * \param table The name of the table.
+	 * \return map<string, string> The name of the other table of the relationship, for each joining table name.
+	 */
+	std::map<std::string, std::string> getLinkingTablesCore(const std::string& table) const;
+
 	/**
 	 * \brief table check method
 	 *
 	 * Allows to check the presence of default tables in the database according to specifics models.
 	 *
 	 * If tables are missing, it builds them. If tables are present but don't match models, it modifies them to make them match models.
+	 *
+	 * A fingerprint of the models is stored in the database (as its user_version) after a successful check. If the database structure was not modified since it was last checked against the same models, the check of tables is skipped (only default records and relationship policies are applied).
 	 * \param isAtomic A flag to operates the modifications in an atomic way.
+	 * \param forceFullCheck If true, tables are always checked, whatever the stored fingerprint.
 	 * \return bool The success or failure of the operation.
 	 */
-	bool checkDefaultTables(const bool& isAtomic = true);
+	bool checkDefaultTables(const bool& isAtomic = true, const bool& forceFullCheck = false);
 
 	/**
 	 * \brief table check method
 	 *
 	 * The 'core' of the checkDefaultTables method, which contains all the SQL statements.
+	 * \param forceFullCheck If true, tables are always checked, whatever the stored fingerprint.
 	 * \return bool The success or failure of the operation.
 	 */
-	bool checkDefaultTablesCore();
+	bool checkDefaultTablesCore(const bool& forceFullCheck = false);
+
+	/**
+	 * \brief db info getter
+	 *
+	 * Compute the fingerprint of a schema for the current database structure.
+	 * \param schema The schema.
+	 * \return unsigned int The fingerprint, which changes if the schema or the structure of the database changes.
+	 */
+	unsigned int getSchemaFingerprintCore(const SQLSchema& schema) const;
+
+	/**
+	 * \brief db info getter
+	 *
+	 * Get the schema version of SQLite, which is incremented each time the structure of the database is modified (by this library or by anyone else).
+	 * \return int The schema version.
+	 */
+	int getSchemaVersionCore() const;
+
+	/**
+	 * \brief db info getter
+	 *
+	 * Get the schema fingerprint stored in the database by the last successful check.
+	 * \return unsigned int The stored fingerprint (0 if the database was never checked).
+	 */
+	unsigned int getStoredSchemaFingerprintCore() const;
+
+	/**
+	 * \brief db info setter
+	 *
+	 * Store a schema fingerprint in the database.
+	 * \param fingerprint The fingerprint to store.
+	 */
+	void storeSchemaFingerprintCore(const unsigned int& fingerprint);
+
+	/**
+	 * \brief table info getter
+	 *
+	 * Check if a table has no record, without reading its content.
+	 * \param table The name of the SQL table.
+	 * \return bool true if the table is empty.
+	 */
+	bool isTableEmptyCore(const std::string& table) const;
+
+	/**
+	 * \brief table info getter
+	 *
+	 * Count the records of a table.
+	 * \param table The name of the SQL table.
+	 * \return unsigned long long The number of records in the table.
+	 */
+	unsigned long long getRowCountCore(const std::string& table) const;
+
+	/**
+	 * \brief database migration planning method
+	 *
+	 * The 'core' of the planMigration method, which contains all the SQL statements.
+	 * It follows the same steps as checkDefaultTablesCore(), on a model of the database structure kept in memory.
+	 * \param configurationDescription The database description to migrate to.
+	 * \param foreignKeysEnabled true if foreign keys will be enabled during the migration (see rebuildMovesJoiningTables()).
+	 * \return vector<DBMigrationOperation> The operations checkDefaultTablesCore() would perform, in order.
+	 */
+	std::vector<DBMigrationOperation> planMigrationCore(const std::string& configurationDescription, const bool& foreignKeysEnabled) const;
 
 	/**
 	 * \brief table check method
@@ -352,6 +892,15 @@ private :
 	 */
 	bool checkTableInDatabaseMatchesModelCore(const SQLTable &model) noexcept;
 
+	/**
+	 * \brief table check method
+	 *
+	 * The 'core' of the checkTableInDatabaseMatchesModel method, using tables that were already introspected.
+	 * \param model A SQLTable instance that modelizes a SQL table.
+	 * \param tablesInDb The tables of the database, as returned by getTablesFromDatabaseCore() (they must be up to date, at least the table modelized by model).
+	 */
+	bool checkTableInDatabaseMatchesModelCore(const SQLTable &model, const std::map<std::string, SQLTable>& tablesInDb) noexcept;
+
 	/**
 	 * \brief table creation method
 	 *
@@ -394,6 +943,75 @@ private :
 	 */
 	bool addFieldsToTable(const std::string& table, const std::vector<std::tuple<std::string, std::string, bool, bool> >& fields, const bool& isAtomic = true) noexcept;
 
+	/**
+	 * \brief SQL generation method
+	 *
+	 * Build the SQL definition of a column (as used in CREATE TABLE or ALTER TABLE statements).
+	 *
+	 * \param field The field (name, default value, not null flag, uniqueness flag).
+	 * \param primaryKey If true, the column is the primary key of the table (this is only used for WITHOUT ROWID tables).
+	 * \return string The SQL definition of the column.
+	 */
+	std::string fieldDefinition(const std::tuple<std::string, std::string, bool, bool>& field, const bool& primaryKey = false) const;
+
+	/**
+	 * \brief table info getter
+	 *
+	 * Get the storage options that will actually be used when creating a table from a model.
+	 * A table can only be stored without rowid if it is not referenced (its ids must be generated by SQLite) and if it has a unique field, which becomes its primary key (the first one in alphabetical order if there are several).
+	 * A table can only be strict if SQLite supports it (since version 3.37.0).
+	 * \param table The table model.
+	 * \param primaryKey The name of the field to use as primary key if the table is to be stored without rowid, an empty string otherwise.
+	 * \param strict true if the table is to be created as a strict table.
+	 */
+	void getTableOptionsCore(const SQLTable& table, std::string& primaryKey, bool& strict) const;
+
+	/**
+	 * \brief migration decision method
+	 *
+	 * Tell if fields can be added to an existing table by ALTER TABLE ... ADD COLUMN, without rebuilding it.
+	 * SQLite can add a column as long as it is not unique (other constraints are fine since we always provide a default value).
+	 * This decision is shared by addFieldsToTableCore() and planMigrationCore().
+	 * \param fields The fields to add to the table.
+	 * \return bool true if the fields can be added in place, false if the table must be rebuilt.
+	 */
+	bool canAddFieldsInPlace(const std::vector<std::tuple<std::string, std::string, bool, bool> >& fields) const;
+
+	/**
+	 * \brief migration decision method
+	 *
+	 * Tell if fields can be removed from an existing table by ALTER TABLE ... DROP COLUMN, without rebuilding it.
+	 * Since version 3.35.0, SQLite can drop a column as long as it is not indexed (this includes unique columns).
+	 * This decision is shared by removeFieldsFromTableCore() and planMigrationCore().
+	 * \param indexedFields The fields of the table that are part of an index.
+	 * \param fields The names of the fields to remove from the table.
+	 * \return bool true if the fields can be removed in place, false if the table must be rebuilt.
+	 */
+	bool canRemoveFieldsInPlace(const std::set<std::string>& indexedFields, const std::vector<std::string>& fields) const;
+
+	/**
+	 * \brief migration decision method
+	 *
+	 * Tell if a table must be rebuilt because its storage options (WITHOUT ROWID, STRICT) differ from the ones its model will actually get (see getTableOptionsCore()).
+	 * This decision is shared by checkTableInDatabaseMatchesModelCore() and planMigrationCore().
+	 * \param model The model of the table.
+	 * \param tableInDb The table as it is (or would be) in the database.
+	 * \return bool true if the table must be rebuilt.
+	 */
+	bool needsStorageRebuildCore(const SQLTable& model, const SQLTable& tableInDb) const;
+
+	/**
+	 * \brief migration decision method
+	 *
+	 * Tell if rebuilding a table moves the content of its joining tables aside and back (see rebuildTableCore()).
+	 * This is not needed if foreign keys are disabled and the table stays referenced: the ids of its records are copied, so the joining tables can be left untouched while the table is replaced.
+	 * This decision is shared by rebuildTableCore() and planMigrationCore().
+	 * \param newTable The new model of the rebuilt table.
+	 * \param foreignKeysEnabled true if foreign keys are enabled during the rebuild.
+	 * \return bool true if the joining tables are moved aside and back.
+	 */
+	bool rebuildMovesJoiningTables(const SQLTable& newTable, const bool& foreignKeysEnabled) const;
+
 	/**
 	 * \brief table setter
 	 *
@@ -444,6 +1062,25 @@ private :
 	 */
 	bool deleteTableCore(const std::string& table) noexcept;
 
+	/**
+	 * \brief index creation method
+	 *
+	 * Creates a secondary index on a table.
+	 * \param table The name of the SQL table.
+	 * \param index The index to create: its name, the names of the indexed fields and its UNIQUE SQL property.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool createIndexCore(const std::string& table, const std::tuple<std::string, std::vector<std::string>, bool>& index) noexcept;
+
+	/**
+	 * \brief index deletion method
+	 *
+	 * Drops a secondary index.
+	 * \param index The name of the index to drop.
+	 * \return bool The success or failure of the operation.
+	 */
+	bool dropIndexCore(const std::string& index) noexcept;
+
 	/**
 	 * \brief table record getter
 	 *
@@ -454,6 +1091,76 @@ private :
 	 */
 	std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecordsCore(const std::string& table, const std::map<std::string, std::string>& record) const;
 
+	/**
+	 * \brief table record getter
+	 *
+	 * The 'core' of the getLinkedRecordsById method, which contains all the SQL statements.
+	 * Linked records are fetched directly from the joining tables, with one SQL query per relationship.
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param id The id of the record in table.
+	 * \param[in,out] result The map into which the records linked to the specified record are appended, organized by tables.
+	 */
+	void getLinkedRecordsByIdCore(const std::string& table, const std::string& id, std::map<std::string, std::vector<std::map<std::string,std::string>>>& result) const;
+
+	/**
+	 * \brief table record getter
+	 *
+	 * The 'core' of the getLinkedRecords method (path version), which contains all the SQL statements.
+	 * All the steps of the path are resolved by one single recursive SQL query (one per chunk of IDS_CHUNK_SIZE ids if many records match the specified record).
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param path The names of the tables to go through, in order.
+	 * \return map<string, vector<map<string,string>>> All the records reached at each step of the path, organized by tables.
+	 */
+	std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecordsCore(const std::string& table, const std::map<std::string, std::string>& record, const std::vector<std::string>& path) const;
+
+	/**
+	 * \brief table record getter
+	 *
+	 * The 'core' of the getLinkedRecordsByDepth method, which contains all the SQL statements.
+	 * The whole traversal is resolved by one single recursive SQL query on all the joining tables (one per chunk of IDS_CHUNK_SIZE ids if many records match the specified record).
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param depth The maximum number of relationships to follow.
+	 * \return map<string, vector<map<string,string>>> All the records reachable from the specified record, organized by tables.
+	 */
+	std::map<std::string, std::vector<std::map<std::string,std::string>>> getLinkedRecordsByDepthCore(const std::string& table, const std::map<std::string, std::string>& record, const unsigned int& depth) const;
+
+	/**
+	 * \brief table record getter
+	 *
+	 * Get records of a table from their ids. Ids are sent to the database by chunks of IDS_CHUNK_SIZE.
+	 * \param table The name of the SQL table.
+	 * \param ids The ids of the records to get.
+	 * \return vector<map<string,string>> The records found, sorted by id.
+	 */
+	std::vector<std::map<std::string,std::string>> getRecordsByIdsCore(const std::string& table, const std::set<std::string>& ids) const;
+
+	/**
+	 * \brief table record getter
+	 *
+	 * The 'core' of the getLinkedRecords method (paginated version), which contains all the SQL statements.
+	 * Only the requested page is fetched from the database (one page per chunk of IDS_CHUNK_SIZE ids if many records match the specified record).
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \param relationship The name of the relationship (ie: the name of its joining table).
+	 * \param limit The maximum number of records to return.
+	 * \param afterId The id of the last record of the previous page (leave empty to get the first page).
+	 * \return vector<map<string,string>> At most limit linked records, whose id is greater than afterId.
+	 */
+	std::vector<std::map<std::string,std::string>> getLinkedRecordsCore(const std::string& table, const std::map<std::string, std::string>& record, const std::string& relationship, const unsigned int& limit, const std::string& afterId) const;
+
+	/**
+	 * \brief table record counter
+	 *
+	 * The 'core' of the countLinked method, which contains all the SQL statements.
+	 * If many records match the specified record, their ids are bound by chunks of IDS_CHUNK_SIZE, and the related ids are gathered to count them.
+	 * \param table The name of the SQL table that contains the record to take as reference.
+	 * \param record The record in table to find.
+	 * \return map<string, unsigned int> The number of linked records, for each relationship of table.
+	 */
+	std::map<std::string, unsigned int> countLinkedCore(const std::string& table, const std::map<std::string, std::string>& record) const;
+
 	/**
 	 * \brief db info getter
 	 *
@@ -461,6 +1168,100 @@ private :
 	 * \return true if foreign keys are enabled
 	 */
 	bool areForeignKeysEnabled() const;
+
+	/**
+	 * \brief connection getter
+	 *
+	 * All the SQL statements of this class are run on the connection returned by this method.
+	 *
+	 * \return The read-only connection of the worker pool reader thread calling this method, or db on any other thread (opened again if it was closed).
+	 */
+	SQLite::Database& conn() const;
+
+	/**
+	 * \brief connection opening method
+	 *
+	 * Opens the connection again after closeConnection(), and checks the database structure if it was migrated while the connection was closed.
+	 */
+	void reopen() const;
+
+	/**
+	 * \brief busy handler installation method
+	 *
+	 * \param connection The connection on which busyHandler() is called when the database is locked.
+	 */
+	void installBusyHandler(SQLite::Database& connection) const;
+
+	/**
+	 * \brief SQLite busy handler
+	 *
+	 * Called by SQLite when a statement can't lock the database. Waits with a jittered exponential backoff, until busyTimeout is reached.
+	 *
+	 * \param manager The manager owning the connection.
+	 * \param count The number of times the handler was already called for the same lock.
+	 * \return 1 to retry, 0 to give up.
+	 */
+	static int busyHandler(void* manager, int count) noexcept;
+
+	/**
+	 * \brief error recording method
+	 *
+	 * Sets the last error of the calling thread from an exception caught by a 'core' method (see DBManager::getLastError()).
+	 *
+	 * \param e The caught exception.
+	 */
+	static void recordError(const SQLite::Exception& e) noexcept;
+
+	/**
+	 * \brief transaction commit method
+	 *
+	 * Commits the transaction of an atomic request. If the commit fails (for example because the database is busy), the error is recorded (see recordError()) and the transaction is rolled back when it is destroyed.
+	 *
+	 * \param transaction The transaction to commit.
+	 * \return bool true if the transaction was committed.
+	 */
+	static bool commitTransaction(SQLite::Transaction& transaction) noexcept;
+
+	/**
+	 * \brief options parsing method
+	 *
+	 * Applies the options passed to the constructor to the database.
+	 *
+	 * \param options The options, by name (see the constructor).
+	 * \return true if all options are known and valid.
+	 */
+	bool applyOptions(const std::map<std::string, std::string>& options);
+
+	/**
+	 * \brief worker pool getter
+	 *
+	 * Starts the worker pool the first time it is called.
+	 * Reader threads are only started if the database is in WAL journal mode, so that they don't block the writer thread.
+	 *
+	 * \return The worker pool running the asynchronous requests.
+	 */
+	SQLiteWorkerPool& getWorkerPool() const;
+
+	/**
+	 * \brief asynchronous request submission method
+	 *
+	 * The 'core' of the post method, which can also be used by const methods.
+	 *
+	 * \param request The request to run, called with the isAtomic flag to pass to the methods of this manager.
+	 * \param completion The function to call after \p request, on the same thread (may be empty).
+	 * \param readOnly Set to true if the request only reads the database, so that it can be run by a reader thread.
+	 */
+	void postRequest(const std::function<void(bool)>& request, const std::function<void()>& completion, const bool& readOnly) const;
+
+	/**
+	 * \brief asynchronous request submission method
+	 *
+	 * \param job The request to run, called with the isAtomic flag to pass to the methods of this manager (false on a reader thread, where it is already run in a read transaction, on a connection that belongs to this thread).
+	 * \param readOnly Set to true if the request only reads the database, so that it can be run by a reader thread.
+	 * \return A future that will hold the result of \p job.
+	 */
+	template<typename R>
+	std::future<R> submitJob(const std::function<R(bool)>& job, const bool& readOnly) const;
 	
 	/**
 	 * \brief table listing method
@@ -660,10 +1461,11 @@ private :
 	 *
 	 * \param kind The kind of relationship.
 	 * \param tables The tables to link.
+	 * \param reverseIndex If true, an index is created on the second column of the joining table (so that records of the second table can be looked up efficiently), otherwise this index is dropped if it exists.
 	 * \param isAtomic A flag to operates the modifications in an atomic way.
 	 * \return string The name of the created table.
 	 */
-	std::string createRelation(const std::string &kind, const std::vector<std::string> &tables, const bool& isAtomic = true);
+	std::string createRelation(const std::string &kind, const std::vector<std::string> &tables, const bool& reverseIndex = true, const bool& isAtomic = true);
 
 	/**
 	 * \brief table creation method
@@ -672,9 +1474,86 @@ private :
 	 *
 	 * \param kind The kind of relationship.
 	 * \param tables The tables to link.
+	 * \param reverseIndex If true, an index is created on the second column of the joining table, otherwise this index is dropped if it exists.
 	 * \return string The name of the created table.
 	 */
-	std::string createRelationCore(const std::string &kind, const std::vector<std::string> &tables);
+	std::string createRelationCore(const std::string &kind, const std::vector<std::string> &tables, const bool& reverseIndex = true);
+
+	/**
+	 * \brief db info getter
+	 *
+	 * Check if the index on the second column of a joining table exists.
+	 *
+	 * \param joiningTable The name of the joining table.
+	 * \return bool true if the index exists.
+	 */
+	bool hasReverseIndexCore(const std::string& joiningTable) const;
+
+	/**
+	 * \brief db info getter
+	 *
+	 * Get the version of the SQLite library used by the database.
+	 *
+	 * \return int The version number, in the same format as SQLITE_VERSION_NUMBER (eg: 3035000 for 3.35.0).
+	 */
+	int getSQLiteVersionCore() const;
+
+	/**
+	 * \brief table info getter
+	 *
+	 * Get the fields of a table that are part of an index (this includes unique fields).
+	 *
+	 * \param name The name of the SQL table.
+	 * \return set<string> The names of the indexed fields.
+	 */
+	std::set<std::string> getIndexedFieldsCore(const std::string& name) const;
+
+	/**
+	 * \brief table info getter
+	 *
+	 * Get the fields of a table model that are part of an index (its unique fields and the fields of its secondary indexes).
+	 * This is what getIndexedFieldsCore() returns once the table is created in the database.
+	 *
+	 * \param table The table model.
+	 * \return set<string> The names of the indexed fields.
+	 */
+	std::set<std::string> getIndexedFields(const SQLTable& table) const;
+
+	/**
+	 * \brief table info getter
+	 *
+	 * Get the secondary indexes of a table, sorted by name (indexes created for UNIQUE and PRIMARY KEY constraints are not listed).
+	 * \param name The name of the SQL table.
+	 * \return vector<tuple<string, vector<string>, bool>> The indexes of the table: their name, the names of the indexed fields (in order) and their UNIQUE SQL property.
+	 */
+	std::vector<std::tuple<std::string, std::vector<std::string>, bool>> getIndexesCore(const std::string& name) const;
+
+	/**
+	 * \brief table setter
+	 *
+	 * Rebuild a table with a new structure, preserving its records and the content of its joining tables.
+	 * The new table is created under a temporary name, records are copied by one single INSERT ... SELECT statement, then the old table is dropped and the new one is renamed.
+	 *
+	 * \param newTable The new model of the table (the table to rebuild is the one having the same name).
+	 * \param columns The columns whose values are copied from the current table to the new one (other columns of the new table get their default value).
+	 * \return bool The success or failure of the operation.
+	 */
+	bool rebuildTableCore(const SQLTable& newTable, const std::vector<std::string>& columns);
+
+	/**
+	 * \brief table copy method
+	 *
+	 * Copies all rows of a table into another one, by chunks of migrationChunkSize rows.
+	 * The migration progress callback is called after each chunk, and the migration cancellation hook before each chunk.
+	 *
+	 * \param name The name of the table given to the progress callback.
+	 * \param source The name of the table to copy rows from.
+	 * \param sourceSchema The schema of the source table ("main", or "temp" for temporary tables).
+	 * \param destination The name of the table to copy rows to.
+	 * \param columns The columns to copy (they must exist in both tables). Leave empty to copy all columns, in which case both tables must have the same columns.
+	 * \return bool false if the copy was cancelled.
+	 */
+	bool copyRowsCore(const std::string& name, const std::string& source, const std::string& sourceSchema, const std::string& destination, const std::vector<std::string>& columns);
 
 	/**
 	 * \brief table creation method
@@ -697,6 +1576,28 @@ private :
 	 */
 	SQLTable getTableFromDatabaseCore(const std::string& table) const;
 
+	/**
+	 * \brief table creation method
+	 *
+	 * Modelizes all tables of the database at once: this only runs 2 queries, using the table-valued pragma functions joined against sqlite_master.
+	 * With SQLite versions older than 3.16.0, tables are introspected one by one.
+	 *
+	 * \param table The name of the only table to modelize. Leave empty to modelize all tables.
+	 * \param byPragmas Introspect the tables one by one with getTableFromDatabaseByPragmasCore(), whatever the SQLite version.
+	 * \return map<string, SQLTable> The tables, by name.
+	 */
+	std::map<std::string, SQLTable> getTablesFromDatabaseCore(const std::string& table = "", const bool& byPragmas = false) const;
+
+	/**
+	 * \brief table creation method
+	 *
+	 * Modelizes a table of the database using one PRAGMA query per table property (used with SQLite versions older than 3.16.0).
+	 *
+	 * \param table The table name to modelize.
+	 * \return The table
+	 */
+	SQLTable getTableFromDatabaseByPragmasCore(const std::string& table) const;
+
 	/**
 	 * \brief relationship parametering method
 	 *
@@ -722,10 +1623,32 @@ private :
 	 */
 	bool applyPolicyCore(const std::string& relationshipName, const std::string& relationshipPolicy, const std::vector<std::string>& linkedTables);
 
+	class ConnectionUse;	/*!< Keeps closeConnection() from closing the connection while a request run with isAtomic set to false uses it */
+
 	std::string filename;						/*!< The SQLite database file path.*/
 	std::string configurationDescriptionFile;	/*!< The configuration file path or the content of this file.*/
+	const DBSchemaDescriptor* schemaDescriptor;	/*!< The precompiled description of the database structure, used instead of configurationDescriptionFile if not NULL */
 	mutable std::mutex mut;								/*!< The mutex to lock access to the base (mutable... so changes to this attribute can be done even on a const object (locking is not changing the db) */
-	SQLite::Database* db;						/*!< The database object (actually points to a SQLite::Database underneath but we hide it so that code using this library does not also have to include SQLiteC++.h */
+	mutable SQLite::Database* db;						/*!< The database object (actually points to a SQLite::Database underneath but we hide it so that code using this library does not also have to include SQLiteC++.h */
+	std::function<void(const std::string&, unsigned long long, unsigned long long)> migrationProgressCallback;	/*!< The function to call after each chunk of rows copied during a migration */
+	std::function<bool()> migrationCancelHook;	/*!< The function to call before each chunk of rows copied during a migration, to know if it should be cancelled */
+	unsigned int migrationChunkSize;	/*!< The maximum number of rows copied at once when a table is rebuilt during a migration */
+	unsigned int readerCount;	/*!< The number of reader threads to start with the worker pool, if the database is in WAL journal mode */
+	mutable std::mutex workerPoolMut;	/*!< The mutex protecting the creation of workerPool */
+	mutable std::unique_ptr<SQLiteWorkerPool> workerPool;	/*!< The threads running asynchronous requests, started by the first one */
+	unsigned int busyTimeout;	/*!< The maximum time (in ms) spent waiting for a locked database */
+	unsigned int busyBackoff;	/*!< The first delay (in ms) waited for a locked database before retrying */
+	mutable std::atomic<unsigned long long> busyRetries;	/*!< The number of times a locked database was waited for */
+	mutable std::atomic<unsigned long long> busyWaitTime;	/*!< The total time (in us) spent waiting for a locked database */
+	mutable std::atomic<unsigned long long> busyTimeouts;	/*!< The number of times waiting for a locked database was given up */
+	std::string journalMode;	/*!< The journal mode set by the options, if any */
+	unsigned int closedFingerprint;	/*!< The schema fingerprint stored in the database when the connection was closed (see closeConnection()) */
+	int closedSchemaVersion;	/*!< The schema version of SQLite when the connection was closed (see closeConnection()), the structure was modified by other means if it changed */
+	mutable std::atomic<bool> connectionOpen;	/*!< false if db was closed by closeConnection() */
+	mutable std::atomic<unsigned long long> lastUse;	/*!< The value of the use clock when db was last used */
+	mutable std::atomic<unsigned int> connectionUsers;	/*!< The number of requests run with isAtomic set to false that are using db (see ConnectionUse) */
+	std::function<void(SQLiteDBManager&)> reopenCallback;	/*!< The function to call when the connection is opened again */
+	std::set<std::string> foreignKeysToCheck;	/*!< The joining tables whose foreign keys were not enforced while a table they reference was rebuilt (see rebuildTableCore()), they are checked before the migration is committed */
 };
 
 #endif //_SQLITE_DBMANAGER_HPP_
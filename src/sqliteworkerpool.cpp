@@ -0,0 +1,85 @@
+/*
+This file is part of libdbmanager
+(see the file COPYING in the root of the sources for a link to the
+homepage of libdbmanager)
+
+libdbmanager is a C++ library providing methods for reading/modifying a
+database using only C++ methods & objects and no SQL
+Copyright (C) 2016 Legrand SA
+
+libdbmanager is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License version 3
+(dated 29 June 2007) as published by the Free Software Foundation.
+
+libdbmanager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with libdbmanager (in the source code, it is enclosed in
+the file named "lgpl-3.0.txt" in the root of the sources).
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "sqliteworkerpool.hpp"
+
+using namespace std;
+
+SQLiteWorkerPool::SQLiteWorkerPool(const vector<SQLite::Database*>& readConnections) :
+			mut(),
+			writeJobPosted(),
+			readJobPosted(),
+			writeJobs(),
+			readJobs(),
+			stopping(false),
+			readConnections(readConnections),
+			threads() {
+
+	this->threads.emplace_back(&SQLiteWorkerPool::run, this, std::ref(this->writeJobs), std::ref(this->writeJobPosted), nullptr);
+	for (auto connection : this->readConnections) {
+		this->threads.emplace_back(&SQLiteWorkerPool::run, this, std::ref(this->readJobs), std::ref(this->readJobPosted), connection);
+	}
+}
+
+SQLiteWorkerPool::~SQLiteWorkerPool() noexcept {
+	{
+		std::lock_guard<std::mutex> lock(this->mut);
+		this->stopping = true;
+	}
+	this->writeJobPosted.notify_all();
+	this->readJobPosted.notify_all();
+	for (auto& thread : this->threads) {
+		thread.join();
+	}
+	for (auto connection : this->readConnections) {
+		delete connection;
+	}
+}
+
+void SQLiteWorkerPool::post(const Job& job, const bool& readOnly) {
+	bool toReaders = (readOnly && !this->readConnections.empty());
+	{
+		std::lock_guard<std::mutex> lock(this->mut);
+		(toReaders ? this->readJobs : this->writeJobs).push_back(job);
+	}
+	(toReaders ? this->readJobPosted : this->writeJobPosted).notify_one();
+}
+
+unsigned int SQLiteWorkerPool::getReaderCount() const {
+	return this->readConnections.size();
+}
+
+void SQLiteWorkerPool::run(deque<Job>& jobs, condition_variable& wakeUp, SQLite::Database* connection) {
+	std::unique_lock<std::mutex> lock(this->mut);
+	for (;;) {
+		wakeUp.wait(lock, [this, &jobs]() { return this->stopping || !jobs.empty(); });
+		if (jobs.empty()) {	/* Stopping, and all the jobs were run */
+			return;
+		}
+		Job job(std::move(jobs.front()));
+		jobs.pop_front();
+		lock.unlock();
+		job(connection);
+		lock.lock();
+	}
+}
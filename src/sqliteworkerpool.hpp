@@ -0,0 +1,112 @@
+/*
+This file is part of libdbmanager
+(see the file COPYING in the root of the sources for a link to the
+homepage of libdbmanager)
+
+libdbmanager is a C++ library providing methods for reading/modifying a
+database using only C++ methods & objects and no SQL
+Copyright (C) 2016 Legrand SA
+
+libdbmanager is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License version 3
+(dated 29 June 2007) as published by the Free Software Foundation.
+
+libdbmanager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with libdbmanager (in the source code, it is enclosed in
+the file named "lgpl-3.0.txt" in the root of the sources).
+If not, see <http://www.gnu.org/licenses/>.
+*/
+/**
+ *
+ * \file sqliteworkerpool.hpp
+ *
+ * \brief Header file that defines the threads running the asynchronous requests made to a SQLite database.
+ *
+ * */
+
+#ifndef _SQLITE_WORKER_POOL_HPP_
+#define _SQLITE_WORKER_POOL_HPP_
+
+//STL includes
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+//SQLiteCpp includes
+#include "SQLiteCpp/SQLiteCpp.h"
+
+/**
+ * \class SQLiteWorkerPool
+ *
+ * \brief Threads running jobs submitted to a SQLite database: one writer thread, plus one reader thread per read-only connection.
+ *
+ * Jobs are run in the order they were posted by the writer thread. Read-only jobs are run by the first available reader thread, or by the writer thread if there are no read-only connections.
+ * A job is called with the read-only connection of the reader thread running it, or with NULL on the writer thread.
+ * Jobs must not throw.
+ */
+class SQLiteWorkerPool {
+
+public:
+	typedef std::function<void(SQLite::Database*)> Job;	/*!< A job, called with the read-only connection to use (NULL on the writer thread) */
+
+	/**
+	 * \brief Constructor, starts the threads
+	 *
+	 * \param readConnections The read-only connections to the database, one for each reader thread to start. The pool takes ownership of them.
+	 */
+	explicit SQLiteWorkerPool(const std::vector<SQLite::Database*>& readConnections);
+
+	/**
+	 * \brief Destructor, runs all the jobs already posted, then stops the threads and closes the read-only connections
+	 */
+	~SQLiteWorkerPool() noexcept;
+
+	SQLiteWorkerPool(const SQLiteWorkerPool& other) = delete;
+	SQLiteWorkerPool& operator=(const SQLiteWorkerPool& other) = delete;
+
+	/**
+	 * \brief Job submission method
+	 *
+	 * \param job The job to run.
+	 * \param readOnly Set to true if the job only reads the database, so that it can be run by a reader thread.
+	 */
+	void post(const Job& job, const bool& readOnly);
+
+	/**
+	 * \brief Reader thread count getter
+	 *
+	 * \return The number of reader threads (0 if read-only jobs are run by the writer thread)
+	 */
+	unsigned int getReaderCount() const;
+
+private:
+	/**
+	 * \brief Thread main loop
+	 *
+	 * Runs the jobs of \p jobs until the pool is destroyed and \p jobs is empty.
+	 *
+	 * \param jobs The queue to take jobs from.
+	 * \param wakeUp The condition signaled when a job is added to \p jobs.
+	 * \param connection The read-only connection passed to the jobs (NULL for the writer thread).
+	 */
+	void run(std::deque<Job>& jobs, std::condition_variable& wakeUp, SQLite::Database* connection);
+
+	std::mutex mut;	/*!< The mutex protecting the queues and stopping */
+	std::condition_variable writeJobPosted;	/*!< Signaled when a job is added to writeJobs */
+	std::condition_variable readJobPosted;	/*!< Signaled when a job is added to readJobs */
+	std::deque<Job> writeJobs;	/*!< The jobs waiting for the writer thread */
+	std::deque<Job> readJobs;	/*!< The read-only jobs waiting for a reader thread */
+	bool stopping;	/*!< Set when the pool is destroyed */
+	std::vector<SQLite::Database*> readConnections;	/*!< The read-only connections, one for each reader thread */
+	std::vector<std::thread> threads;	/*!< The writer thread, followed by the reader threads */
+};
+
+#endif //_SQLITE_WORKER_POOL_HPP_
@@ -0,0 +1,370 @@
+/*
+This file is part of libdbmanager
+(see the file COPYING in the root of the sources for a link to the
+homepage of libdbmanager)
+
+libdbmanager is a C++ library providing methods for reading/modifying a
+database using only C++ methods & objects and no SQL
+Copyright (C) 2016 Legrand SA
+
+libdbmanager is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License version 3
+(dated 29 June 2007) as published by the Free Software Foundation.
+
+libdbmanager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with libdbmanager (in the source code, it is enclosed in
+the file named "lgpl-3.0.txt" in the root of the sources).
+If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "sqlschema.hpp"
+
+#include <sstream>
+#include <algorithm>
+#include <unistd.h>	/* For access() */
+
+//tinyxml includes
+#define TIXML_USE_STL	/* Fix possibly badly packaged tinyxml headers */
+#include <tinyxml.h>
+#undef TIXML_USE_STL
+
+using namespace std;
+
+/**
+ * \def SQLSCHEMA_FINGERPRINT_VERSION
+ * The version of the normalized representation of a schema used to compute its fingerprint.
+ * This must be incremented each time the way the library creates a database from its schema changes, so that existing databases are fully checked again.
+ */
+#define SQLSCHEMA_FINGERPRINT_VERSION 2
+
+/**
+ * \brief Tests if a file is readable
+ *
+ * \param filename The name (PATH) of the file to test
+ * \return true if the file is readable, false otherwise
+ */
+inline bool fileIsReadable(const std::string& filename) {
+	return (access(filename.c_str(), R_OK) == 0);
+}
+
+/**
+ * \brief Get the value of an XML attribute
+ *
+ * \param elem The XML element
+ * \param name The name of the attribute
+ * \return The value of the attribute, or an empty string if the attribute is not present
+ */
+inline string getAttribute(const TiXmlElement* elem, const char* name) {
+	const char* value = elem->Attribute(name);
+	return (value ? string(value) : string());
+}
+
+SQLSchema::SQLSchema() : tables(), defaultRecords(), relationships() {
+}
+
+bool SQLSchema::parse(const std::string& configurationDescription) {
+
+	bool validXmlContent = false;	/* Do we consider the input XML as valid ? */
+	TiXmlDocument doc;
+	/* Load the default table model base on the provided input XML definition
+	 * This XML can be provided inside a file (configurationDescription then contains the PATH to this file)
+	 * or it can be provided directly as a string buffer (configurationDescription then stores the actual XML content)
+	 */
+
+	if (fileIsReadable(configurationDescription)) { /* We first check if configurationDescription is an existing file... */
+#ifdef DEBUG
+		cout << "Reading XML database description from file " + configurationDescription << endl;
+#endif
+		doc.LoadFile(configurationDescription.c_str());
+		validXmlContent = true;
+	}
+	else { /* ...as a second chance, we try to parse configurationDescription directly as XML */
+		validXmlContent = (doc.Parse(configurationDescription.data()) == NULL);
+#ifdef DEBUG
+		if (validXmlContent) {
+			cout << "Read XML database description directly from provided buffer" << endl;
+		}
+#endif
+	}
+
+	if (!validXmlContent)
+		return false;
+
+	this->tables.clear();
+	this->defaultRecords.clear();
+	this->relationships.clear();
+
+	/*
+	 * The expect structure the configuration file is :
+	 * <database>
+	 * 	<!-- without-rowid and strict possible values : true, false (default) -->
+	 * 	<table name="..." without-rowid="..." strict="...">
+	 * 		<field name="..." default-value="..." is-not-null="..." is-unique="..." />
+	 * 		<field name="..." default-value="..." is-not-null="..." is-unique="..." />
+	 * 		<index name="..." fields="...,..." unique="..." />
+	 * 		<default-records>
+	 * 			<record>
+	 * 				<field name="..." value="..." />
+	 * 				<field name="..." value="..." />
+	 * 			</record>
+	 * 			<record>
+	 * 				<field name="..." value="..." />
+	 * 				<field name="..." value="..." />
+	 * 			</record>
+	 * 		</default-records>
+	 * 	</table>
+	 * 	<table name="...">
+	 * 		<field name="..." default-value="..." is-not-null="..." is-unique="..." />
+	 * 		<field name="..." default-value="..." is-not-null="..." is-unique="..." />
+	 * 		<index name="..." fields="...,..." unique="..." />
+	 * 		<default-records>
+	 * 			<record>
+	 * 				<field name="..." value="..." />
+	 * 				<field name="..." value="..." />
+	 * 			</record>
+	 * 			<record>
+	 * 				<field name="..." value="..." />
+	 * 				<field name="..." value="..." />
+	 * 			</record>
+	 * 		</default-records>
+	 * 	</table>
+	 * 	<!-- kind possible value : m:n -->
+	 * 	<!-- policy possible value : none, link-all -->
+	 * 	<!-- reverse-index possible value : true (default), false -->
+	 * 	<relationship kind="..." policy="..." first-table="..." second-table="..." reverse-index="..." />
+	 * 	<relationship kind="..." policy="..." first-table="..." second-table="..." reverse-index="..." />
+	 * </database>
+	 */
+	TiXmlElement *dbElem = doc.FirstChildElement();
+	if(dbElem && (string(dbElem->Value()) == "database")) {
+		//We get first "basics" tables
+		TiXmlElement *tableElem = dbElem->FirstChildElement();
+		while(tableElem) {
+			if(string(tableElem->Value()) == "table") {
+				SQLTable table(getAttribute(tableElem, "name"));
+				table.setWithoutRowid(getAttribute(tableElem, "without-rowid") == "true");
+				table.setStrict(getAttribute(tableElem, "strict") == "true");
+				TiXmlElement *fieldElem = tableElem->FirstChildElement();
+				while(fieldElem) {
+					if(string(fieldElem->Value()) == "field") {
+						string name = getAttribute(fieldElem, "name");
+						string defaultValue = getAttribute(fieldElem, "default-value");
+						bool isNotNull = (getAttribute(fieldElem, "is-not-null") == "true");
+						bool isUnique  = (getAttribute(fieldElem, "is-unique") == "true");
+						table.addField(tuple<string,string,bool,bool>(name, defaultValue, isNotNull, isUnique));
+					}
+					else if(string(fieldElem->Value()) == "index") {
+						vector<string> indexedFields;
+						stringstream ss(getAttribute(fieldElem, "fields"));
+						string indexedField;
+						while(getline(ss, indexedField, ',')) {
+							indexedField.erase(0, indexedField.find_first_not_of(" \t"));
+							indexedField.erase(indexedField.find_last_not_of(" \t") + 1);
+							if(!indexedField.empty())
+								indexedFields.push_back(indexedField);
+						}
+						bool isUnique = (getAttribute(fieldElem, "unique") == "true");
+						table.addIndex(tuple<string,vector<string>,bool>(getAttribute(fieldElem, "name"), indexedFields, isUnique));
+					}
+					else if(string(fieldElem->Value()) == "default-records") {
+						TiXmlElement *recordElem = fieldElem->FirstChildElement();
+						while(recordElem) {
+							if(string(recordElem->Value()) == "record") {
+								map<string, string> record;
+								TiXmlElement *fieldValueElem = recordElem->FirstChildElement();
+								while(fieldValueElem) {
+									if(string(fieldValueElem->Value()) == "field") {
+										record.emplace(getAttribute(fieldValueElem, "name"), getAttribute(fieldValueElem, "value"));
+									}
+									fieldValueElem = fieldValueElem->NextSiblingElement();
+								}
+								this->defaultRecords[table.getName()].push_back(record);
+							}
+							recordElem = recordElem->NextSiblingElement();
+						}
+					}
+					fieldElem = fieldElem->NextSiblingElement();
+				}
+				this->tables.push_back(table);
+			}
+			tableElem = tableElem->NextSiblingElement();
+		}
+
+		//Then we get relationships, and mark the tables they link as referenced
+		TiXmlElement *relationElem = dbElem->FirstChildElement();
+		while(relationElem) {
+			if(string(relationElem->Value()) == "relationship") {
+				SQLRelationship relationship = {
+					getAttribute(relationElem, "kind"),
+					getAttribute(relationElem, "policy"),
+					getAttribute(relationElem, "first-table"),
+					getAttribute(relationElem, "second-table"),
+					(getAttribute(relationElem, "reverse-index") != "false")	/* Reverse index is created unless explicitly disabled */
+				};
+				this->addRelationship(relationship);
+			}
+			relationElem = relationElem->NextSiblingElement();
+		}
+	}
+
+	return true;
+}
+
+bool SQLSchema::load(const DBSchemaDescriptor& descriptor) {
+
+	this->tables.clear();
+	this->defaultRecords.clear();
+	this->relationships.clear();
+
+	for(size_t i = 0; i < descriptor.tableCount; i++) {
+		const DBTableDescriptor& tableDescriptor = descriptor.tables[i];
+		if(tableDescriptor.name == NULL)
+			return false;
+		SQLTable table(tableDescriptor.name);
+		table.setWithoutRowid(tableDescriptor.withoutRowid);
+		table.setStrict(tableDescriptor.strict);
+		for(size_t j = 0; j < tableDescriptor.fieldCount; j++) {
+			const DBFieldDescriptor& field = tableDescriptor.fields[j];
+			if(field.name == NULL)
+				return false;
+			table.addField(tuple<string,string,bool,bool>(field.name, (field.defaultValue ? field.defaultValue : ""), field.isNotNull, field.isUnique));
+		}
+		for(size_t j = 0; j < tableDescriptor.indexCount; j++) {
+			const DBIndexDescriptor& index = tableDescriptor.indexes[j];
+			if(index.name == NULL)
+				return false;
+			vector<string> indexedFields;
+			for(size_t k = 0; k < index.fieldCount; k++) {
+				if(index.fields[k] == NULL)
+					return false;
+				indexedFields.push_back(index.fields[k]);
+			}
+			table.addIndex(tuple<string,vector<string>,bool>(index.name, indexedFields, index.isUnique));
+		}
+		for(size_t j = 0; j < tableDescriptor.defaultRecordCount; j++) {
+			const DBRecordDescriptor& recordDescriptor = tableDescriptor.defaultRecords[j];
+			map<string, string> record;
+			for(size_t k = 0; k < recordDescriptor.valueCount; k++) {
+				if(recordDescriptor.values[k].field == NULL)
+					return false;
+				record.emplace(recordDescriptor.values[k].field, (recordDescriptor.values[k].value ? recordDescriptor.values[k].value : ""));
+			}
+			this->defaultRecords[table.getName()].push_back(record);
+		}
+		this->tables.push_back(table);
+	}
+
+	for(size_t i = 0; i < descriptor.relationshipCount; i++) {
+		const DBRelationshipDescriptor& relationshipDescriptor = descriptor.relationships[i];
+		if(relationshipDescriptor.kind == NULL || relationshipDescriptor.firstTable == NULL || relationshipDescriptor.secondTable == NULL)
+			return false;
+		SQLRelationship relationship = {
+			relationshipDescriptor.kind,
+			(relationshipDescriptor.policy ? relationshipDescriptor.policy : ""),
+			relationshipDescriptor.firstTable,
+			relationshipDescriptor.secondTable,
+			relationshipDescriptor.reverseIndex
+		};
+		this->addRelationship(relationship);
+	}
+
+	return true;
+}
+
+void SQLSchema::addRelationship(const SQLRelationship& relationship) {
+	if(relationship.kind == "m:n") {
+		for(auto &it : this->tables) {
+			if(it.getName() == relationship.firstTable || it.getName() == relationship.secondTable) {
+				it.markReferenced();
+			}
+		}
+	}
+	this->relationships.push_back(relationship);
+}
+
+std::vector<SQLTable> SQLSchema::getTables() const {
+	return this->tables;
+}
+
+std::map<std::string, std::vector<std::map<std::string, std::string>>> SQLSchema::getDefaultRecords() const {
+	return this->defaultRecords;
+}
+
+std::vector<SQLRelationship> SQLSchema::getRelationships() const {
+	return this->relationships;
+}
+
+unsigned int SQLSchema::getFingerprint(const std::string& salt) const {
+
+	/* Build a normalized representation of the schema: tables, fields and relationships are sorted by name, and each string is prefixed by its length so that no separator can be ambiguous */
+	stringstream ss(ios_base::in | ios_base::out | ios_base::ate);
+	auto str = [&ss](const string& value) { ss << value.length() << ":" << value << ";"; };
+
+	ss << "v" << SQLSCHEMA_FINGERPRINT_VERSION << ";";
+
+	vector<SQLTable> sortedTables(this->tables);
+	sort(sortedTables.begin(), sortedTables.end(), [](const SQLTable& a, const SQLTable& b) { return a.getName() < b.getName(); });
+	for(auto &table : sortedTables) {
+		ss << "T";
+		str(table.getName());
+		ss << (table.isReferenced() ? "R" : "-") << (table.isWithoutRowid() ? "W" : "-") << (table.isStrict() ? "S" : "-");
+		vector<tuple<string, string, bool, bool>> fields = table.getFields();
+		sort(fields.begin(), fields.end());
+		for(auto &field : fields) {
+			ss << "F";
+			str(std::get<0>(field));
+			str(std::get<1>(field));
+			ss << (std::get<2>(field) ? "N" : "-") << (std::get<3>(field) ? "U" : "-");
+		}
+		vector<tuple<string, vector<string>, bool>> indexes = table.getIndexes();
+		sort(indexes.begin(), indexes.end());
+		for(auto &index : indexes) {	/* The order of the fields of an index matters */
+			ss << "X";
+			str(std::get<0>(index));
+			for(auto &it : std::get<1>(index)) {
+				str(it);
+			}
+			ss << (std::get<2>(index) ? "U" : "-");
+		}
+		map<string, vector<map<string, string>>>::const_iterator records = this->defaultRecords.find(table.getName());
+		if(records != this->defaultRecords.end()) {
+			for(auto &record : records->second) {	/* The order of default records matters, since it gives their ids */
+				ss << "D";
+				for(auto &it : record) {
+					str(it.first);
+					str(it.second);
+				}
+			}
+		}
+	}
+
+	vector<SQLRelationship> sortedRelationships(this->relationships);
+	sort(sortedRelationships.begin(), sortedRelationships.end(), [](const SQLRelationship& a, const SQLRelationship& b) {
+		return make_tuple(a.firstTable, a.secondTable, a.kind) < make_tuple(b.firstTable, b.secondTable, b.kind);
+	});
+	for(auto &relationship : sortedRelationships) {
+		ss << "L";
+		str(relationship.kind);
+		str(relationship.policy);
+		str(relationship.firstTable);
+		str(relationship.secondTable);
+		ss << (relationship.reverseIndex ? "I" : "-");
+	}
+
+	ss << "S";
+	str(salt);
+
+	/* 32-bit FNV-1a hash, truncated to 31 bits */
+	unsigned int hash = 2166136261u;
+	for(auto &c : ss.str()) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 16777619u;
+	}
+	hash &= 0x7fffffff;
+
+	return (hash != 0 ? hash : 1);	/* 0 is kept for databases that have no fingerprint yet */
+}
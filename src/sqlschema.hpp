@@ -0,0 +1,137 @@
+/*
+This file is part of libdbmanager
+(see the file COPYING in the root of the sources for a link to the
+homepage of libdbmanager)
+
+libdbmanager is a C++ library providing methods for reading/modifying a
+database using only C++ methods & objects and no SQL
+Copyright (C) 2016 Legrand SA
+
+libdbmanager is free software: you can redistribute it and/or modify
+it under the terms of the GNU Lesser General Public License version 3
+(dated 29 June 2007) as published by the Free Software Foundation.
+
+libdbmanager is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with libdbmanager (in the source code, it is enclosed in
+the file named "lgpl-3.0.txt" in the root of the sources).
+If not, see <http://www.gnu.org/licenses/>.
+*/
+/**
+ *
+ * \file sqlschema.hpp
+ *
+ * \brief Header file that defines the class that modelizes a whole database structure, as described by the XML database configuration.
+ *
+ * */
+
+#ifndef _SQLSCHEMA_HPP_
+#define _SQLSCHEMA_HPP_
+
+//STL includes
+#include <vector>
+#include <map>
+#include <string>
+
+//Project includes
+#include "sqltable.hpp"
+#include "dbschemadescriptor.hpp"
+
+/**
+ * \struct SQLRelationship
+ *
+ * \brief Modelization of a relationship between 2 SQL tables.
+ *
+ */
+struct SQLRelationship {
+	std::string kind;           /*!< The kind of relationship (only m:n relationships are handled for the moment) */
+	std::string policy;         /*!< The policy used to populate the joining table (none, link-all) */
+	std::string firstTable;     /*!< The name of the first table of the relationship */
+	std::string secondTable;    /*!< The name of the second table of the relationship */
+	bool reverseIndex;          /*!< Shall the second column of the joining table be indexed? */
+};
+
+/**
+ * \class SQLSchema
+ *
+ * \brief Class that modelizes the structure of a database: its tables, their default records and the relationships between them.
+ *
+ */
+class SQLSchema {
+
+public:
+	/**
+	 * \brief Constructor.
+	 *
+	 * Builds an empty schema.
+	 */
+	SQLSchema();
+
+	/**
+	 * \brief XML parsing method
+	 *
+	 * Loads the schema from an XML database configuration (see README.md for the expected structure).
+	 *
+	 * \param configurationDescription Either the PATH to a file containing the XML configuration, or the XML configuration itself.
+	 * \return bool true if the XML configuration could be parsed, false otherwise.
+	 */
+	bool parse(const std::string& configurationDescription);
+
+	/**
+	 * \brief Precompiled schema loading method
+	 *
+	 * Loads the schema from descriptors generated by dbmanager-schemagen, without parsing any XML.
+	 *
+	 * \param descriptor The description of the database structure.
+	 * \return bool true if the descriptors are complete (all names are set), false otherwise.
+	 */
+	bool load(const DBSchemaDescriptor& descriptor);
+
+	//Getters
+	/**
+	 * \brief tables attribute getter
+	 *
+	 * \return vector<SQLTable> The tables of the schema, in the order they were declared. Tables that are part of a relationship are marked as referenced.
+	 */
+	std::vector<SQLTable> getTables() const;
+	/**
+	 * \brief defaultRecords attribute getter
+	 *
+	 * \return map<string, vector<map<string, string>>> The records to insert in each table when it is empty.
+	 */
+	std::map<std::string, std::vector<std::map<std::string, std::string>>> getDefaultRecords() const;
+	/**
+	 * \brief relationships attribute getter
+	 *
+	 * \return vector<SQLRelationship> The relationships of the schema, in the order they were declared.
+	 */
+	std::vector<SQLRelationship> getRelationships() const;
+
+	/**
+	 * \brief Get a fingerprint of the schema
+	 *
+	 * The fingerprint is a hash of a normalized representation of the schema: it does not depend on the formatting of the XML configuration, nor on the order of fields or attributes.
+	 *
+	 * \param salt Any additional data to take into account in the hash.
+	 * \return unsigned int A non-zero 31-bit hash (so that it can be stored in a signed 32-bit integer).
+	 */
+	unsigned int getFingerprint(const std::string& salt = "") const;
+
+private:
+	/**
+	 * \brief Add a relationship to the schema, and mark the tables it links as referenced
+	 *
+	 * \param relationship The relationship to add.
+	 */
+	void addRelationship(const SQLRelationship& relationship);
+
+	std::vector<SQLTable> tables;                                                         /*!< The tables of the schema */
+	std::map<std::string, std::vector<std::map<std::string, std::string>>> defaultRecords; /*!< The default records of each table */
+	std::vector<SQLRelationship> relationships;                                           /*!< The relationships between tables */
+};
+
+#endif //_SQLSCHEMA_HPP_
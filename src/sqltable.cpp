@@ -23,12 +23,14 @@ If not, see <http://www.gnu.org/licenses/>.
 */
 #include "sqltable.hpp"
 
+#include <algorithm>
+
 using namespace std;
 
-SQLTable::SQLTable(const string& name) : name(name), fields(), referenced(false), foreignKeys() {
+SQLTable::SQLTable(const string& name) : name(name), fields(), indexes(), withoutRowid(false), strict(false), referenced(false), foreignKeys() {
 }
 
-SQLTable::SQLTable(const SQLTable& orig) : name(orig.getName()), fields(orig.fields), referenced(orig.referenced), foreignKeys(orig.foreignKeys) {
+SQLTable::SQLTable(const SQLTable& orig) : name(orig.getName()), fields(orig.fields), indexes(orig.indexes), withoutRowid(orig.withoutRowid), strict(orig.strict), referenced(orig.referenced), foreignKeys(orig.foreignKeys) {
 }
 	
 void SQLTable::setName(const string& name) {
@@ -40,7 +42,7 @@ void SQLTable::addField(const tuple<string, string, bool, bool>& field) {
 }
 
 void SQLTable::removeField(const string& name) {
-	vector<tuple<string, string, bool, bool> >::iterator toDelete;
+	vector<tuple<string, string, bool, bool> >::iterator toDelete = this->fields.end();
 	for(vector<tuple<string, string, bool, bool> >::iterator it = this->fields.begin(); it != this->fields.end(); ++it) {
 		if(get<0>(*it) == name) {
 			toDelete = it;
@@ -48,6 +50,27 @@ void SQLTable::removeField(const string& name) {
 	}
 	if(toDelete != this->fields.end())
 		this->fields.erase(toDelete);
+
+	//Indexes on this field can't exist anymore
+	for(vector<tuple<string, vector<string>, bool> >::iterator it = this->indexes.begin(); it != this->indexes.end();) {
+		if(find(get<1>(*it).begin(), get<1>(*it).end(), name) != get<1>(*it).end())
+			it = this->indexes.erase(it);
+		else
+			++it;
+	}
+}
+
+void SQLTable::addIndex(const tuple<string, vector<string>, bool>& index) {
+	this->indexes.push_back(index);
+}
+
+void SQLTable::removeIndex(const string& name) {
+	for(vector<tuple<string, vector<string>, bool> >::iterator it = this->indexes.begin(); it != this->indexes.end(); ++it) {
+		if(get<0>(*it) == name) {
+			this->indexes.erase(it);
+			return;
+		}
+	}
 }
 
 string SQLTable::getName() const {
@@ -58,6 +81,10 @@ vector<tuple<string, string, bool, bool> > SQLTable::getFields() const {
 	return this->fields;
 }
 
+vector<tuple<string, vector<string>, bool> > SQLTable::getIndexes() const {
+	return this->indexes;
+}
+
 bool SQLTable::hasColumn(const string& name) const {
 	bool result = false;
 
@@ -133,6 +160,22 @@ void SQLTable::unmarkReferenced() {
 	this->referenced = false;
 }
 
+bool SQLTable::isWithoutRowid() const {
+	return this->withoutRowid;
+}
+
+void SQLTable::setWithoutRowid(const bool& withoutRowid) {
+	this->withoutRowid = withoutRowid;
+}
+
+bool SQLTable::isStrict() const {
+	return this->strict;
+}
+
+void SQLTable::setStrict(const bool& strict) {
+	this->strict = strict;
+}
+
 map<string, pair<string , string>> SQLTable::getForeignKeys()  const {
 	return this->foreignKeys;
 }
@@ -91,6 +91,20 @@ public:
 	 * \param name The name of the field to remove from the table.
 	 */
 	void removeField(const std::string& name);
+	/**
+	 * \brief indexes attribute setter
+	 *
+	 * Allows to add an index to the table.
+	 * \param index A C++ STL tuple composed of the index name, the names of the indexed fields (in order) and a bool that sets the UNIQUE SQL property of the index.
+	 */
+	void addIndex(const std::tuple<std::string, std::vector<std::string>, bool>& index);
+	/**
+	 * \brief indexes attribute setter
+	 *
+	 * Allows to remove an index from the table.
+	 * \param name The name of the index to remove from the table.
+	 */
+	void removeIndex(const std::string& name);
 
 	//Getters
 	/**
@@ -105,6 +119,12 @@ public:
 	 * \return vector<tuple<string, string, bool, bool> > The fields attribute value.
 	 */
 	std::vector<std::tuple<std::string, std::string, bool, bool> > getFields() const;
+	/**
+	 * \brief indexes attribute getter
+	 *
+	 * \return vector<tuple<string, vector<string>, bool> > The indexes attribute value.
+	 */
+	std::vector<std::tuple<std::string, std::vector<std::string>, bool> > getIndexes() const;
 
 	//Operators
 	/**
@@ -164,6 +184,30 @@ public:
 	 * \brief Set this table as not referenced by any other
 	 */
 	void unmarkReferenced();
+	/**
+	 * \brief Shall this table be stored without rowid?
+	 *
+	 * \return bool true if the table should be created as a WITHOUT ROWID table (see SQLite documentation)
+	 */
+	bool isWithoutRowid() const;
+	/**
+	 * \brief withoutRowid attribute setter
+	 *
+	 * \param withoutRowid The new value for the withoutRowid attribute.
+	 */
+	void setWithoutRowid(const bool& withoutRowid);
+	/**
+	 * \brief Shall this table be a strict table?
+	 *
+	 * \return bool true if the table should be created as a STRICT table (see SQLite documentation)
+	 */
+	bool isStrict() const;
+	/**
+	 * \brief strict attribute setter
+	 *
+	 * \param strict The new value for the strict attribute.
+	 */
+	void setStrict(const bool& strict);
 	/**
 	 * \brief Get the list of foreign keys
 	 *
@@ -190,6 +234,9 @@ public:
 private:
 	std::string name;                                                       /*!< The name of the table.*/
 	std::vector<std::tuple<std::string, std::string, bool, bool> > fields;  /*!< The fields of the table. A field is a C++ STL tuple composed of 2 std::string and 2 bool. First string is the field name, second string is the default value for the field, first bool sets the NOT NULL SQL property of the field and second bool sets the UNIQUE SQL property of the field. */
+	std::vector<std::tuple<std::string, std::vector<std::string>, bool> > indexes; /*!< The secondary indexes of the table. An index is a C++ STL tuple composed of the index name, the names of the indexed fields and a bool that sets the UNIQUE SQL property of the index. */
+	bool withoutRowid;                                                      /*!< Shall this table be stored without rowid? */
+	bool strict;                                                            /*!< Shall this table be a strict table? */
 	bool referenced;                                                        /*!< Is this tabled referenced by another one? */
 	std::map<std::string, std::pair<std::string, std::string>> foreignKeys; /*!< A map of foreign keys. In this map, the key is the SQL field name, and the value is a pair of <referenced table name, referenced field name> */
 };
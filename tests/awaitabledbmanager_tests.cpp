@@ -0,0 +1,133 @@
+#include "dbmanagercontainer.hpp"
+#include "awaitabledbmanager.hpp"
+
+#include "common/tools.hpp"
+
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include <CppUTest/TestHarness.h>	// cpputest headers should come after all other headers to avoid compilation errors with gcc 6
+#include <CppUTest/CommandLineTestRunner.h>
+
+using namespace std;
+
+const char* progname;	/* The name under which we were called */
+
+string database_structure = "<?xml version=\"1.0\" encoding=\"utf-8\"?><database><table name=\"linked1\"><field name=\"field1\" default-value=\"\" is-not-null=\"true\" is-unique=\"true\" /></table><table name=\"linked2\"><field name=\"field1\" default-value=\"\" is-not-null=\"true\" is-unique=\"true\" /></table><relationship kind=\"m:n\" policy=\"none\" first-table=\"linked1\" second-table=\"linked2\" /></database>";
+
+/**
+ * \brief A coroutine that starts immediately, and that nobody waits for
+ */
+struct DetachedCoroutine {
+	struct promise_type {
+		DetachedCoroutine get_return_object() { return DetachedCoroutine(); }
+		std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+		std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+		void return_void() { }
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+/**
+ * \brief An executor running the functions it is given when run() is called
+ */
+class QueueExecutor {
+public:
+	QueueExecutor() : mut(), functions() { }
+
+	void post(function<void()> f) {
+		lock_guard<mutex> lock(this->mut);
+		this->functions.push_back(std::move(f));
+	}
+
+	/**
+	 * \brief Run the queued functions until \p done is ready
+	 */
+	void run(future<void>& done) {
+		while (done.wait_for(chrono::milliseconds(1)) != future_status::ready) {
+			function<void()> f;
+			{
+				lock_guard<mutex> lock(this->mut);
+				if (this->functions.empty())
+					continue;
+				f = std::move(this->functions.front());
+				this->functions.pop_front();
+			}
+			f();
+		}
+	}
+
+private:
+	mutex mut;
+	deque<function<void()>> functions;
+};
+
+DetachedCoroutine insertAndLink(AwaitableDBManager db, promise<void>& done, bool& inserted, bool& linked, size_t& linkedCount, thread::id& resumedOn) {
+	map<string, string> record1;
+	record1.emplace("field1", "value1");
+	map<string, string> record2;
+	record2.emplace("field1", "value2");
+	inserted = co_await db.insert("linked1", record1);
+	linked = co_await db.linkRecords("linked1", record1, "linked2", record2);
+	map<string, vector<map<string, string>>> linkedRecords = co_await db.getLinkedRecords("linked1", record1);
+	linkedCount = linkedRecords["linked2"].size();
+	resumedOn = this_thread::get_id();
+	done.set_value();
+}
+
+TEST_GROUP(AwaitableDBManagerTests) {
+};
+
+TEST(AwaitableDBManagerTests, resumeOnWorkerThreadTest) {
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+
+	bool inserted = false;
+	bool linked = false;
+	size_t linkedCount = 0;
+	thread::id resumedOn;
+	{
+		DBManagerContainer dbmc(database_url, database_structure);
+		promise<void> done;
+		future<void> doneFuture = done.get_future();
+		insertAndLink(AwaitableDBManager(dbmc.getDBManager()), done, inserted, linked, linkedCount, resumedOn);
+		doneFuture.wait();
+	}
+	remove(tmp_fn.c_str());
+
+	CHECK(inserted);
+	CHECK(linked);
+	CHECK_EQUAL(1, linkedCount);
+	CHECK(resumedOn != this_thread::get_id());	/* Resumed by the worker thread */
+};
+
+TEST(AwaitableDBManagerTests, resumeOnExecutorTest) {
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+
+	bool inserted = false;
+	bool linked = false;
+	size_t linkedCount = 0;
+	thread::id resumedOn;
+	{
+		DBManagerContainer dbmc(database_url, database_structure);
+		QueueExecutor executor;
+		promise<void> done;
+		future<void> doneFuture = done.get_future();
+		insertAndLink(AwaitableDBManager(dbmc.getDBManager(), [&executor](function<void()> f) { executor.post(std::move(f)); }), done, inserted, linked, linkedCount, resumedOn);
+		executor.run(doneFuture);
+	}
+	remove(tmp_fn.c_str());
+
+	CHECK(inserted);
+	CHECK(linked);
+	CHECK_EQUAL(1, linkedCount);
+	CHECK(resumedOn == this_thread::get_id());	/* Resumed by the executor, run by this thread */
+};
+
+int main(int argc, char** argv) {
+	progname = get_progname();
+	return CommandLineTestRunner::RunAllTests(argc, argv);
+}
@@ -5,6 +5,7 @@
 
 #define TEST_TABLE_NAME "unittests"
 #define DATABASE_SQLITE_TYPE "sqlite://"
+#define DATABASE_SQLITE_SHARDED_TYPE "sqlite-sharded://"
 
 /**
  * \brief Allocate a temporary filename (in the system's temporary directory) and return its name
@@ -0,0 +1,81 @@
+#include "dbmanagercontainer.hpp"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdlib>	/* For strtoul() */
+#include <stdio.h>	/* For remove() */
+
+#include "common/tools.hpp"
+
+using namespace std;
+
+/* Benchmark of the creation and destruction of DBManagerContainer objects from several threads
+ * Usage: dbfactory_benchmark [threads] [iterations per thread] [databases]
+ * Each thread creates, copies and destroys containers in a loop, in 2 scenarios:
+ * - all threads use the same database
+ * - each thread uses its own database (up to the number of databases)
+ * One container is kept alive on each database during the benchmark, so that only the factory is measured (the databases are not reopened)
+ */
+
+string database_structure = "<?xml version=\"1.0\" encoding=\"utf-8\"?><database><table name=\"unittests\"><field name=\"field1\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" /></table></database>";
+
+/**
+ * \brief Run one scenario of the benchmark
+ *
+ * \param threadCount The number of threads to run
+ * \param iterations The number of containers each thread creates (and copies)
+ * \param database_urls The databases to use, thread n uses database n modulo their number
+ * \return The number of container creations per second
+**/
+double run(unsigned int threadCount, unsigned int iterations, const vector<string>& database_urls) {
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	vector<thread> threads;
+	for(unsigned int t = 0; t < threadCount; t++) {
+		const string& database_url = database_urls.at(t % database_urls.size());
+		threads.push_back(thread([&database_url, iterations]() {
+			for(unsigned int i = 0; i < iterations; i++) {
+				DBManagerContainer dbmc(database_url);
+				DBManagerContainer dbmcCopy(dbmc);
+			}
+		}));
+	}
+	for(auto &it : threads) {
+		it.join();
+	}
+	chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+	return (2.0 * threadCount * iterations) / elapsed.count();
+}
+
+int main(int argc, char** argv) {
+
+	const char* progname = get_progname();
+	unsigned int threadCount = (argc > 1 ? strtoul(argv[1], NULL, 10) : 8);
+	unsigned int iterations = (argc > 2 ? strtoul(argv[2], NULL, 10) : 100000);
+	unsigned int databaseCount = (argc > 3 ? strtoul(argv[3], NULL, 10) : threadCount);
+	if(threadCount == 0 || databaseCount == 0) {
+		cerr << "Usage: " << progname << " [threads] [iterations per thread] [databases]\n";
+		return 2;
+	}
+
+	vector<string> tmp_fns;
+	vector<string> database_urls;
+	vector<DBManagerContainer> pinned;	/* Keep the databases open during the benchmark */
+	for(unsigned int i = 0; i < databaseCount; i++) {
+		tmp_fns.push_back(mktemp_filename(progname));
+		database_urls.push_back(DATABASE_SQLITE_TYPE + tmp_fns.back());
+		pinned.push_back(DBManagerContainer(database_urls.back(), database_structure));
+	}
+
+	cout << threadCount << " threads, " << iterations << " iterations per thread, " << databaseCount << " databases\n";
+	cout << "Same database:      " << static_cast<unsigned long>(run(threadCount, iterations, vector<string>(1, database_urls.at(0)))) << " containers/s\n";
+	cout << "Separate databases: " << static_cast<unsigned long>(run(threadCount, iterations, database_urls)) << " containers/s\n";
+
+	pinned.clear();
+	for(auto &it : tmp_fns) {
+		remove(it.c_str());
+	}
+	return 0;
+}
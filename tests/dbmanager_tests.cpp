@@ -1,6 +1,16 @@
 #include "dbfactory.hpp"
+#include "dbmanagercontainer.hpp"
+#include "sqlitedbmanager.hpp"
 
 #include "common/tools.hpp"
+#include "precompiled_schema.hpp"	/* Generated from precompiled_schema.xml by dbmanager-schemagen */
+
+#include <set>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <sqlite3.h>	/* For SQLITE_OPEN_READWRITE */
+#include <SQLiteCpp/SQLiteCpp.h>
 
 #include <CppUTest/TestHarness.h>	// cpputest headers should come after all other headers to avoid compilation errors with gcc 6
 #include <CppUTest/CommandLineTestRunner.h>
@@ -144,7 +154,11 @@ string database_structure = "<?xml version=\"1.0\" encoding=\"utf-8\"?><database
 	"<field name=\"field2\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
 	"<field name=\"field3\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
 "</table>" \
+"<table name=\"linked3\">" \
+	"<field name=\"field1\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
 "<relationship kind=\"m:n\" policy=\"link-all\" first-table=\"linked1\" second-table=\"linked2\" />" \
+"<relationship kind=\"m:n\" policy=\"none\" first-table=\"linked2\" second-table=\"linked3\" reverse-index=\"false\" />" \
 "</database>";
 
 TEST_GROUP(DBManagerMethodsTests) {
@@ -152,6 +166,285 @@ TEST_GROUP(DBManagerMethodsTests) {
 TEST_GROUP(DBManagerInputRobustnessTests) {
 };
 
+TEST(DBManagerMethodsTests, countAndPaginateLinkedRecordsTest) {
+	map<string, string> group;
+	group.emplace("field1", "page");
+	group.emplace("field2", "page");
+	group.emplace("field3", "page");
+	vector<pair<map<string, string>, map<string, string>>> pairs;
+	for(unsigned int i = 0; i < 7; i++) {
+		map<string, string> member(group);
+		member["field1"] = "page" + to_string(i);
+		pairs.push_back(make_pair(group, member));
+	}
+	if(!global_manager->linkRecords("linked1", "linked2", pairs))
+		FAIL("Linkage of records failed.");
+
+	map<string, unsigned int> counts = global_manager->countLinked("linked1", group);
+	if(counts.size() != 1 || counts["linked1_linked2"] != 7)
+		FAIL("Issue in counting linked records.");
+
+	set<string> seenIds;
+	string cursor;
+	unsigned int pages = 0;
+	while(true) {
+		vector<map<string, string>> page = global_manager->getLinkedRecords("linked1", group, "linked1_linked2", 3, cursor);
+		if(page.empty())
+			break;
+		if(page.size() > 3)
+			FAIL("Page of linked records is too big.");
+		for(auto &it : page) {
+			if(it["field1"].find("page") != 0)
+				FAIL("Unexpected linked record in page.");
+			seenIds.emplace(it["id"]);
+		}
+		cursor = page.back()["id"];
+		pages++;
+	}
+	if(pages != 3 || seenIds.size() != 7)
+		FAIL("Issue in paginating linked records.");
+
+	if(!global_manager->getLinkedRecords("linked1", group, "linked2_linked3", 3).empty())
+		FAIL("A relationship that does not involve the table should not give any record.");
+};
+
+TEST(DBManagerMethodsTests, countAndPaginateLinkedRecordsOfManyRecordsTest) {
+	/* More matching records than ids bound to one SQL statement, linked to overlapping related records */
+	map<string, string> member;
+	member.emplace("field1", "many-members");
+	if(!global_manager->insert("linked3", vector<map<string, string>>(1100, member)))
+		FAIL("Insertion of records failed.");
+	vector<pair<map<string, string>, map<string, string>>> pairs;
+	for(unsigned int i = 0; i < 5; i++) {
+		map<string, string> zone;
+		zone.emplace("field1", "many-zone" + to_string(i));
+		zone.emplace("field2", "");
+		zone.emplace("field3", "");
+		pairs.push_back(make_pair(zone, member));
+	}
+	if(!global_manager->linkRecords("linked2", "linked3", pairs))
+		FAIL("Linkage of records failed.");
+
+	map<string, unsigned int> counts = global_manager->countLinked("linked3", member);
+	if(counts["linked2_linked3"] != 5)
+		FAIL("Issue in counting records linked to many records.");
+
+	set<string> seenIds;
+	string cursor;
+	unsigned int pages = 0;
+	while(true) {
+		vector<map<string, string>> page = global_manager->getLinkedRecords("linked3", member, "linked2_linked3", 2, cursor);
+		if(page.empty())
+			break;
+		if(page.size() > 2 || (!cursor.empty() && stoll(page.front()["id"]) <= stoll(cursor)))
+			FAIL("Issue in the pages of records linked to many records.");
+		for(auto &it : page)
+			seenIds.emplace(it["id"]);
+		cursor = page.back()["id"];
+		pages++;
+	}
+	if(pages != 3 || seenIds.size() != 5)
+		FAIL("Issue in paginating records linked to many records.");
+};
+
+TEST(DBManagerMethodsTests, joiningTablesReverseIndexTest) {
+	set<string> indexes;
+	for(auto &it : global_manager->get("sqlite_master"))
+		if(it["type"] == "index")
+			indexes.emplace(it["tbl_name"] + ":" + it["sql"]);
+
+	if(indexes.find("linked1_linked2:CREATE INDEX \"linked1_linked2#reverse\" ON \"linked1_linked2\" (\"linked2#id\")") == indexes.end())
+		FAIL("Missing reverse index on joining table.");
+	for(auto &it : indexes)
+		if(it.find("linked2_linked3:CREATE INDEX") == 0)
+			FAIL("Unexpected reverse index on joining table.");
+};
+
+TEST(DBManagerMethodsTests, getMultiHopLinkedRecordsTest) {
+	map<string, string> site;
+	site.emplace("field1", "hop");
+	site.emplace("field2", "hop");
+	site.emplace("field3", "hop");
+	vector<pair<map<string, string>, map<string, string>>> level1;
+	vector<pair<map<string, string>, map<string, string>>> level2;
+	for(unsigned int i = 0; i < 2; i++) {
+		map<string, string> zone(site);
+		zone["field1"] = "hop" + to_string(i);
+		level1.push_back(make_pair(site, zone));
+		map<string, string> room;
+		room.emplace("field1", "hop" + to_string(i));
+		level2.push_back(make_pair(zone, room));
+	}
+	map<string, string> unlinkedRoom;
+	unlinkedRoom.emplace("field1", "hop-unlinked");
+	global_manager->insert("linked3", unlinkedRoom);
+
+	if(!global_manager->linkRecords("linked1", "linked2", level1) || !global_manager->linkRecords("linked2", "linked3", level2))
+		FAIL("Linkage of records failed.");
+
+	map<string, vector<map<string, string>>> linked = global_manager->getLinkedRecords("linked1", site, vector<string>({"linked2", "linked3"}));
+	if(linked.size() != 2 || linked["linked2"].size() != 2 || linked["linked3"].size() != 2)
+		FAIL("Issue in getting linked records along a path.");
+	for(auto &it : linked["linked3"])
+		if(it["field1"] != "hop0" && it["field1"] != "hop1")
+			FAIL("Unexpected record reached along a path.");
+
+	if(!global_manager->getLinkedRecords("linked1", site, vector<string>({"linked3"})).empty())
+		FAIL("A path without relationship should not give any record.");
+
+	linked = global_manager->getLinkedRecordsByDepth("linked1", site, 2);
+	if(linked.size() != 2 || linked["linked2"].size() != 2 || linked["linked3"].size() != 2)
+		FAIL("Issue in getting linked records by depth.");
+	linked = global_manager->getLinkedRecordsByDepth("linked1", site, 1);
+	if(linked.size() != 1 || linked["linked2"].size() != 2)
+		FAIL("Issue in getting directly linked records by depth.");
+	linked = global_manager->getLinkedRecordsByDepth("linked3", level2.at(0).second, 3);	/* Walk back from a room to its site, and down again to the other zone */
+	if(linked["linked1"].size() != 1 || linked["linked2"].size() != 2)
+		FAIL("Issue in getting linked records by depth in the reverse direction.");
+};
+
+TEST(DBManagerMethodsTests, getMultiHopLinkedRecordsFromManyRecordsTest) {
+	/* More matching records than ids bound to one SQL statement */
+	map<string, string> crowd;
+	crowd.emplace("field1", "crowd");
+	if(!global_manager->insert("linked3", vector<map<string, string>>(1100, crowd)))
+		FAIL("Insertion of records failed.");
+	map<string, string> zone;
+	zone.emplace("field1", "crowd-zone");
+	zone.emplace("field2", "crowd-zone");
+	zone.emplace("field3", "crowd-zone");
+	if(!global_manager->linkRecords("linked3", crowd, "linked2", zone))
+		FAIL("Linkage of records failed.");
+
+	map<string, vector<map<string, string>>> fromZone = global_manager->getLinkedRecordsByDepth("linked2", zone, 1);
+	if(fromZone["linked3"].size() != 1100)
+		FAIL("Issue in getting many linked records by depth.");
+
+	map<string, vector<map<string, string>>> linked = global_manager->getLinkedRecords("linked3", crowd, vector<string>({"linked2", "linked1"}));
+	if(linked["linked2"].size() != 1 || linked["linked1"].size() != fromZone["linked1"].size())
+		FAIL("Issue in getting linked records along a path from many records.");
+	linked = global_manager->getLinkedRecordsByDepth("linked3", crowd, 2);
+	if(linked["linked2"].size() != 1 || linked["linked1"].size() != fromZone["linked1"].size() || linked.find("linked3") != linked.end())
+		FAIL("Issue in getting linked records by depth from many records.");
+};
+
+TEST(DBManagerMethodsTests, linkAndUnlinkByIdInDatabaseTest) {
+	map<string, string> vals1;
+	vals1.emplace("field1", "byid");
+	vals1.emplace("field2", "byid");
+	vals1.emplace("field3", "byid");
+	map<string, string> vals2(vals1);
+	vals2["field1"] = "byid2";
+
+	global_manager->insert("linked1", vals1);
+	global_manager->insert("linked2", vals2);
+
+	string idLinked1;
+	for(auto &it : global_manager->get("linked1"))
+		if(it["field1"] == "byid")
+			idLinked1 = it["id"];
+	string idLinked2;
+	for(auto &it : global_manager->get("linked2"))
+		if(it["field1"] == "byid2")
+			idLinked2 = it["id"];
+
+	if(!global_manager->linkById("linked1", idLinked1, "linked2", idLinked2))
+		FAIL("Linkage of records by id failed.");
+	if(global_manager->linkById("linked1", idLinked1, "linked2", "999999"))
+		FAIL("Linkage to a record that does not exist should fail.");
+
+	map<string, vector<map<string, string>>> linked = global_manager->getLinkedRecordsById("linked1", idLinked1);
+	if(linked["linked2"].size() != 1 || linked["linked2"].at(0)["id"] != idLinked2 || linked["linked2"].at(0)["field1"] != "byid2")
+		FAIL("Issue in getting linked records by id.");
+	linked = global_manager->getLinkedRecordsById("linked2", idLinked2);
+	if(linked["linked1"].size() != 1 || linked["linked1"].at(0)["id"] != idLinked1)
+		FAIL("Issue in getting linked records by id in the reverse direction.");
+	if(global_manager->getLinkedRecords("linked1", vals1)["linked2"].size() != 1)
+		FAIL("Issue in getting linked records.");
+
+	if(!global_manager->unlinkById("linked2", idLinked2, "linked1", idLinked1))
+		FAIL("Unlinkage of records by id failed.");
+	if(global_manager->unlinkById("linked1", idLinked1, "linked2", idLinked2))
+		FAIL("Unlinkage of records that are not linked should fail.");
+	if(!global_manager->getLinkedRecordsById("linked1", idLinked1).empty())
+		FAIL("Issue in unlinkage of records by id.");
+};
+
+TEST(DBManagerMethodsTests, unlinkManyRecordsInDatabaseTest) {
+	vector<pair<map<string, string>, map<string, string>>> pairs;
+	for(unsigned int i = 0; i < 300; i++) {
+		map<string, string> vals1;
+		vals1.emplace("field1", "batch" + to_string(i % 10));
+		vals1.emplace("field2", "batch");
+		vals1.emplace("field3", "batch");
+		map<string, string> vals2;
+		vals2.emplace("field1", "batch" + to_string(i));
+		vals2.emplace("field2", "batch");
+		vals2.emplace("field3", "batch");
+		if(i % 2 == 0)	/* Only unlink half of the pairs */
+			pairs.push_back(make_pair(vals1, vals2));
+	}
+
+	if(!global_manager->unlinkRecords("linked1", "linked2", pairs))
+		FAIL("Batch unlinkage of records failed.");
+
+	unsigned int linksLeft = 0;
+	set<string> batchIds2;
+	for(auto &it : global_manager->get("linked2"))
+		if(it["field2"] == "batch")
+			batchIds2.emplace(it["id"]);
+	for(auto &it : global_manager->get("linked1_linked2"))
+		if(batchIds2.find(it["linked2#id"]) != batchIds2.end())
+			linksLeft++;
+
+	if(linksLeft != 150)
+		FAIL("Issue in batch unlinkage of records.");
+};
+
+TEST(DBManagerMethodsTests, linkManyRecordsInDatabaseTest) {
+	vector<pair<map<string, string>, map<string, string>>> pairs;
+	for(unsigned int i = 0; i < 300; i++) {	/* 10 distinct records in linked1, 300 distinct records in linked2 */
+		map<string, string> vals1;
+		vals1.emplace("field1", "batch" + to_string(i % 10));
+		vals1.emplace("field2", "batch");
+		vals1.emplace("field3", "batch");
+		map<string, string> vals2;
+		vals2.emplace("field1", "batch" + to_string(i));
+		vals2.emplace("field2", "batch");
+		vals2.emplace("field3", "batch");
+		pairs.push_back(make_pair(vals1, vals2));
+	}
+
+	if(!global_manager->linkRecords("linked1", "linked2", pairs))
+		FAIL("Batch linkage of records failed.");
+	if(!global_manager->linkRecords("linked1", "linked2", pairs))	/* Linking again pairs that are already linked is not an error */
+		FAIL("Batch linkage of records already linked failed.");
+
+	map<string, string> ids1;
+	for(auto &it : global_manager->get("linked1"))
+		if(it["field2"] == "batch")
+			ids1.emplace(it["id"], it["field1"]);
+	map<string, string> ids2;
+	for(auto &it : global_manager->get("linked2"))
+		if(it["field2"] == "batch")
+			ids2.emplace(it["id"], it["field1"]);
+	if(ids1.size() != 10 || ids2.size() != 300)
+		FAIL("Issue in batch insertion of records to link.");
+
+	unsigned int linksFound = 0;
+	for(auto &it : global_manager->get("linked1_linked2")) {
+		if(ids1.find(it["linked1#id"]) != ids1.end() && ids2.find(it["linked2#id"]) != ids2.end()) {
+			string field1 = ids2[it["linked2#id"]];	/* "batch<i>" */
+			if(ids1[it["linked1#id"]] != "batch" + to_string(atoi(field1.substr(5).c_str()) % 10))
+				FAIL("Unexpected link between records.");
+			linksFound++;
+		}
+	}
+
+	if(linksFound != 300)
+		FAIL("Issue in batch linkage of records.");
+};
+
 TEST(DBManagerMethodsTests, unlinkRecordsInDatabaseTest) {
 	map<string, string> vals1;
 	vals1.emplace("field1", "unikval7");
@@ -463,6 +756,1026 @@ TEST(DBManagerMethodsTests, getDatabaseContentTest) {
 };
 
 
+TEST(DBManagerMethodsTests, asyncRequestsTest) {
+	using namespace precompiled_schema;
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+
+	DBManager& manager = DBManagerFactory::getInstance().getDBManager(database_url, schema);
+	map<string, string> group(manager.get(tables::groups).at(0));
+	group.erase(fields::groups::id);
+	/* Writes are run in the order they were submitted */
+	vector<future<bool>> writes;
+	for (unsigned int i = 0; i < 10; i++) {
+		map<string, string> device;
+		device.emplace(fields::devices::mac, "mac" + to_string(i));
+		device.emplace(fields::devices::firmware, "1.0");	/* Records are linked by all their fields */
+		device.emplace(fields::devices::site_id, "site0");
+		writes.push_back(manager.insertAsync(tables::devices, device));
+		writes.push_back(manager.linkRecordsAsync(tables::groups, group, tables::devices, device));
+	}
+	map<string, string> device0;
+	device0.emplace(fields::devices::mac, "mac0");
+	device0.emplace(fields::devices::firmware, "1.0");
+	device0.emplace(fields::devices::site_id, "site0");
+	writes.push_back(manager.unlinkRecordsAsync(tables::groups, group, tables::devices, device0));
+	writes.push_back(manager.removeAsync(tables::devices, device0));
+	bool written = true;
+	for (auto& write : writes) {
+		written = write.get() && written;
+	}
+	/* Reads submitted after the writes completed see them */
+	size_t devices = manager.getAsync(tables::devices).get().size();
+	size_t linkedDevices = manager.getLinkedRecordsAsync(tables::groups, group).get()[tables::devices].size();
+	DBManagerFactory::getInstance().freeDBManager(database_url);
+	remove(tmp_fn.c_str());
+
+	CHECK(written);
+	CHECK_EQUAL(9, devices);
+	CHECK_EQUAL(9, linkedDevices);
+};
+
+TEST(DBManagerMethodsTests, asyncReadersTest) {
+	using namespace precompiled_schema;
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn + "?journal_mode=wal&readers=4";
+
+	/* Used as a SQLiteDBManager, so that the overloads inherited from DBManager are checked to be visible */
+	SQLiteDBManager& manager = dynamic_cast<SQLiteDBManager&>(DBManagerFactory::getInstance().getDBManager(database_url, schema));
+	vector<map<string, string>> devices;
+	for (unsigned int i = 0; i < 100; i++) {
+		map<string, string> device;
+		device.emplace(fields::devices::mac, "mac" + to_string(i));
+		device.emplace(fields::devices::site_id, "site" + to_string(i % 2));
+		devices.push_back(device);
+	}
+	bool inserted = manager.insertAsync(tables::devices, devices).get();
+	/* Reads are run by reader threads on their own connections, concurrently with the writes */
+	vector<future<vector<map<string, string>>>> reads;
+	vector<future<bool>> writes;
+	for (unsigned int i = 0; i < 20; i++) {
+		reads.push_back(manager.getAsync(tables::devices));
+		map<string, string> device;
+		device.emplace(fields::devices::mac, "new" + to_string(i));
+		device.emplace(fields::devices::site_id, "site0");
+		writes.push_back(manager.insertAsync(tables::devices, device));
+	}
+	bool consistentReads = true;
+	for (auto& read : reads) {
+		size_t count = read.get().size();
+		consistentReads = consistentReads && (count >= 100) && (count <= 120);
+	}
+	bool written = true;
+	for (auto& write : writes) {
+		written = write.get() && written;
+	}
+	vector<string> columns = {fields::devices::site_id};
+	size_t sites = manager.getAsync(tables::devices, columns, true).get().size();
+	size_t total = manager.getAsync(tables::devices).get().size();
+	DBManagerFactory::getInstance().freeDBManager(database_url);
+	remove(tmp_fn.c_str());
+	remove((tmp_fn + "-wal").c_str());
+	remove((tmp_fn + "-shm").c_str());
+
+	CHECK(inserted);
+	CHECK(consistentReads);
+	CHECK(written);
+	CHECK_EQUAL(2, sites);
+	CHECK_EQUAL(120, total);
+};
+
+TEST(DBManagerMethodsTests, snapshotTest) {
+	using namespace precompiled_schema;
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn + "?journal_mode=wal";
+
+	DBManager& manager = DBManagerFactory::getInstance().getDBManager(database_url, schema);
+	map<string, string> group(manager.get(tables::groups).at(0));
+	group.erase(fields::groups::id);
+	vector<map<string, string>> devices;
+	for (unsigned int i = 0; i < 3; i++) {
+		map<string, string> device;
+		device.emplace(fields::devices::mac, "mac" + to_string(i));
+		device.emplace(fields::devices::firmware, "1.0");
+		device.emplace(fields::devices::site_id, "site0");
+		devices.push_back(device);
+	}
+	manager.insert(tables::devices, vector<map<string, string>>({devices.at(0), devices.at(1)}));
+	manager.linkRecords(tables::groups, group, tables::devices, devices.at(0));
+
+	unique_ptr<DBSnapshot> snapshot = manager.snapshot();
+	/* Writers are not blocked by the snapshot, which does not see their writes */
+	bool inserted = manager.insert(tables::devices, devices.at(2));
+	bool linked = manager.linkRecords(tables::groups, group, tables::devices, devices.at(1));
+	unsigned long long snapshotDevices = snapshot->count(tables::devices);
+	size_t snapshotRecords = snapshot->get(tables::devices).size();
+	size_t snapshotLinkedDevices = snapshot->getLinkedRecords(tables::groups, group)[tables::devices].size();
+	unsigned int snapshotLinks = snapshot->countLinked(tables::groups, group)[string(tables::groups) + "_" + tables::devices];
+	snapshot.reset();
+	unsigned long long currentDevices = manager.count(tables::devices);
+	DBManagerFactory::getInstance().freeDBManager(database_url);
+	remove(tmp_fn.c_str());
+	remove((tmp_fn + "-wal").c_str());
+	remove((tmp_fn + "-shm").c_str());
+
+	CHECK(inserted);
+	CHECK(linked);
+	CHECK_EQUAL(2, snapshotDevices);
+	CHECK_EQUAL(2, snapshotRecords);
+	CHECK_EQUAL(1, snapshotLinkedDevices);
+	CHECK_EQUAL(1, snapshotLinks);
+	CHECK_EQUAL(3, currentDevices);
+};
+
+TEST(DBManagerMethodsTests, snapshotWithoutWalTest) {
+	using namespace precompiled_schema;
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+
+	DBManager& manager = DBManagerFactory::getInstance().getDBManager(database_url, schema);
+	map<string, string> device;
+	device.emplace(fields::devices::mac, "mac0");
+	device.emplace(fields::devices::site_id, "site0");
+
+	unique_ptr<DBSnapshot> snapshot = manager.snapshot();
+	/* Outside of WAL journal mode, the snapshot blocks writers until it is released */
+	bool blocked = !manager.insert(tables::devices, device);
+	DBManagerError error = DBManager::getLastError();
+	snapshot.reset();
+	bool inserted = manager.insert(tables::devices, device);
+	DBManagerFactory::getInstance().freeDBManager(database_url);
+	remove(tmp_fn.c_str());
+
+	CHECK(blocked);
+	CHECK(error == DBManagerError::Busy);
+	CHECK(inserted);
+};
+
+TEST(DBManagerMethodsTests, invalidDatabaseOptionsTest) {
+	using namespace precompiled_schema;
+	string tmp_fn = mktemp_filename(progname);
+
+	CHECK_THROWS(invalid_argument, DBManagerFactory::getInstance().getDBManager(DATABASE_SQLITE_TYPE + tmp_fn + "?journal_mode=none", schema));
+	CHECK_THROWS(invalid_argument, DBManagerFactory::getInstance().getDBManager(DATABASE_SQLITE_TYPE + tmp_fn + "?readers=-1", schema));
+	CHECK_THROWS(invalid_argument, DBManagerFactory::getInstance().getDBManager(DATABASE_SQLITE_TYPE + tmp_fn + "?unknown=1", schema));
+	remove(tmp_fn.c_str());
+};
+
+TEST(DBManagerMethodsTests, busyDatabaseTest) {
+	using namespace precompiled_schema;
+	string tmp_fn = mktemp_filename(progname);
+	/* The factory refuses to open a database twice, so managers are created directly to simulate several processes */
+	SQLiteDBManager impatientManager(tmp_fn, schema);
+	SQLiteDBManager patientManager(tmp_fn, schema, {{"busy_timeout", "5000"}, {"busy_backoff", "2"}});
+	DBManager& impatient = impatientManager;
+	DBManager& patient = patientManager;
+	SQLite::Database holder(tmp_fn, SQLITE_OPEN_READWRITE);
+	holder.exec("BEGIN EXCLUSIVE");	/* Another process locks the database */
+	bool impatientInserted = impatient.insert(tables::devices, map<string, string>({{fields::devices::mac, "mac0"}}));
+	DBManagerError impatientError = DBManager::getLastError();
+	map<string, vector<map<string, string>>> impatientLinked = impatient.getLinkedRecordsById(tables::groups, "1");
+	DBManagerError impatientLinkedError = DBManager::getLastError();
+	/* The error of an asynchronous request is reported with its result */
+	pair<bool, DBManagerError> impatientSubmitted = impatient.submit<bool>([&impatient](bool isAtomic) {
+		return impatient.insert(tables::devices, map<string, string>({{fields::devices::mac, "mac0"}}), isAtomic);
+	}).get();
+	/* Waits until the lock is released */
+	future<pair<bool, DBManagerError>> patientInserted = async(launch::async, [&patient]() {
+		bool inserted = patient.insert(tables::devices, map<string, string>({{fields::devices::mac, "mac1"}}));
+		return make_pair(inserted, DBManager::getLastError());
+	});
+	this_thread::sleep_for(chrono::milliseconds(50));
+	holder.exec("COMMIT");
+	pair<bool, DBManagerError> patientResult = patientInserted.get();
+	DBBusyStatistics impatientStatistics = impatient.getBusyStatistics();
+	DBBusyStatistics patientStatistics = patient.getBusyStatistics();
+	unsigned long long devices = patient.count(tables::devices);
+	remove(tmp_fn.c_str());
+
+	CHECK(!impatientInserted);
+	CHECK(impatientError == DBManagerError::Busy);
+	CHECK(impatientLinked.empty());
+	CHECK(impatientLinkedError == DBManagerError::Busy);
+	CHECK(!impatientSubmitted.first);
+	CHECK(impatientSubmitted.second == DBManagerError::Busy);
+	CHECK_EQUAL(0, impatientStatistics.retries);
+	CHECK_EQUAL(3, impatientStatistics.timeouts);
+	CHECK(patientResult.first);
+	CHECK(patientResult.second == DBManagerError::None);
+	CHECK(patientStatistics.retries > 0);
+	CHECK(patientStatistics.waitMicroseconds > 0);
+	CHECK_EQUAL(0, patientStatistics.timeouts);
+	CHECK_EQUAL(1, devices);
+};
+
+/**
+ * \brief Remove the files of a sqlite-sharded:// database
+ */
+static void remove_shards(const string& directory, const unsigned int& shards) {
+	for (unsigned int i = 0; i < shards; i++) {
+		remove((directory + "/shard-" + to_string(i) + ".sqlite").c_str());
+	}
+	remove((directory + "/shards.conf").c_str());
+	remove(directory.c_str());
+}
+
+TEST(DBManagerMethodsTests, shardedRequestsTest) {
+	using namespace precompiled_schema;
+	string tmp_dir = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_SHARDED_TYPE + tmp_dir + "?shards=4&key=" + fields::devices::mac;
+
+	DBManager& manager = DBManagerFactory::getInstance().getDBManager(database_url, schema);
+	/* Default records of tables without key field are replicated in all shards */
+	vector<map<string, string>> groups = manager.get(tables::groups);
+	map<string, string> group(groups.at(0));
+	group.erase(fields::groups::id);
+
+	vector<map<string, string>> devices;
+	for (unsigned int i = 0; i < 20; i++) {
+		map<string, string> device;
+		device.emplace(fields::devices::mac, "mac" + to_string(i));
+		device.emplace(fields::devices::firmware, "1.0");
+		device.emplace(fields::devices::site_id, "site" + to_string(i % 2));
+		devices.push_back(device);
+	}
+	bool inserted = manager.insert(tables::devices, devices);
+	/* Unkeyed requests are run by all shards */
+	size_t total = manager.get(tables::devices).size();
+	vector<string> columns = {fields::devices::site_id};
+	size_t sites = manager.get(tables::devices, columns, true).size();
+	unsigned long long site1Devices = manager.count(tables::devices, {{fields::devices::site_id, "site1"}});
+	/* Keyed requests are run by one shard */
+	unsigned long long mac3Devices = manager.count(tables::devices, {{fields::devices::mac, "mac3"}});
+	bool modified = manager.modify(tables::devices, {{fields::devices::mac, "mac3"}}, {{fields::devices::firmware, "2.0"}});
+	bool keyModified = manager.modify(tables::devices, {{fields::devices::mac, "mac3"}}, {{fields::devices::mac, "mac33"}});
+	unsigned long long upgradedDevices = manager.count(tables::devices, {{fields::devices::firmware, "2.0"}});
+
+	vector<pair<map<string, string>, map<string, string>>> pairs;
+	for (unsigned int i = 0; i < 6; i += 2) {
+		pairs.push_back(make_pair(group, devices.at(i)));
+	}
+	bool linked = manager.linkRecords(tables::groups, tables::devices, pairs);
+	bool unkeyedLinked = manager.linkRecords(tables::groups, group, tables::devices, {{fields::devices::site_id, "site1"}});
+	bool linkedById = manager.linkById(tables::groups, groups.at(0)[fields::groups::id], tables::devices, "1");
+	size_t linkedDevices = manager.getLinkedRecords(tables::groups, group)[tables::devices].size();
+	size_t linkedGroups = manager.getLinkedRecords(tables::devices, devices.at(2))[tables::groups].size();
+	unsigned int groupLinks = manager.countLinked(tables::groups, group)[string(tables::groups) + "_" + tables::devices];
+	bool removed = manager.remove(tables::devices, {{fields::devices::site_id, "site1"}});
+	unsigned long long remainingDevices = manager.count(tables::devices);
+	size_t remainingGroups = manager.get(tables::groups).size();
+	DBManagerFactory::getInstance().freeDBManager(database_url);
+
+	/* Records are spread over the shards */
+	unsigned long long maxShardDevices = 0;
+	unsigned long long shardedDevices = 0;
+	for (unsigned int i = 0; i < 4; i++) {
+		string shard_url = DATABASE_SQLITE_TYPE + tmp_dir + "/shard-" + to_string(i) + ".sqlite";
+		unsigned long long shardDevices = DBManagerFactory::getInstance().getDBManager(shard_url, schema).count(tables::devices);
+		DBManagerFactory::getInstance().freeDBManager(shard_url);
+		maxShardDevices = max(maxShardDevices, shardDevices);
+		shardedDevices += shardDevices;
+	}
+	remove_shards(tmp_dir, 4);
+
+	CHECK(inserted);
+	CHECK_EQUAL(1, groups.size());
+	CHECK_EQUAL(20, total);
+	CHECK_EQUAL(2, sites);
+	CHECK_EQUAL(10, site1Devices);
+	CHECK_EQUAL(1, mac3Devices);
+	CHECK(modified);
+	CHECK(!keyModified);
+	CHECK_EQUAL(1, upgradedDevices);
+	CHECK(linked);
+	CHECK(!unkeyedLinked);	/* The shard of the device is unknown */
+	CHECK(!linkedById);	/* Ids are not unique across shards */
+	CHECK_EQUAL(3, linkedDevices);
+	CHECK_EQUAL(1, linkedGroups);
+	CHECK_EQUAL(3, groupLinks);
+	CHECK(removed);
+	CHECK_EQUAL(10, remainingDevices);
+	CHECK_EQUAL(1, remainingGroups);
+	CHECK_EQUAL(10, shardedDevices);
+	CHECK(maxShardDevices < 10);
+};
+
+TEST(DBManagerMethodsTests, shardedSnapshotTest) {
+	using namespace precompiled_schema;
+	string tmp_dir = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_SHARDED_TYPE + tmp_dir + "?shards=3&key=" + fields::devices::mac + "&journal_mode=wal";
+
+	DBManager& manager = DBManagerFactory::getInstance().getDBManager(database_url, schema);
+	vector<map<string, string>> devices;
+	for (unsigned int i = 0; i < 10; i++) {
+		devices.push_back({{fields::devices::mac, "mac" + to_string(i)}});
+	}
+	manager.insert(tables::devices, devices);
+	unique_ptr<DBSnapshot> snapshot = manager.snapshot();
+	bool removed = manager.remove(tables::devices, {{fields::devices::firmware, "1.0"}});
+	unsigned long long snapshotDevices = snapshot->count(tables::devices);
+	unsigned long long snapshotDevice = snapshot->count(tables::devices, {{fields::devices::mac, "mac3"}});
+	snapshot.reset();
+	unsigned long long currentDevices = manager.count(tables::devices);
+	DBManagerFactory::getInstance().freeDBManager(database_url);
+	for (unsigned int i = 0; i < 3; i++) {
+		remove((tmp_dir + "/shard-" + to_string(i) + ".sqlite-wal").c_str());
+		remove((tmp_dir + "/shard-" + to_string(i) + ".sqlite-shm").c_str());
+	}
+	remove_shards(tmp_dir, 3);
+
+	CHECK(removed);
+	CHECK_EQUAL(10, snapshotDevices);
+	CHECK_EQUAL(1, snapshotDevice);
+	CHECK_EQUAL(0, currentDevices);
+};
+
+TEST(DBManagerMethodsTests, invalidShardingOptionsTest) {
+	using namespace precompiled_schema;
+	string tmp_dir = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_SHARDED_TYPE + tmp_dir + "?shards=2&key=" + fields::devices::mac;
+
+	CHECK_THROWS(invalid_argument, DBManagerFactory::getInstance().getDBManager(DATABASE_SQLITE_SHARDED_TYPE + tmp_dir + "?shards=2", schema));
+	CHECK_THROWS(invalid_argument, DBManagerFactory::getInstance().getDBManager(DATABASE_SQLITE_SHARDED_TYPE + tmp_dir + "?shards=0&key=" + fields::devices::mac, schema));
+	DBManagerFactory::getInstance().getDBManager(database_url, schema);
+	DBManagerFactory::getInstance().freeDBManager(database_url);
+	/* Records can't be found anymore if the sharding parameters change */
+	CHECK_THROWS(invalid_argument, DBManagerFactory::getInstance().getDBManager(DATABASE_SQLITE_SHARDED_TYPE + tmp_dir + "?shards=3&key=" + fields::devices::mac, schema));
+	remove_shards(tmp_dir, 2);
+};
+
+TEST(DBManagerMethodsTests, maxOpenDatabasesTest) {
+	using namespace precompiled_schema;
+	DBManagerFactory& factory = DBManagerFactory::getInstance();
+	factory.setMaxOpenDatabases(2);
+	vector<string> tmp_fns;
+	vector<string> database_urls;
+	bool inserted = true;
+	for (unsigned int i = 0; i < 4; i++) {
+		tmp_fns.push_back(mktemp_filename(progname));
+		database_urls.push_back(DATABASE_SQLITE_TYPE + tmp_fns.back());
+		DBManager& manager = factory.getDBManager(database_urls.back(), schema);
+		inserted = inserted && manager.insert(tables::devices, map<string, string>({{fields::devices::mac, "mac" + to_string(i)}}));
+	}
+	unsigned int openDatabases = 0;
+	for (auto &database_url : database_urls) {
+		if (dynamic_cast<SQLiteDBManager&>(factory.getDBManager(database_url)).isConnectionOpen())
+			openDatabases++;
+		factory.freeDBManager(database_url);
+	}
+	/* The least recently used database was closed, it is opened again on its next use */
+	SQLiteDBManager& first = dynamic_cast<SQLiteDBManager&>(factory.getDBManager(database_urls.front()));
+	bool firstWasOpen = first.isConnectionOpen();
+	vector<map<string, string>> devices = first.get(tables::devices);
+	bool firstIsOpen = first.isConnectionOpen();
+	factory.freeDBManager(database_urls.front());
+
+	factory.setMaxOpenDatabases(0);
+	for (unsigned int i = 0; i < 4; i++) {
+		factory.freeDBManager(database_urls[i]);
+		remove(tmp_fns[i].c_str());
+	}
+
+	CHECK(inserted);
+	CHECK_EQUAL(2, openDatabases);
+	CHECK(!firstWasOpen);
+	CHECK(firstIsOpen);
+	CHECK_EQUAL(1, devices.size());
+	CHECK_EQUAL("mac0", devices.at(0).at(fields::devices::mac));
+};
+
+TEST(DBManagerMethodsTests, nonAtomicReadsDuringEvictionTest) {
+	using namespace precompiled_schema;
+	DBManagerFactory& factory = DBManagerFactory::getInstance();
+	factory.setMaxOpenDatabases(1);
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+	SQLiteDBManager& manager = dynamic_cast<SQLiteDBManager&>(factory.getDBManager(database_url, schema));
+	bool inserted = factory.getDBManager(database_url).insert(tables::devices, map<string, string>({{fields::devices::mac, "mac"}}));
+	factory.freeDBManager(database_url);
+
+	/* Requests run with isAtomic set to false don't lock the manager: its connection must not be closed under them */
+	future<unsigned int> reads = async(launch::async, [&manager]() {
+		unsigned int found = 0;
+		for (unsigned int i = 0; i < 500; i++) {
+			if (manager.get(tables::devices, vector<string>(), false, false).size() == 1)
+				found++;
+		}
+		return found;
+	});
+	while (reads.wait_for(chrono::milliseconds(0)) != future_status::ready) {
+		manager.closeConnection();	/* Fails while a read is running, the next read opens the connection again otherwise */
+		factory.setMaxOpenDatabases(1);	/* Closes the least recently used connections */
+	}
+	unsigned int found = reads.get();
+	bool closedAfterReads = manager.closeConnection();
+	size_t devices = manager.get(tables::devices).size();
+
+	factory.setMaxOpenDatabases(0);
+	factory.freeDBManager(database_url);
+	remove(tmp_fn.c_str());
+
+	CHECK(inserted);
+	CHECK_EQUAL(500, found);
+	CHECK(closedAfterReads);
+	CHECK_EQUAL(1, devices);
+};
+
+TEST_GROUP(DBManagerMigrationTests) {
+};
+
+string migration_structure_v1 = "<?xml version=\"1.0\" encoding=\"utf-8\"?><database>" \
+"<table name=\"devices\">" \
+	"<field name=\"mac\" default-value=\"\" is-not-null=\"true\" is-unique=\"true\" />" \
+	"<field name=\"firmware\" default-value=\"1.0\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<table name=\"groups\">" \
+	"<field name=\"label\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<relationship kind=\"m:n\" policy=\"none\" first-table=\"groups\" second-table=\"devices\" />" \
+"</database>";
+
+/**
+ * \brief Create a database using migration_structure_v1, fill it, then reopen it with another structure
+ *
+ * \param tmp_fn The database file to use
+ * \param structure_v2 The database structure to migrate to
+ * \param expectedDeviceValues Values that all records of table devices should have after the migration
+ * \return true if the records and links created with the first structure were all found after the migration
+**/
+bool fillAndMigrate(const string& tmp_fn, const string& structure_v2, const map<string, string>& expectedDeviceValues = map<string, string>()) {
+
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+	{
+		DBManagerContainer dbmc(database_url, migration_structure_v1);
+		vector<pair<map<string, string>, map<string, string>>> pairs;
+		for(unsigned int i = 0; i < 20; i++) {
+			map<string, string> group;
+			group.emplace("label", "group" + to_string(i % 4));
+			map<string, string> device;
+			device.emplace("mac", "mac" + to_string(i));
+			pairs.push_back(make_pair(group, device));
+		}
+		if(!dbmc.getDBManager().linkRecords("groups", "devices", pairs))
+			return false;
+	}
+
+	DBManagerContainer dbmc(database_url, structure_v2);
+	DBManager& manager = dbmc.getDBManager();
+	if(manager.get("devices").size() != 20 || manager.get("groups").size() != 4 || manager.get("groups_devices").size() != 20)
+		return false;
+	for(auto &device : manager.get("devices"))
+		for(auto &it : expectedDeviceValues)
+			if(device.find(it.first) == device.end() || device[it.first] != it.second)
+				return false;
+	for(unsigned int i = 0; i < 4; i++) {
+		map<string, string> group;
+		group.emplace("label", "group" + to_string(i));
+		for(auto &it : manager.get("groups"))
+			if(it["label"] == group["label"])
+				group = it;
+		group.erase("id");
+		if(manager.countLinked("groups", group)["groups_devices"] != 5)
+			return false;
+	}
+	return true;
+}
+
+TEST(DBManagerMigrationTests, precompiledSchemaTest) {
+	using namespace precompiled_schema;
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+
+	/* A database created from the generated header has the structure described by the XML configuration it was generated from */
+	DBManager& manager = DBManagerFactory::getInstance().getDBManager(database_url, schema);
+	vector<map<string, string>> groups = manager.get(tables::groups);
+	bool defaultRecords = (groups.size() == 1) && (groups.at(0)[fields::groups::label] == "all \"devices\"") && (groups.at(0)[fields::groups::class_] == "system");
+	map<string, string> device;
+	device.emplace(fields::devices::mac, "mac0");
+	device.emplace(fields::devices::site_id, "site0");
+	map<string, string> group(groups.at(0));
+	group.erase(fields::groups::id);
+	bool linked = manager.linkRecords(tables::groups, group, tables::devices, device);
+	vector<DBMigrationOperation> plan = manager.planMigration(PRECOMPILED_SCHEMA_XML);
+	DBManagerFactory::getInstance().freeDBManager(database_url);
+	remove(tmp_fn.c_str());
+
+	CHECK(defaultRecords);
+	CHECK(linked);
+	CHECK(plan.empty());	/* Nothing to migrate, the fingerprints of both descriptions are the same */
+};
+
+TEST(DBManagerMigrationTests, cancelAndReportMigrationProgressTest) {
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+	/* Removing the unique field mac requires rebuilding table devices, its joining table is left untouched */
+	string structure_v2 = "<?xml version=\"1.0\" encoding=\"utf-8\"?><database>" \
+"<table name=\"devices\">" \
+	"<field name=\"firmware\" default-value=\"1.0\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<table name=\"groups\">" \
+	"<field name=\"label\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<relationship kind=\"m:n\" policy=\"none\" first-table=\"groups\" second-table=\"devices\" />" \
+"</database>";
+
+	DBManagerContainer dbmc(database_url, migration_structure_v1);
+	DBManager& manager = dbmc.getDBManager();
+	vector<pair<map<string, string>, map<string, string>>> pairs;
+	for(unsigned int i = 0; i < 20; i++) {
+		map<string, string> group;
+		group.emplace("label", "group" + to_string(i % 4));
+		map<string, string> device;
+		device.emplace("mac", "mac" + to_string(i));
+		pairs.push_back(make_pair(group, device));
+	}
+	CHECK(manager.linkRecords("groups", "devices", pairs));
+
+	/* A cancelled migration is rolled back */
+	manager.setMigrationCancelHook([]() { return true; });
+	manager.setDatabaseConfigurationFile(structure_v2);
+	bool cancelled = !manager.checkDefaultTables();
+	vector<map<string, string>> devices = manager.get("devices");
+	bool rolledBack = (devices.size() == 20) && (devices.at(0).find("mac") != devices.at(0).end()) && (manager.get("groups_devices").size() == 20);
+
+	/* Progress is only reported for the rebuilt table, the ids of its records and their links are kept */
+	vector<map<string, string>> devicesBefore = manager.get("devices", vector<string>({"id", "firmware"}));
+	vector<map<string, string>> linksBefore = manager.get("groups_devices");
+	map<string, pair<unsigned long long, unsigned long long>> progress;
+	unsigned int calls = 0;
+	manager.setMigrationCancelHook(std::function<bool()>());
+	manager.setMigrationProgressCallback([&progress, &calls](const string& table, unsigned long long done, unsigned long long total) {
+		progress[table] = make_pair(done, total);
+		calls++;
+	});
+	bool migrated = manager.checkDefaultTables();
+	manager.setMigrationProgressCallback(std::function<void(const string&, unsigned long long, unsigned long long)>());
+	devices = manager.get("devices");
+	migrated = migrated && (devices.size() == 20) && (devices.at(0).find("mac") == devices.at(0).end()) && (manager.get("groups_devices").size() == 20);
+	bool kept = (manager.get("devices", vector<string>({"id", "firmware"})) == devicesBefore) && (manager.get("groups_devices") == linksBefore);
+	/* Foreign keys are enforced again once the migration is over */
+	bool enforced = !manager.linkById("groups", linksBefore.at(0)["groups#id"], "devices", "12345");
+	remove(tmp_fn.c_str());
+
+	CHECK(cancelled);
+	CHECK(rolledBack);
+	CHECK(migrated);
+	CHECK(kept);
+	CHECK(enforced);
+	CHECK_EQUAL(1, calls);
+	CHECK(progress["devices"] == make_pair(20ULL, 20ULL));
+	CHECK(progress.find("groups_devices") == progress.end());
+};
+
+TEST(DBManagerMigrationTests, migrationChunksTest) {
+	string tmp_fn = mktemp_filename(progname);
+	/* Removing the unique field mac requires rebuilding table devices */
+	string structure_v2 = "<?xml version=\"1.0\" encoding=\"utf-8\"?><database>" \
+"<table name=\"devices\">" \
+	"<field name=\"firmware\" default-value=\"1.0\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<table name=\"groups\">" \
+	"<field name=\"label\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<relationship kind=\"m:n\" policy=\"none\" first-table=\"groups\" second-table=\"devices\" />" \
+"</database>";
+
+	SQLiteDBManager sqliteManager(tmp_fn, migration_structure_v1, {{"migration_chunk_size", "7"}});
+	DBManager& manager = sqliteManager;
+	bool invalidRejected = !sqliteManager.setMigrationChunkSize(0);
+	/* All devices are in group "all", the first 5 ones are also in group "some": 20 of the 25 links share the same first key in the joining table */
+	vector<pair<map<string, string>, map<string, string>>> pairs;
+	for(unsigned int i = 0; i < 20; i++) {
+		map<string, string> device;
+		device.emplace("mac", "mac" + to_string(i));
+		map<string, string> group;
+		group.emplace("label", "all");
+		pairs.push_back(make_pair(group, device));
+		if(i < 5) {
+			group["label"] = "some";
+			pairs.push_back(make_pair(group, device));
+		}
+	}
+	CHECK(manager.linkRecords("groups", "devices", pairs));
+	vector<map<string, string>> linksBefore = manager.get("groups_devices");
+
+	vector<tuple<string, unsigned long long, unsigned long long>> progress;
+	manager.setMigrationProgressCallback([&progress](const string& table, unsigned long long done, unsigned long long total) {
+		progress.push_back(make_tuple(table, done, total));
+	});
+
+	/* The migration is cancelled between the first and the second chunk of devices */
+	unsigned int chunks = 0;
+	manager.setMigrationCancelHook([&chunks]() { return (++chunks > 1); });
+	manager.setDatabaseConfigurationFile(structure_v2);
+	bool cancelled = !manager.checkDefaultTables();
+	vector<tuple<string, unsigned long long, unsigned long long>> cancelledProgress(progress);
+	vector<map<string, string>> devices = manager.get("devices");
+	bool rolledBack = (devices.size() == 20) && (devices.at(0).find("mac") != devices.at(0).end());
+
+	/* Without foreign keys suspended, the joining table is moved aside and back: its 20 links with the same first key are copied in one chunk */
+	progress.clear();
+	manager.setMigrationCancelHook(std::function<bool()>());
+	bool migrated = manager.checkDefaultTables(false);
+	devices = manager.get("devices");
+	migrated = migrated && (devices.size() == 20) && (devices.at(0).find("mac") == devices.at(0).end());
+	bool kept = (manager.get("groups_devices") == linksBefore);
+	remove(tmp_fn.c_str());
+
+	CHECK(invalidRejected);
+	CHECK(cancelled);
+	CHECK(rolledBack);
+	CHECK_EQUAL(1, cancelledProgress.size());
+	CHECK(cancelledProgress.at(0) == make_tuple(string("devices"), 7ULL, 20ULL));
+	CHECK(migrated);
+	CHECK(kept);
+	vector<tuple<string, unsigned long long, unsigned long long>> expectedProgress({
+		make_tuple(string("groups_devices"), 20ULL, 25ULL),	/* Chunks end at a key boundary */
+		make_tuple(string("groups_devices"), 25ULL, 25ULL),
+		make_tuple(string("devices"), 7ULL, 20ULL),
+		make_tuple(string("devices"), 14ULL, 20ULL),
+		make_tuple(string("devices"), 20ULL, 20ULL),
+		make_tuple(string("groups_devices"), 7ULL, 25ULL),	/* The saved copy has no primary key, it is copied back in rowid order */
+		make_tuple(string("groups_devices"), 14ULL, 25ULL),
+		make_tuple(string("groups_devices"), 21ULL, 25ULL),
+		make_tuple(string("groups_devices"), 25ULL, 25ULL)
+	});
+	CHECK(progress == expectedProgress);
+};
+
+TEST(DBManagerMigrationTests, tableStorageOptionsTest) {
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+	string structure_end = ">" \
+	"<field name=\"key\" default-value=\"\" is-not-null=\"true\" is-unique=\"true\" />" \
+	"<field name=\"value\" default-value=\"\" is-not-null=\"false\" is-unique=\"false\" />" \
+"</table>" \
+"</database>";
+	string structure_kv = "<?xml version=\"1.0\" encoding=\"utf-8\"?><database><table name=\"settings\" without-rowid=\"true\" strict=\"true\"" + structure_end;
+	string structure_plain = "<?xml version=\"1.0\" encoding=\"utf-8\"?><database><table name=\"settings\"" + structure_end;
+
+	bool stored = false;
+	bool planned = false;
+	bool migrated = false;
+	{
+		DBManagerContainer dbmc(database_url, structure_kv);
+		DBManager& manager = dbmc.getDBManager();
+		map<string, string> setting;
+		setting.emplace("key", "timeout");
+		setting.emplace("value", "30");
+		map<string, string> refFields;
+		refFields.emplace("key", "timeout");
+		map<string, string> values;
+		values.emplace("value", "60");
+		stored = manager.insert("settings", setting) && !manager.insert("settings", setting) && manager.modify("settings", refFields, values, false);
+		vector<map<string, string>> settings = manager.get("settings");
+		stored = stored && (settings.size() == 1) && (settings.at(0)["value"] == "60");
+
+		vector<DBMigrationOperation> plan = manager.planMigration(structure_plain);
+		planned = (plan.size() == 1 && plan.at(0).operation == "rebuild-table" && plan.at(0).rows == 1);
+	}
+	{	/* Going back to a regular table rebuilds it */
+		DBManagerContainer dbmc(database_url, structure_plain);
+		vector<map<string, string>> settings = dbmc.getDBManager().get("settings");
+		migrated = (settings.size() == 1) && (settings.at(0)["key"] == "timeout") && (settings.at(0)["value"] == "60");
+		migrated = migrated && dbmc.getDBManager().planMigration(structure_plain).empty();
+	}
+	remove(tmp_fn.c_str());
+
+	CHECK(stored);
+	CHECK(planned);
+	CHECK(migrated);
+};
+
+TEST(DBManagerMigrationTests, secondaryIndexesTest) {
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+	string structure_begin = "<?xml version=\"1.0\" encoding=\"utf-8\"?><database>" \
+"<table name=\"devices\">";
+	string structure_end = "<field name=\"firmware\" default-value=\"1.0\" is-not-null=\"true\" is-unique=\"false\" />" \
+	"<field name=\"model\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />";
+	string structure_index = "<index name=\"devices_firmware_model\" fields=\"firmware, model\" unique=\"true\" />";
+	string structure_tail = "</table>" \
+"<table name=\"groups\">" \
+	"<field name=\"label\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<relationship kind=\"m:n\" policy=\"none\" first-table=\"groups\" second-table=\"devices\" />" \
+"</database>";
+	string mac_field = "<field name=\"mac\" default-value=\"\" is-not-null=\"true\" is-unique=\"true\" />";
+
+	map<string, string> device1;
+	device1.emplace("model", "a");
+	map<string, string> device2(device1);
+	device1.emplace("mac", "mac1");
+	device2.emplace("mac", "mac2");
+
+	bool created = false;
+	bool rebuilt = false;
+	bool dropped = false;
+	bool planned = false;
+	{	/* The unique index is created with the table */
+		DBManagerContainer dbmc(database_url, structure_begin + mac_field + structure_end + structure_index + structure_tail);
+		created = dbmc.getDBManager().insert("devices", device1) && !dbmc.getDBManager().insert("devices", device2);
+	}
+	{	/* Removing the unique field mac requires a table rebuild, the index must survive it */
+		DBManagerContainer dbmc(database_url, structure_begin + structure_end + structure_index + structure_tail);
+		map<string, string> device;
+		device.emplace("model", "a");
+		rebuilt = (dbmc.getDBManager().get("devices").size() == 1) && !dbmc.getDBManager().insert("devices", device);
+
+		vector<DBMigrationOperation> plan = dbmc.getDBManager().planMigration(structure_begin + structure_end + structure_tail);
+		planned = (plan.size() == 1 && plan.at(0).operation == "drop-index" && plan.at(0).fields == vector<string>({"firmware", "model"}));
+	}
+	{	/* The index is dropped when it is removed from the description */
+		DBManagerContainer dbmc(database_url, structure_begin + structure_end + structure_tail);
+		map<string, string> device;
+		device.emplace("model", "a");
+		dropped = dbmc.getDBManager().insert("devices", device);
+	}
+	remove(tmp_fn.c_str());
+
+	CHECK(created);
+	CHECK(rebuilt);
+	CHECK(planned);
+	CHECK(dropped);
+};
+
+TEST(DBManagerMigrationTests, introspectionMatchesPragmasTest) {
+	string tmp_fn = mktemp_filename(progname);
+	string structure = "<?xml version=\"1.0\" encoding=\"utf-8\"?><database>" \
+"<table name=\"devices\">" \
+	"<field name=\"mac\" default-value=\"\" is-not-null=\"true\" is-unique=\"true\" />" \
+	"<field name=\"firmware\" default-value=\"1.0\" is-not-null=\"true\" is-unique=\"false\" />" \
+	"<field name=\"model\" default-value=\"\" is-not-null=\"false\" is-unique=\"false\" />" \
+	"<index name=\"devices_firmware_model\" fields=\"firmware, model\" unique=\"true\" />" \
+	"<index name=\"devices_model\" fields=\"model\" unique=\"false\" />" \
+"</table>" \
+"<table name=\"groups\">" \
+	"<field name=\"label\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<table name=\"settings\" without-rowid=\"true\" strict=\"true\">" \
+	"<field name=\"key\" default-value=\"\" is-not-null=\"true\" is-unique=\"true\" />" \
+	"<field name=\"value\" default-value=\"\" is-not-null=\"false\" is-unique=\"false\" />" \
+"</table>" \
+"<relationship kind=\"m:n\" policy=\"none\" first-table=\"groups\" second-table=\"devices\" />" \
+"</database>";
+
+	/* All tables introspected at once must match the ones introspected one by one with pragmas (which is the fallback for old versions of SQLite) */
+	map<string, SQLTable> tablesInDb;
+	map<string, SQLTable> tablesByPragmas;
+	{
+		SQLiteDBManager manager(tmp_fn, structure);
+		tablesInDb = manager.getTablesFromDatabase();
+		tablesByPragmas = manager.getTablesFromDatabase(true);
+	}
+	remove(tmp_fn.c_str());
+
+	CHECK_EQUAL(tablesByPragmas.size(), tablesInDb.size());
+	for(auto &it : tablesByPragmas) {
+		map<string, SQLTable>::const_iterator table = tablesInDb.find(it.first);
+		CHECK(table != tablesInDb.end());
+		if(table == tablesInDb.end())
+			continue;
+		CHECK(it.second.getFields() == table->second.getFields());
+		CHECK(it.second.getIndexes() == table->second.getIndexes());
+		CHECK_EQUAL(it.second.isReferenced(), table->second.isReferenced());
+		CHECK_EQUAL(it.second.isWithoutRowid(), table->second.isWithoutRowid());
+		CHECK_EQUAL(it.second.isStrict(), table->second.isStrict());
+	}
+	CHECK(tablesInDb.at("devices").isReferenced());
+	CHECK_EQUAL(2, tablesInDb.at("devices").getIndexes().size());
+	CHECK(tablesInDb.at("settings").isWithoutRowid());
+	CHECK(tablesInDb.at("settings").isStrict());
+	CHECK(!tablesInDb.at("groups").isWithoutRowid());
+};
+
+TEST(DBManagerMigrationTests, planMigrationTest) {
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+
+	DBManagerContainer dbmc(database_url, migration_structure_v1);
+	DBManager& manager = dbmc.getDBManager();
+	vector<pair<map<string, string>, map<string, string>>> pairs;
+	for(unsigned int i = 0; i < 20; i++) {
+		map<string, string> group;
+		group.emplace("label", "group" + to_string(i % 4));
+		map<string, string> device;
+		device.emplace("mac", "mac" + to_string(i));
+		pairs.push_back(make_pair(group, device));
+	}
+	CHECK(manager.linkRecords("groups", "devices", pairs));
+
+	CHECK(manager.planMigration(migration_structure_v1).empty());
+
+	string migration_structure_v2 = "<?xml version=\"1.0\" encoding=\"utf-8\"?><database>" \
+"<table name=\"devices\">" \
+	"<field name=\"firmware\" default-value=\"1.0\" is-not-null=\"true\" is-unique=\"false\" />" \
+	"<field name=\"model\" default-value=\"unknown\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<table name=\"groups\">" \
+	"<field name=\"label\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<table name=\"sites\">" \
+	"<field name=\"name\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
+	"<default-records>" \
+		"<record><field name=\"name\" value=\"site1\" /></record>" \
+		"<record><field name=\"name\" value=\"site2\" /></record>" \
+	"</default-records>" \
+"</table>" \
+"<relationship kind=\"m:n\" policy=\"none\" first-table=\"groups\" second-table=\"devices\" />" \
+"</database>";
+	vector<DBMigrationOperation> plan = manager.planMigration(migration_structure_v2);
+	vector<DBMigrationOperation> planWithForeignKeys = manager.planMigration(migration_structure_v2, false);	/* A non atomic migration runs with foreign keys enabled */
+
+	/* Since the database was not modified, it can be checked before removing the file */
+	size_t devicesCount = manager.get("devices").size();
+	bool tableCreated = false;
+	for(auto &it : manager.listTables())
+		tableCreated = tableCreated || (it == "sites");
+	remove(tmp_fn.c_str());
+
+	CHECK_EQUAL(20, devicesCount);
+	CHECK(!tableCreated);
+	CHECK_EQUAL(4, plan.size());
+	CHECK_EQUAL("add-columns", plan.at(0).operation);
+	CHECK_EQUAL("devices", plan.at(0).table);
+	CHECK(plan.at(0).fields == vector<string>({"model"}));
+	CHECK_EQUAL(0, plan.at(0).rows);
+	CHECK_EQUAL("rebuild-table", plan.at(1).operation);	/* mac is unique, so it can't be dropped in place */
+	CHECK(plan.at(1).fields == vector<string>({"mac"}));
+	CHECK_EQUAL(20, plan.at(1).rows);	/* 20 devices, their links are left untouched */
+	CHECK_EQUAL("create-table", plan.at(2).operation);
+	CHECK_EQUAL("sites", plan.at(2).table);
+	CHECK_EQUAL("insert-default-records", plan.at(3).operation);
+	CHECK_EQUAL("sites", plan.at(3).table);
+	CHECK_EQUAL(2, plan.at(3).rows);
+	CHECK_EQUAL(4, planWithForeignKeys.size());
+	CHECK_EQUAL("rebuild-table", planWithForeignKeys.at(1).operation);
+	CHECK_EQUAL(60, planWithForeignKeys.at(1).rows);	/* 20 devices, and their 20 links moved aside and back */
+};
+
+TEST(DBManagerMigrationTests, unchangedSchemaFingerprintTest) {
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+
+	bool migrated = fillAndMigrate(tmp_fn, migration_structure_v1);	/* Reopening with the same structure takes the fast path */
+	bool handmadeKept = false;
+	bool handmadeReconciled = false;
+	bool modifiedReconciled = false;
+	if(migrated) {
+		/* A column that is not described in the XML is added by hand, and the schema version of SQLite is restored, so the fingerprint still matches: the full check is skipped, and the column is kept */
+		SQLite::Database database(tmp_fn, SQLITE_OPEN_READWRITE);
+		SQLite::Statement query(database, "PRAGMA schema_version");
+		int schemaVersion = query.executeStep() ? query.getColumn(0).getInt() : 0;
+		query.reset();
+		database.exec("ALTER TABLE \"devices\" ADD COLUMN \"handmade\" TEXT DEFAULT 'kept'");
+		database.exec("PRAGMA schema_version = " + to_string(schemaVersion));
+	}
+	if(migrated) {
+		DBManagerContainer dbmc(database_url, migration_structure_v1);
+		DBManager& manager = dbmc.getDBManager();
+		vector<map<string, string>> devices = manager.get("devices");
+		handmadeKept = !devices.empty() && devices.at(0)["handmade"] == "kept";	/* The structure was not reconciled */
+		if(!manager.checkDefaultTables(true, true))	/* A full check can still be forced */
+			migrated = false;
+		devices = manager.get("devices");
+		handmadeReconciled = !devices.empty() && devices.at(0).find("handmade") == devices.at(0).end();
+		if(devices.size() != 20 || manager.get("groups_devices").size() != 20)
+			migrated = false;
+	}
+	if(migrated) {
+		/* Any other modification of the structure invalidates the fingerprint */
+		{
+			SQLite::Database database(tmp_fn, SQLITE_OPEN_READWRITE);
+			database.exec("ALTER TABLE \"devices\" ADD COLUMN \"handmade\" TEXT DEFAULT 'kept'");
+		}
+		DBManagerContainer dbmc(database_url, migration_structure_v1);
+		vector<map<string, string>> devices = dbmc.getDBManager().get("devices");
+		modifiedReconciled = !devices.empty() && devices.at(0).find("handmade") == devices.at(0).end();
+	}
+	remove(tmp_fn.c_str());
+	if(!migrated)
+		FAIL("Records or links were lost when reopening a database with an unchanged structure.");
+	CHECK(handmadeKept);
+	CHECK(handmadeReconciled);
+	CHECK(modifiedReconciled);
+};
+
+TEST(DBManagerMigrationTests, reopenedSchemaChangeTest) {
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+
+	bool migrated = fillAndMigrate(tmp_fn, migration_structure_v1);
+	bool closed = false;
+	bool modifiedReconciled = false;
+	size_t devices = 0;
+	if(migrated) {
+		DBManagerContainer dbmc(database_url, migration_structure_v1);
+		SQLiteDBManager& manager = dynamic_cast<SQLiteDBManager&>(dbmc.getDBManager());
+		closed = manager.closeConnection();	/* Evicted, as by DBManagerFactory::setMaxOpenDatabases() */
+		{
+			/* The structure is modified by other means than this library: the fingerprint stored in user_version is left unchanged */
+			SQLite::Database database(tmp_fn, SQLITE_OPEN_READWRITE);
+			database.exec("ALTER TABLE \"devices\" ADD COLUMN \"handmade\" TEXT DEFAULT 'kept'");
+		}
+		/* Reopening reconciles the structure, as opening the database again from scratch does (see unchangedSchemaFingerprintTest) */
+		vector<map<string, string>> records = manager.get("devices");
+		devices = records.size();
+		modifiedReconciled = !records.empty() && records.at(0).find("handmade") == records.at(0).end();
+	}
+	remove(tmp_fn.c_str());
+
+	CHECK(migrated);
+	CHECK(closed);
+	CHECK_EQUAL(20, devices);
+	CHECK(modifiedReconciled);
+};
+
+TEST(DBManagerMigrationTests, removeRelationshipTest) {
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+
+	bool migrated = fillAndMigrate(tmp_fn, migration_structure_v1);
+	if(migrated) {	/* Now remove the relationship, so that tables are not referenced anymore */
+		DBManagerContainer dbmc(database_url, "<?xml version=\"1.0\" encoding=\"utf-8\"?><database>" \
+"<table name=\"devices\">" \
+	"<field name=\"mac\" default-value=\"\" is-not-null=\"true\" is-unique=\"true\" />" \
+	"<field name=\"firmware\" default-value=\"1.0\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<table name=\"groups\">" \
+	"<field name=\"label\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"</database>");
+		vector<map<string, string>> devices = dbmc.getDBManager().get("devices");
+		if(devices.size() != 20 || devices.at(0).find("id") != devices.at(0).end() || devices.at(0)["firmware"] != "1.0")
+			migrated = false;
+		if(dbmc.getDBManager().get("groups").size() != 4)
+			migrated = false;
+	}
+	remove(tmp_fn.c_str());
+	if(!migrated)
+		FAIL("Records were lost when unmarking tables as referenced.");
+};
+
+TEST(DBManagerMigrationTests, removeUniqueFieldByRebuildTest) {
+	string tmp_fn = mktemp_filename(progname);
+
+	map<string, string> expectedDeviceValues;
+	expectedDeviceValues.emplace("firmware", "1.0");
+	bool migrated = fillAndMigrate(tmp_fn, "<?xml version=\"1.0\" encoding=\"utf-8\"?><database>" \
+"<table name=\"devices\">" \
+	"<field name=\"firmware\" default-value=\"1.0\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<table name=\"groups\">" \
+	"<field name=\"label\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<relationship kind=\"m:n\" policy=\"none\" first-table=\"groups\" second-table=\"devices\" />" \
+"</database>", expectedDeviceValues);
+	remove(tmp_fn.c_str());
+	if(!migrated)
+		FAIL("Records or links were lost when removing a unique field.");
+};
+
+TEST(DBManagerMigrationTests, removeFieldsInPlaceTest) {
+	string tmp_fn = mktemp_filename(progname);
+
+	bool migrated = fillAndMigrate(tmp_fn, "<?xml version=\"1.0\" encoding=\"utf-8\"?><database>" \
+"<table name=\"devices\">" \
+	"<field name=\"mac\" default-value=\"\" is-not-null=\"true\" is-unique=\"true\" />" \
+"</table>" \
+"<table name=\"groups\">" \
+	"<field name=\"label\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<relationship kind=\"m:n\" policy=\"none\" first-table=\"groups\" second-table=\"devices\" />" \
+"</database>");
+	remove(tmp_fn.c_str());
+	if(!migrated)
+		FAIL("Records or links were lost when removing a field.");
+};
+
+TEST(DBManagerMigrationTests, addFieldsInPlaceTest) {
+	string tmp_fn = mktemp_filename(progname);
+
+	map<string, string> expectedDeviceValues;
+	expectedDeviceValues.emplace("firmware", "1.0");
+	expectedDeviceValues.emplace("model", "unknown");
+	expectedDeviceValues.emplace("location", "");
+	bool migrated = fillAndMigrate(tmp_fn, "<?xml version=\"1.0\" encoding=\"utf-8\"?><database>" \
+"<table name=\"devices\">" \
+	"<field name=\"mac\" default-value=\"\" is-not-null=\"true\" is-unique=\"true\" />" \
+	"<field name=\"firmware\" default-value=\"1.0\" is-not-null=\"true\" is-unique=\"false\" />" \
+	"<field name=\"model\" default-value=\"unknown\" is-not-null=\"true\" is-unique=\"false\" />" \
+	"<field name=\"location\" default-value=\"\" is-not-null=\"false\" is-unique=\"false\" />" \
+"</table>" \
+"<table name=\"groups\">" \
+	"<field name=\"label\" default-value=\"\" is-not-null=\"true\" is-unique=\"false\" />" \
+"</table>" \
+"<relationship kind=\"m:n\" policy=\"none\" first-table=\"groups\" second-table=\"devices\" />" \
+"</database>", expectedDeviceValues);
+	remove(tmp_fn.c_str());
+	if(!migrated)
+		FAIL("Records or links were lost, or added fields do not have their default value.");
+};
+
 bool testStringInRecordValue(DBManager* manager, const string& value) {
 
 	manager->remove(TEST_TABLE_NAME, map<string, string>());	/* Flush table */
@@ -4,6 +4,16 @@
 #include <iostream>
 #include <fstream>
 #include <stdio.h>	/* For remove() */
+#include <thread>
+#include <chrono>
+#include <atomic>
+#ifdef __unix__
+extern "C" {
+	#include <sys/file.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+}
+#endif
 
 #include "common/tools.hpp"
 
@@ -208,6 +218,71 @@ TEST(DBManagerContainerTests, nonExclusiveAllocationTwice) {
 	exclusiveAllocationX2(false, false);
 }
 
+#ifdef __unix__
+TEST(DBManagerContainerTests, sharedLockCheck) {
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+	string lock_fn = tmp_fn;
+	while(lock_fn.find("/") != string::npos) {
+		lock_fn.replace(lock_fn.find_first_of("/"), 1, "_");
+	}
+	lock_fn = "/tmp/dbmanager" + lock_fn + ".lock";
+
+	/* Another process uses the database (an open file description of our own behaves the same for flock()) */
+	int other = open(lock_fn.c_str(), O_RDWR | O_CREAT, 0644);
+	CHECK(other != -1);
+	CHECK_EQUAL(0, flock(other, LOCK_SH | LOCK_NB));
+	{
+		DBManagerContainer dbmc(database_url, database_structure);	/* Shared with the other process */
+		CHECK_EQUAL(1, factoryProxy.getRefCount(database_url));
+	}
+	CHECK_THROWS(runtime_error, DBManagerContainer(database_url, database_structure, true));
+	CHECK_EQUAL(0, access(lock_fn.c_str(), F_OK));	/* Not deleted, the other process still locks it */
+
+	flock(other, LOCK_UN);
+	{
+		DBManagerContainer dbmc(database_url, database_structure, true);
+		CHECK_EQUAL(-1, flock(other, LOCK_SH | LOCK_NB));	/* The other process can't use the database anymore */
+	}
+	close(other);
+	CHECK(access(lock_fn.c_str(), F_OK) != 0);	/* Deleted by the last user */
+	CHECK_EQUAL(0, factoryProxy.getRefCount(database_url));
+	remove(tmp_fn.c_str());
+}
+
+TEST(DBManagerContainerTests, deletedLockCheck) {
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+	string lock_fn = tmp_fn;
+	while(lock_fn.find("/") != string::npos) {
+		lock_fn.replace(lock_fn.find_first_of("/"), 1, "_");
+	}
+	lock_fn = "/tmp/dbmanager" + lock_fn + ".lock";
+
+	/* Another process holds the lock file exclusively and keeps it: the database can't be used */
+	int other = open(lock_fn.c_str(), O_RDWR | O_CREAT, 0644);
+	CHECK(other != -1);
+	CHECK_EQUAL(0, flock(other, LOCK_EX | LOCK_NB));
+	CHECK_THROWS(runtime_error, DBManagerContainer(database_url, database_structure));
+
+	/* The other process was the last user of the database: it holds the lock file exclusively only to delete it */
+	thread releasing([&lock_fn, other]() {
+		this_thread::sleep_for(chrono::milliseconds(2));
+		remove(lock_fn.c_str());
+		flock(other, LOCK_UN);
+		close(other);
+	});
+	{
+		DBManagerContainer dbmc(database_url, database_structure);	/* Waits for the deletion and locks a new file */
+		CHECK_EQUAL(1, factoryProxy.getRefCount(database_url));
+		releasing.join();
+		CHECK_EQUAL(0, access(lock_fn.c_str(), F_OK));	/* The new file */
+	}
+	CHECK(access(lock_fn.c_str(), F_OK) != 0);
+	remove(tmp_fn.c_str());
+}
+#endif
+
 TEST(DBManagerContainerTests, checkStructureFrombufferOrFile) {
 	/* Generate two databases */
 	string tmp_fn1 = mktemp_filename(progname);
@@ -348,6 +423,157 @@ TEST(DBManagerContainerTests, checkGetDBManager) {
 }
 
 
+TEST(DBManagerContainerTests, copyAndMoveCheck) {
+
+	string tmp_fn = mktemp_filename(progname);
+	string database_url = DATABASE_SQLITE_TYPE + tmp_fn;
+	unsigned int refCountAfterCopy = 0;
+	unsigned int refCountAfterMove = 0;
+	unsigned int refCountAfterMoveAssignment = 0;
+	bool sameManager = false;
+	bool exclusiveCopyRefused = false;
+	{
+		DBManagerContainer dbmc(database_url, database_structure);
+		DBManagerContainer dbmcCopy(dbmc);
+		refCountAfterCopy = factoryProxy.getRefCount(database_url);
+		DBManagerContainer dbmcMoved(std::move(dbmcCopy));	/* The reference of dbmcCopy is transferred, the count does not change */
+		refCountAfterMove = factoryProxy.getRefCount(database_url);
+		sameManager = (&dbmcMoved.getDBManager() == &dbmc.getDBManager());
+		DBManagerContainer dbmcOther(::database_url);
+		dbmcOther = std::move(dbmcMoved);	/* dbmcOther's reference on ::database_url is released when dbmcMoved is destructed */
+		refCountAfterMoveAssignment = factoryProxy.getRefCount(database_url);
+	}
+	unsigned int refCountAfterDestruction = factoryProxy.getRefCount(database_url);
+	{
+		DBManagerContainer dbmc(database_url, database_structure, true);
+		try {
+			DBManagerContainer dbmcCopy(dbmc);
+		}
+		catch (const std::runtime_error &e) {
+			exclusiveCopyRefused = true;
+		}
+	}
+	unsigned int refCountAfterExclusive = factoryProxy.getRefCount(database_url);
+	remove(tmp_fn.c_str());
+
+	CHECK_EQUAL(2, refCountAfterCopy);
+	CHECK_EQUAL(2, refCountAfterMove);
+	CHECK(sameManager);
+	CHECK_EQUAL(2, refCountAfterMoveAssignment);
+	CHECK_EQUAL(0, refCountAfterDestruction);
+	CHECK(exclusiveCopyRefused);
+	CHECK_EQUAL(0, refCountAfterExclusive);
+}
+
+TEST(DBManagerContainerTests, checkConcurrentAllocationFree) {
+
+	unsigned int countmanager = factoryProxy.getRefCount(database_url);
+	vector<string> tmp_fns;
+	vector<string> database_urls;
+	for(unsigned int i = 0; i < 4; i++) {
+		tmp_fns.push_back(mktemp_filename(progname));
+		database_urls.push_back(DATABASE_SQLITE_TYPE + tmp_fns.back());
+	}
+
+	/* Containers are created, copied and destroyed from several threads at once, both on a shared database and on databases that are opened and closed again and again */
+	atomic<unsigned int> failures(0);
+	vector<thread> threads;
+	for(unsigned int t = 0; t < 8; t++) {
+		threads.push_back(thread([&failures, &database_urls, t]() {
+			for(unsigned int i = 0; i < 100; i++) {
+				try {
+					DBManagerContainer dbmc(database_url);
+					DBManagerContainer dbmcCopy(dbmc);
+					DBManagerContainer dbmcOther(database_urls.at((t + i) % database_urls.size()), database_structure);
+					if(dbmcOther.getDBManager().get(TEST_TABLE_NAME).size() != 0)
+						failures++;
+				}
+				catch (const std::exception &e) {
+					failures++;
+				}
+			}
+		}));
+	}
+	for(auto &it : threads) {
+		it.join();
+	}
+
+	CHECK_EQUAL(0, failures);
+	CHECK_EQUAL(countmanager, factoryProxy.getRefCount(database_url));
+	for(unsigned int i = 0; i < database_urls.size(); i++) {
+		CHECK_EQUAL(0, factoryProxy.getRefCount(database_urls.at(i)));
+		remove(tmp_fns.at(i).c_str());
+	}
+}
+
+TEST(DBManagerContainerTests, prewarmCheck) {
+
+	vector<string> tmp_fns;
+	vector<string> database_urls;
+	for(unsigned int i = 0; i < 8; i++) {
+		tmp_fns.push_back(mktemp_filename(progname));
+		database_urls.push_back(DATABASE_SQLITE_TYPE + tmp_fns.back());
+	}
+	database_urls.push_back("unknown://" + tmp_fns.back());
+
+	vector<DBPrewarmResult> results = DBManagerFactory::getInstance().prewarm(database_urls, database_structure, 4);
+
+	CHECK_EQUAL(database_urls.size(), results.size());
+	for(unsigned int i = 0; i < tmp_fns.size(); i++) {
+		CHECK_EQUAL(database_urls.at(i), results.at(i).location);
+		CHECK(results.at(i).opened);
+		CHECK(results.at(i).error.empty());
+		/* The manager is ready but not referenced */
+		CHECK(factoryProxy.isAllocated(database_urls.at(i)));
+		CHECK_EQUAL(0, factoryProxy.getRefCount(database_urls.at(i)));
+	}
+	CHECK(!results.back().opened);
+	CHECK(!results.back().error.empty());
+	CHECK(!factoryProxy.isAllocated(database_urls.back()));
+
+	{
+		DBManagerContainer dbmc(database_urls.front());	/* Served without configuration: the database was checked by prewarm() */
+		CHECK_EQUAL(1, factoryProxy.getRefCount(database_urls.front()));
+		CHECK_EQUAL(0, dbmc.getDBManager().get(TEST_TABLE_NAME).size());
+		CHECK(dbmc.getDBManager().insert(TEST_TABLE_NAME, map<string, string>({{"field1", "value1"}})));
+	}
+	CHECK(!factoryProxy.isAllocated(database_urls.front()));	/* The last reference was released */
+
+	for(unsigned int i = 0; i < tmp_fns.size(); i++) {
+		DBManagerFactory::getInstance().freeDBManager(database_urls.at(i));
+		CHECK(!factoryProxy.isAllocated(database_urls.at(i)));
+		remove(tmp_fns.at(i).c_str());
+	}
+}
+
+TEST(DBManagerContainerTests, prewarmSameLocationCheck) {
+
+	vector<string> tmp_fns;
+	vector<string> database_urls;
+	for(unsigned int i = 0; i < 4; i++) {
+		tmp_fns.push_back(mktemp_filename(progname));
+	}
+	/* More threads than shards, each location being asked for by several threads at once: only one of them opens it, the others wait for its manager */
+	for(unsigned int i = 0; i < 2 * DBMANAGER_FACTORY_SHARDS; i++) {
+		database_urls.push_back(DATABASE_SQLITE_TYPE + tmp_fns.at(i % tmp_fns.size()));
+	}
+
+	vector<DBPrewarmResult> results = DBManagerFactory::getInstance().prewarm(database_urls, database_structure, 2 * DBMANAGER_FACTORY_SHARDS);
+
+	CHECK_EQUAL(database_urls.size(), results.size());
+	for(auto &result : results) {
+		CHECK(result.opened);
+		CHECK(result.error.empty());
+	}
+	for(unsigned int i = 0; i < tmp_fns.size(); i++) {
+		CHECK(factoryProxy.isAllocated(database_urls.at(i)));
+		CHECK_EQUAL(0, factoryProxy.getRefCount(database_urls.at(i)));
+		DBManagerFactory::getInstance().freeDBManager(database_urls.at(i));
+		CHECK(!factoryProxy.isAllocated(database_urls.at(i)));
+		remove(tmp_fns.at(i).c_str());
+	}
+}
+
 int main(int argc, char** argv) {
 	
 	int rc;